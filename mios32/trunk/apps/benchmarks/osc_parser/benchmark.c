@@ -0,0 +1,183 @@
+// $Id$
+/*
+ * Benchmark for OSC Parser
+ * See README.txt for details
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2015 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <string.h>
+#include "benchmark.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////////////////////////////////
+
+// each message: path (max. 16 bytes) + ",f" (4 bytes) + float value (4 bytes)
+#define MAX_PACKET_SIZE 24
+
+static u8 packet_storage[BENCHMARK_NUM_MESSAGES][MAX_PACKET_SIZE];
+static u8 packet_len[BENCHMARK_NUM_MESSAGES];
+
+static mios32_osc_address_cache_t osc_cache;
+
+static u32 num_method_calls;
+
+const static mios32_osc_search_tree_t parse_root[];
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Initialisation
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_Init(u32 mode)
+{
+  MIOS32_OSC_AddressCacheClear(&osc_cache);
+  num_method_calls = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the number of called OSC methods (to check that all messages have
+// been dispatched)
+/////////////////////////////////////////////////////////////////////////////
+u32 BENCHMARK_NumMethodCallsGet(void)
+{
+  return num_method_calls;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prints the hit/miss statistics of the address cache
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_PrintCacheStatistics(void)
+{
+  MIOS32_MIDI_SendDebugMessage("Address Cache: %u hits, %u misses\n", osc_cache.hits, osc_cache.misses);
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Fader stream as sent by a TouchOSC layout while two faders are moved
+// on page 1 and 2 (the typical case which should be handled fast)
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_Reset_FaderStream(u32 par)
+{
+  int i;
+
+  for(i=0; i<BENCHMARK_NUM_MESSAGES; ++i) {
+    char path[16];
+    u8 page = (i & 1) ? 2 : 1;
+    u8 fader = ((i / 64) % 8) + 1;
+
+    sprintf(path, "/%d/fader%d", page, fader);
+
+    u8 *end_ptr = &packet_storage[i][0];
+    end_ptr = MIOS32_OSC_PutString(end_ptr, path);
+    end_ptr = MIOS32_OSC_PutString(end_ptr, ",f");
+    end_ptr = MIOS32_OSC_PutFloat(end_ptr, (float)(i % 64) / 63.0);
+    packet_len[i] = (u8)(end_ptr - &packet_storage[i][0]);
+  }
+
+  MIOS32_OSC_AddressCacheClear(&osc_cache);
+  num_method_calls = 0;
+
+  return 0; // no error
+}
+
+s32 BENCHMARK_Start_FaderStream(u32 par)
+{
+  int i;
+
+  for(i=0; i<BENCHMARK_NUM_MESSAGES; ++i)
+    BENCHMARK_ParsePacket(&packet_storage[i][0], packet_len[i], par);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Parses a single packet with the benchmark search tree
+// (also used by tools/osc_bench to replay a captured stream)
+// cached: 0: search tree, 1: address cache
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_ParsePacket(u8 *packet, u32 len, u32 cached)
+{
+  if( cached )
+    return MIOS32_OSC_ParsePacketCached(packet, len, parse_root, &osc_cache);
+
+  return MIOS32_OSC_ParsePacket(packet, len, parse_root);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// OSC method: only counts the calls and fetches the value
+/////////////////////////////////////////////////////////////////////////////
+static s32 BENCHMARK_Method_Control(mios32_osc_args_t *osc_args, u32 method_arg)
+{
+  if( osc_args->num_args >= 1 && osc_args->arg_type[0] == 'f' ) {
+    volatile float value = MIOS32_OSC_GetFloat(osc_args->arg_ptr[0]);
+    (void)value;
+  }
+
+  ++num_method_calls;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Search Tree similar to a TouchOSC layout with 4 pages
+/////////////////////////////////////////////////////////////////////////////
+
+const static mios32_osc_search_tree_t parse_page[] = {
+  { "fader1",   NULL, &BENCHMARK_Method_Control, 0x00000000 }, // bit [7:0] control number
+  { "fader2",   NULL, &BENCHMARK_Method_Control, 0x00000001 },
+  { "fader3",   NULL, &BENCHMARK_Method_Control, 0x00000002 },
+  { "fader4",   NULL, &BENCHMARK_Method_Control, 0x00000003 },
+  { "fader5",   NULL, &BENCHMARK_Method_Control, 0x00000004 },
+  { "fader6",   NULL, &BENCHMARK_Method_Control, 0x00000005 },
+  { "fader7",   NULL, &BENCHMARK_Method_Control, 0x00000006 },
+  { "fader8",   NULL, &BENCHMARK_Method_Control, 0x00000007 },
+  { "rotary1",  NULL, &BENCHMARK_Method_Control, 0x00000010 },
+  { "rotary2",  NULL, &BENCHMARK_Method_Control, 0x00000011 },
+  { "rotary3",  NULL, &BENCHMARK_Method_Control, 0x00000012 },
+  { "rotary4",  NULL, &BENCHMARK_Method_Control, 0x00000013 },
+  { "rotary5",  NULL, &BENCHMARK_Method_Control, 0x00000014 },
+  { "rotary6",  NULL, &BENCHMARK_Method_Control, 0x00000015 },
+  { "rotary7",  NULL, &BENCHMARK_Method_Control, 0x00000016 },
+  { "rotary8",  NULL, &BENCHMARK_Method_Control, 0x00000017 },
+  { "toggle1",  NULL, &BENCHMARK_Method_Control, 0x00000020 },
+  { "toggle2",  NULL, &BENCHMARK_Method_Control, 0x00000021 },
+  { "toggle3",  NULL, &BENCHMARK_Method_Control, 0x00000022 },
+  { "toggle4",  NULL, &BENCHMARK_Method_Control, 0x00000023 },
+  { "push1",    NULL, &BENCHMARK_Method_Control, 0x00000030 },
+  { "push2",    NULL, &BENCHMARK_Method_Control, 0x00000031 },
+  { "push3",    NULL, &BENCHMARK_Method_Control, 0x00000032 },
+  { "push4",    NULL, &BENCHMARK_Method_Control, 0x00000033 },
+  { "xy",       NULL, &BENCHMARK_Method_Control, 0x00000040 },
+
+  { NULL, NULL, NULL, 0 } // terminator
+};
+
+const static mios32_osc_search_tree_t parse_root[] = {
+  { "1", parse_page, NULL, 0x00000000 }, // bit [9:8] selects the page
+  { "2", parse_page, NULL, 0x00000100 },
+  { "3", parse_page, NULL, 0x00000200 },
+  { "4", parse_page, NULL, 0x00000300 },
+
+  { NULL, NULL, NULL, 0 } // terminator
+};
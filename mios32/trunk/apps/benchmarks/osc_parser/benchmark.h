@@ -0,0 +1,50 @@
+// $Id$
+/*
+ * Header file for benchmark routines
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2015 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of OSC messages in the fader stream
+#define BENCHMARK_NUM_MESSAGES 256
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global Types
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern s32 BENCHMARK_Init(u32 mode);
+
+extern s32 BENCHMARK_Reset_FaderStream(u32 par);
+extern s32 BENCHMARK_Start_FaderStream(u32 par);
+
+extern s32 BENCHMARK_ParsePacket(u8 *packet, u32 len, u32 cached);
+
+extern u32 BENCHMARK_NumMethodCallsGet(void);
+extern s32 BENCHMARK_PrintCacheStatistics(void);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Export global variables
+/////////////////////////////////////////////////////////////////////////////
+
+
+#endif /* _BENCHMARK_H */
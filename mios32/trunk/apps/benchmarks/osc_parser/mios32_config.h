@@ -0,0 +1,21 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file
+ *
+ * this file allows to disable (or re-configure) default functions of MIOS32
+ * available switches are listed in $MIOS32_PATH/modules/mios32/MIOS32_CONFIG.txt
+ *
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// The boot message which is print during startup and returned on a SysEx query
+#define MIOS32_LCD_BOOT_MSG_LINE1 "OSC Parser Benchmark"
+#define MIOS32_LCD_BOOT_MSG_LINE2 "(c) 2015 T.Klose"
+
+
+// function used to output debug messages (must be printf compatible!)
+#define DEBUG_MSG MIOS32_MIDI_SendDebugMessage
+
+#endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1,115 @@
+#!/usr/bin/perl -w
+# $Id$
+#
+# Writes a pcap capture of the UDP packets which are sent by a TouchOSC
+# layout while faders are moved (one OSC message per packet, ~60 Hz
+# update rate per control, occasional page switches, toggles and xy pad
+# moves)
+#
+# The capture can be replaced by a real recording, e.g.:
+#   tcpdump -i any -w touchosc.pcap udp port 8000
+#
+# Usage: perl gen_capture.pl [<number of gestures>] > faders.pcap
+#
+
+use strict;
+
+my $num_gestures = $ARGV[0] || 40;
+
+# fixed seed, so that the capture is reproducible
+srand(4711);
+
+binmode(STDOUT);
+
+# pcap header: v2.4, snaplen 65535, LINKTYPE_ETHERNET
+print pack("VvvVVVV", 0xa1b2c3d4, 2, 4, 0, 0, 65535, 1);
+
+my $time_us = 1000000;
+my $ip_id = 0;
+my $page = 1;
+my @value = map { 0.0 } (0..63);
+
+#########################################################################
+# OSC encoding
+#########################################################################
+sub osc_string {
+  my ($str) = @_;
+  $str .= "\0";
+  $str .= "\0" while length($str) % 4;
+  return $str;
+}
+
+sub osc_message {
+  my ($path, @args) = @_;
+  return osc_string($path) . osc_string("," . ("f" x scalar(@args))) . join("", map { pack("f>", $_) } @args);
+}
+
+#########################################################################
+# Ethernet/IPv4/UDP framing
+#########################################################################
+sub ip_checksum {
+  my ($hdr) = @_;
+  my $sum = 0;
+  $sum += $_ foreach unpack("n*", $hdr);
+  $sum = ($sum & 0xffff) + ($sum >> 16) while $sum >> 16;
+  return ~$sum & 0xffff;
+}
+
+sub put_packet {
+  my ($payload) = @_;
+
+  my $udp = pack("nnnn", 49152, 8000, 8 + length($payload), 0) . $payload;
+  my $ip = pack("CCnnnCCnNN", 0x45, 0, 20 + length($udp), $ip_id++ & 0xffff, 0x4000, 64, 17, 0,
+                0xc0a80165, 0xc0a8010a); # 192.168.1.101 -> 192.168.1.10
+  substr($ip, 10, 2) = pack("n", ip_checksum($ip));
+  my $frame = pack("H12H12n", "020000000002", "020000000001", 0x0800) . $ip . $udp;
+
+  print pack("VVVV", int($time_us / 1000000), $time_us % 1000000, length($frame), length($frame)) . $frame;
+}
+
+#########################################################################
+# Gestures
+#########################################################################
+for(my $gesture=0; $gesture<$num_gestures; ++$gesture) {
+  my $kind = rand();
+
+  if( $kind < 0.10 ) {
+    # page switch
+    $page = 1 + int(rand(4));
+    put_packet(osc_message("/$page"));
+  } elsif( $kind < 0.20 ) {
+    # toggle: press and release
+    my $toggle = 1 + int(rand(4));
+    put_packet(osc_message("/$page/toggle$toggle", 1.0));
+    $time_us += 80000 + int(rand(120000));
+    put_packet(osc_message("/$page/toggle$toggle", 0.0));
+  } elsif( $kind < 0.30 ) {
+    # xy pad
+    my $steps = 20 + int(rand(60));
+    my ($x, $y) = (rand(), rand());
+    for(my $i=0; $i<$steps; ++$i) {
+      $x = abs($x + rand(0.04) - 0.02); $x = 1.0 if $x > 1.0;
+      $y = abs($y + rand(0.04) - 0.02); $y = 1.0 if $y > 1.0;
+      put_packet(osc_message("/$page/xy", $x, $y));
+      $time_us += 16000 + int(rand(2000));
+    }
+  } else {
+    # one or two faders (multitouch) are moved to a new position
+    my @faders = (1 + int(rand(8)));
+    push @faders, 1 + (($faders[0] + int(rand(7))) % 8) if rand() < 0.4;
+    my $steps = 10 + int(rand(50));
+    my %target = map { $_ => rand() } @faders;
+    my %start = map { $_ => $value[($page-1)*8 + $_ - 1] } @faders;
+    for(my $i=1; $i<=$steps; ++$i) {
+      foreach my $fader (@faders) {
+        my $v = $start{$fader} + ($target{$fader} - $start{$fader}) * $i / $steps;
+        $value[($page-1)*8 + $fader - 1] = $v;
+        put_packet(osc_message("/$page/fader$fader", $v));
+        $time_us += 200 + int(rand(300));
+      }
+      $time_us += 16000 + int(rand(2000));
+    }
+  }
+
+  $time_us += 200000 + int(rand(800000));
+}
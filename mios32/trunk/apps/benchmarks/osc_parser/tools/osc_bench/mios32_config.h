@@ -0,0 +1,19 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host build of the benchmark
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// function used to output debug messages (must be printf compatible!)
+#define DEBUG_MSG MIOS32_MIDI_SendDebugMessage
+
+#endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1,300 @@
+// $Id$
+/*
+ * Host build of the OSC Parser Benchmark
+ *
+ * Replays the OSC messages of a pcap capture (e.g. recorded with tcpdump
+ * while faders are moved in TouchOSC) through the search tree of
+ * ../../benchmark.c and reports the throughput of MIOS32_OSC_ParsePacket()
+ * and MIOS32_OSC_ParsePacketCached().
+ * Without capture the synthetic fader stream of the target benchmark is used.
+ *
+ * See README.txt for details
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <mios32.h>
+#include "benchmark.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+#define MAX_PACKETS     65536
+#define MAX_PACKET_SIZE 1536
+
+// pcap link types
+#define LINKTYPE_NULL       0
+#define LINKTYPE_ETHERNET   1
+#define LINKTYPE_RAW        101
+#define LINKTYPE_LINUX_SLL  113
+#define LINKTYPE_LINUX_SLL2 276
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u8  *packet_ptr[MAX_PACKETS];
+static u32  packet_len[MAX_PACKETS];
+static u32  num_packets;
+
+static u8 debug_enabled;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stubs
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  va_list args;
+
+  if( !debug_enabled )
+    return 0;
+
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Host timer in uS
+/////////////////////////////////////////////////////////////////////////////
+static double TimeGet_uS(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Reads the UDP payloads of a pcap file
+// udp_port: 0: any port, else only packets with the given src or dst port
+// returns < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+static u32 Get32(u8 *buffer, u8 swap)
+{
+  return swap
+    ? ((u32)buffer[0] << 24) | ((u32)buffer[1] << 16) | ((u32)buffer[2] << 8) | buffer[3]
+    : ((u32)buffer[3] << 24) | ((u32)buffer[2] << 16) | ((u32)buffer[1] << 8) | buffer[0];
+}
+
+static s32 CaptureRead(const char *filename, u16 udp_port)
+{
+  FILE *f;
+  u8 header[24];
+  u8 record[16];
+  u8 frame[MAX_PACKET_SIZE + 64];
+  u8 swap;
+  u32 link_type;
+
+  if( (f=fopen(filename, "rb")) == NULL ) {
+    fprintf(stderr, "ERROR: can't open '%s'\n", filename);
+    return -1;
+  }
+
+  if( fread(header, 1, sizeof(header), f) != sizeof(header) ) {
+    fprintf(stderr, "ERROR: '%s' is too short\n", filename);
+    fclose(f);
+    return -2;
+  }
+
+  // little or big endian, uS or nS timestamps (the timestamps aren't used)
+  u32 magic = Get32(header, 0);
+  if( magic == 0xa1b2c3d4 || magic == 0xa1b23c4d )
+    swap = 0;
+  else if( magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1 )
+    swap = 1;
+  else {
+    fprintf(stderr, "ERROR: '%s' is not a pcap file (pcapng isn't supported, convert with 'editcap -F pcap')\n", filename);
+    fclose(f);
+    return -3;
+  }
+
+  link_type = Get32(&header[20], swap) & 0xffff;
+  if( link_type != LINKTYPE_NULL && link_type != LINKTYPE_ETHERNET && link_type != LINKTYPE_RAW &&
+      link_type != LINKTYPE_LINUX_SLL && link_type != LINKTYPE_LINUX_SLL2 ) {
+    fprintf(stderr, "ERROR: link type %u of '%s' not supported\n", link_type, filename);
+    fclose(f);
+    return -4;
+  }
+
+  num_packets = 0;
+  while( fread(record, 1, sizeof(record), f) == sizeof(record) ) {
+    u32 incl_len = Get32(&record[8], swap);
+    u32 len = (incl_len > sizeof(frame)) ? sizeof(frame) : incl_len;
+
+    if( fread(frame, 1, len, f) != len )
+      break; // truncated capture
+    if( incl_len > len )
+      fseek(f, incl_len - len, SEEK_CUR);
+
+    // skip the link layer
+    u8 *ip;
+    u16 ether_type = 0x0800;
+    switch( link_type ) {
+    case LINKTYPE_NULL:       ip = &frame[4]; break;
+    case LINKTYPE_RAW:        ip = &frame[0]; break;
+    case LINKTYPE_LINUX_SLL:  ip = &frame[16]; ether_type = (frame[14] << 8) | frame[15]; break;
+    case LINKTYPE_LINUX_SLL2: ip = &frame[20]; ether_type = (frame[0] << 8) | frame[1]; break;
+    default: // LINKTYPE_ETHERNET
+      ip = &frame[14];
+      ether_type = (frame[12] << 8) | frame[13];
+      if( ether_type == 0x8100 ) { // VLAN tag
+	ether_type = (frame[16] << 8) | frame[17];
+	ip += 4;
+      }
+    }
+
+    // only unfragmented IPv4/UDP
+    if( ether_type != 0x0800 || (ip + 20) > &frame[len] || (ip[0] >> 4) != 4 || ip[9] != 17 )
+      continue;
+    if( ((ip[6] & 0x3f) | ip[7]) != 0 )
+      continue;
+
+    u8 *udp = ip + 4*(ip[0] & 0x0f);
+    if( (udp + 8) > &frame[len] )
+      continue;
+
+    u16 src_port = (udp[0] << 8) | udp[1];
+    u16 dst_port = (udp[2] << 8) | udp[3];
+    if( udp_port && src_port != udp_port && dst_port != udp_port )
+      continue;
+
+    u32 payload_len = ((udp[4] << 8) | udp[5]) - 8;
+    if( payload_len > MAX_PACKET_SIZE || (udp + 8 + payload_len) > &frame[len] )
+      continue;
+
+    if( num_packets >= MAX_PACKETS ) {
+      fprintf(stderr, "WARNING: only the first %d packets are replayed\n", MAX_PACKETS);
+      break;
+    }
+
+    // 4 byte aligned copy, like the receive buffers of the target
+    u8 *buffer = malloc(payload_len + 4);
+    memcpy(buffer, udp + 8, payload_len);
+    packet_ptr[num_packets] = buffer;
+    packet_len[num_packets] = payload_len;
+    ++num_packets;
+  }
+
+  fclose(f);
+
+  return num_packets;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Replays the captured packets (or the synthetic stream if no capture loaded)
+// cached: 0: search tree, 1: address cache
+/////////////////////////////////////////////////////////////////////////////
+static void Replay(u32 cached, u32 num_loops)
+{
+  int loop, i;
+
+  BENCHMARK_Init(0); // clears the cache and the method counter
+
+  double start_us = TimeGet_uS();
+  for(loop=0; loop<num_loops; ++loop) {
+    if( !num_packets )
+      BENCHMARK_Start_FaderStream(cached);
+    else {
+      for(i=0; i<num_packets; ++i)
+	BENCHMARK_ParsePacket(packet_ptr[i], packet_len[i], cached);
+    }
+  }
+  double time_us = TimeGet_uS() - start_us;
+
+  u32 num_messages = num_loops * (num_packets ? num_packets : BENCHMARK_NUM_MESSAGES);
+  printf("%s: %u messages in %.1f mS -> %.0f messages/s, %.3f uS per message\n",
+	 cached ? "Address Cache" : "Search Tree  ",
+	 num_messages, time_us / 1000.0, (double)num_messages * 1e6 / time_us, time_us / num_messages);
+  printf("  Dispatched: %u method calls\n", BENCHMARK_NumMethodCallsGet());
+
+  if( cached ) {
+    u8 prev_debug_enabled = debug_enabled;
+    debug_enabled = 1;
+    printf("  ");
+    BENCHMARK_PrintCacheStatistics();
+    debug_enabled = prev_debug_enabled;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+static void Usage(const char *prog)
+{
+  fprintf(stderr,
+	  "Usage: %s [-n <loops>] [-p <udp port>] [-d] [<capture.pcap>]\n"
+	  "  -n: number of replays (default: 1000)\n"
+	  "  -p: only replay packets from/to the given UDP port (default: any)\n"
+	  "  -d: print the debug messages of MIOS32_OSC\n"
+	  "Without capture the synthetic fader stream of the target benchmark is parsed.\n",
+	  prog);
+}
+
+int main(int argc, char *argv[])
+{
+  u32 num_loops = 1000;
+  u16 udp_port = 0;
+  int opt;
+
+  while( (opt=getopt(argc, argv, "n:p:dh")) != -1 ) {
+    switch( opt ) {
+    case 'n': num_loops = atoi(optarg); break;
+    case 'p': udp_port = atoi(optarg); break;
+    case 'd': debug_enabled = 1; break;
+    default:
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if( num_loops < 1 )
+    num_loops = 1;
+
+  if( optind < argc ) {
+    if( CaptureRead(argv[optind], udp_port) < 0 )
+      return 1;
+
+    if( !num_packets ) {
+      fprintf(stderr, "ERROR: no UDP packets found in '%s'\n", argv[optind]);
+      return 1;
+    }
+
+    printf("Capture: %s, %u packets\n", argv[optind], num_packets);
+  } else {
+    BENCHMARK_Reset_FaderStream(0);
+    num_packets = 0; // Replay() parses the synthetic stream
+
+    printf("Synthetic fader stream, %u packets\n", BENCHMARK_NUM_MESSAGES);
+  }
+
+  Replay(0, num_loops);
+  Replay(1, num_loops);
+
+  return 0;
+}
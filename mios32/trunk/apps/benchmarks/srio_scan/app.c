@@ -0,0 +1,205 @@
+// $Id$
+/*
+ * Benchmark for SRIO Scan
+ * See README.txt for details
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2015 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <FreeRTOS.h>
+#include <portmacro.h>
+
+#include "benchmark.h"
+#include "app.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global Variables
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+// tested number of shift registers
+static const u8 benchmark_num_sr[] = { 1, 2, 4, 8, 16, 24, 32 };
+#define BENCHMARK_NUM_SR_TESTS (sizeof(benchmark_num_sr)/sizeof(u8))
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This hook is called after startup to initialize the application
+/////////////////////////////////////////////////////////////////////////////
+void APP_Init(void)
+{
+  // initialize all LEDs
+  MIOS32_BOARD_LED_Init(0xffffffff);
+
+  // initialize stopwatch for measuring delays
+  MIOS32_STOPWATCH_Init(1);
+
+  // initialize benchmark
+  BENCHMARK_Init(0);
+
+  // print welcome message on MIOS terminal
+  MIOS32_MIDI_SendDebugMessage("\n");
+  MIOS32_MIDI_SendDebugMessage("====================\n");
+  MIOS32_MIDI_SendDebugMessage("%s\n", MIOS32_LCD_BOOT_MSG_LINE1);
+  MIOS32_MIDI_SendDebugMessage("====================\n");
+  MIOS32_MIDI_SendDebugMessage("\n");
+  MIOS32_MIDI_SendDebugMessage("Play MIDI notes to start different benchmarks\n");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This task is running endless in background
+/////////////////////////////////////////////////////////////////////////////
+void APP_Background(void)
+{
+  // clear LCD screen
+  MIOS32_LCD_Clear();
+
+  // print message
+  MIOS32_LCD_CursorSet(0, 0);
+  MIOS32_LCD_PrintString("see README.txt   ");
+  MIOS32_LCD_CursorSet(0, 1);
+  MIOS32_LCD_PrintString("for details     ");
+
+  // wait endless
+  while( 1 );
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This hook is called when a MIDI package has been received
+/////////////////////////////////////////////////////////////////////////////
+void APP_MIDI_NotifyPackage(mios32_midi_port_t port, mios32_midi_package_t midi_package)
+{
+  if( midi_package.type == NoteOn && midi_package.velocity > 0 ) {
+    // change debug interface (where messages are forwarded)
+    MIOS32_MIDI_DebugPortSet(port);
+
+    // determine test number (use note number, remove octave)
+    u8 test_number = midi_package.note % 12;
+    int i;
+
+    switch( test_number ) {
+      case 0:
+	MIOS32_MIDI_SendDebugMessage("Testing scan time (SPI prescaler %d)\n", MIOS32_SRIO_SPI_PRESCALER);
+	break;
+
+      case 1:
+	MIOS32_MIDI_SendDebugMessage("Testing MIOS32_DIN_Handler() without DIN changes\n");
+	break;
+
+      case 2:
+	MIOS32_MIDI_SendDebugMessage("Testing MIOS32_DIN_Handler() with a change at the last SR\n");
+	break;
+
+      default:
+	MIOS32_MIDI_SendDebugMessage("This note isn't mapped to a test function.\n");
+	return;
+    }
+
+    // add some delay to ensure that there a no USB background traffic caused by the debug message
+    MIOS32_DELAY_Wait_uS(50000);
+
+    for(i=0; i<BENCHMARK_NUM_SR_TESTS; ++i) {
+      u8 num_sr = benchmark_num_sr[i];
+
+      if( num_sr > MIOS32_SRIO_NUM_SR )
+	break;
+
+      // turn on LED (e.g. for measurements with a scope)
+      MIOS32_BOARD_LED_Set(0xffffffff, 1);
+
+      if( test_number == 0 ) {
+	u32 avg_us, max_us;
+	s32 status = BENCHMARK_ScanTime(num_sr, &avg_us, &max_us);
+
+	MIOS32_BOARD_LED_Set(0xffffffff, 0);
+
+	if( status < 0 )
+	  MIOS32_MIDI_SendDebugMessage("%2d SRs: no scan measured!\n", num_sr);
+	else
+	  MIOS32_MIDI_SendDebugMessage("%2d SRs: avg %4d uS, max %4d uS\n", num_sr, avg_us, max_us);
+      } else {
+	s32 delay = BENCHMARK_DinHandler(num_sr, test_number == 2);
+
+	MIOS32_BOARD_LED_Set(0xffffffff, 0);
+
+	if( delay == -2 )
+	  MIOS32_MIDI_SendDebugMessage("%2d SRs: overrun!\n", num_sr);
+	else if( delay < 0 )
+	  MIOS32_MIDI_SendDebugMessage("%2d SRs: missed notifications!\n", num_sr);
+	else
+	  MIOS32_MIDI_SendDebugMessage("%2d SRs: %d uS for %d calls\n", num_sr, delay, BENCHMARK_NUM_HANDLER_CALLS);
+      }
+    }
+
+    // restore default scan length
+    MIOS32_SRIO_ScanNumSet(MIOS32_SRIO_NUM_SR);
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This hook is called before the shift register chain is scanned
+/////////////////////////////////////////////////////////////////////////////
+void APP_SRIO_ServicePrepare(void)
+{
+  BENCHMARK_ServicePrepare();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This hook is called after the shift register chain has been scanned
+/////////////////////////////////////////////////////////////////////////////
+void APP_SRIO_ServiceFinish(void)
+{
+  BENCHMARK_ServiceFinish();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This hook is called when a button has been toggled
+// pin_value is 1 when button released, and 0 when button pressed
+/////////////////////////////////////////////////////////////////////////////
+void APP_DIN_NotifyToggle(u32 pin, u32 pin_value)
+{
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This hook is called when an encoder has been moved
+// incrementer is positive when encoder has been turned clockwise, else
+// it is negative
+/////////////////////////////////////////////////////////////////////////////
+void APP_ENC_NotifyChange(u32 encoder, s32 incrementer)
+{
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This hook is called when a pot has been moved
+/////////////////////////////////////////////////////////////////////////////
+void APP_AIN_NotifyChange(u32 pin, u32 pin_value)
+{
+}
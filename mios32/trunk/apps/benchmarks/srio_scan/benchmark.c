@@ -0,0 +1,158 @@
+// $Id$
+/*
+ * Benchmark for SRIO Scan
+ * See README.txt for details
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2015 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <FreeRTOS.h>
+#include <portmacro.h>
+
+#include "benchmark.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////////////////////////////////
+
+static volatile u8 scan_measure;
+static volatile u32 scan_num;
+static volatile u32 scan_sum_us;
+static volatile u32 scan_max_us;
+
+static u32 num_notifications;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Initialisation
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_Init(u32 mode)
+{
+  scan_measure = 0;
+  num_notifications = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Called from APP_SRIO_ServicePrepare before the scan is started
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_ServicePrepare(void)
+{
+  if( scan_measure )
+    MIOS32_STOPWATCH_Reset();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Called from APP_SRIO_ServiceFinish once the DMA transfer has been finished
+// and the DIN values have been compared
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_ServiceFinish(void)
+{
+  if( scan_measure ) {
+    u32 delay = MIOS32_STOPWATCH_ValueGet();
+
+    scan_sum_us += delay;
+    if( delay > scan_max_us )
+      scan_max_us = delay;
+    ++scan_num;
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measures the time of a complete scan (from MIOS32_SRIO_ScanStart() until
+// the DIN values have been compared) for the given number of SRs
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_ScanTime(u8 num_sr, u32 *avg_us, u32 *max_us)
+{
+  MIOS32_SRIO_ScanNumSet(num_sr);
+
+  // skip the ongoing scan
+  MIOS32_DELAY_Wait_uS(2000);
+
+  scan_num = 0;
+  scan_sum_us = 0;
+  scan_max_us = 0;
+  scan_measure = 1;
+
+  // measure ca. 100 scans (MIOS32_DELAY_Wait_uS() is limited to 65535 uS)
+  int i;
+  for(i=0; i<100; ++i)
+    MIOS32_DELAY_Wait_uS(1000);
+
+  scan_measure = 0;
+
+  *avg_us = scan_num ? (scan_sum_us / scan_num) : 0;
+  *max_us = scan_max_us;
+
+  return scan_num ? 0 : -1; // no scan has been measured
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Dummy DIN notification
+/////////////////////////////////////////////////////////////////////////////
+static void BENCHMARK_DinNotify(u32 pin, u32 value)
+{
+  ++num_notifications;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Measures BENCHMARK_NUM_HANDLER_CALLS calls of MIOS32_DIN_Handler()
+// If with_change is set, a pin change at the last SR will be notified
+// before each call.
+// Returns the measured time in uS, -1 if notifications are missing,
+// -2 on stopwatch overrun
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_DinHandler(u8 num_sr, u8 with_change)
+{
+  int i;
+  u8 sr = num_sr - 1;
+
+  MIOS32_SRIO_ScanNumSet(num_sr);
+  num_notifications = 0;
+
+  portENTER_CRITICAL(); // port specific FreeRTOS function to disable tasks (nested)
+
+  MIOS32_STOPWATCH_Reset();
+
+  for(i=0; i<BENCHMARK_NUM_HANDLER_CALLS; ++i) {
+    if( with_change )
+      MIOS32_DIN_SRChangedSet(sr, 0x80);
+
+    MIOS32_DIN_Handler(BENCHMARK_DinNotify);
+  }
+
+  u32 delay = MIOS32_STOPWATCH_ValueGet();
+
+  portEXIT_CRITICAL(); // port specific FreeRTOS function to enable tasks (nested)
+
+  if( delay == 0xffffffff )
+    return -2; // stopwatch overrun
+
+  if( with_change && num_notifications != BENCHMARK_NUM_HANDLER_CALLS )
+    return -1; // missed notifications
+
+  return delay;
+}
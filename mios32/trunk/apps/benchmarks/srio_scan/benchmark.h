@@ -0,0 +1,48 @@
+// $Id$
+/*
+ * Header file for benchmark routines
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2015 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of DIN handler calls per measurement
+#define BENCHMARK_NUM_HANDLER_CALLS 1000
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global Types
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern s32 BENCHMARK_Init(u32 mode);
+
+extern s32 BENCHMARK_ServicePrepare(void);
+extern s32 BENCHMARK_ServiceFinish(void);
+
+extern s32 BENCHMARK_ScanTime(u8 num_sr, u32 *avg_us, u32 *max_us);
+extern s32 BENCHMARK_DinHandler(u8 num_sr, u8 with_change);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Export global variables
+/////////////////////////////////////////////////////////////////////////////
+
+
+#endif /* _BENCHMARK_H */
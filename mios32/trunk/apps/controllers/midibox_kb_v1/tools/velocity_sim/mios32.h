@@ -0,0 +1,57 @@
+// $Id$
+/*
+ * Minimal MIOS32 replacement for the keyboard velocity simulation
+ * Only the functions which are used by modules/keyboard/keyboard.c are
+ * declared here, they are implemented in velocity_sim.c
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _MIOS32_H
+#define _MIOS32_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// variable types (32bit like on the target)
+/////////////////////////////////////////////////////////////////////////////
+
+typedef int32_t  s32;
+typedef int16_t  s16;
+typedef int8_t   s8;
+typedef uint32_t u32;
+typedef uint16_t u16;
+typedef uint8_t  u8;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stubs
+/////////////////////////////////////////////////////////////////////////////
+
+// only a single DOUT page
+#define MIOS32_SRIO_NUM_DOUT_PAGES 1
+
+// the simulation is single threaded
+#define MIOS32_IRQ_Disable() do {} while(0)
+#define MIOS32_IRQ_Enable()  do {} while(0)
+
+extern u8  MIOS32_SRIO_ScanNumGet(void);
+
+extern s32 MIOS32_DIN_SRGet(u32 sr);
+extern s32 MIOS32_DIN_SRChangedGetAndClear(u32 sr, u8 mask);
+extern s32 MIOS32_DOUT_SRSet(u32 sr, u8 value);
+
+extern s32 MIOS32_TIMESTAMP_Get(void);
+extern u32 MIOS32_TIMESTAMP_Get_uS(void);
+
+extern s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...);
+
+#endif /* _MIOS32_H */
@@ -0,0 +1,443 @@
+// $Id$
+/*
+ * Host based simulation of the MIDIbox KB velocity measurement
+ *
+ * Compiles the original modules/keyboard/keyboard.c against a virtual
+ * SRIO scan:
+ *   - each scan selects the next row via KEYBOARD_SRIO_ServicePrepare(),
+ *     latches the DIN values of the previously selected row and calls
+ *     KEYBOARD_SRIO_ServiceFinish() at the end of the transfer
+ *   - the scan period and an optional random delay of the scan restart
+ *     (interrupt latency) can be changed from command line
+ *   - KEYBOARD_Periodic_1mS() is called each mS
+ *
+ * Keys are played with random break->make travel times, the velocity
+ * which is sent by the keyboard handler is compared against the velocity
+ * of the real travel time.
+ *
+ * With -l the uS timestamp is replaced by a scan counter which is
+ * multiplied by KEYBOARD_DELAY_UNIT_US, this corresponds to the previous
+ * implementation which counted scans.
+ *
+ * With -t the task which calls KEYBOARD_Periodic_1mS() is stalled
+ * periodically, so that the event queue overruns. The Note On/Off
+ * sequence of each key is checked for duplicated or missing events.
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <mios32.h>
+#include <keyboard.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Simulation parameters (can be changed from command line)
+/////////////////////////////////////////////////////////////////////////////
+
+static double sim_scan_period_us = 25.0; // DMA transfer + restart of the scan
+static u32    sim_jitter_us = 0;         // max. additional delay of the scan restart
+static u8     sim_num_rows = 8;
+static u32    sim_num_presses = 10000;
+static u32    sim_press_distance_us = 5000;
+static u32    sim_hold_us = 20000;
+static u8     sim_legacy = 0;
+static u32    sim_stall_ms = 0;          // task stalled for this time...
+static u32    sim_stall_period_ms = 250; // ...within this period
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Virtual clock and SRIO
+/////////////////////////////////////////////////////////////////////////////
+
+static double sim_time_us;
+static u32 sim_scan_ctr;
+
+static u8 dout_sr[2];
+static u16 active_selection; // DOUT value which has been shifted out with the last scan
+static u8 din_sr[2];
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Played keys
+/////////////////////////////////////////////////////////////////////////////
+
+#define SIM_MAX_KEYS 128
+
+typedef struct {
+  double t_break_on;
+  double t_make_on;
+  double t_make_off;
+  double t_break_off;
+  int expected_velocity;
+  int velocity;
+} sim_press_t;
+
+static sim_press_t *presses;
+static int key_press[SIM_MAX_KEYS]; // currently played press of the key, -1 if none
+static u32 num_keys;
+
+static u8  note_on[SIM_MAX_KEYS];
+static u32 num_note_on;
+static u32 num_note_off;
+static u32 dup_note_on;
+static u32 dup_note_off;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stubs
+/////////////////////////////////////////////////////////////////////////////
+
+u8 MIOS32_SRIO_ScanNumGet(void)
+{
+  return 2;
+}
+
+s32 MIOS32_DIN_SRGet(u32 sr)
+{
+  return (sr < 2) ? din_sr[sr] : 0xff;
+}
+
+s32 MIOS32_DIN_SRChangedGetAndClear(u32 sr, u8 mask)
+{
+  return 0;
+}
+
+s32 MIOS32_DOUT_SRSet(u32 sr, u8 value)
+{
+  if( sr < 2 )
+    dout_sr[sr] = value;
+  return 0;
+}
+
+s32 MIOS32_TIMESTAMP_Get(void)
+{
+  return (u32)(sim_time_us / 1000);
+}
+
+u32 MIOS32_TIMESTAMP_Get_uS(void)
+{
+  if( sim_legacy )
+    return sim_scan_ctr * KEYBOARD_DELAY_UNIT_US;
+
+  return (u32)sim_time_us;
+}
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Key <-> matrix mapping like in KEYBOARD_NotifyToggle()
+/////////////////////////////////////////////////////////////////////////////
+
+static void SIM_KeyPos(u32 key, u8 *row_make, u8 *column)
+{
+  u32 keys_per_half = 4 * sim_num_rows; // 8 keys per row pair
+
+  if( key < keys_per_half ) {
+    *column = key % 8;
+    *row_make = 2 * (key / 8);
+  } else {
+    *column = 8 + ((key - keys_per_half) % 8);
+    *row_make = 2 * ((key - keys_per_half) / 8);
+  }
+}
+
+static u8 SIM_ContactActive(u32 key, u8 break_contact)
+{
+  int ix = key_press[key];
+  if( ix < 0 )
+    return 0;
+
+  sim_press_t *p = &presses[ix];
+  if( break_contact )
+    return sim_time_us >= p->t_break_on && sim_time_us < p->t_break_off;
+  return sim_time_us >= p->t_make_on && sim_time_us < p->t_make_off;
+}
+
+// DIN values of the selected row (active contact = 0)
+static void SIM_LatchDin(void)
+{
+  u16 value = 0xffff;
+  int row;
+
+  for(row=0; row<sim_num_rows; ++row)
+    if( !(active_selection & (1 << row)) )
+      break;
+
+  if( row < sim_num_rows ) {
+    u32 key;
+    for(key=0; key<num_keys; ++key) {
+      u8 row_make, column;
+      SIM_KeyPos(key, &row_make, &column);
+      if( (row & ~1) == row_make && SIM_ContactActive(key, row & 1) )
+	value &= ~(1 << column);
+    }
+  }
+
+  din_sr[0] = value & 0xff;
+  din_sr[1] = value >> 8;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Note hook (called from KEYBOARD_NotifyToggle())
+/////////////////////////////////////////////////////////////////////////////
+
+s32 SIM_NotifyToggle(u8 kb, u8 note_number, u8 velocity)
+{
+  int key = note_number - keyboard_config[kb].note_offset;
+
+  if( key < 0 || key >= SIM_MAX_KEYS )
+    return 0;
+
+  // check the Note On/Off sequence
+  if( velocity ) {
+    ++num_note_on;
+    if( note_on[key] )
+      ++dup_note_on;
+    note_on[key] = 1;
+  } else {
+    ++num_note_off;
+    if( !note_on[key] )
+      ++dup_note_off;
+    note_on[key] = 0;
+  }
+
+  if( velocity && key >= 0 && key < SIM_MAX_KEYS && key_press[key] >= 0 ) {
+    sim_press_t *p = &presses[key_press[key]];
+    if( p->velocity < 0 )
+      p->velocity = velocity;
+  }
+
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Same formula like KEYBOARD_GetVelocity(), but with the real delay
+/////////////////////////////////////////////////////////////////////////////
+
+static int SIM_ExpectedVelocity(double travel_us, keyboard_config_t *kc)
+{
+  double delay = travel_us / KEYBOARD_DELAY_UNIT_US;
+  int velocity = 127;
+
+  if( delay > kc->delay_fastest ) {
+    velocity = 127 - (int)(((delay - kc->delay_fastest) * 127) / (kc->delay_slowest - kc->delay_fastest));
+    if( velocity < 1 )
+      velocity = 1;
+    if( velocity > 127 )
+      velocity = 127;
+  }
+
+  return velocity;
+}
+
+
+static inline unsigned long long SIM_ClockNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+  int opt;
+
+  while( (opt=getopt(argc, argv, "s:j:r:n:lt:")) != -1 ) {
+    switch( opt ) {
+    case 's': sim_scan_period_us = atof(optarg); break;
+    case 'j': sim_jitter_us = atoi(optarg); break;
+    case 'r': sim_num_rows = atoi(optarg); break;
+    case 'n': sim_num_presses = atoi(optarg); break;
+    case 'l': sim_legacy = 1; break;
+    case 't': sim_stall_ms = atoi(optarg); break;
+    default:
+      fprintf(stderr, "Usage: %s [-s scan_period_us] [-j scan_jitter_us] [-r rows (2..16)] [-n presses] [-l] [-t stall_ms]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if( sim_stall_ms >= sim_stall_period_ms ) {
+    fprintf(stderr, "stall time must be less than %u mS!\n", sim_stall_period_ms);
+    return 1;
+  }
+
+  if( sim_num_rows < 2 || sim_num_rows > 16 || (sim_num_rows & 1) ) {
+    fprintf(stderr, "number of rows must be even and in the range 2..16!\n");
+    return 1;
+  }
+
+  srand(1);
+
+  // configure the keyboard like a MIDIbox KB with 2 DOUT and 2 DIN SRs
+  KEYBOARD_Init(0);
+  keyboard_config_t *kc = &keyboard_config[0];
+  kc->note_offset = 0;
+  kc->num_rows = sim_num_rows;
+  kc->din_key_offset = 4 * sim_num_rows;
+  kc->verbose_level = 0;
+  KEYBOARD_Init(1);
+
+  num_keys = 8 * sim_num_rows;
+  if( num_keys > SIM_MAX_KEYS )
+    num_keys = SIM_MAX_KEYS;
+
+  {
+    int key;
+    for(key=0; key<SIM_MAX_KEYS; ++key)
+      key_press[key] = -1;
+  }
+
+  // create the key presses: keys are played one after another with overlapping notes,
+  // travel time between break and make uniformly distributed over the velocity range
+  presses = calloc(sim_num_presses, sizeof(sim_press_t));
+  {
+    u32 i;
+    double travel_min = kc->delay_fastest * KEYBOARD_DELAY_UNIT_US;
+    double travel_max = kc->delay_slowest * KEYBOARD_DELAY_UNIT_US;
+
+    for(i=0; i<sim_num_presses; ++i) {
+      sim_press_t *p = &presses[i];
+      double travel = travel_min + (travel_max - travel_min) * ((double)rand() / RAND_MAX);
+
+      p->t_break_on = 10000.0 + (double)i * sim_press_distance_us + (rand() % 1000);
+      p->t_make_on = p->t_break_on + travel;
+      p->t_make_off = p->t_make_on + sim_hold_us;
+      p->t_break_off = p->t_make_off + travel;
+      p->expected_velocity = SIM_ExpectedVelocity(travel, kc);
+      p->velocity = -1;
+    }
+  }
+
+  printf("Keyboard velocity simulation: %s timestamps\n", sim_legacy ? "scan counter" : "uS");
+  printf("%d rows, scan period %.1f uS + up to %u uS restart delay, delay unit %d uS, %u key presses\n",
+	 sim_num_rows, sim_scan_period_us, sim_jitter_us, KEYBOARD_DELAY_UNIT_US, sim_num_presses);
+  if( sim_stall_ms )
+    printf("task stalled for %u mS every %u mS\n", sim_stall_ms, sim_stall_period_ms);
+
+  // run the scan
+  double end_time_us = presses[sim_num_presses-1].t_break_off + 100000.0;
+  if( sim_stall_ms )
+    end_time_us += sim_stall_period_ms * 1000.0; // ensure that the last stall is over
+  double next_periodic_us = 1000.0;
+  u32 next_press = 0;
+  unsigned long long finish_ns = 0, periodic_ns = 0;
+  u32 num_scans = 0, num_periodic = 0;
+
+  active_selection = 0xffff;
+  sim_time_us = 0;
+  sim_scan_ctr = 0;
+
+  while( sim_time_us < end_time_us ) {
+    // assign new key presses
+    while( next_press < sim_num_presses && presses[next_press].t_break_on <= sim_time_us + sim_scan_period_us ) {
+      u32 key = next_press % num_keys;
+      key_press[key] = next_press;
+      ++next_press;
+    }
+
+    // scan start: DIN values of previous selection are latched, new selection is shifted out
+    ++sim_scan_ctr;
+    KEYBOARD_SRIO_ServicePrepare();
+    SIM_LatchDin();
+    active_selection = dout_sr[0] | ((u16)((sim_num_rows <= 8) ? dout_sr[0] : dout_sr[1]) << 8);
+
+    // end of DMA transfer
+    sim_time_us += sim_scan_period_us;
+    {
+      unsigned long long t = SIM_ClockNs();
+      KEYBOARD_SRIO_ServiceFinish();
+      finish_ns += SIM_ClockNs() - t;
+      ++num_scans;
+    }
+
+    // optional delay until the scan is restarted
+    if( sim_jitter_us )
+      sim_time_us += rand() % (sim_jitter_us + 1);
+
+    // task
+    while( sim_time_us >= next_periodic_us ) {
+      if( sim_stall_ms && ((u32)(next_periodic_us / 1000.0) % sim_stall_period_ms) < sim_stall_ms ) {
+	next_periodic_us += 1000.0;
+	continue;
+      }
+
+      unsigned long long t = SIM_ClockNs();
+      KEYBOARD_Periodic_1mS();
+      periodic_ns += SIM_ClockNs() - t;
+      ++num_periodic;
+      next_periodic_us += 1000.0;
+    }
+  }
+
+  // evaluate
+  {
+    u32 i;
+    u32 missed = 0;
+    u32 num = 0;
+    int max_error = 0;
+    double sum_abs_error = 0.0;
+    double sum_error = 0.0;
+
+    for(i=0; i<sim_num_presses; ++i) {
+      sim_press_t *p = &presses[i];
+      if( p->velocity < 0 ) {
+	++missed;
+	continue;
+      }
+
+      int error = p->velocity - p->expected_velocity;
+      sum_error += error;
+      sum_abs_error += abs(error);
+      if( abs(error) > abs(max_error) )
+	max_error = error;
+      ++num;
+    }
+
+    if( num )
+      printf("Velocity: error mean=%+6.2f mean abs=%5.2f max=%+4d, %u of %u notes missed\n",
+	     sum_error / num, sum_abs_error / num, max_error, missed, sim_num_presses);
+    else
+      printf("Velocity: no notes received!\n");
+    printf("Queue overruns: %u\n", KEYBOARD_EventQueueOverrunsGet());
+
+    u32 stuck = 0;
+    for(i=0; i<SIM_MAX_KEYS; ++i)
+      if( note_on[i] )
+	++stuck;
+    printf("Notes: %u On, %u Off, %u duplicated On, %u duplicated Off, %u hanging\n",
+	   num_note_on, num_note_off, dup_note_on, dup_note_off, stuck);
+    printf("Host CPU: KEYBOARD_SRIO_ServiceFinish %.1f nS/scan, KEYBOARD_Periodic_1mS %.1f nS/call\n",
+	   num_scans ? (double)finish_ns / num_scans : 0.0,
+	   num_periodic ? (double)periodic_ns / num_periodic : 0.0);
+  }
+
+  free(presses);
+
+  return 0;
+}
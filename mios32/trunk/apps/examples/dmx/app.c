@@ -60,6 +60,7 @@ void APP_Background(void)
 
   MIOS32_LCD_FontInit((u8 *)GLCD_FONT_FADERS);
 	u8 f,g;
+	u8 dmx_changed;
 	for (f=0;f<2;f++)
 	{
 		MIOS32_LCD_GCursorSet(0, (f*16)+16);
@@ -78,6 +79,7 @@ void APP_Background(void)
   // endless loop
   while( 1 )
 	{
+		dmx_changed=0;
 		for (f=0;f<24;f++)
 		{
 			if (f<12) {
@@ -89,6 +91,7 @@ void APP_Background(void)
 					MIOS32_LCD_FontInit((u8 *)GLCD_FONT_NORMAL);
 					int q=(((banka[f]*mastera)>>8)|((bankb[f]*(u8)~masterb)>>8));
 					DMX_SetChannel(f,(u8)q);
+					dmx_changed=1;
 					//MIOS32_MIDI_SendDebugMessage("Channel: %d = %d\n",f,(u8)q);
 
 					
@@ -102,6 +105,7 @@ void APP_Background(void)
 					MIOS32_LCD_FontInit((u8 *)GLCD_FONT_NORMAL);
 					int q=(((banka[f-12]*mastera)>>8)|((bankb[f-12]*(u8)~masterb)>>8));
 					DMX_SetChannel(f-12,(u8)q);
+					dmx_changed=1;
 					//MIOS32_MIDI_SendDebugMessage("Channel: %d = %d\n",f-12,(u8)q);
 
 				}
@@ -120,10 +124,13 @@ void APP_Background(void)
 			for (g=0;g<12;g++) {
 				int q=(((banka[g]*mastera)>>8)|((bankb[g]*(u8)~masterb)>>8));
 				DMX_SetChannel(g,(u8)q);
+				dmx_changed=1;
 				//if (g<4)
 				//	MIOS32_MIDI_SendDebugMessage("MASTERA=%d MASTERB=%d CHANNEL%d=%d\n",mastera,masterb,g,(u8)q);
 			}
 		}
+		if (dmx_changed)
+			DMX_Update(); // All changes are sent with the next frame.
 	}
 }
 
@@ -154,9 +154,10 @@ void APP_Init(void)
 	xTaskCreate(TASK_CHASE, (signed portCHAR *)"CHASE", configMINIMAL_STACK_SIZE, NULL, PRIORITY_TASK_CHASE, NULL);
 }
 
-void Check_Faders(void)
+u8 Check_Faders(void)
 {
 	u8 f;
+	u8 changed=0;
 	for (f=0;f<24;f++)
 	{
 		if (f<12) {
@@ -164,6 +165,7 @@ void Check_Faders(void)
 				banka[f]=Faders[f].value;
 				int q=(((banka[f]*mastera)/255)|((bankb[f]*(u8)~masterb)/255));
 				DMX_SetChannel(f,(u8)q);
+				changed=1;
 				//MIOS32_MIDI_SendDebugMessage("Channel: %d = %d (Fader: %d = %d)\n",f,(u8)q,f,banka[f]);
 			}
 		} else if (f>=12){
@@ -171,15 +173,18 @@ void Check_Faders(void)
 				bankb[f-12]=Faders[f].value;
 				int q=(((banka[f-12]*mastera)/255)|((bankb[f-12]*(u8)~masterb)/255));
 				DMX_SetChannel(f-12,(u8)q);
+				changed=1;
 				//MIOS32_MIDI_SendDebugMessage("Channel: %d = %d (Fader: %d = %d)\n",f,(u8)q,f,bankb[f-12]);
 			}
 		}
 	}
+	return changed;
 }
 
-void Check_Submasters(void)
+u8 Check_Submasters(void)
 {
 	u8 f;
+	u8 changed=0;
 	for (f=0;f<24;f++)
 	{
 		if (f<12) {
@@ -187,6 +192,7 @@ void Check_Submasters(void)
 				banka[f]=Faders[f].value;
 				int q=(((banka[f]*mastera)>>8)|((bankb[f]*(u8)~masterb)>>8));
 				DMX_SetChannel(f,(u8)q);
+				changed=1;
 				//MIOS32_MIDI_SendDebugMessage("Channel: %d = %d\n",f,(u8)q);
 			}
 		} else if (f>=12){
@@ -194,10 +200,12 @@ void Check_Submasters(void)
 				bankb[f-12]=Faders[f].value;
 				int q=(((banka[f-12]*mastera)>>8)|((bankb[f-12]*(u8)~masterb)>>8));
 				DMX_SetChannel(f-12,(u8)q);
+				changed=1;
 				//MIOS32_MIDI_SendDebugMessage("Channel: %d = %d\n",f-12,(u8)q);
 			}
 		}
 	}
+	return changed;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -207,17 +215,19 @@ void APP_Background(void)
 {
 	u32 g;
 	u8 temp_mastera, temp_masterb;
+	u8 dmx_changed;
 	
 	// endless loop
 	while( 1 )
 	{
 		UW_Run();	// Do any outstanding window function.
+		dmx_changed=0;
 		if (current_state==FADER_VIEW) {
-			Check_Faders(); // Scan all of the faders and update the DMX value if faders have moved.
+			dmx_changed=Check_Faders(); // Scan all of the faders and update the DMX value if faders have moved.
 			temp_mastera=Faders[24].value;
 			temp_masterb=Faders[25].value;
 		} else if (current_state==SUBMASTER_VIEW) {
-			Check_Submasters(); // Scan all of the faders and update the DMX value if faders have moved.
+			dmx_changed=Check_Submasters(); // Scan all of the faders and update the DMX value if faders have moved.
 			temp_mastera=Submasters[24].value;
 			temp_masterb=Submasters[25].value;
 		}
@@ -229,10 +239,14 @@ void APP_Background(void)
 			MIOS32_MIDI_SendDebugMessage("Master A = %d  Master B = %d\n",mastera,(u8)~masterb);
 			for(g=0; g<12; g++) {
 				u8 q=(((banka[g]*mastera)>>8)|((bankb[g]*(u8)~masterb)>>8));
-				if (DMX_GetChannel(g) != q)
+				if (DMX_GetChannel(g) != q) {
 					DMX_SetChannel(g,(u8)q);
+					dmx_changed=1;
+				}
 			}
 		}
+		if (dmx_changed)
+			DMX_Update(); // All changes are sent with the next frame.
 	}
 }
 
@@ -53,9 +53,11 @@ void MbCv::init(u8 _cvNum, MbCvClock *_mbCvClockPtr)
 
 
 /////////////////////////////////////////////////////////////////////////////
-// Sound Engine Update Cycle
+// Sound Engine Update Cycle, first phase
+// The LFO and ENV states are located in blocks which are shared by all CV channels,
+// the modulator index is derived from the CV channel number
 /////////////////////////////////////////////////////////////////////////////
-bool MbCv::tick(const u8 &updateSpeedFactor)
+void MbCv::tickPrepare(const u8 &updateSpeedFactor, MbCvLfoBlock &lfoBlock, MbCvEnvBlock &envBlock)
 {
     // external trigger
     {
@@ -98,9 +100,7 @@ bool MbCv::tick(const u8 &updateSpeedFactor)
             l->lfoAmplitudeModulation =  mbCvMod.takeDstValue(MBCV_MOD_DST_LFO1_A + lfo);
             l->lfoRateModulation = mbCvMod.takeDstValue(MBCV_MOD_DST_LFO1_R + lfo);
 
-            if( l->tick(updateSpeedFactor) ) {
-                // trigger[MBCV_TRG_L1P+lfo];
-            }
+            l->tickPrepare(lfoBlock, cvNum*CV_SE_LFO_NUM + lfo, updateSpeedFactor);
         }
     }
 
@@ -114,9 +114,7 @@ bool MbCv::tick(const u8 &updateSpeedFactor)
             e->envAmplitudeModulation = mbCvMod.takeDstValue(MBCV_MOD_DST_ENV1_A);
             e->envRateModulation = mbCvMod.takeDstValue(MBCV_MOD_DST_ENV1_R);
 
-            if( e->tick(updateSpeedFactor) ) {
-                // trigger[MBCV_TRG_E1S];
-            }
+            e->tickPrepare(envBlock, cvNum*CV_SE_ENV_NUM + 0, updateSpeedFactor);
         }
     }
 
@@ -129,7 +127,42 @@ bool MbCv::tick(const u8 &updateSpeedFactor)
             e->envAmplitudeModulation = mbCvMod.takeDstValue(MBCV_MOD_DST_ENV2_A);
             e->envRateModulation = mbCvMod.takeDstValue(MBCV_MOD_DST_ENV2_R);
 
-            if( e->tick(updateSpeedFactor) ) {
+            e->tickPrepare(envBlock, cvNum*CV_SE_ENV_NUM + 1, updateSpeedFactor);
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sound Engine Update Cycle, second phase
+// (after MbCvLfoBlock::tick() and MbCvEnvBlock::tick())
+/////////////////////////////////////////////////////////////////////////////
+bool MbCv::tickFinish(const u8 &updateSpeedFactor, MbCvLfoBlock &lfoBlock, MbCvEnvBlock &envBlock)
+{
+    // LFOs
+    {
+        MbCvLfo *l = mbCvLfo.first();
+        for(int lfo=0; lfo < mbCvLfo.size; ++lfo, ++l) {
+            if( l->tickFinish(lfoBlock, cvNum*CV_SE_LFO_NUM + lfo) ) {
+                // trigger[MBCV_TRG_L1P+lfo];
+            }
+        }
+    }
+
+    // ENVs
+    {
+        MbCvEnv *e = mbCvEnv1.first();
+        for(int env=0; env < mbCvEnv1.size; ++env, ++e) {
+            if( e->tickFinish(envBlock, cvNum*CV_SE_ENV_NUM + 0) ) {
+                // trigger[MBCV_TRG_E1S];
+            }
+        }
+    }
+
+    {
+        MbCvEnvMulti *e = mbCvEnv2.first();
+        for(int env=0; env < mbCvEnv2.size; ++env, ++e) {
+            if( e->tickFinish(envBlock, cvNum*CV_SE_ENV_NUM + 1) ) {
                 // trigger[MBCV_TRG_E2S];
             }
         }
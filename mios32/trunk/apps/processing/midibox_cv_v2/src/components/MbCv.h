@@ -45,9 +45,13 @@ public:
     // initializes the sound engines
     void init(u8 _cvNum, MbCvClock *_mbCvClockPtr);
 
-    // sound engine update cycle
+    // sound engine update cycle, split into two phases:
+    // tickPrepare() handles the inputs of the modulators, thereafter
+    // the LFO and ENV blocks of all CV channels are updated at once, and
+    // tickFinish() handles modulation matrix and voice
     // returns true if CV registers have to be updated
-    bool tick(const u8 &updateSpeedFactor);
+    void tickPrepare(const u8 &updateSpeedFactor, MbCvLfoBlock &lfoBlock, MbCvEnvBlock &envBlock);
+    bool tickFinish(const u8 &updateSpeedFactor, MbCvLfoBlock &lfoBlock, MbCvEnvBlock &envBlock);
 
     // MIDI access
     void midiReceive(mios32_midi_port_t port, mios32_midi_package_t midi_package);
@@ -66,7 +70,7 @@ public:
     MbCvVoice mbCvVoice;
 
     // modulators
-    array<MbCvLfo, 2> mbCvLfo;
+    array<MbCvLfo, CV_SE_LFO_NUM> mbCvLfo;
     array<MbCvEnv, 1> mbCvEnv1;
     array<MbCvEnvMulti, 1> mbCvEnv2;
     MbCvArp mbCvArp;
@@ -15,7 +15,6 @@
 #include <string.h>
 #include "MbCvEnv.h"
 #include "MbCvTables.h"
-#include "CapChargeCurve.h"
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -57,30 +56,32 @@ void MbCvEnv::init(void)
 
 
 /////////////////////////////////////////////////////////////////////////////
-// Envelope handler
+// Envelope handler, first phase: state handling and segment setup
 /////////////////////////////////////////////////////////////////////////////
-bool MbCvEnv::tick(const u8 &updateSpeedFactor)
+void MbCvEnv::tickPrepare(MbCvEnvBlock &block, const u8 &ix, const u8 &updateSpeedFactor)
 {
-    bool sustainPhase = false; // will be the return value
+    prepareReset(block, ix);
+    block.envFlags[ix] = 0;
+
     if( restartReq ) {
         restartReq = false;
         envState = MBCV_ENV_STATE_ATTACK;
         envDelayCtr = envDelay ? 1 : 0;
-        envInitialLevel = envWaveOut;
-        envCtr = 0;
+        envInitialLevel = block.envWaveOut[ix];
+        block.envCtr[ix] = 0;
     }
 
     if( releaseReq ) {        
         releaseReq = false;
         envState = MBCV_ENV_STATE_RELEASE;
-        envInitialLevel = envWaveOut;
-        envCtr = 0;
+        envInitialLevel = block.envWaveOut[ix];
+        block.envCtr[ix] = 0;
     }
 
     // if clock sync enabled: only increment on each 16th clock event
     if( envModeClkSync && !syncClockReq ) {
         if( envState == MBCV_ENV_STATE_IDLE )
-            return false; // nothing to do
+            return; // nothing to do
     } else {
         syncClockReq = false;
 
@@ -92,7 +93,7 @@ bool MbCvEnv::tick(const u8 &updateSpeedFactor)
                     envDelayCtr = 0; // delay passed
                 else {
                     envDelayCtr = newDelayCtr; // delay not passed
-                    return false; // no error
+                    return; // no error
                 }
             }
 
@@ -101,8 +102,7 @@ bool MbCvEnv::tick(const u8 &updateSpeedFactor)
             if( attack > 255 ) attack = 255; else if( attack < 0 ) attack = 0;
   
             u16 incrementer = mbCvEnvTable[attack] / (envModeFast ? 1 : updateSpeedFactor);
-            if( step(envInitialLevel, 0xffff, incrementer, false) )
-                envState = MBCV_ENV_STATE_DECAY;
+            prepareStep(block, ix, envInitialLevel, 0xffff, incrementer, false);
         } break;
   
         case MBCV_ENV_STATE_DECAY: {
@@ -112,22 +112,14 @@ bool MbCvEnv::tick(const u8 &updateSpeedFactor)
             if( decay > 255 ) decay = 255; else if( decay < 0 ) decay = 0;
 
             u16 incrementer = mbCvEnvTable[decay] / (envModeFast ? 1 : updateSpeedFactor);
-            if( step(0xffff, envSustain << 8, incrementer, false) ) {
-                envState = envModeOneshot ? MBCV_ENV_STATE_SUSTAIN : MBCV_ENV_STATE_RELEASE;
-  
-                // propagate sustain phase to trigger matrix
-                sustainPhase = true;
-
-                envInitialLevel = envWaveOut;
-                envCtr = 0;
-            }
+            prepareStep(block, ix, 0xffff, envSustain << 8, incrementer, false);
         } break;
   
         case MBCV_ENV_STATE_SUSTAIN:
             // always update sustain level
-            envWaveOut = envSustain << 8;
-            envInitialLevel = envWaveOut;
-            envCtr = 0;
+            block.envWaveOut[ix] = envSustain << 8;
+            envInitialLevel = block.envWaveOut[ix];
+            block.envCtr[ix] = 0;
             break;
   
         case MBCV_ENV_STATE_RELEASE: {
@@ -137,17 +129,11 @@ bool MbCvEnv::tick(const u8 &updateSpeedFactor)
             if( release > 255 ) release = 255; else if( release < 0 ) release = 0;
 
             u16 incrementer = mbCvEnvTable[release] / (envModeFast ? 1 : updateSpeedFactor);
-            if( step(envInitialLevel, 0x0000, incrementer, false) ) {
-                if( envModeOneshot ) {
-                    envState = MBCV_ENV_STATE_IDLE;
-                } else {
-                    envState = MBCV_ENV_STATE_ATTACK;
-                }
-            }
+            prepareStep(block, ix, envInitialLevel, 0x0000, incrementer, false);
         } break;
   
         default: // like MBCV_ENV_STATE_IDLE
-            return false; // nothing to do...
+            return; // nothing to do...
         }
     }
 
@@ -155,12 +141,58 @@ bool MbCvEnv::tick(const u8 &updateSpeedFactor)
     s32 amplitude = envAmplitude + (envAmplitudeModulation / 512);
     if( amplitude > 127 ) amplitude = 127; else if( amplitude < -128 ) amplitude = -128;
 
-    // final output value
+    // final output value will be calculated by MbCvEnvBlock::tick():
     //envOut = ((s32)(envWaveOut / 2) * (s32)amplitude) / 128;
     // multiplied by *2 to allow envelopes over full range
-    envOut = ((s32)envWaveOut * (s32)amplitude) / 128;
+    //envOut = ((s32)envWaveOut * (s32)amplitude) / 128;
+    block.envFlags[ix] |= MBCV_ENV_BLOCK_FLAG_OUTPUT;
+    block.envAmplitude[ix] = amplitude;
+    block.envOutScale[ix] = 1;
+    block.envOutOffset[ix] = 0;
+}
 
-    accentReq = false;
+
+/////////////////////////////////////////////////////////////////////////////
+// Envelope handler, second phase: state transitions and output value
+/////////////////////////////////////////////////////////////////////////////
+bool MbCvEnv::tickFinish(MbCvEnvBlock &block, const u8 &ix)
+{
+    bool sustainPhase = false; // will be the return value
+    u8 flags = block.envFlags[ix];
+
+    if( (flags & MBCV_ENV_BLOCK_FLAG_STEP) && block.envStepDone[ix] ) {
+        switch( envState ) {
+        case MBCV_ENV_STATE_ATTACK:
+            envState = MBCV_ENV_STATE_DECAY;
+            break;
+
+        case MBCV_ENV_STATE_DECAY:
+            envState = envModeOneshot ? MBCV_ENV_STATE_SUSTAIN : MBCV_ENV_STATE_RELEASE;
+
+            // propagate sustain phase to trigger matrix
+            sustainPhase = true;
+
+            envInitialLevel = block.envWaveOut[ix];
+            block.envCtr[ix] = 0;
+            break;
+
+        case MBCV_ENV_STATE_RELEASE:
+            if( envModeOneshot ) {
+                envState = MBCV_ENV_STATE_IDLE;
+            } else {
+                envState = MBCV_ENV_STATE_ATTACK;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if( flags & MBCV_ENV_BLOCK_FLAG_OUTPUT ) {
+        envOut = block.envOut[ix];
+        accentReq = false;
+    }
 
     return sustainPhase;
 }
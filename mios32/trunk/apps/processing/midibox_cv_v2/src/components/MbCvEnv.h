@@ -30,8 +30,9 @@ public:
     // ENV init function
     virtual void init(void);
 
-    // ENV handler (returns true when sustain phase reached)
-    virtual bool tick(const u8 &updateSpeedFactor);
+    // ENV handler (see MbCvEnvBase.h)
+    virtual void tickPrepare(MbCvEnvBlock &block, const u8 &ix, const u8 &updateSpeedFactor);
+    virtual bool tickFinish(MbCvEnvBlock &block, const u8 &ix);
 
     // additional input parameters (see also MbCvEnvBase.h)
     u8 envDelay;
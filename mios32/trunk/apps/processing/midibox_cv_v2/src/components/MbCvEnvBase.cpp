@@ -14,7 +14,6 @@
 
 #include "MbCvEnvBase.h"
 #include "MbCvTables.h"
-#include "CapChargeCurve.h"
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -44,6 +43,7 @@ void MbCvEnvBase::init(void)
     restartReq = false;
     releaseReq = false;
     syncClockReq = false;
+    blockResetReq = true;
 
     // clear variables
     envModeClkSync = 0;
@@ -67,8 +67,6 @@ void MbCvEnvBase::init(void)
     envOut = 0;
 
     envState = MBCV_ENV_STATE_IDLE;
-    envCtr = 0;
-    envWaveOut = 0;
     envDelayCtr = 0;
 }
 
@@ -76,7 +74,13 @@ void MbCvEnvBase::init(void)
 /////////////////////////////////////////////////////////////////////////////
 // Envelope handler
 /////////////////////////////////////////////////////////////////////////////
-bool MbCvEnvBase::tick(const u8 &updateSpeedFactor)
+void MbCvEnvBase::tickPrepare(MbCvEnvBlock &block, const u8 &ix, const u8 &updateSpeedFactor)
+{
+    prepareReset(block, ix);
+    block.envFlags[ix] = 0;
+}
+
+bool MbCvEnvBase::tickFinish(MbCvEnvBlock &block, const u8 &ix)
 {
     envOut = 0;
 
@@ -84,58 +88,30 @@ bool MbCvEnvBase::tick(const u8 &updateSpeedFactor)
 }
 
 
-
 /////////////////////////////////////////////////////////////////////////////
-// Calculates a step
+// Clears the state in the ENV block after init()
 /////////////////////////////////////////////////////////////////////////////
-bool MbCvEnvBase::step(const u16& startValue, const u16& targetValue, const u16& incrementer, const bool& constantDelay)
+void MbCvEnvBase::prepareReset(MbCvEnvBlock &block, const u8 &ix)
 {
-    bool curveInverted = targetValue < startValue;
-
-    if( !constantDelay &&
-        ((!curveInverted && startValue >= targetValue) || ( curveInverted && startValue <= targetValue)) ) {
-        envCtr = 0xffff; // next stage
-    } else {
-        s32 newCtr = (s32)envCtr + incrementer;
-        if( newCtr < 0xffff )
-            envCtr = newCtr;
-        else
-            envCtr = 0xffff; // next stage
-    }
-
-
-    // Waveshape depending on envCurve
-    u16 curveValue = envCtr; // MBCV_ENV_CURVE_LINEAR and other unimplemented
-    u8 curve = curveInverted ? envCurveNeg : envCurvePos;
-    switch( curve ) {
-    case MBCV_ENV_CURVE_EXP1:
-        curveValue = capChargeCurve1[curveValue / (65536 / CAP_CHARGE_CURVE_STEPS)];
-        break;
-    case MBCV_ENV_CURVE_EXP1_INV:
-        curveValue = 65535 - capChargeCurve1[(65535 - curveValue) / (65536 / CAP_CHARGE_CURVE_STEPS)];
-        break;
-    case MBCV_ENV_CURVE_EXP2:
-        curveValue = capChargeCurve2[curveValue / (65536 / CAP_CHARGE_CURVE_STEPS)];
-        break;
-    case MBCV_ENV_CURVE_EXP2_INV:
-        curveValue = 65535 - capChargeCurve2[(65535 - curveValue) / (65536 / CAP_CHARGE_CURVE_STEPS)];
-        break;
+    if( blockResetReq ) {
+        blockResetReq = false;
+        block.envCtr[ix] = 0;
+        block.envWaveOut[ix] = 0;
+        block.envOut[ix] = 0;
     }
+}
 
-    // scale over range
-    if( curveInverted ) {
-        u32 scaledValue = ((startValue - targetValue + 1) * (u32)(65535 - curveValue)) >> 16;
-        envWaveOut = targetValue + scaledValue;
-    } else {
-        u32 scaledValue = ((targetValue - startValue + 1) * (u32)curveValue) >> 16;
-        envWaveOut = startValue + scaledValue;
-    }
 
-    // next stage?
-    if( envCtr == 0xffff ) {
-        envCtr = 0;
-        return true;
-    }
+/////////////////////////////////////////////////////////////////////////////
+// Sets up a step, it will be calculated by MbCvEnvBlock::tick()
+/////////////////////////////////////////////////////////////////////////////
+void MbCvEnvBase::prepareStep(MbCvEnvBlock &block, const u8 &ix, const u16& startValue, const u16& targetValue, const u16& incrementer, const bool& constantDelay)
+{
+    bool curveInverted = targetValue < startValue;
 
-    return false; // continue with current stage
+    block.envFlags[ix] |= MBCV_ENV_BLOCK_FLAG_STEP | (constantDelay ? MBCV_ENV_BLOCK_FLAG_CONSTANT_DELAY : 0);
+    block.envCurve[ix] = curveInverted ? envCurveNeg : envCurvePos;
+    block.envStartValue[ix] = startValue;
+    block.envTargetValue[ix] = targetValue;
+    block.envInc[ix] = incrementer;
 }
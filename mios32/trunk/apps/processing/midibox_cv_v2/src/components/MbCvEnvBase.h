@@ -17,6 +17,7 @@
 
 #include <mios32.h>
 #include "MbCvStructs.h"
+#include "MbCvEnvBlock.h"
 
 
 class MbCvEnvBase
@@ -31,8 +32,12 @@ public:
     // ENV init function
     virtual void init(void);
 
-    // ENV handler (returns true when sustain phase reached)
-    virtual bool tick(const u8 &updateSpeedFactor);
+    // ENV handler, split into two phases:
+    // tickPrepare() sets up the current segment in the ENV block, and
+    // tickFinish() handles the state transitions after MbCvEnvBlock::tick()
+    // (returns true when sustain phase reached)
+    virtual void tickPrepare(MbCvEnvBlock &block, const u8 &ix, const u8 &updateSpeedFactor);
+    virtual bool tickFinish(MbCvEnvBlock &block, const u8 &ix);
 
     typedef enum {
         MBCV_ENV_STATE_IDLE = 0,
@@ -85,13 +90,15 @@ public:
 
 
 protected:
-    bool step(const u16& startValue, const u16& targetValue, const u16& incrementer, const bool& constantDelay);
+    void prepareReset(MbCvEnvBlock &block, const u8 &ix);
+    void prepareStep(MbCvEnvBlock &block, const u8 &ix, const u16& startValue, const u16& targetValue, const u16& incrementer, const bool& constantDelay);
 
-    // internal variables
+    // requests to clear the state in the ENV block (set by init())
+    bool blockResetReq;
+
+    // internal variables (counter and wave output are located in the ENV block)
     EnvStateT envState;
 
-    u16 envCtr;
-    u16 envWaveOut;
     u32 envDelayCtr;
 
 };
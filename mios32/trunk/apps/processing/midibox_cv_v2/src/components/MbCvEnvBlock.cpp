@@ -0,0 +1,131 @@
+/* -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*- */
+// $Id$
+/*
+ * MIDIbox CV ENV Block
+ * Segment state of all envelopes, stored as structure-of-arrays
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2015 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include <string.h>
+#include "MbCvEnvBlock.h"
+#include "MbCvEnvBase.h"
+#include "CapChargeCurve.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructor
+/////////////////////////////////////////////////////////////////////////////
+MbCvEnvBlock::MbCvEnvBlock()
+{
+    init();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Destructor
+/////////////////////////////////////////////////////////////////////////////
+MbCvEnvBlock::~MbCvEnvBlock()
+{
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Clears all envelopes
+/////////////////////////////////////////////////////////////////////////////
+void MbCvEnvBlock::init(void)
+{
+    memset(envFlags, 0, sizeof(envFlags));
+    memset(envCurve, 0, sizeof(envCurve));
+    memset(envStartValue, 0, sizeof(envStartValue));
+    memset(envTargetValue, 0, sizeof(envTargetValue));
+    memset(envInc, 0, sizeof(envInc));
+    memset(envAmplitude, 0, sizeof(envAmplitude));
+    memset(envOutScale, 0, sizeof(envOutScale));
+    memset(envOutOffset, 0, sizeof(envOutOffset));
+
+    memset(envCtr, 0, sizeof(envCtr));
+    memset(envWaveOut, 0, sizeof(envWaveOut));
+    memset(envStepDone, 0, sizeof(envStepDone));
+    memset(envOut, 0, sizeof(envOut));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Updates all envelopes
+/////////////////////////////////////////////////////////////////////////////
+void MbCvEnvBlock::tick(void)
+{
+    // Segment stage: moves the wave output from start to target value
+    for(int i=0; i<MBCV_ENV_BLOCK_SIZE; ++i) {
+        u8 flags = envFlags[i];
+        envStepDone[i] = 0;
+
+        if( !(flags & MBCV_ENV_BLOCK_FLAG_STEP) )
+            continue;
+
+        u16 startValue = envStartValue[i];
+        u16 targetValue = envTargetValue[i];
+        bool curveInverted = targetValue < startValue;
+
+        u16 ctr;
+        if( !(flags & MBCV_ENV_BLOCK_FLAG_CONSTANT_DELAY) &&
+            ((!curveInverted && startValue >= targetValue) || ( curveInverted && startValue <= targetValue)) ) {
+            ctr = 0xffff; // next stage
+        } else {
+            s32 newCtr = (s32)envCtr[i] + envInc[i];
+            if( newCtr < 0xffff )
+                ctr = newCtr;
+            else
+                ctr = 0xffff; // next stage
+        }
+
+        // Waveshape depending on envCurve
+        u16 curveValue = ctr; // MBCV_ENV_CURVE_LINEAR and other unimplemented
+        switch( envCurve[i] ) {
+        case MbCvEnvBase::MBCV_ENV_CURVE_EXP1:
+            curveValue = capChargeCurve1[curveValue / (65536 / CAP_CHARGE_CURVE_STEPS)];
+            break;
+        case MbCvEnvBase::MBCV_ENV_CURVE_EXP1_INV:
+            curveValue = 65535 - capChargeCurve1[(65535 - curveValue) / (65536 / CAP_CHARGE_CURVE_STEPS)];
+            break;
+        case MbCvEnvBase::MBCV_ENV_CURVE_EXP2:
+            curveValue = capChargeCurve2[curveValue / (65536 / CAP_CHARGE_CURVE_STEPS)];
+            break;
+        case MbCvEnvBase::MBCV_ENV_CURVE_EXP2_INV:
+            curveValue = 65535 - capChargeCurve2[(65535 - curveValue) / (65536 / CAP_CHARGE_CURVE_STEPS)];
+            break;
+        }
+
+        // scale over range
+        if( curveInverted ) {
+            u32 scaledValue = ((startValue - targetValue + 1) * (u32)(65535 - curveValue)) >> 16;
+            envWaveOut[i] = targetValue + scaledValue;
+        } else {
+            u32 scaledValue = ((targetValue - startValue + 1) * (u32)curveValue) >> 16;
+            envWaveOut[i] = startValue + scaledValue;
+        }
+
+        // next stage?
+        if( ctr == 0xffff ) {
+            ctr = 0;
+            envStepDone[i] = 1;
+        }
+
+        envCtr[i] = ctr;
+    }
+
+    // Output stage: scale the wave output by the amplitude
+    for(int i=0; i<MBCV_ENV_BLOCK_SIZE; ++i) {
+        if( envFlags[i] & MBCV_ENV_BLOCK_FLAG_OUTPUT ) {
+            s32 value = (s32)envWaveOut[i] * envOutScale[i] + envOutOffset[i];
+            envOut[i] = (value * (s32)envAmplitude[i]) / 128;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+/* -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*- */
+// $Id$
+/*
+ * MIDIbox CV ENV Block
+ * Segment state of all envelopes, stored as structure-of-arrays
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2015 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _MB_CV_ENV_BLOCK_H
+#define _MB_CV_ENV_BLOCK_H
+
+#include <mios32.h>
+#include "MbCvStructs.h"
+
+// number of envelopes handled by the block
+#define MBCV_ENV_BLOCK_SIZE (CV_SE_NUM * CV_SE_ENV_NUM)
+
+// flags which are set by MbCvEnv*::tickPrepare()
+#define MBCV_ENV_BLOCK_FLAG_STEP           (1 << 0) // process segment
+#define MBCV_ENV_BLOCK_FLAG_CONSTANT_DELAY (1 << 1) // segment takes the full time even if start == target
+#define MBCV_ENV_BLOCK_FLAG_OUTPUT         (1 << 2) // update output value
+
+
+class MbCvEnvBlock
+{
+public:
+    // Constructor
+    MbCvEnvBlock();
+
+    // Destructor
+    ~MbCvEnvBlock();
+
+    // clears all envelopes
+    void init(void);
+
+    // processes the current segment and output stage of all envelopes
+    // the inputs have been prepared with MbCvEnv*::tickPrepare() before
+    void tick(void);
+
+    // inputs (set by MbCvEnv*::tickPrepare())
+    u8  envFlags[MBCV_ENV_BLOCK_SIZE];
+    u8  envCurve[MBCV_ENV_BLOCK_SIZE];       // MbCvEnvBase::EnvCurveT
+    u16 envStartValue[MBCV_ENV_BLOCK_SIZE];
+    u16 envTargetValue[MBCV_ENV_BLOCK_SIZE];
+    u16 envInc[MBCV_ENV_BLOCK_SIZE];
+    s16 envAmplitude[MBCV_ENV_BLOCK_SIZE];   // -128..127 (incl. modulation)
+    s16 envOutScale[MBCV_ENV_BLOCK_SIZE];    // output = ((waveOut * scale + offset) * amplitude) / 128
+    s32 envOutOffset[MBCV_ENV_BLOCK_SIZE];
+
+    // state and outputs
+    u16 envCtr[MBCV_ENV_BLOCK_SIZE];
+    u16 envWaveOut[MBCV_ENV_BLOCK_SIZE];
+    u8  envStepDone[MBCV_ENV_BLOCK_SIZE];    // segment finished
+    s32 envOut[MBCV_ENV_BLOCK_SIZE];
+};
+
+#endif /* _MB_CV_ENV_BLOCK_H */
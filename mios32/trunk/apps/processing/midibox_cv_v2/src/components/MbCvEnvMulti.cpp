@@ -60,23 +60,24 @@ void MbCvEnvMulti::init(void)
 
     envCurrentStep = 0;
 
-    recalc(2);
+    recalc();
 }
 
 
 /////////////////////////////////////////////////////////////////////////////
-// Envelope handler
+// Envelope handler, first phase: state handling and segment setup
 /////////////////////////////////////////////////////////////////////////////
-bool MbCvEnvMulti::tick(const u8 &updateSpeedFactor)
+void MbCvEnvMulti::tickPrepare(MbCvEnvBlock &block, const u8 &ix, const u8 &updateSpeedFactor)
 {
-    bool sustainPhase = false; // will be the return value
+    prepareReset(block, ix);
+    block.envFlags[ix] = 0;
 
     if( restartReq ) {
         restartReq = false;
         envState = MBCV_ENV_STATE_ATTACK;
         envCurrentStep = 0;
-        envCtr = 0;
-        recalc(updateSpeedFactor);
+        block.envCtr[ix] = 0;
+        recalc();
     }
 
     if( releaseReq ) {
@@ -85,15 +86,15 @@ bool MbCvEnvMulti::tick(const u8 &updateSpeedFactor)
 
         if( envSustainStep && envSustainStep <= MBCV_ENV_MULTI_NUM_STEPS ) {
             envCurrentStep = envSustainStep - 1;
-            envCtr = 0;
-            recalc(updateSpeedFactor);
+            block.envCtr[ix] = 0;
+            recalc();
         }
     }
 
     // if clock sync enabled: only increment on each 16th clock event
     if( envModeClkSync && !syncClockReq ) {
         if( envState == MBCV_ENV_STATE_IDLE )
-            return false; // nothing to do
+            return; // nothing to do
     } else {
         syncClockReq = false;
 
@@ -103,31 +104,14 @@ bool MbCvEnvMulti::tick(const u8 &updateSpeedFactor)
             if( sustainStep >= MBCV_ENV_MULTI_NUM_STEPS )
                 sustainStep = MBCV_ENV_MULTI_NUM_STEPS - 1;
 
-            envWaveOut = envLevel[sustainStep] << 8;
+            block.envWaveOut[ix] = envLevel[sustainStep] << 8;
         } else {
             // the rate can be modulated
             s32 rate = envRate + (envRateModulation / 128);
             if( rate > 255 ) rate = 255; else if( rate < 0 ) rate = 0;
 
             u16 incrementer = mbCvEnvTable[rate] / (envModeFast ? 1 : updateSpeedFactor);
-            if( step(envLevel[envCurrentStep] << 8, envLevel[envNextStep] << 8, incrementer, true) ) {
-                envCurrentStep = envNextStep;
-
-                if( (envSustainStep && envCurrentStep == (envSustainStep-1)) ) {
-                    if( envLoopAttack ) {
-                        envState = MBCV_ENV_STATE_ATTACK;
-                        envCurrentStep = envLoopAttack;
-                        recalc(updateSpeedFactor);
-                    } else {
-                        envState = MBCV_ENV_STATE_SUSTAIN;
-  
-                        // propagate sustain phase to trigger matrix
-                        sustainPhase = true;
-                    }
-                } else {
-                    recalc(updateSpeedFactor);
-                }
-            }
+            prepareStep(block, ix, envLevel[envCurrentStep] << 8, envLevel[envNextStep] << 8, incrementer, true);
         }
     }
 
@@ -135,22 +119,61 @@ bool MbCvEnvMulti::tick(const u8 &updateSpeedFactor)
     s32 amplitude = envAmplitude + (envAmplitudeModulation / 512);
     if( amplitude > 127 ) amplitude = 127; else if( amplitude < -128 ) amplitude = -128;
 
-    // final output value
+    // final output value will be calculated by MbCvEnvBlock::tick():
 #if 0
     // unidirectional (for typical ENV behaviour)
-    envOut = ((s32)envWaveOut * (s32)amplitude) / 128;
+    //envOut = ((s32)envWaveOut * (s32)amplitude) / 128;
+    block.envOutScale[ix] = 1;
+    block.envOutOffset[ix] = 0;
 #else
     // better:
     // bidirectional (allows to realize a waveform based LFO)
-    envOut = (((s32)envWaveOut - 32768 + ((s32)envOffset*512)) * (s32)amplitude) / 64;
+    //envOut = (((s32)envWaveOut - 32768 + ((s32)envOffset*512)) * (s32)amplitude) / 64;
+    // (the block divides by 128, therefore the value is doubled)
+    block.envOutScale[ix] = 2;
+    block.envOutOffset[ix] = 2 * (-32768 + ((s32)envOffset*512));
 #endif
+    block.envFlags[ix] |= MBCV_ENV_BLOCK_FLAG_OUTPUT;
+    block.envAmplitude[ix] = amplitude;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Envelope handler, second phase: step transitions and output value
+/////////////////////////////////////////////////////////////////////////////
+bool MbCvEnvMulti::tickFinish(MbCvEnvBlock &block, const u8 &ix)
+{
+    bool sustainPhase = false; // will be the return value
+    u8 flags = block.envFlags[ix];
+
+    if( (flags & MBCV_ENV_BLOCK_FLAG_STEP) && block.envStepDone[ix] ) {
+        envCurrentStep = envNextStep;
+
+        if( (envSustainStep && envCurrentStep == (envSustainStep-1)) ) {
+            if( envLoopAttack ) {
+                envState = MBCV_ENV_STATE_ATTACK;
+                envCurrentStep = envLoopAttack;
+                recalc();
+            } else {
+                envState = MBCV_ENV_STATE_SUSTAIN;
+  
+                // propagate sustain phase to trigger matrix
+                sustainPhase = true;
+            }
+        } else {
+            recalc();
+        }
+    }
+
+    if( flags & MBCV_ENV_BLOCK_FLAG_OUTPUT )
+        envOut = block.envOut[ix];
 
     return sustainPhase;
 }
 
 
 // recalculates envNextStep
-void MbCvEnvMulti::recalc(const u8 &updateSpeedFactor)
+void MbCvEnvMulti::recalc(void)
 {
     envNextStep = envCurrentStep + 1;
 
@@ -34,8 +34,9 @@ public:
     // ENV init function
     virtual void init(void);
 
-    // ENV handler (returns true when sustain phase reached)
-    virtual bool tick(const u8 &updateSpeedFactor);
+    // ENV handler (see MbCvEnvBase.h)
+    virtual void tickPrepare(MbCvEnvBlock &block, const u8 &ix, const u8 &updateSpeedFactor);
+    virtual bool tickFinish(MbCvEnvBlock &block, const u8 &ix);
 
     // additional input parameters (see also MbCvEnvBase.h)
     u8  envLevel[MBCV_ENV_MULTI_NUM_STEPS];
@@ -52,7 +53,7 @@ protected:
     u8  envCurrentStep;
     u8  envNextStep;
 
-    void recalc(const u8 &updateSpeedFactor);
+    void recalc(void);
 };
 
 #endif /* _MB_CV_ENV_MULTI_H */
@@ -125,7 +125,15 @@ bool MbCvEnvironment::tick(void)
 
     // Engines
     for(MbCv *s = mbCv.first(); s != NULL ; s=mbCv.next(s)) {
-        if( s->tick(updateSpeedFactor) )
+        s->tickPrepare(updateSpeedFactor, mbCvLfoBlock, mbCvEnvBlock);
+    }
+
+    // Modulators of all engines
+    mbCvLfoBlock.tick();
+    mbCvEnvBlock.tick();
+
+    for(MbCv *s = mbCv.first(); s != NULL ; s=mbCv.next(s)) {
+        if( s->tickFinish(updateSpeedFactor, mbCvLfoBlock, mbCvEnvBlock) )
             updateRequired = true;
     }
 
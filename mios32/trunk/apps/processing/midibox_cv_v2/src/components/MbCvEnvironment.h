@@ -36,6 +36,11 @@ public:
     // instantiate the MbCv instances
     array<MbCv, CV_SE_NUM> mbCv;
 
+    // LFO and ENV states of all MbCv instances
+    // (structure-of-arrays, updated in a single loop per modulator type)
+    MbCvLfoBlock mbCvLfoBlock;
+    MbCvEnvBlock mbCvEnvBlock;
+
     // CV Output value (will be mapped in MbCvEnvironment::tick() !!!)
     array<u16, CV_SE_NUM> cvOut;
 
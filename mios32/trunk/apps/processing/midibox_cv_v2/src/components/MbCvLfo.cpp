@@ -43,6 +43,7 @@ void MbCvLfo::init()
     // clear flags
     restartReq = false;
     syncClockReq = false;
+    blockResetReq = true;
 
     // clear variables
     lfoModeKeySync = 0;
@@ -65,18 +66,25 @@ void MbCvLfo::init()
 
     lfoOut = 0;
 
-    lfoCtr = 0;
     lfoDelayCtr = 0;
     lfoMidiClockCtr = 0;
 }
 
 
 /////////////////////////////////////////////////////////////////////////////
-// LFO handler
+// LFO handler, first phase: determines the counter increment and amplitude
+// The waveform is calculated for all LFOs at once by MbCvLfoBlock::tick()
 /////////////////////////////////////////////////////////////////////////////
-bool MbCvLfo::tick(const u8 &updateSpeedFactor)
+void MbCvLfo::tickPrepare(MbCvLfoBlock &block, const u8 &ix, const u8 &updateSpeedFactor)
 {
-    bool overrun = false; // will be the return value
+    u16 &lfoCtr = block.lfoCtr[ix];
+
+    // LFO has been initialized?
+    if( blockResetReq ) {
+        blockResetReq = false;
+        lfoCtr = 0;
+        block.lfoOut[ix] = 0;
+    }
 
     // LFO restart requested?
     if( restartReq ) {
@@ -101,6 +109,10 @@ bool MbCvLfo::tick(const u8 &updateSpeedFactor)
             lfoDelayCtr = newDelayCtr; // delay not passed
     }
 
+    // a stalled or delayed LFO passes the counter stage with inc = 0
+    u16 inc = 0;
+    bool resync = false;
+
     if( !lfoDelayCtr ) { // delay passed?
         bool lfoStalled = false;
 
@@ -121,8 +133,6 @@ bool MbCvLfo::tick(const u8 &updateSpeedFactor)
             if( rate > 255 ) rate = 255; else if( rate < 0 ) rate = 0;
 
             // if LFO synched via clock, take rate value from alternative table
-            u16 inc;
-            bool resync = false;
             if( lfoModeClkSync ) {
                 u16 ticks = mbCvMclkTable[rate/8]; // we support 32 clock settings
 
@@ -131,100 +141,35 @@ bool MbCvLfo::tick(const u8 &updateSpeedFactor)
                     resync = true;
                 }
 
-                inc = 65536 / ticks;
+                inc = ticks ? (65536 / ticks) : 0; // ticks == 0: LFO disabled
             } else {
                 inc = mbCvLfoTable[rate];
                 if( !lfoModeFast )
                     inc /= updateSpeedFactor;
             }
-
-            // add to counter and check for overrun
-            s32 newCtr = lfoCtr + inc;
-            if( newCtr > 0xffff || resync ) {
-                overrun = true;
-
-                if( lfoModeOneshot )
-                    newCtr = 0xffff; // stop at end position
-                else if( resync )
-                    newCtr = 0x0000; // resynched via MIDI clock
-            }
-            lfoCtr = (u16)newCtr;
-        }
-
-        // map counter to waveform
-        switch( lfoWaveform ) {
-        case 0: { // Sine
-            // sine table contains a quarter of a sine
-            // we have to negate/mirror it depending on the mapped counter value
-            u8 ptr = lfoCtr >> 7;
-            if( lfoCtr & (1 << 14) )
-                ptr ^= 0x7f;
-            ptr &= 0x7f;
-            lfoOutRaw = mbCvSinTable[ptr];
-            if( lfoCtr & (1 << 15) )
-                lfoOutRaw = -lfoOutRaw;
-        } break;  
-
-        case 1: { // Triangle
-            // similar to sine, but linear waveform
-            lfoOutRaw = (lfoCtr & 0x3fff) << 1;
-            if( lfoCtr & (1 << 14) )
-                lfoOutRaw = 0x7fff - lfoOutRaw;
-            if( lfoCtr & (1 << 15) )
-                lfoOutRaw = -lfoOutRaw;
-        } break;  
-
-        case 2: { // Saw
-            lfoOutRaw = lfoCtr - 0x8000;
-        } break;  
-
-        case 3: { // Pulse
-            lfoOutRaw = (lfoCtr < 0x8000) ? -0x8000 : 0x7fff; // due to historical reasons it's inverted
-        } break;  
-
-        case 4: { // Random
-            // only on LFO overrun
-            if( overrun )
-                lfoOutRaw = randomGen.value(0x0000, 0xffff);
-        } break;  
-            
-        case 5: { // Positive Sine
-            // sine table contains a quarter of a sine
-            // we have to negate/mirror it depending on the mapped counter value
-            u8 ptr = lfoCtr >> 8;
-            if( lfoCtr & (1 << 15) )
-                ptr ^= 0x7f;
-            ptr &= 0x7f;
-            lfoOutRaw = mbCvSinTable[ptr];
-        } break;  
-
-        case 6: { // Positive Triangle
-            // similar to sine, but linear waveform
-            lfoOutRaw = (lfoCtr & 0x7fff);
-            if( lfoCtr & (1 << 15) )
-                lfoOutRaw = 0x7fff - lfoOutRaw;
-        } break;  
-
-        case 7: { // Positive Saw
-            lfoOutRaw = lfoCtr >> 1;
-        } break;  
-
-        case 8: { // Positive Pulse
-            lfoOutRaw = (lfoCtr < 0x8000) ? 0 : 0x7fff; // due to historical reasons it's inverted
-        } break;  
-
-        default: // take saw as default
-            lfoOutRaw = lfoCtr - 0x8000;
         }
 
         // the amplitude can be modulated
         s32 amplitude = lfoAmplitude + (lfoAmplitudeModulation / 512);
         if( amplitude > 127 ) amplitude = 127; else if( amplitude < -128 ) amplitude = -128;
-
-        // final output value
-        lfoOut = ((s32)lfoOutRaw * (s32)amplitude) / 128;
+        block.lfoAmplitude[ix] = amplitude;
     }
 
-    return overrun;
+    block.lfoInc[ix] = inc;
+    block.lfoResyncMask[ix] = resync ? 0xffff : 0x0000;
+    block.lfoOneshotMask[ix] = lfoModeOneshot ? 0xffff : 0x0000;
+    block.lfoActive[ix] = lfoDelayCtr ? 0 : 1;
+    block.lfoWaveform[ix] = lfoWaveform;
 }
 
+
+/////////////////////////////////////////////////////////////////////////////
+// LFO handler, second phase: takes the output values
+/////////////////////////////////////////////////////////////////////////////
+bool MbCvLfo::tickFinish(MbCvLfoBlock &block, const u8 &ix)
+{
+    lfoOutRaw = block.lfoOutRaw[ix];
+    lfoOut = block.lfoOut[ix];
+
+    return block.lfoOverrun[ix] != 0;
+}
@@ -17,7 +17,7 @@
 
 #include <mios32.h>
 #include "MbCvStructs.h"
-#include "MbCvRandomGen.h"
+#include "MbCvLfoBlock.h"
 
 
 class MbCvLfo
@@ -32,8 +32,11 @@ public:
     // LFO init function
     void init();
 
-    // LFO handler (returns true on overrun)
-    bool tick(const u8 &updateSpeedFactor);
+    // LFO handler, split into two phases:
+    // tickPrepare() transfers the inputs into the LFO block, and
+    // tickFinish() takes the output after MbCvLfoBlock::tick() (returns true on overrun)
+    void tickPrepare(MbCvLfoBlock &block, const u8 &ix, const u8 &updateSpeedFactor);
+    bool tickFinish(MbCvLfoBlock &block, const u8 &ix);
 
     // input parameters
     bool lfoModeKeySync;
@@ -67,12 +70,11 @@ public:
     // set by each 6th MIDI clock (if LFO in SYNC mode)
     bool syncClockReq;
 
-    // random generator
-    MbCvRandomGen randomGen;
-
 protected:
-    // internal variables
-    u16 lfoCtr;
+    // requests to clear the state in the LFO block (set by init())
+    bool blockResetReq;
+
+    // internal variables (the counter is located in the LFO block)
     u16 lfoDelayCtr;
 
     u16 lfoMidiClockCtr;
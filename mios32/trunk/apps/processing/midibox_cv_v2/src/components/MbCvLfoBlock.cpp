@@ -0,0 +1,184 @@
+/* -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*- */
+// $Id$
+/*
+ * MIDIbox CV LFO Block
+ * Waveform state of all LFOs, stored as structure-of-arrays
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2015 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include <string.h>
+#include "MbCvLfoBlock.h"
+#include "MbCvTables.h"
+
+
+#if defined(MIOS32_FAMILY_STM32F4xx)
+/////////////////////////////////////////////////////////////////////////////
+// Adds two pairs of 16bit values, returns a 0xffff mask for each carry
+// (UADD16 sets the GE flags on carry, SEL converts them into a mask)
+// Note: the CMSIS intrinsics are not available for C++ files
+/////////////////////////////////////////////////////////////////////////////
+static inline u32 uadd16Carry(u32 a, u32 b, u32 *carry)
+{
+    u32 sum, mask;
+    __asm__ volatile ("uadd16 %0, %2, %3\n\t"
+                      "sel    %1, %4, %5"
+                      : "=&r" (sum), "=r" (mask)
+                      : "r" (a), "r" (b), "r" (0xffffffff), "r" (0x00000000));
+    *carry = mask;
+    return sum;
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructor
+/////////////////////////////////////////////////////////////////////////////
+MbCvLfoBlock::MbCvLfoBlock()
+{
+    init();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Destructor
+/////////////////////////////////////////////////////////////////////////////
+MbCvLfoBlock::~MbCvLfoBlock()
+{
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Clears all LFOs
+/////////////////////////////////////////////////////////////////////////////
+void MbCvLfoBlock::init(void)
+{
+    memset(lfoInc, 0, sizeof(lfoInc));
+    memset(lfoOneshotMask, 0, sizeof(lfoOneshotMask));
+    memset(lfoResyncMask, 0, sizeof(lfoResyncMask));
+    memset(lfoActive, 0, sizeof(lfoActive));
+    memset(lfoWaveform, 0, sizeof(lfoWaveform));
+    memset(lfoAmplitude, 0, sizeof(lfoAmplitude));
+
+    memset(lfoCtr, 0, sizeof(lfoCtr));
+    memset(lfoOverrun, 0, sizeof(lfoOverrun));
+    memset(lfoOutRaw, 0, sizeof(lfoOutRaw));
+    memset(lfoOut, 0, sizeof(lfoOut));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Updates all LFOs
+/////////////////////////////////////////////////////////////////////////////
+void MbCvLfoBlock::tick(void)
+{
+    // Counter stage:
+    // newCtr = ctr + inc, an overrun is flagged on carry or resync request.
+    // In oneshot mode the counter stops at 0xffff on overrun, otherwise it wraps
+    // (resync: starts from 0).
+    // Stalled and delayed LFOs have been prepared with inc = 0 and no resync,
+    // so that they pass this stage without changes.
+#if defined(MIOS32_FAMILY_STM32F4xx)
+    // two LFOs at once
+    for(int i=0; i<MBCV_LFO_BLOCK_SIZE/2; ++i) {
+        u32 carry;
+        u32 sum = uadd16Carry(lfoCtr32[i], lfoInc32[i], &carry);
+        u32 overrun = carry | lfoResyncMask32[i];
+        lfoCtr32[i] = (sum & ~lfoResyncMask32[i]) | (overrun & lfoOneshotMask32[i]);
+        lfoOverrun32[i] = overrun;
+    }
+#else
+    for(int i=0; i<MBCV_LFO_BLOCK_SIZE; ++i) {
+        u32 sum = (u32)lfoCtr[i] + lfoInc[i];
+        u16 carry = (sum > 0xffff) ? 0xffff : 0x0000;
+        u16 overrun = carry | lfoResyncMask[i];
+        lfoCtr[i] = ((u16)sum & ~lfoResyncMask[i]) | (overrun & lfoOneshotMask[i]);
+        lfoOverrun[i] = overrun;
+    }
+#endif
+
+    // Waveform stage: map counter to waveform and scale it by the amplitude
+    for(int i=0; i<MBCV_LFO_BLOCK_SIZE; ++i) {
+        if( !lfoActive[i] )
+            continue; // delayed LFO: keep previous output value
+
+        u16 ctr = lfoCtr[i];
+        s16 outRaw = lfoOutRaw[i];
+
+        switch( lfoWaveform[i] ) {
+        case 0: { // Sine
+            // sine table contains a quarter of a sine
+            // we have to negate/mirror it depending on the mapped counter value
+            u8 ptr = ctr >> 7;
+            if( ctr & (1 << 14) )
+                ptr ^= 0x7f;
+            ptr &= 0x7f;
+            outRaw = mbCvSinTable[ptr];
+            if( ctr & (1 << 15) )
+                outRaw = -outRaw;
+        } break;
+
+        case 1: { // Triangle
+            // similar to sine, but linear waveform
+            outRaw = (ctr & 0x3fff) << 1;
+            if( ctr & (1 << 14) )
+                outRaw = 0x7fff - outRaw;
+            if( ctr & (1 << 15) )
+                outRaw = -outRaw;
+        } break;
+
+        case 2: { // Saw
+            outRaw = ctr - 0x8000;
+        } break;
+
+        case 3: { // Pulse
+            outRaw = (ctr < 0x8000) ? -0x8000 : 0x7fff; // due to historical reasons it's inverted
+        } break;
+
+        case 4: { // Random
+            // only on LFO overrun
+            if( lfoOverrun[i] )
+                outRaw = randomGen.value(0x0000, 0xffff);
+        } break;
+
+        case 5: { // Positive Sine
+            // sine table contains a quarter of a sine
+            // we have to negate/mirror it depending on the mapped counter value
+            u8 ptr = ctr >> 8;
+            if( ctr & (1 << 15) )
+                ptr ^= 0x7f;
+            ptr &= 0x7f;
+            outRaw = mbCvSinTable[ptr];
+        } break;
+
+        case 6: { // Positive Triangle
+            // similar to sine, but linear waveform
+            outRaw = (ctr & 0x7fff);
+            if( ctr & (1 << 15) )
+                outRaw = 0x7fff - outRaw;
+        } break;
+
+        case 7: { // Positive Saw
+            outRaw = ctr >> 1;
+        } break;
+
+        case 8: { // Positive Pulse
+            outRaw = (ctr < 0x8000) ? 0 : 0x7fff; // due to historical reasons it's inverted
+        } break;
+
+        default: // take saw as default
+            outRaw = ctr - 0x8000;
+        }
+
+        lfoOutRaw[i] = outRaw;
+
+        // final output value
+        lfoOut[i] = ((s32)outRaw * (s32)lfoAmplitude[i]) / 128;
+    }
+}
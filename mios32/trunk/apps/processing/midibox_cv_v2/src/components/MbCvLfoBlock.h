@@ -0,0 +1,79 @@
+/* -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*- */
+// $Id$
+/*
+ * MIDIbox CV LFO Block
+ * Waveform state of all LFOs, stored as structure-of-arrays
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2015 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _MB_CV_LFO_BLOCK_H
+#define _MB_CV_LFO_BLOCK_H
+
+#include <mios32.h>
+#include "MbCvStructs.h"
+#include "MbCvRandomGen.h"
+
+// number of LFOs handled by the block (must be even, see lfoCtr32)
+#define MBCV_LFO_BLOCK_SIZE (CV_SE_NUM * CV_SE_LFO_NUM)
+
+
+class MbCvLfoBlock
+{
+public:
+    // Constructor
+    MbCvLfoBlock();
+
+    // Destructor
+    ~MbCvLfoBlock();
+
+    // clears all LFOs
+    void init(void);
+
+    // updates the counters and waveforms of all LFOs
+    // the inputs have been prepared with MbCvLfo::tickPrepare() before
+    void tick(void);
+
+    // inputs (set by MbCvLfo::tickPrepare())
+    // the 16bit arrays which are used by the counter stage are also accessible as
+    // 32bit words, so that two LFOs can be processed with a single SIMD instruction
+    union {
+        u16 lfoInc[MBCV_LFO_BLOCK_SIZE];         // counter increment, 0 if stalled
+        u32 lfoInc32[MBCV_LFO_BLOCK_SIZE/2];
+    };
+    union {
+        u16 lfoOneshotMask[MBCV_LFO_BLOCK_SIZE]; // 0xffff: stop at end position
+        u32 lfoOneshotMask32[MBCV_LFO_BLOCK_SIZE/2];
+    };
+    union {
+        u16 lfoResyncMask[MBCV_LFO_BLOCK_SIZE];  // 0xffff: resync counter (MIDI clock)
+        u32 lfoResyncMask32[MBCV_LFO_BLOCK_SIZE/2];
+    };
+    u8  lfoActive[MBCV_LFO_BLOCK_SIZE];          // 0 while LFO is delayed
+    u8  lfoWaveform[MBCV_LFO_BLOCK_SIZE];
+    s16 lfoAmplitude[MBCV_LFO_BLOCK_SIZE];       // -128..127 (incl. modulation)
+
+    // state and outputs
+    union {
+        u16 lfoCtr[MBCV_LFO_BLOCK_SIZE];
+        u32 lfoCtr32[MBCV_LFO_BLOCK_SIZE/2];
+    };
+    union {
+        u16 lfoOverrun[MBCV_LFO_BLOCK_SIZE];     // 0xffff on counter overrun
+        u32 lfoOverrun32[MBCV_LFO_BLOCK_SIZE/2];
+    };
+    s16 lfoOutRaw[MBCV_LFO_BLOCK_SIZE];
+    s32 lfoOut[MBCV_LFO_BLOCK_SIZE];
+
+protected:
+    // random generator
+    MbCvRandomGen randomGen;
+};
+
+#endif /* _MB_CV_LFO_BLOCK_H */
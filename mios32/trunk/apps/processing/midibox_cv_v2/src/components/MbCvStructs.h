@@ -25,6 +25,9 @@
 
 #define CV_SE_NUM             8 // CV Channels
 
+#define CV_SE_LFO_NUM         2 // LFOs per CV Channel
+#define CV_SE_ENV_NUM         2 // ENV1 + ENV2 per CV Channel
+
 #define CV_SE_NOTESTACK_SIZE 10
 
 #define CV_PATCH_SIZE        0x400
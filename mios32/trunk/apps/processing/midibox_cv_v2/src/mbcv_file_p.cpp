@@ -569,6 +569,9 @@ s32 MBCV_FILE_P_Read(char *filename)
   // close file
   status |= FILE_ReadClose(&file);
 
+  // take over the ROUTER nodes
+  MIDI_ROUTER_NodesChanged();
+
 #if !defined(MIOS32_FAMILY_EMULATION)
   // OSC_SERVER_Init(0) has to be called after all settings have been done!
   OSC_SERVER_Init(0);
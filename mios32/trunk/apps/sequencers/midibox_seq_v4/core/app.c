@@ -471,6 +471,9 @@ void SEQ_TASK_Period1mS(void)
   // update BPM
   SEQ_CORE_BPM_SweepHandler();
 
+  // send requested mixer values
+  SEQ_MIXER_Handler();
+
 #ifndef MBSEQV4L
   // Button handlers
   if( seq_hwcfg_blm.enabled ) {
@@ -806,6 +809,9 @@ static s32 NOTIFY_MIDI_Rx(mios32_midi_port_t port, u8 midi_byte)
 /////////////////////////////////////////////////////////////////////////////
 static s32 NOTIFY_MIDI_Tx(mios32_midi_port_t port, mios32_midi_package_t package)
 {
+  // keep track of the Program Changes and CCs which have been sent to mixer channels
+  SEQ_MIXER_NotifyMIDITx(port, package);
+
   return SEQ_MIDI_PORT_NotifyMIDITx(port, package);
 }
 
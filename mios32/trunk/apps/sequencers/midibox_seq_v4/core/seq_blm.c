@@ -170,6 +170,9 @@ static s32 SEQ_BLM_SYSEX_SendAck(mios32_midi_port_t port, u8 ack_code, u8 ack_ar
 
 static u8 SEQ_BLM_BUTTON_Hlp_TransposeNote(u8 track, u8 note);
 static s32 BLM_SendPackets(mios32_midi_package_t *packets, u8 num_packets);
+#ifdef MBSEQV4L
+static s32 SEQ_BLM_ArmedTracksUpdate(void);
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1279,7 +1282,7 @@ static s32 SEQ_BLM_BUTTON_GP_KeyboardMode(u8 button_row, u8 button_column, u8 de
 #endif
   }
 
-  u8 should_be_recorded = seq_record_state.ENABLED && (seq_record_state.ARMED_TRACKS & (1 << visible_track));
+  u8 should_be_recorded = seq_record_state.ENABLED && SEQ_CORE_TRKSET_GET(&seq_record_state.ARMED_TRACKS, visible_track);
 
   if( depressed ) {
     // play off event - but only if depressed button matches with last one that played the note
@@ -1636,33 +1639,37 @@ s32 SEQ_BLM_LED_Update(void)
 
   // can be overwritten by SEQ_BLM_LED_Update* functions
   {
+    // the extra column displays the first 16 tracks
+    u16 trk_muted = SEQ_CORE_TrkSetGet16(&seq_core_trk_muted, 0);
+    u16 trk_soloed = SEQ_CORE_TrkSetGet16(&seq_core_trk_soloed, 0);
+
     if( blm_mute_solo_active ) { // Mute or Solo Tracks
 #if 0
       // LED Colour coding:
       // - LED off: Track won't play (due to Mute or Solo)
       // - LED green: Solo not active and track not muted
       // - LED yellow: Track soloed
-      u16 unmuted_or_solo = (seq_core_trk_soloed ? 0x0000 : (seq_core_trk_muted ^ 0xffff)) | seq_core_trk_soloed;
+      u16 unmuted_or_solo = (trk_soloed ? 0x0000 : (trk_muted ^ 0xffff)) | trk_soloed;
       blm_leds_extracolumn_green = 0xffff & unmuted_or_solo;
-      blm_leds_extracolumn_red = seq_core_trk_soloed & unmuted_or_solo;
+      blm_leds_extracolumn_red = trk_soloed & unmuted_or_solo;
 #else
       // LED Colour coding (compliant with LED handling in MUTE page)
       // - LED off: Track neither muted nor soloed
       // - LED green: Track muted
       // - LED yellow: Track soloed
       // - LED red: Track muted and soloed - solo has higher priority, therefore track will be played
-      if( seq_core_trk_soloed ) {
-	u16 muted_and_solo = seq_core_trk_muted & seq_core_trk_soloed;
-	blm_leds_extracolumn_green = (seq_core_trk_muted | seq_core_trk_soloed) & (muted_and_solo ^ 0xffff);
-	blm_leds_extracolumn_red = seq_core_trk_soloed | muted_and_solo;
+      if( trk_soloed ) {
+	u16 muted_and_solo = trk_muted & trk_soloed;
+	blm_leds_extracolumn_green = (trk_muted | trk_soloed) & (muted_and_solo ^ 0xffff);
+	blm_leds_extracolumn_red = trk_soloed | muted_and_solo;
       } else {
-	blm_leds_extracolumn_green = seq_core_trk_muted;
+	blm_leds_extracolumn_green = trk_muted;
 	blm_leds_extracolumn_red = 0x0000;
       }
 #endif
     } else {
-      blm_leds_extracolumn_green = ui_selected_tracks;
-      blm_leds_extracolumn_red = seq_core_trk_muted;
+      blm_leds_extracolumn_green = SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0);
+      blm_leds_extracolumn_red = trk_muted;
     }
 
     if( blm_num_rows <= 8 ) {
@@ -1974,18 +1981,12 @@ s32 SEQ_BLM_MIDI_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_pac
 
 #ifdef MBSEQV4L
 	if( blm_mode != BLM_MODE_PATTERNS )
-	  ui_selected_tracks = (new_track >= 8) ? 0xff00 : 0x00ff;
+	  SEQ_CORE_TrkSetSet16(&ui_selected_tracks, 0, (new_track >= 8) ? 0xff00 : 0x00ff);
 	ui_selected_group = (new_track >= 8) ? 2 : 0;
 
 	// armed tracks handling: alternate and select all tracks depending on seq selection
 	// can be changed in RecArm page
-	if( ui_selected_tracks & 0xff00 ) {
-	  if( (seq_record_state.ARMED_TRACKS & 0x00ff) )
-	    seq_record_state.ARMED_TRACKS = 0xff00;
-	} else {
-	  if( (seq_record_state.ARMED_TRACKS & 0xff00) )
-	    seq_record_state.ARMED_TRACKS = 0x00ff;
-	}
+	SEQ_BLM_ArmedTracksUpdate();
 #else
 	if( blm_num_rows <= 4 ) {
 	  if( new_track >= 4 )
@@ -1997,8 +1998,10 @@ s32 SEQ_BLM_MIDI_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_pac
 	} else {
 	  ui_selected_group = (new_track / 4);
 	}
-	if( blm_mode != BLM_MODE_PATTERNS )
-	  ui_selected_tracks = 1 << (4*ui_selected_group + (new_track % 4));
+	if( blm_mode != BLM_MODE_PATTERNS ) {
+	  SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+	  SEQ_CORE_TRKSET_SET(&ui_selected_tracks, 4*ui_selected_group + (new_track % 4));
+	}
 #endif
       }
 
@@ -2087,29 +2090,22 @@ s32 SEQ_BLM_MIDI_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_pac
 	    new_track = (new_track & 0x7) | ((ui_selected_group & 2) << 2);
 	  }
 
-	  u16 track_mask = 1 << new_track;
-
 	  if( blm_mute_solo_active == 1 ) { // Mute Tracks
-	    seq_core_trk_muted ^= track_mask;
+	    SEQ_CORE_TRKSET_TOGGLE(&seq_core_trk_muted, new_track);
 	  } else if( blm_mute_solo_active == 2 ) { // Solo Tracks
-	    seq_core_trk_soloed ^= track_mask;
-	    seq_ui_button_state.SOLO = seq_core_trk_soloed ? 1 : 0;
+	    SEQ_CORE_TRKSET_TOGGLE(&seq_core_trk_soloed, new_track);
+	    seq_ui_button_state.SOLO = SEQ_CORE_TrkSetIsEmpty(&seq_core_trk_soloed) ? 0 : 1;
 	  } else {
 #ifdef MBSEQV4L
-	    ui_selected_tracks = (new_track >= 8) ? 0xff00 : 0x00ff;
+	    SEQ_CORE_TrkSetSet16(&ui_selected_tracks, 0, (new_track >= 8) ? 0xff00 : 0x00ff);
 	    blm_force_update = 1;	
 
 	    // armed tracks handling: alternate and select all tracks depending on seq selection
 	    // can be changed in RecArm page
-	    if( ui_selected_tracks & 0xff00 ) {
-	      if( (seq_record_state.ARMED_TRACKS & 0x00ff) )
-		seq_record_state.ARMED_TRACKS = 0xff00;
-	    } else {
-	      if( (seq_record_state.ARMED_TRACKS & 0xff00) )
-		seq_record_state.ARMED_TRACKS = 0x00ff;
-	    }
+	    SEQ_BLM_ArmedTracksUpdate();
 #else
-	    ui_selected_tracks = track_mask;
+	    SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+	    SEQ_CORE_TRKSET_SET(&ui_selected_tracks, new_track);
 	    ui_selected_group = (new_track / 4);
 	    blm_force_update = 1;	
 
@@ -2149,7 +2145,7 @@ s32 SEQ_BLM_MIDI_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_pac
 	  case BLM_SELECTION_MUTE:
 	    if( midi_package.velocity > 0 ) {
 	      if( blm_alt_active ) {
-		seq_core_trk_muted = 0;
+		SEQ_CORE_TrkSetClear(&seq_core_trk_muted);
 	      } else {
 		// if mute already active: clear mute mode
 		// otherwise select mute mode
@@ -2161,7 +2157,7 @@ s32 SEQ_BLM_MIDI_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_pac
 	  case BLM_SELECTION_SOLO:
 	    if( midi_package.velocity > 0 ) {
 	      if( blm_alt_active ) {
-		seq_core_trk_soloed = 0;
+		SEQ_CORE_TrkSetClear(&seq_core_trk_soloed);
 		seq_ui_button_state.SOLO = 0;
 	      } else {
 		// if solo already active: clear solo mode
@@ -2173,12 +2169,12 @@ s32 SEQ_BLM_MIDI_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_pac
 
 	  case BLM_SELECTION_UPPER_TRACKS:
 	    if( midi_package.velocity > 0 ) {
-	      u16 selected_tracks = ui_selected_tracks;
+	      u16 selected_tracks = SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0);
 	      ui_selected_group ^= 2;
 	      if( ui_selected_group >= 2 ) {
-		ui_selected_tracks = selected_tracks << 8;
+		SEQ_CORE_TrkSetSet16(&ui_selected_tracks, 0, selected_tracks << 8);
 	      } else {
-		ui_selected_tracks = selected_tracks >> 8;
+		SEQ_CORE_TrkSetSet16(&ui_selected_tracks, 0, selected_tracks >> 8);
 	      }
 	      blm_force_update = 1;	
 	    }
@@ -2365,3 +2361,24 @@ static s32 BLM_SendPackets(mios32_midi_package_t *packets, u8 num_packets)
 
   return 0; // no error
 }
+
+
+#ifdef MBSEQV4L
+/////////////////////////////////////////////////////////////////////////////
+// MBSEQ V4L: armed tracks follow the selected sequence (first or second 8 tracks)
+/////////////////////////////////////////////////////////////////////////////
+static s32 SEQ_BLM_ArmedTracksUpdate(void)
+{
+  u16 armed_tracks = SEQ_CORE_TrkSetGet16(&seq_record_state.ARMED_TRACKS, 0);
+
+  if( SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0) & 0xff00 ) {
+    if( (armed_tracks & 0x00ff) )
+      SEQ_CORE_TrkSetSet16(&seq_record_state.ARMED_TRACKS, 0, 0xff00);
+  } else {
+    if( (armed_tracks & 0xff00) )
+      SEQ_CORE_TrkSetSet16(&seq_record_state.ARMED_TRACKS, 0, 0x00ff);
+  }
+
+  return 0; // no error
+}
+#endif
@@ -65,6 +65,16 @@
 // value is visible in INFO->System page (-> press exit button, go to last item)
 #define STOPWATCH_PERFORMANCE_MEASURING 1
 
+#ifndef AHB_SECTION
+#define AHB_SECTION
+#endif
+
+// max number of echos which are repeated via SEQ_MIDI_OUT_RepeatEvent
+// if all descriptors are allocated, the repeats are scheduled immediately
+#ifndef SEQ_CORE_ECHO_NUM_SLOTS
+#define SEQ_CORE_ECHO_NUM_SLOTS 32
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
@@ -72,6 +82,8 @@
 
 static s32 SEQ_CORE_ResetTrkPos(u8 track, seq_core_trk_t *t, seq_cc_trk_t *tcc);
 static s32 SEQ_CORE_NextStep(seq_core_trk_t *t, seq_cc_trk_t *tcc, u8 no_progression, u8 reverse);
+static const u8 *SEQ_CORE_NoteMapGet(u8 track, seq_cc_trk_t *tcc);
+static s32 SEQ_CORE_EchoRepeatCallback(u16 repeat_id, u32 timestamp, u32 *next_timestamp);
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -82,11 +94,11 @@ seq_core_options_t seq_core_options;
 u8 seq_core_steps_per_measure;
 u8 seq_core_steps_per_pattern;
 
-u16 seq_core_trk_muted;
-u16 seq_core_trk_synched_mute;
-u16 seq_core_trk_synched_unmute;
+seq_core_trkset_t seq_core_trk_muted;
+seq_core_trkset_t seq_core_trk_synched_mute;
+seq_core_trkset_t seq_core_trk_synched_unmute;
 seq_core_slaveclk_mute_t seq_core_slaveclk_mute;
-u16 seq_core_trk_soloed;
+seq_core_trkset_t seq_core_trk_soloed;
 
 u8 seq_core_step_update_req;
 
@@ -127,6 +139,58 @@ static u32 bpm_tick_prefetched;
 static float seq_core_bpm_target;
 static float seq_core_bpm_sweep_inc;
 
+// force-to-scale and Limit Fx combined into a 128 entry table for each track
+// the table is only recalculated if one of the settings in the key has been changed
+typedef struct {
+  u8 valid;
+  u8 force_scale;
+  u8 scale;
+  u8 root;
+  u8 limit_lower;
+  u8 limit_upper;
+} seq_core_note_map_key_t;
+
+static u8 AHB_SECTION seq_core_note_map[SEQ_CORE_NUM_TRACKS][128];
+static seq_core_note_map_key_t seq_core_note_map_key[SEQ_CORE_NUM_TRACKS];
+
+// MIDI port and channel settings of a track which are considered by SEQ_CORE_ScheduleEvent()
+typedef struct {
+  mios32_midi_port_t midi_port;
+  mios32_midi_port_t fx_midi_port;
+  u8 midi_chn;
+  u8 fx_midi_chn;
+  u8 fx_midi_num_chn;
+  seq_core_fx_midi_mode_t fx_midi_mode;
+} seq_core_port_cfg_t;
+
+// repeat descriptors of the echo Fx
+// all track settings are taken over when the note is played
+typedef struct {
+  mios32_midi_package_t p; // note/velocity of the last repeat
+  u32 gatelength;
+  s32 delay;               // delay to the next repeat (feedback is applied)
+  u32 timestamp;           // timestamp of the last repeat
+  seq_random_track_stream_t random_stream; // for random note feedback
+  seq_core_port_cfg_t port_cfg;
+  u8  active;              // descriptor is queued in SEQ_MIDI_OUT
+  u8  lookahead;           // the descriptor is called earlier by the negative port delay
+  u8  track;
+  u8  event_type;
+  u8  robotize_flags;
+  u8  num_repeats;
+  u8  repeat_ctr;
+  u8  note_base;
+  u8  fb_velocity;
+  u8  fb_note;
+  u8  fb_gatelength;
+  u8  fb_ticks;
+  u8  force_scale;
+  u8  scale;
+  u8  root;
+} seq_core_echo_t;
+
+static seq_core_echo_t seq_core_echo[SEQ_CORE_ECHO_NUM_SLOTS];
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initialisation
@@ -136,9 +200,11 @@ s32 SEQ_CORE_Init(u32 mode)
 {
   int i;
 
-  seq_core_trk_muted = 0;
+  SEQ_CORE_TrkSetClear(&seq_core_trk_muted);
+  SEQ_CORE_TrkSetClear(&seq_core_trk_synched_mute);
+  SEQ_CORE_TrkSetClear(&seq_core_trk_synched_unmute);
   seq_core_slaveclk_mute = SEQ_CORE_SLAVECLK_MUTE_Off;
-  seq_core_trk_soloed = 0;
+  SEQ_CORE_TrkSetClear(&seq_core_trk_soloed);
   seq_core_options.ALL = 0;
   if( mode == 0 ) {
     seq_core_options.INIT_CC = 64;
@@ -170,6 +236,7 @@ s32 SEQ_CORE_Init(u32 mode)
   seq_core_bpm_sweep_inc = 0.0;
 
   seq_core_state.ALL = 0;
+  SEQ_CORE_TrkSetClear(&seq_core_state.reset_trkpos_req);
 
   seq_core_glb_loop_mode = SEQ_CORE_LOOP_MODE_ALL_TRACKS_VIEW;
   seq_core_glb_loop_offset = 0;
@@ -219,11 +286,21 @@ s32 SEQ_CORE_Init(u32 mode)
   SEQ_MIDEXP_Init(0);
   SEQ_MIDIMP_Init(0);
 
+  // repeat descriptors of the echo Fx (mode 1: could still be queued)
+  if( mode == 0 ) {
+    for(i=0; i<SEQ_CORE_ECHO_NUM_SLOTS; ++i)
+      seq_core_echo[i].active = 0;
+  }
+  SEQ_MIDI_OUT_Callback_Repeat_Set(SEQ_CORE_EchoRepeatCallback);
+
   // clear registers which are not reset by SEQ_CORE_Reset()
   u8 track;
   seq_core_trk_t *t = &seq_core_trk[0];
   for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track, ++t) {
 
+    // note map will be calculated with the first note
+    seq_core_note_map_key[track].valid = 0;
+
     // if track name only contains spaces, the UI will print 
     // the track number instead of an empty message
     // this ensures highest flexibility (e.g. any track can 
@@ -265,36 +342,48 @@ s32 SEQ_CORE_Init(u32 mode)
 /////////////////////////////////////////////////////////////////////////////
 // This function schedules a MIDI event by considering the "normal" and "Fx"
 // MIDI port
+// The port settings can be taken over with SEQ_CORE_PortCfgGet(), so that
+// echo repeats use the settings which were active when the note was played
 /////////////////////////////////////////////////////////////////////////////
-s32 SEQ_CORE_ScheduleEvent(seq_core_trk_t *t, seq_cc_trk_t *tcc, mios32_midi_package_t midi_package, seq_midi_out_event_type_t event_type, u32 timestamp, u32 len, u8 is_echo, seq_robotize_flags_t robotize_flags)
+static void SEQ_CORE_PortCfgGet(seq_cc_trk_t *tcc, seq_core_port_cfg_t *cfg)
+{
+  cfg->midi_port = tcc->midi_port;
+  cfg->fx_midi_port = tcc->fx_midi_port;
+  cfg->midi_chn = tcc->midi_chn;
+  cfg->fx_midi_chn = tcc->fx_midi_chn;
+  cfg->fx_midi_num_chn = tcc->fx_midi_num_chn;
+  cfg->fx_midi_mode = tcc->fx_midi_mode;
+}
+
+static s32 SEQ_CORE_ScheduleEventPortCfg(seq_core_trk_t *t, seq_core_port_cfg_t *cfg, mios32_midi_package_t midi_package, seq_midi_out_event_type_t event_type, u32 timestamp, u32 len, u8 is_echo, seq_robotize_flags_t robotize_flags)
 {
   s32 status = 0;
-  mios32_midi_port_t fx_midi_port = tcc->fx_midi_port ? tcc->fx_midi_port : tcc->midi_port;
+  mios32_midi_port_t fx_midi_port = cfg->fx_midi_port ? cfg->fx_midi_port : cfg->midi_port;
 
   //check that there are more than 0 additional channels, that it's not just one channel and FX starting on current channel, check disable flag, check for robotizer
-  if( ! ( tcc->fx_midi_num_chn & 0x3f ) || ( ( tcc->fx_midi_num_chn & 0x3f ) == 1 && tcc->fx_midi_chn == midi_package.chn  ) || ( ( tcc->fx_midi_num_chn & 0x40 ) && ! robotize_flags.DUPLICATE ) ) {
-    status |= SEQ_MIDI_OUT_Send(tcc->midi_port, midi_package, event_type, timestamp, len);
+  if( ! ( cfg->fx_midi_num_chn & 0x3f ) || ( ( cfg->fx_midi_num_chn & 0x3f ) == 1 && cfg->fx_midi_chn == midi_package.chn  ) || ( ( cfg->fx_midi_num_chn & 0x40 ) && ! robotize_flags.DUPLICATE ) ) {
+    status |= SEQ_MIDI_OUT_Send(cfg->midi_port, midi_package, event_type, timestamp, len);
 
     if( event_type == SEQ_MIDI_OUT_OnEvent ) { // schedule off event at same port
       midi_package.velocity = 0;
-      status |= SEQ_MIDI_OUT_Send(tcc->midi_port, midi_package, SEQ_MIDI_OUT_OffEvent, 0xffffffff, 0);
+      status |= SEQ_MIDI_OUT_Send(cfg->midi_port, midi_package, SEQ_MIDI_OUT_OffEvent, 0xffffffff, 0);
     }
   } else {
     if( event_type == SEQ_MIDI_OUT_OnEvent || event_type == SEQ_MIDI_OUT_OnOffEvent ) {
-      switch( tcc->fx_midi_mode.beh ) {
+      switch( cfg->fx_midi_mode.beh ) {
       case SEQ_CORE_FX_MIDI_MODE_BEH_Alternate:
       case SEQ_CORE_FX_MIDI_MODE_BEH_AlternateSynchedEcho: {
 	// forward to next channel
-	if( (tcc->fx_midi_mode.beh == SEQ_CORE_FX_MIDI_MODE_BEH_AlternateSynchedEcho && !is_echo) ||
-	  ++t->fx_midi_ctr > ( tcc->fx_midi_num_chn & 0x3f ) )
+	if( (cfg->fx_midi_mode.beh == SEQ_CORE_FX_MIDI_MODE_BEH_AlternateSynchedEcho && !is_echo) ||
+	  ++t->fx_midi_ctr > ( cfg->fx_midi_num_chn & 0x3f ) )
 	  t->fx_midi_ctr = 0;
 
 	mios32_midi_port_t midi_port;
 	if( t->fx_midi_ctr == 0 ) {
-	  midi_port = tcc->midi_port;
+	  midi_port = cfg->midi_port;
 	} else {
 	  midi_port = fx_midi_port;
-	  midi_package.chn = (( tcc->fx_midi_num_chn & 0x3f ) + (t->fx_midi_ctr-1)) % 16;
+	  midi_package.chn = (( cfg->fx_midi_num_chn & 0x3f ) + (t->fx_midi_ctr-1)) % 16;
 	}
 
 	status |= SEQ_MIDI_OUT_Send(midi_port, midi_package, event_type, timestamp, len);
@@ -307,13 +396,13 @@ s32 SEQ_CORE_ScheduleEvent(seq_core_trk_t *t, seq_cc_trk_t *tcc, mios32_midi_pac
 	
       case SEQ_CORE_FX_MIDI_MODE_BEH_Random: {
 	// select random channel
-	int ix = SEQ_RANDOM_Gen_Range(0, ( tcc->fx_midi_num_chn & 0x3f ));
+	int ix = SEQ_RANDOM_Gen_Range(0, ( cfg->fx_midi_num_chn & 0x3f ));
 	mios32_midi_port_t midi_port;
 	if( ix == 0 ) {
-	  midi_port = tcc->midi_port;
+	  midi_port = cfg->midi_port;
 	} else {
 	  midi_port = fx_midi_port;
-	  midi_package.chn = (( tcc->fx_midi_num_chn & 0x3f ) + ix-1) % 16;
+	  midi_package.chn = (( cfg->fx_midi_num_chn & 0x3f ) + ix-1) % 16;
 	}
 
 	status |= SEQ_MIDI_OUT_Send(midi_port, midi_package, event_type, timestamp, len);
@@ -328,23 +417,23 @@ s32 SEQ_CORE_ScheduleEvent(seq_core_trk_t *t, seq_cc_trk_t *tcc, mios32_midi_pac
 	// forward to all channels
 
 	// original channel
-	status |= SEQ_MIDI_OUT_Send(tcc->midi_port, midi_package, event_type, timestamp, len);
+	status |= SEQ_MIDI_OUT_Send(cfg->midi_port, midi_package, event_type, timestamp, len);
 
 	// all other channels
 	int ix;
-	for(ix=0; ix < ( tcc->fx_midi_num_chn & 0x3f ); ++ix) {
-	  midi_package.chn = (tcc->fx_midi_chn + ix) % 16;
+	for(ix=0; ix < ( cfg->fx_midi_num_chn & 0x3f ); ++ix) {
+	  midi_package.chn = (cfg->fx_midi_chn + ix) % 16;
 	  status |= SEQ_MIDI_OUT_Send(fx_midi_port, midi_package, event_type, timestamp, len);
 	}
 
 	if( event_type == SEQ_MIDI_OUT_OnEvent ) { // schedule off event at same port
 	  midi_package.velocity = 0;
 
-	  midi_package.chn = tcc->midi_chn % 16;
-	  status |= SEQ_MIDI_OUT_Send(tcc->midi_port, midi_package, SEQ_MIDI_OUT_OffEvent, 0xffffffff, 0);
+	  midi_package.chn = cfg->midi_chn % 16;
+	  status |= SEQ_MIDI_OUT_Send(cfg->midi_port, midi_package, SEQ_MIDI_OUT_OffEvent, 0xffffffff, 0);
 
-	  for(ix=0; ix< ( tcc->fx_midi_num_chn & 0x3f ); ++ix) {
-	    midi_package.chn = (tcc->fx_midi_chn + ix) % 16;
+	  for(ix=0; ix< ( cfg->fx_midi_num_chn & 0x3f ); ++ix) {
+	    midi_package.chn = (cfg->fx_midi_chn + ix) % 16;
 	    status |= SEQ_MIDI_OUT_Send(fx_midi_port, midi_package, SEQ_MIDI_OUT_OffEvent, 0xffffffff, 0);
 	  }
 	}
@@ -354,13 +443,13 @@ s32 SEQ_CORE_ScheduleEvent(seq_core_trk_t *t, seq_cc_trk_t *tcc, mios32_midi_pac
       }
     } else {
       // original channel
-      status |= SEQ_MIDI_OUT_Send(tcc->midi_port, midi_package, event_type, timestamp, len);
+      status |= SEQ_MIDI_OUT_Send(cfg->midi_port, midi_package, event_type, timestamp, len);
 
-      if( tcc->fx_midi_mode.fwd_non_notes ) {
+      if( cfg->fx_midi_mode.fwd_non_notes ) {
 	// all other channels
 	int ix;
-	for(ix=0; ix < ( tcc->fx_midi_num_chn & 0x3f ); ++ix) {
-	  midi_package.chn = (tcc->fx_midi_chn + ix) % 16;
+	for(ix=0; ix < ( cfg->fx_midi_num_chn & 0x3f ); ++ix) {
+	  midi_package.chn = (cfg->fx_midi_chn + ix) % 16;
 	  status |= SEQ_MIDI_OUT_Send(fx_midi_port, midi_package, event_type, timestamp, len);
 	}
       }
@@ -370,6 +459,13 @@ s32 SEQ_CORE_ScheduleEvent(seq_core_trk_t *t, seq_cc_trk_t *tcc, mios32_midi_pac
   return status;
 }
 
+s32 SEQ_CORE_ScheduleEvent(seq_core_trk_t *t, seq_cc_trk_t *tcc, mios32_midi_package_t midi_package, seq_midi_out_event_type_t event_type, u32 timestamp, u32 len, u8 is_echo, seq_robotize_flags_t robotize_flags)
+{
+  seq_core_port_cfg_t cfg;
+  SEQ_CORE_PortCfgGet(tcc, &cfg);
+  return SEQ_CORE_ScheduleEventPortCfg(t, &cfg, midi_package, event_type, timestamp, len, is_echo, robotize_flags);
+}
+
 
 /////////////////////////////////////////////////////////////////////////////
 // this sequencer handler is called periodically to check for new requests
@@ -515,7 +611,7 @@ s32 SEQ_CORE_Handler(void)
 	      
 	      if( seq_song_guide_track ) {
 		// request synch-to-measure for all tracks
-		SEQ_CORE_ManualSynchToMeasure(0xffff);
+		SEQ_CORE_ManualSynchToMeasure(NULL);
 		
 		// corner case: we will load new tracks and the length of the guide track could change
 		// in order to ensure that the reference step jumps back to 0, we've to force this here:
@@ -659,7 +755,7 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
     seq_cc_trk_t *tcc = &seq_cc_trk[0];
     u8 track;
     for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track, ++t, ++tcc) {
-      if( seq_core_state.reset_trkpos_req & (1 << track) ) {
+      if( SEQ_CORE_TRKSET_GET(&seq_core_state.reset_trkpos_req, track) ) {
 	SEQ_CORE_ResetTrkPos(track, t, tcc);
 	++t->bar;
       }
@@ -677,7 +773,7 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
 	t->lfo_cc_muted_from_midi_next = 0;
       }
     }
-    seq_core_state.reset_trkpos_req = 0;
+    SEQ_CORE_TrkSetClear(&seq_core_state.reset_trkpos_req);
 
     if( seq_core_state.FIRST_CLK || seq_core_state.FORCE_REF_STEP_RESET ) {
       seq_core_state.FORCE_REF_STEP_RESET = 0;
@@ -718,7 +814,7 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
       // release pause mode
       ui_seq_pause = 0;
       // TK: this makes sense! Request synch-to-measure for all tracks so that they restart properly
-      SEQ_CORE_ManualSynchToMeasure(0xffff);
+      SEQ_CORE_ManualSynchToMeasure(NULL);
     }
   }
 
@@ -783,11 +879,11 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
     // the priority handling for each individual track ensures
     // that mute/unmute will be done depending on the current mute state
     // unmute has higher priority than mute
-    seq_core_trk_muted |= (seq_core_trk_synched_mute & ~seq_core_trk_muted);
-    seq_core_trk_synched_mute = 0;
+    SEQ_CORE_TrkSetOr(&seq_core_trk_muted, &seq_core_trk_synched_mute);
+    SEQ_CORE_TrkSetClear(&seq_core_trk_synched_mute);
 
-    seq_core_trk_muted &= ~(seq_core_trk_synched_unmute & seq_core_trk_muted);
-    seq_core_trk_synched_unmute = 0;
+    SEQ_CORE_TrkSetAndNot(&seq_core_trk_muted, &seq_core_trk_synched_unmute);
+    SEQ_CORE_TrkSetClear(&seq_core_trk_synched_unmute);
   }
 
   // process all tracks
@@ -815,7 +911,7 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
       SEQ_LFO_HandleTrk(track, bpm_tick);
 
       // send LFO CC (if enabled and not muted)
-      if( !(seq_core_trk_muted & (1 << track)) && !seq_core_slaveclk_mute && !t->lfo_cc_muted_from_midi ) {
+      if( !SEQ_CORE_TRKSET_GET(&seq_core_trk_muted, track) && !seq_core_slaveclk_mute && !t->lfo_cc_muted_from_midi ) {
 	mios32_midi_package_t p;
 	if( SEQ_LFO_FastCC_Event(track, bpm_tick, &p, 0) > 0 ) {
 	  if( loopback_port )
@@ -862,6 +958,10 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
 	  else
 	    t->timestamp_next_step_ref += t->step_length;
 
+	  // the random streams of the track are located at the reference timestamp of the step,
+	  // so that the same random values are generated whenever this step is played again
+	  SEQ_RANDOM_TrackPosSet(track, t->timestamp_next_step_ref - t->step_length);
+
 	  // increment step if not in arpeggiator mode or arp position == 0
 	  u8 inc_step = tcc->mode.playmode != SEQ_CORE_TRKMODE_Arpeggiator || !t->arp_pos;
 
@@ -994,10 +1094,11 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
 	// mute for non-loopback tracks activated
 	// MIDI player in exclusive mode
 	// Record Mode, new step and FWD_MIDI off
-	u8 track_soloed = seq_core_trk_soloed && (seq_core_trk_soloed & (1 << track));
-        if( (!seq_core_trk_soloed && seq_ui_button_state.SOLO && !SEQ_UI_IsSelectedTrack(track)) ||
-	    (seq_core_trk_soloed && !track_soloed) ||
-	    (!track_soloed && (seq_core_trk_muted & (1 << track))) || // Track Mute function
+	u8 any_track_soloed = !SEQ_CORE_TrkSetIsEmpty(&seq_core_trk_soloed);
+	u8 track_soloed = any_track_soloed && SEQ_CORE_TRKSET_GET(&seq_core_trk_soloed, track);
+        if( (!any_track_soloed && seq_ui_button_state.SOLO && !SEQ_UI_IsSelectedTrack(track)) ||
+	    (any_track_soloed && !track_soloed) ||
+	    (!track_soloed && SEQ_CORE_TRKSET_GET(&seq_core_trk_muted, track)) || // Track Mute function
 	    seq_core_slaveclk_mute || // Slave Clock Mute Function
 	    SEQ_MIDI_PORT_OutMuteGet(tcc->midi_port) || // Port Mute Function
 	    tcc->mode.playmode == SEQ_CORE_TRKMODE_Off || // track disabled
@@ -1029,7 +1130,7 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
 	u16 layer_muted = (tcc->event_mode != SEQ_EVENT_MODE_Drum) ? (t->layer_muted | t->layer_muted_from_midi) : 0;
 
         // if random gate trigger set: play step with 1:1 probability
-        if( SEQ_TRG_RandomGateGet(track, t->step, 0) && (SEQ_RANDOM_Gen(0) & 1) )
+        if( SEQ_TRG_RandomGateGet(track, t->step, 0) && (SEQ_RANDOM_TrackGen(track, SEQ_RANDOM_STREAM_PROBABILITY) & 1) )
 	  continue;
 
 	// check probability if not in drum mode
@@ -1038,7 +1139,7 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
 	if( tcc->event_mode != SEQ_EVENT_MODE_Drum ) {
 	  u8 rnd_probability;
 	  if( (rnd_probability=SEQ_PAR_ProbabilityGet(track, t->step, 0, layer_muted)) < 100 &&
-	      SEQ_RANDOM_Gen_Range(0, 99) >= rnd_probability )
+	      SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_PROBABILITY, 0, 99) >= rnd_probability )
 	    continue;
 	}
 
@@ -1085,7 +1186,7 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
 	    if( tcc->event_mode == SEQ_EVENT_MODE_Drum ) {
 	      u8 rnd_probability;
 	      if( (rnd_probability=SEQ_PAR_ProbabilityGet(track, t->step, instrument, layer_muted)) < 100 &&
-		  SEQ_RANDOM_Gen_Range(0, 99) >= rnd_probability )
+		  SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_PROBABILITY, 0, 99) >= rnd_probability )
 		continue;
 	    }
 
@@ -1197,18 +1298,15 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
 
 	      tcc->mode.ROBOSUSTAIN = ( robotize_flags.SUSTAIN ) ? 1 : 0 ;// set robosustain flag
 
-	      // force to scale
-	      if( tcc->mode.FORCE_SCALE ) {
+	      // force to scale and Limit Fx (should be the last Fx in the chain!)
+	      if( !no_fx ) {
+		p->note = SEQ_CORE_NoteMapGet(track, tcc)[p->note & 0x7f]; // note is in the 0..127 range at this point
+	      } else if( tcc->mode.FORCE_SCALE ) {
 		u8 scale, root_selection, root;
 		SEQ_CORE_FTS_GetScaleAndRoot(&scale, &root_selection, &root);
 		SEQ_SCALE_Note(p, scale, root);
 	      }
 
-	      // apply Pre-FX after force-to-scale
-	      if( !no_fx ) {
-		SEQ_CORE_Limit(t, tcc, e); // should be the last Fx in the chain!
-	      }
-
 	      // force velocity to 0x7f (drum mode: selectable value) if accent flag set
 	      if( nth_trigger == SEQ_PAR_TYPE_NTH_ACCENT || SEQ_TRG_AccentGet(track, t->step, instrument) ) {
 		if( tcc->event_mode == SEQ_EVENT_MODE_Drum )
@@ -1608,6 +1706,7 @@ extern s32 SEQ_CORE_SetTrkPos(u8 track, u8 value, u8 scale_value)
 /////////////////////////////////////////////////////////////////////////////
 static s32 SEQ_CORE_NextStep(seq_core_trk_t *t, seq_cc_trk_t *tcc, u8 no_progression, u8 reverse)
 {
+  u8 track = t - &seq_core_trk[0]; // for the random stream
   int i;
   u8 save_step = 0;
   u8 new_step = 1;
@@ -1664,11 +1763,11 @@ static s32 SEQ_CORE_NextStep(seq_core_trk_t *t, seq_cc_trk_t *tcc, u8 no_progres
 
       case SEQ_CORE_TRKDIR_Random_Dir:
 	// set forward/backward direction with 1:1 probability
-	t->state.BACKWARD = SEQ_RANDOM_Gen(0) & 1;
+	t->state.BACKWARD = SEQ_RANDOM_TrackGen(track, SEQ_RANDOM_STREAM_DIRECTION) & 1;
         break;
 
       case SEQ_CORE_TRKDIR_Random_Step:
-	t->step = SEQ_RANDOM_Gen_Range(tcc->loop, tcc->length);
+	t->step = SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_DIRECTION, tcc->loop, tcc->length);
 	new_step = 0; // no new step calculation required anymore
         break;
 
@@ -1678,12 +1777,12 @@ static s32 SEQ_CORE_NextStep(seq_core_trk_t *t, seq_cc_trk_t *tcc, u8 no_progres
 	  // we change the direction with a probability of 25%
 	  // we jump to a new step with a probability of 25%
 	  u32 rnd;
-	  if( ((rnd=SEQ_RANDOM_Gen(0)) & 0xff) < 0x80 ) {
+	  if( ((rnd=SEQ_RANDOM_TrackGen(track, SEQ_RANDOM_STREAM_DIRECTION)) & 0xff) < 0x80 ) {
 	    if( rnd < 0x40 ) {
 	      // set forward/backward direction with 1:1 probability
-	      t->state.BACKWARD = SEQ_RANDOM_Gen(0) & 1;
+	      t->state.BACKWARD = SEQ_RANDOM_TrackGen(track, SEQ_RANDOM_STREAM_DIRECTION) & 1;
 	    } else {
-	      t->step = SEQ_RANDOM_Gen_Range(tcc->loop, tcc->length);
+	      t->step = SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_DIRECTION, tcc->loop, tcc->length);
 	      new_step = 0; // no new step calculation required anymore
 	    }
 	  }
@@ -1895,6 +1994,63 @@ s32 SEQ_CORE_Limit(seq_core_trk_t *t, seq_cc_trk_t *tcc, seq_layer_evnt_t *e)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Returns the note map of a track, which combines force-to-scale and the
+// Limit Fx, so that both can be applied with a single lookup:
+//   p->note = SEQ_CORE_NoteMapGet(track, tcc)[p->note];
+// The map is only recalculated if the scale, root note, force-to-scale flag
+// or limit range has been changed since the last call.
+/////////////////////////////////////////////////////////////////////////////
+static const u8 *SEQ_CORE_NoteMapGet(u8 track, seq_cc_trk_t *tcc)
+{
+  seq_core_note_map_key_t *key = &seq_core_note_map_key[track];
+  u8 *map = seq_core_note_map[track];
+
+  u8 scale, root_selection, root;
+  SEQ_CORE_FTS_GetScaleAndRoot(&scale, &root_selection, &root);
+
+  u8 force_scale = tcc->mode.FORCE_SCALE;
+  if( key->valid &&
+      key->force_scale == force_scale &&
+      (!force_scale || (key->scale == scale && key->root == root)) &&
+      key->limit_lower == tcc->limit_lower &&
+      key->limit_upper == tcc->limit_upper )
+    return map; // no change
+
+  key->valid = 1;
+  key->force_scale = force_scale;
+  key->scale = scale;
+  key->root = root;
+  key->limit_lower = tcc->limit_lower;
+  key->limit_upper = tcc->limit_upper;
+
+  // limit range like in SEQ_CORE_Limit()
+  u8 lower = tcc->limit_lower;
+  u8 upper = tcc->limit_upper;
+  if( lower || upper ) {
+    if( !upper )
+      upper = 127;
+
+    if( lower > upper ) {
+      u8 tmp = upper;
+      upper=lower;
+      lower=tmp;
+    }
+  } else {
+    lower = 0;
+    upper = 127;
+  }
+
+  int note;
+  for(note=0; note<128; ++note) {
+    u8 mapped = force_scale ? SEQ_SCALE_NoteValueGet(note, scale, root) : note;
+    map[note] = SEQ_CORE_TrimNote(mapped, lower, upper);
+  }
+
+  return map;
+}
+
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Name of Delay mode (we should outsource the echo function to seq_echo.c later)
@@ -1990,46 +2146,114 @@ u8 SEQ_CORE_Echo_MapInternalToUser(u8 internal_value)
 
 /////////////////////////////////////////////////////////////////////////////
 // Echo Fx
+// Only the first repeat is scheduled immediately, the remaining repeats are
+// handled by a repeat descriptor which is queued as SEQ_MIDI_OUT_RepeatEvent:
+// whenever it's due, it schedules the next repeat and re-schedules itself
+// for the repeat after. Accordingly each echo only occupies a constant
+// number of queue items, regardless of the number of repeats.
+// The repeat timestamps are always derived from the original event time.
+// A negative port delay moves the events earlier than the grid, therefore
+// the descriptor is called earlier by this delay (lookahead); repeats which
+// are due before the next call are scheduled at once.
 /////////////////////////////////////////////////////////////////////////////
-s32 SEQ_CORE_Echo(seq_core_trk_t *t, seq_cc_trk_t *tcc, mios32_midi_package_t p, u32 bpm_tick, u32 gatelength, seq_robotize_flags_t robotize_flags)
+
+// returns the delay to the next repeat (no feedback of echo ticks on first step)
+static s32 SEQ_CORE_EchoNextDelay(seq_core_echo_t *e)
 {
-  // thanks to MIDI queuing mechanism, this is a no-brainer :)
+  if( e->repeat_ctr && e->fb_ticks != 20 ) // 20 == 100% -> no change
+    return (e->delay * 5*e->fb_ticks) / 100;
 
-  // 64T, 64, 32T, 32, 16T, 16, ... 1, Rnd1 and Rnd2, 64d..2d (new), 0 (supernew)
-  s32 fb_ticks;
-  s32 echo_delay = tcc->echo_delay;
-  if( echo_delay >= 22 ) // new zero delay
-    fb_ticks = 0;
-  else if ( echo_delay >= 16 ) // new dotted delays
-    fb_ticks = 36 * (1 << (echo_delay-16));
-  else {
-    if( echo_delay >= 14 ) // Rnd1 and Rnd2
-      echo_delay = SEQ_RANDOM_Gen_Range(3, 7); // between 32 and 8
-    fb_ticks = ((tcc->echo_delay & 1) ? 24 : 16) * (1 << (echo_delay>>1));
+  return e->delay;
+}
+
+// performs a single repeat: applies the feedback values and schedules the event
+// repeat_timestamp contains the timestamp of the previous repeat, it will be incremented by the delay
+static s32 SEQ_CORE_EchoRepeat(seq_core_echo_t *e, u32 *repeat_timestamp)
+{
+  seq_core_trk_t *t = &seq_core_trk[e->track];
+
+  if( e->repeat_ctr ) { // no feedback of velocity on first step
+    if( e->fb_velocity != 20 ) { // 20 == 100% -> no change
+      s32 fb_velocity = (e->p.velocity * 5*e->fb_velocity) / 100;
+      if( fb_velocity > 127 )
+	fb_velocity = 127;
+      e->p.velocity = (u8)fb_velocity;
+    }
   }
+  e->delay = SEQ_CORE_EchoNextDelay(e);
+  *repeat_timestamp += e->delay;
 
-  s32 fb_note = p.note;
-  s32 fb_note_base = fb_note; // for random function
+  if( e->fb_note != 24 ) { // 24 == 0 -> no change
+    s32 fb_note;
+    if( e->fb_note == 49 ) // random (values have been reserved in the track stream when the note was played)
+      fb_note = e->note_base + ((s32)SEQ_RANDOM_TrackStreamGen_Range(&e->random_stream, 0, 48) - 24);
+    else
+      fb_note = e->p.note + ((s32)e->fb_note-24);
 
-  // the initial velocity value allows to start with a low velocity,
-  // and to increase it with each step via FB velocity value
-  s32 fb_velocity = p.velocity;
-  if( tcc->echo_velocity != 20 ) { // 20 == 100% -> no change
-    fb_velocity = (fb_velocity * 5*tcc->echo_velocity) / 100;
-    if( fb_velocity > 127 )
-      fb_velocity = 127;
-    p.velocity = (u8)fb_velocity;
+    // ensure that note is in the 0..127 range
+    e->p.note = (u8)SEQ_CORE_TrimNote(fb_note, 0, 127);
   }
 
-  seq_midi_out_event_type_t event_type = SEQ_MIDI_OUT_OnOffEvent;
-  if( (p.type == CC || p.type == PitchBend || p.type == ProgramChange) && !gatelength )
-    event_type = SEQ_MIDI_OUT_CCEvent;
+  if( e->gatelength && e->fb_gatelength != 20 ) { // 20 == 100% -> no change
+    e->gatelength = (e->gatelength * 5*e->fb_gatelength) / 100;
+    if( !e->gatelength )
+      e->gatelength = 1;
+  }
 
-  // for the case that force-to-scale is activated
-  u8 scale, root_selection, root;
-  SEQ_CORE_FTS_GetScaleAndRoot(&scale, &root_selection, &root);
+  // force to scale
+  mios32_midi_package_t p = e->p;
+  if( e->force_scale ) {
+    SEQ_SCALE_Note(&p, e->scale, e->root);
+  }
+
+  seq_robotize_flags_t robotize_flags;
+  robotize_flags.ALL = e->robotize_flags;
+
+  ++e->repeat_ctr;
+  return SEQ_CORE_ScheduleEventPortCfg(t, &e->port_cfg, p, e->event_type, *repeat_timestamp, e->gatelength, 1, robotize_flags);
+}
+
+// schedules the next repeat, and all further repeats which are due before the descriptor could be called again
+// returns 1 if repeats are left, next_timestamp contains the timestamp at which the descriptor has to be called
+static s32 SEQ_CORE_EchoScheduleRepeats(seq_core_echo_t *e, u32 timestamp, u32 *next_timestamp)
+{
+  do {
+    SEQ_CORE_EchoRepeat(e, &e->timestamp);
+
+    if( e->repeat_ctr >= e->num_repeats )
+      return 0; // finished
+
+    *next_timestamp = e->timestamp + SEQ_CORE_EchoNextDelay(e);
+    *next_timestamp = (*next_timestamp > e->lookahead) ? (*next_timestamp - e->lookahead) : 0;
+  } while( *next_timestamp <= timestamp );
+
+  return 1;
+}
+
+// called by SEQ_MIDI_OUT_Handler() when a repeat descriptor is due
+static s32 SEQ_CORE_EchoRepeatCallback(u16 repeat_id, u32 timestamp, u32 *next_timestamp)
+{
+  if( repeat_id >= SEQ_CORE_ECHO_NUM_SLOTS )
+    return 0; // invalid ID
+
+  seq_core_echo_t *e = &seq_core_echo[repeat_id];
+  if( next_timestamp == NULL || !e->active ) {
+    e->active = 0; // removed from queue
+    return 0;
+  }
+
+  if( SEQ_CORE_EchoScheduleRepeats(e, timestamp, next_timestamp) < 1 ) {
+    e->active = 0;
+    return 0; // finished
+  }
+
+  return 1; // call again for the next repeat
+}
+
+s32 SEQ_CORE_Echo(seq_core_trk_t *t, seq_cc_trk_t *tcc, mios32_midi_package_t p, u32 bpm_tick, u32 gatelength, seq_robotize_flags_t robotize_flags)
+{
+  u8 track = t - &seq_core_trk[0]; // for the random stream
 
-  u32 echo_offset = fb_ticks;
   u8 echo_repeats = tcc->echo_repeats;
 
   if( robotize_flags.ECHO ) {
@@ -2040,48 +2264,97 @@ s32 SEQ_CORE_Echo(seq_core_trk_t *t, seq_cc_trk_t *tcc, mios32_midi_package_t p,
 	
   if( echo_repeats & 0x40 && !robotize_flags.ECHO) // disable flag
     echo_repeats = 0;
-    
-    
-  int i;
-  for(i=0; i<echo_repeats; ++i) {
-    if( i ) { // no feedback of velocity or echo ticks on first step
-      if( tcc->echo_fb_velocity != 20 ) { // 20 == 100% -> no change
-	fb_velocity = (fb_velocity * 5*tcc->echo_fb_velocity) / 100;
-	if( fb_velocity > 127 )
-	  fb_velocity = 127;
-	p.velocity = (u8)fb_velocity;
-      }
 
-      if( tcc->echo_fb_ticks != 20 ) { // 20 == 100% -> no change
-	fb_ticks = (fb_ticks * 5*tcc->echo_fb_ticks) / 100;
-      }
-      echo_offset += fb_ticks;
+  if( !echo_repeats )
+    return 0; // nothing to do
+
+  // take a free repeat descriptor - if no one is available, we use a temporary one and schedule all repeats immediately
+  seq_core_echo_t tmp_echo;
+  seq_core_echo_t *e = &tmp_echo;
+  u16 repeat_id;
+  for(repeat_id=0; repeat_id<SEQ_CORE_ECHO_NUM_SLOTS; ++repeat_id) {
+    if( !seq_core_echo[repeat_id].active ) {
+      e = &seq_core_echo[repeat_id];
+      break;
     }
+  }
 
-    if( tcc->echo_fb_note != 24 ) { // 24 == 0 -> no change
-      if( tcc->echo_fb_note == 49 ) // random
-	fb_note = fb_note_base + ((s32)SEQ_RANDOM_Gen_Range(0, 48) - 24);
-      else
-	fb_note = fb_note + ((s32)tcc->echo_fb_note-24);
+  e->track = track;
+  e->num_repeats = echo_repeats;
+  e->repeat_ctr = 0;
+  e->robotize_flags = robotize_flags.ALL;
 
-      // ensure that note is in the 0..127 range
-      fb_note = SEQ_CORE_TrimNote(fb_note, 0, 127);
+  // 64T, 64, 32T, 32, 16T, 16, ... 1, Rnd1 and Rnd2, 64d..2d (new), 0 (supernew)
+  s32 echo_delay = tcc->echo_delay;
+  if( echo_delay >= 22 ) // new zero delay
+    e->delay = 0;
+  else if ( echo_delay >= 16 ) // new dotted delays
+    e->delay = 36 * (1 << (echo_delay-16));
+  else {
+    if( echo_delay >= 14 ) // Rnd1 and Rnd2
+      echo_delay = SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_ECHO, 3, 7); // between 32 and 8
+    e->delay = ((tcc->echo_delay & 1) ? 24 : 16) * (1 << (echo_delay>>1));
+  }
 
-      p.note = (u8)fb_note;
-    }
+  // feedback values are taken over when the note is played
+  e->fb_velocity = tcc->echo_fb_velocity;
+  e->fb_note = tcc->echo_fb_note;
+  e->fb_gatelength = tcc->echo_fb_gatelength;
+  e->fb_ticks = tcc->echo_fb_ticks;
+  e->note_base = p.note; // for random function
+  if( e->fb_note == 49 ) // one random value per repeat
+    SEQ_RANDOM_TrackStreamTake(track, SEQ_RANDOM_STREAM_ECHO, echo_repeats, &e->random_stream);
 
-    if( gatelength && tcc->echo_fb_gatelength != 20 ) { // 20 == 100% -> no change
-      gatelength = (gatelength * 5*tcc->echo_fb_gatelength) / 100;
-      if( !gatelength )
-	gatelength = 1;
-    }
+  // the initial velocity value allows to start with a low velocity,
+  // and to increase it with each step via FB velocity value
+  if( tcc->echo_velocity != 20 ) { // 20 == 100% -> no change
+    s32 fb_velocity = (p.velocity * 5*tcc->echo_velocity) / 100;
+    if( fb_velocity > 127 )
+      fb_velocity = 127;
+    p.velocity = (u8)fb_velocity;
+  }
+  e->p = p;
+  e->gatelength = gatelength;
+
+  SEQ_CORE_PortCfgGet(tcc, &e->port_cfg);
+
+  // the descriptor has to be called before the repeats are moved by a negative port delay
+  e->lookahead = 0;
+#if SEQ_MIDI_OUT_SUPPORT_DELAY
+  {
+    s32 delay = SEQ_MIDI_OUT_DelayGet(e->port_cfg.midi_port);
+    s32 fx_delay = SEQ_MIDI_OUT_DelayGet(e->port_cfg.fx_midi_port ? e->port_cfg.fx_midi_port : e->port_cfg.midi_port);
+    if( fx_delay < delay )
+      delay = fx_delay;
+    if( delay < 0 )
+      e->lookahead = (u8)-delay;
+  }
+#endif
 
-    // force to scale
-    if( tcc->mode.FORCE_SCALE ) {
-      SEQ_SCALE_Note(&p, scale, root);
-    }
+  e->event_type = SEQ_MIDI_OUT_OnOffEvent;
+  if( (p.type == CC || p.type == PitchBend || p.type == ProgramChange) && !gatelength )
+    e->event_type = SEQ_MIDI_OUT_CCEvent;
 
-    SEQ_CORE_ScheduleEvent(t, tcc, p, event_type, bpm_tick + echo_offset, gatelength, 1, robotize_flags);
+  // for the case that force-to-scale is activated
+  u8 scale, root_selection, root;
+  SEQ_CORE_FTS_GetScaleAndRoot(&scale, &root_selection, &root);
+  e->force_scale = tcc->mode.FORCE_SCALE;
+  e->scale = scale;
+  e->root = root;
+
+  // schedule first repeat (and the repeats which are due before the descriptor could be called)
+  u32 next_timestamp;
+  e->timestamp = bpm_tick;
+  if( SEQ_CORE_EchoScheduleRepeats(e, bpm_tick, &next_timestamp) > 0 ) {
+    if( e != &tmp_echo ) {
+      e->active = 1;
+      if( SEQ_MIDI_OUT_Send(0, p, SEQ_MIDI_OUT_RepeatEvent, next_timestamp, repeat_id) < 0 )
+	e->active = 0; // out of memory: skip remaining repeats
+    } else {
+      // no free descriptor: schedule remaining repeats immediately
+      while( e->repeat_ctr < e->num_repeats )
+	SEQ_CORE_EchoRepeat(e, &e->timestamp);
+    }
   }
 
   return 0; // no error
@@ -2116,15 +2389,16 @@ s32 SEQ_CORE_ManualTrigger(u8 step)
 
 /////////////////////////////////////////////////////////////////////////////
 // Manually requests synch to measure for given tracks
+// NULL: all tracks
 /////////////////////////////////////////////////////////////////////////////
-s32 SEQ_CORE_ManualSynchToMeasure(u16 tracks)
+s32 SEQ_CORE_ManualSynchToMeasure(seq_core_trkset_t *tracks)
 {
   MIOS32_IRQ_Disable();
 
   u8 track;
   seq_core_trk_t *t = &seq_core_trk[0];
   for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track, ++t)
-    if( tracks & (1 << track) )
+    if( !tracks || SEQ_CORE_TRKSET_GET(tracks, track) )
       t->state.SYNC_MEASURE = 1;
 
   MIOS32_IRQ_Enable();
@@ -2417,3 +2691,130 @@ u8 SEQ_CORE_TrimNote(s32 note, u8 lower, u8 upper)
 
   return note;
 }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Track set utilities
+// Single track flags are accessed with the SEQ_CORE_TRKSET_* macros
+/////////////////////////////////////////////////////////////////////////////
+
+// mask of the valid tracks in the last word
+#if (SEQ_CORE_NUM_TRACKS % 32)
+#define TRKSET_LAST_WORD_MASK ((1UL << (SEQ_CORE_NUM_TRACKS % 32)) - 1)
+#else
+#define TRKSET_LAST_WORD_MASK 0xffffffff
+#endif
+
+s32 SEQ_CORE_TrkSetClear(seq_core_trkset_t *set)
+{
+  int i;
+  for(i=0; i<SEQ_CORE_TRKSET_NUM_WORDS; ++i)
+    set->word[i] = 0;
+
+  return 0; // no error
+}
+
+s32 SEQ_CORE_TrkSetFill(seq_core_trkset_t *set)
+{
+  int i;
+  for(i=0; i<(SEQ_CORE_TRKSET_NUM_WORDS-1); ++i)
+    set->word[i] = 0xffffffff;
+  set->word[SEQ_CORE_TRKSET_NUM_WORDS-1] = TRKSET_LAST_WORD_MASK;
+
+  return 0; // no error
+}
+
+// returns 1 if no track flag is set
+s32 SEQ_CORE_TrkSetIsEmpty(seq_core_trkset_t *set)
+{
+  int i;
+  for(i=0; i<SEQ_CORE_TRKSET_NUM_WORDS; ++i)
+    if( set->word[i] )
+      return 0;
+
+  return 1;
+}
+
+// returns 1 if the flags of all tracks are set
+s32 SEQ_CORE_TrkSetIsFull(seq_core_trkset_t *set)
+{
+  int i;
+  for(i=0; i<(SEQ_CORE_TRKSET_NUM_WORDS-1); ++i)
+    if( set->word[i] != 0xffffffff )
+      return 0;
+
+  return set->word[SEQ_CORE_TRKSET_NUM_WORDS-1] == TRKSET_LAST_WORD_MASK;
+}
+
+// set |= src
+s32 SEQ_CORE_TrkSetOr(seq_core_trkset_t *set, seq_core_trkset_t *src)
+{
+  int i;
+  for(i=0; i<SEQ_CORE_TRKSET_NUM_WORDS; ++i)
+    set->word[i] |= src->word[i];
+
+  return 0; // no error
+}
+
+// set &= ~src
+s32 SEQ_CORE_TrkSetAndNot(seq_core_trkset_t *set, seq_core_trkset_t *src)
+{
+  int i;
+  for(i=0; i<SEQ_CORE_TRKSET_NUM_WORDS; ++i)
+    set->word[i] &= ~src->word[i];
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the flags of 16 tracks starting at first_track as u16 mask, as
+// used by the UI (16 GP buttons), BLM extra column and bookmarks.
+// first_track has to be a multiple of 16
+/////////////////////////////////////////////////////////////////////////////
+u16 SEQ_CORE_TrkSetGet16(seq_core_trkset_t *set, u8 first_track)
+{
+  if( first_track >= SEQ_CORE_NUM_TRACKS )
+    return 0;
+
+  return (set->word[first_track >> 5] >> (first_track & 16)) & 0xffff;
+}
+
+s32 SEQ_CORE_TrkSetSet16(seq_core_trkset_t *set, u8 first_track, u16 value)
+{
+  if( first_track >= SEQ_CORE_NUM_TRACKS )
+    return -1; // invalid track
+
+  if( (SEQ_CORE_NUM_TRACKS - first_track) < 16 )
+    value &= (1 << (SEQ_CORE_NUM_TRACKS - first_track)) - 1;
+
+  u32 *word = &set->word[first_track >> 5];
+  u8 shift = first_track & 16;
+  *word = (*word & ~(0xffffUL << shift)) | ((u32)value << shift);
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the flags of the 4 tracks of a group (bit 0: first track)
+/////////////////////////////////////////////////////////////////////////////
+u8 SEQ_CORE_TrkSetGroupGet(seq_core_trkset_t *set, u8 group)
+{
+  if( group >= SEQ_CORE_NUM_GROUPS )
+    return 0;
+
+  u8 first_track = group * SEQ_CORE_NUM_TRACKS_PER_GROUP;
+  return (set->word[first_track >> 5] >> (first_track & 31)) & 0xf;
+}
+
+s32 SEQ_CORE_TrkSetGroupSet(seq_core_trkset_t *set, u8 group, u8 value)
+{
+  if( group >= SEQ_CORE_NUM_GROUPS )
+    return -1; // invalid group
+
+  u8 first_track = group * SEQ_CORE_NUM_TRACKS_PER_GROUP;
+  u32 *word = &set->word[first_track >> 5];
+  u8 shift = first_track & 31;
+  *word = (*word & ~(0xfUL << shift)) | ((u32)(value & 0xf) << shift);
+
+  return 0; // no error
+}
@@ -18,10 +18,22 @@
 // Global definitions
 /////////////////////////////////////////////////////////////////////////////
 
+// the number of groups can be overruled in mios32_config.h, e.g. 8 (32 tracks) or 16 (64 tracks)
+// for STM32F4 targets with enough RAM
+// the UI, BLM and bookmarks still address the first 16 tracks
+#ifndef SEQ_CORE_NUM_GROUPS
 #define SEQ_CORE_NUM_GROUPS            4
+#endif
 #define SEQ_CORE_NUM_TRACKS_PER_GROUP  4
 #define SEQ_CORE_NUM_TRACKS            (SEQ_CORE_NUM_TRACKS_PER_GROUP*SEQ_CORE_NUM_GROUPS)
 
+#if SEQ_CORE_NUM_TRACKS > 128
+# error "SEQ_CORE_NUM_TRACKS: max. 128 tracks supported (u8 track index)"
+#endif
+
+// number of 32bit words stored in a track set
+#define SEQ_CORE_TRKSET_NUM_WORDS      ((SEQ_CORE_NUM_TRACKS+31)/32)
+
 #define SEQ_CORE_NUM_BPM_PRESETS       16
 
 
@@ -29,6 +41,17 @@
 // Global Types
 /////////////////////////////////////////////////////////////////////////////
 
+// one flag per track (mutes, solo, reset requests...)
+typedef struct {
+  u32 word[SEQ_CORE_TRKSET_NUM_WORDS];
+} seq_core_trkset_t;
+
+// access to a single track flag (used in the tick handler, therefore macros)
+#define SEQ_CORE_TRKSET_GET(set, track)    (((set)->word[(track) >> 5] >> ((track) & 31)) & 1)
+#define SEQ_CORE_TRKSET_SET(set, track)    ((set)->word[(track) >> 5] |=  (1UL << ((track) & 31)))
+#define SEQ_CORE_TRKSET_CLR(set, track)    ((set)->word[(track) >> 5] &= ~(1UL << ((track) & 31)))
+#define SEQ_CORE_TRKSET_TOGGLE(set, track) ((set)->word[(track) >> 5] ^=  (1UL << ((track) & 31)))
+
 typedef union {
   u32 ALL;
   struct {
@@ -49,7 +72,7 @@ typedef union {
   struct {
     u16 ref_step; // u16 instead of u8 to cover overrun on 256 steps per measure
     u16 ref_step_song; // reference step can be different in song mode if a guide track is used
-    u16 reset_trkpos_req; // resets the track with the next step
+    seq_core_trkset_t reset_trkpos_req; // resets the track with the next step
 
     u16 FIRST_CLK:1;
     u16 FORCE_REF_STEP_RESET:1;
@@ -248,7 +271,7 @@ extern s32 SEQ_CORE_ResetTrkPosAll(void);
 extern s32 SEQ_CORE_SetTrkPos(u8 track, u8 value, u8 scale_value);
 
 extern s32 SEQ_CORE_ManualTrigger(u8 step);
-extern s32 SEQ_CORE_ManualSynchToMeasure(u16 tracks);
+extern s32 SEQ_CORE_ManualSynchToMeasure(seq_core_trkset_t *tracks);
 
 extern s32 SEQ_CORE_NotifyIncomingMIDIEvent(u8 track, mios32_midi_package_t p);
 
@@ -263,6 +286,17 @@ extern s32 SEQ_CORE_CancelSustainedNotes(u8 track);
 
 extern u8 SEQ_CORE_TrimNote(s32 note, u8 lower, u8 upper);
 
+extern s32 SEQ_CORE_TrkSetClear(seq_core_trkset_t *set);
+extern s32 SEQ_CORE_TrkSetFill(seq_core_trkset_t *set);
+extern s32 SEQ_CORE_TrkSetIsEmpty(seq_core_trkset_t *set);
+extern s32 SEQ_CORE_TrkSetIsFull(seq_core_trkset_t *set);
+extern s32 SEQ_CORE_TrkSetOr(seq_core_trkset_t *set, seq_core_trkset_t *src);
+extern s32 SEQ_CORE_TrkSetAndNot(seq_core_trkset_t *set, seq_core_trkset_t *src);
+extern u16 SEQ_CORE_TrkSetGet16(seq_core_trkset_t *set, u8 first_track);
+extern s32 SEQ_CORE_TrkSetSet16(seq_core_trkset_t *set, u8 first_track, u16 value);
+extern u8 SEQ_CORE_TrkSetGroupGet(seq_core_trkset_t *set, u8 group);
+extern s32 SEQ_CORE_TrkSetGroupSet(seq_core_trkset_t *set, u8 group, u8 value);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
@@ -272,11 +306,11 @@ extern seq_core_options_t seq_core_options;
 extern u8 seq_core_steps_per_measure;
 extern u8 seq_core_steps_per_pattern;
 
-extern u16 seq_core_trk_muted;
-extern u16 seq_core_trk_synched_mute;
-extern u16 seq_core_trk_synched_unmute;
+extern seq_core_trkset_t seq_core_trk_muted;
+extern seq_core_trkset_t seq_core_trk_synched_mute;
+extern seq_core_trkset_t seq_core_trk_synched_unmute;
 extern seq_core_slaveclk_mute_t seq_core_slaveclk_mute;
-extern u16 seq_core_trk_soloed;
+extern seq_core_trkset_t seq_core_trk_soloed;
 
 extern u8 seq_core_step_update_req;
 
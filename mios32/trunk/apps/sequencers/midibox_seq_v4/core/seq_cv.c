@@ -18,6 +18,7 @@
 #include <mios32.h>
 #include <aout.h>
 #include <notestack.h>
+#include <seq_midi_out.h>
 
 
 #include "seq_cv.h"
@@ -34,6 +35,27 @@
 // mirror J5.A0 at P0.4 (J18, CAN port) since the original IO doesn't work on his LPCXPRESSO anymore
 #define MIRROR_J5_A0_AT_J18 1
 
+// output latency and clock pulsewidth in timer periods
+#define OUTPUT_LATENCY_PERIODS (SEQ_CV_OUTPUT_LATENCY_US / SEQ_CV_TIMER_PERIOD_US)
+#define PULSEWIDTH_PERIODS     (1000 / SEQ_CV_TIMER_PERIOD_US)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+  SEQ_CV_EVENT_PACKAGE,
+  SEQ_CV_EVENT_CLK_TRIGGER,
+} seq_cv_event_type_t;
+
+typedef struct {
+  u32 time; // in timer periods
+  mios32_midi_package_t package;
+  seq_cv_event_type_t type;
+} seq_cv_event_t;
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Global variables
 /////////////////////////////////////////////////////////////////////////////
@@ -49,12 +71,50 @@ u8  seq_cv_clkout_pulsewidth[SEQ_CV_NUM_CLKOUT];
 static u8 gates;
 static u8 gate_inversion_mask;
 
-static u8 seq_cv_clkout_pulse_ctr[SEQ_CV_NUM_CLKOUT];
+static u16 seq_cv_clkout_pulse_ctr[SEQ_CV_NUM_CLKOUT];
 
 // each channel has an own notestack
 static notestack_t cv_notestack[SEQ_CV_NUM];
 static notestack_item_t cv_notestack_items[SEQ_CV_NUM][SEQ_CV_NOTESTACK_SIZE];
 
+#if SEQ_CV_TIMED_OUTPUT
+// timestamped events, written by the sequencer task and read by the timer interrupt
+static seq_cv_event_t event_queue[SEQ_CV_EVENT_QUEUE_SIZE];
+static volatile u16 event_queue_head;
+static volatile u16 event_queue_tail;
+
+// time base of the output stage (incremented each SEQ_CV_TIMER_PERIOD_US)
+static volatile u32 timer_ctr;
+
+// time at which the last BPM tick has been noticed
+static u32 last_bpm_tick;
+static u32 last_bpm_tick_time;
+
+// set while the AOUT interface is re-configured
+static volatile u8 aout_update_locked;
+
+// set by the output stage if new CV values have to be transfered by SEQ_CV_Update()
+static volatile u8 aout_update_pending;
+
+// time of the last AOUT_Update() call (slew rate is stepped each mS)
+static u32 last_aout_update_time;
+#endif
+
+// called by the output stage to resume the task which calls SEQ_CV_Update()
+static void (*update_callback_func)(void);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static s32 SEQ_CV_ProcessPackage(mios32_midi_package_t package);
+static s32 SEQ_CV_UpdateGates(void);
+#if SEQ_CV_TIMED_OUTPUT
+static s32 SEQ_CV_QueueEvent(seq_cv_event_type_t type, mios32_midi_package_t package);
+static void SEQ_CV_Timer(void);
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initialisation
@@ -117,6 +177,18 @@ s32 SEQ_CV_Init(u32 mode)
   // reset all channels
   SEQ_CV_ResetAllChannels();
 
+#if SEQ_CV_TIMED_OUTPUT
+  // start output stage
+  event_queue_head = event_queue_tail = 0;
+  timer_ctr = 0;
+  last_bpm_tick = SEQ_BPM_TickGet();
+  last_bpm_tick_time = 0;
+  aout_update_locked = 0;
+  aout_update_pending = 0;
+  last_aout_update_time = 0;
+  MIOS32_TIMER_Init(SEQ_CV_TIMER_NUM, SEQ_CV_TIMER_PERIOD_US, SEQ_CV_Timer, MIOS32_IRQ_PRIO_MID);
+#endif
+
   return 0; // no error
 }
 
@@ -135,8 +207,16 @@ s32 SEQ_CV_IfSet(aout_if_t if_type)
   config.if_option = (config.if_type == AOUT_IF_74HC595) ? 0xffffffff : 0x00000000; // AOUT_LC: select 8/8 bit configuration
   config.num_channels = 8;
   //config.chn_inverted = 0; // configurable
+#if SEQ_CV_TIMED_OUTPUT
+  // don't access the interface from the timer interrupt while it's re-initialized
+  aout_update_locked = 1;
+#endif
   AOUT_ConfigSet(config);
-  return AOUT_IF_Init(0);
+  s32 status = AOUT_IF_Init(0);
+#if SEQ_CV_TIMED_OUTPUT
+  aout_update_locked = 0;
+#endif
+  return status;
 }
 
 aout_if_t SEQ_CV_IfGet(void)
@@ -266,10 +346,12 @@ s32 SEQ_CV_GateInversionSet(u8 gate, u8 inverted)
   if( gate >= SEQ_CV_NUM )
     return -1; // invalid gate selected
 
+  MIOS32_IRQ_Disable(); // the mask is also read by the output stage
   if( inverted )
     gate_inversion_mask |= (1 << gate);
   else
     gate_inversion_mask &= ~(1 << gate);
+  MIOS32_IRQ_Enable();
 
   return 0; // no error
 }
@@ -358,15 +440,190 @@ s32 SEQ_CV_Clk_Trigger(u8 clkout)
   if( clkout >= SEQ_CV_NUM_CLKOUT )
     return -1; // invalid clkout
 
+#if SEQ_CV_TIMED_OUTPUT
+  // pulse will be started by the output stage
+  mios32_midi_package_t package;
+  package.ALL = 0;
+  package.evnt1 = clkout;
+  return SEQ_CV_QueueEvent(SEQ_CV_EVENT_CLK_TRIGGER, package);
+#else
   seq_cv_clkout_pulse_ctr[clkout] = seq_cv_clkout_pulsewidth[clkout] + 1;
   return 0; // no error
+#endif
 }
 
 
 /////////////////////////////////////////////////////////////////////////////
 // Updates all CV channels and gates
+// Called from SEQ_TASK_MIDI each mS
 /////////////////////////////////////////////////////////////////////////////
 s32 SEQ_CV_Update(void)
+{
+#if SEQ_CV_TIMED_OUTPUT
+  // gates and clocks are latched by the output stage (timer interrupt).
+  // The AOUT channels are transfered here, since the SPI port is shared with
+  // other drivers and shouldn't be accessed from interrupt context.
+  // The output stage resumes the task via the update callback once new values are due,
+  // otherwise the update is done each mS, so that the slew rate is stepped like before.
+  u32 now = timer_ctr;
+  if( !aout_update_pending && (now - last_aout_update_time) < (1000 / SEQ_CV_TIMER_PERIOD_US) )
+    return 0; // no error
+
+  aout_update_pending = 0;
+  last_aout_update_time = now;
+
+  if( aout_update_locked )
+    return 0; // interface is re-configured
+
+  return AOUT_Update();
+#else
+  SEQ_CV_UpdateGates();
+  return AOUT_Update();
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Installs a callback which is called by the output stage (from interrupt
+// context!) whenever new CV values have been set. It should resume the task
+// which calls SEQ_CV_Update(), so that the AOUT channels follow the gates
+// without waiting for the next mS
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_CV_UpdateCallback_Init(void (*callback_func)(void))
+{
+  update_callback_func = callback_func;
+
+  return 0; // no error
+}
+
+
+#if SEQ_CV_TIMED_OUTPUT
+/////////////////////////////////////////////////////////////////////////////
+// Returns the time at which an event should be output.
+// Events sent by SEQ_MIDI_OUT_Handler() are placed relative to the BPM tick
+// they belong to, all other events are output immediately
+/////////////////////////////////////////////////////////////////////////////
+static u32 SEQ_CV_EventTime(void)
+{
+  u32 now = timer_ctr;
+  u32 tick;
+
+  if( !SEQ_MIDI_OUT_DispatchTimestampGet(&tick) )
+    return now;
+
+  MIOS32_IRQ_Disable();
+  s32 ticks_ago = (s32)(last_bpm_tick - tick);
+  u32 tick_time = last_bpm_tick_time;
+  MIOS32_IRQ_Enable();
+
+  if( ticks_ago < 0 ) {
+    // the tick hasn't been noticed by the output stage yet, it happened within the last timer period
+    ticks_ago = 0;
+    tick_time = now;
+  }
+
+  // the tick has to be within the output latency, otherwise no valid reference is available
+  // (e.g. after song position change)
+  u32 tick_period = SEQ_BPM_TickPeriod_uS();
+  if( !tick_period || (u32)ticks_ago > (SEQ_CV_OUTPUT_LATENCY_US / tick_period) )
+    return now;
+
+  u32 time = tick_time + OUTPUT_LATENCY_PERIODS - (ticks_ago * tick_period) / SEQ_CV_TIMER_PERIOD_US;
+  if( (s32)(time - now) < 0 )
+    time = now;
+
+  return time;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Puts an event into the output queue
+/////////////////////////////////////////////////////////////////////////////
+static s32 SEQ_CV_QueueEvent(seq_cv_event_type_t type, mios32_midi_package_t package)
+{
+  u32 time = SEQ_CV_EventTime();
+
+  MIOS32_IRQ_Disable();
+
+  u16 next_head = (event_queue_head + 1) % SEQ_CV_EVENT_QUEUE_SIZE;
+  if( next_head == event_queue_tail ) {
+    // queue full: output event immediately (interrupts are disabled, so that we don't conflict with the timer)
+    if( type == SEQ_CV_EVENT_CLK_TRIGGER )
+      seq_cv_clkout_pulse_ctr[package.evnt1] = seq_cv_clkout_pulsewidth[package.evnt1] * PULSEWIDTH_PERIODS + 1;
+    else {
+      SEQ_CV_ProcessPackage(package);
+      aout_update_pending = 1;
+    }
+  } else {
+    // the queue is processed in FIFO order, therefore ensure that events never overtake each other
+    if( event_queue_head != event_queue_tail ) {
+      u32 prev_time = event_queue[(event_queue_head + SEQ_CV_EVENT_QUEUE_SIZE - 1) % SEQ_CV_EVENT_QUEUE_SIZE].time;
+      if( (s32)(time - prev_time) < 0 )
+	time = prev_time;
+    }
+
+    seq_cv_event_t *e = &event_queue[event_queue_head];
+    e->time = time;
+    e->package = package;
+    e->type = type;
+    event_queue_head = next_head;
+  }
+
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Output stage, called each SEQ_CV_TIMER_PERIOD_US
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_CV_Timer(void)
+{
+  u32 now = ++timer_ctr;
+
+  // notice the time of the last BPM tick (reference for SEQ_CV_EventTime())
+  u32 bpm_tick = SEQ_BPM_TickGet();
+  if( bpm_tick != last_bpm_tick ) {
+    last_bpm_tick = bpm_tick;
+    last_bpm_tick_time = now;
+  }
+
+  // apply all events which are due
+  u8 cv_changed = 0;
+  while( event_queue_tail != event_queue_head ) {
+    seq_cv_event_t *e = &event_queue[event_queue_tail];
+    if( (s32)(e->time - now) > 0 )
+      break;
+
+    if( e->type == SEQ_CV_EVENT_CLK_TRIGGER )
+      seq_cv_clkout_pulse_ctr[e->package.evnt1] = seq_cv_clkout_pulsewidth[e->package.evnt1] * PULSEWIDTH_PERIODS + 1;
+    else {
+      SEQ_CV_ProcessPackage(e->package);
+      cv_changed = 1;
+    }
+
+    event_queue_tail = (event_queue_tail + 1) % SEQ_CV_EVENT_QUEUE_SIZE;
+  }
+
+  // latch gates and clocks
+  SEQ_CV_UpdateGates();
+
+  // the AOUT channels are transfered by SEQ_CV_Update()
+  if( cv_changed ) {
+    aout_update_pending = 1;
+    if( update_callback_func )
+      update_callback_func();
+  }
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Updates clock outputs and gates
+// (the AOUT digital pins are transfered with the next AOUT_Update() call)
+/////////////////////////////////////////////////////////////////////////////
+static s32 SEQ_CV_UpdateGates(void)
 {
   static u8 last_gates = 0xff; // to force an update
   static u8 last_start_stop = 0xff; // to force an update
@@ -379,7 +636,7 @@ s32 SEQ_CV_Update(void)
   {
     int clkout;
     u16 *clk_divider = (u16 *)&seq_cv_clkout_divider[0];
-    u8 *pulse_ctr = (u8 *)&seq_cv_clkout_pulse_ctr[0];
+    u16 *pulse_ctr = (u16 *)&seq_cv_clkout_pulse_ctr[0];
     for(clkout=0; clkout<SEQ_CV_NUM_CLKOUT; ++clkout, ++clk_divider, ++pulse_ctr) {
       if( !*clk_divider && start_stop ) {
 	clk_sr_value |= (1 << clkout);
@@ -478,9 +735,6 @@ s32 SEQ_CV_Update(void)
 #endif
   }
 
-  // update AOUTs
-  AOUT_Update();
-
   return 0; // no error
 }
 
@@ -496,6 +750,22 @@ s32 SEQ_CV_SendPackage(u8 cv_port, mios32_midi_package_t package)
   if( cv_port > 0 )
     return 0; // event not taken
 
+#if SEQ_CV_TIMED_OUTPUT
+  // will be processed by the output stage
+  SEQ_CV_QueueEvent(SEQ_CV_EVENT_PACKAGE, package);
+#else
+  SEQ_CV_ProcessPackage(package);
+#endif
+
+  return 1; // event taken
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sets CV and gates for the given MIDI event
+/////////////////////////////////////////////////////////////////////////////
+static s32 SEQ_CV_ProcessPackage(mios32_midi_package_t package)
+{
   // Note Off -> Note On with velocity 0
   if( package.event == NoteOff ) {
     package.event = NoteOn;
@@ -609,7 +879,7 @@ s32 SEQ_CV_SendPackage(u8 cv_port, mios32_midi_package_t package)
     AOUT_PinPitchSet(aout_chn_note, pitch);
   }
 
-  return 1; // event taken
+  return 0; // no error
 }
 
 
@@ -620,6 +890,12 @@ s32 SEQ_CV_ResetAllChannels(void)
 {
   int cv;
 
+#if SEQ_CV_TIMED_OUTPUT
+  // drop pending events and ensure that the output stage doesn't access the notestacks meanwhile
+  MIOS32_IRQ_Disable();
+  event_queue_tail = event_queue_head;
+#endif
+
   for(cv=0; cv<SEQ_CV_NUM; ++cv) {
     NOTESTACK_Init(&cv_notestack[cv],
 		   NOTESTACK_MODE_PUSH_TOP,
@@ -638,5 +914,9 @@ s32 SEQ_CV_ResetAllChannels(void)
     MIOS32_DOUT_SRSet(sr, seq_hwcfg_dout_gate_sr[sr]);
 #endif
 
+#if SEQ_CV_TIMED_OUTPUT
+  MIOS32_IRQ_Enable();
+#endif
+
   return 0; // no error
 }
@@ -39,6 +39,36 @@
 // number of clock outputs
 #define SEQ_CV_NUM_CLKOUT 8
 
+// timestamped output stage: CV/Gate/Clock events are queued with the BPM tick
+// they belong to, and applied from a hardware timer interrupt with sub-mS resolution.
+// The interrupt only latches gates and clocks, the AOUT channels are transfered via SPI
+// by SEQ_CV_Update() (task resumed via SEQ_CV_UpdateCallback_Init())
+// If disabled, all outputs are updated by SEQ_CV_Update() each mS like before
+#ifndef SEQ_CV_TIMED_OUTPUT
+#define SEQ_CV_TIMED_OUTPUT 1
+#endif
+
+// timer used by the output stage (timer 0 is allocated by SEQ_BPM)
+#ifndef SEQ_CV_TIMER_NUM
+#define SEQ_CV_TIMER_NUM 1
+#endif
+
+// period of the output stage in uS (resolution of gate/clock edges)
+#ifndef SEQ_CV_TIMER_PERIOD_US
+#define SEQ_CV_TIMER_PERIOD_US 100
+#endif
+
+// constant output delay in uS - events are dispatched by SEQ_TASK_MIDI each mS,
+// therefore they have to be delayed by one task period to be placed accurately
+#ifndef SEQ_CV_OUTPUT_LATENCY_US
+#define SEQ_CV_OUTPUT_LATENCY_US 1000
+#endif
+
+// max. number of queued events (should be a power of 2)
+#ifndef SEQ_CV_EVENT_QUEUE_SIZE
+#define SEQ_CV_EVENT_QUEUE_SIZE 64
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
 /////////////////////////////////////////////////////////////////////////////
@@ -82,6 +112,7 @@ extern s32 SEQ_CV_GateInversionAllSet(u8 mask);
 extern u8 SEQ_CV_GateInversionAllGet(void);
 
 extern s32 SEQ_CV_Update(void);
+extern s32 SEQ_CV_UpdateCallback_Init(void (*callback_func)(void));
 
 extern s32 SEQ_CV_SendPackage(u8 cv_port, mios32_midi_package_t package);
 
@@ -73,8 +73,35 @@
 // e.g. 256 steps, 4 parameter layers will result into 1024 bytes as well
 // this has the advantage, that a single bank can store different parameter layer configurations as long as the size is equal
 
+// Structure of packed bank file (used for new banks):
+//    file_type[10]
+//    seq_file_b_header_t
+//    Pattern Index: num_patterns * (u32 offset, u16 size)
+//               offset 0 means that the pattern hasn't been stored yet
+//               size is the number of bytes reserved at this offset
+//    Pattern data at the offset given in the index: seq_file_b_pattern_t
+//               Track 0: seq_file_b_track_t
+//                        u16 p_packed_size, u16 t_packed_size
+//                        Parameter Layers, PackBits encoded (p_packed_size bytes)
+//                        Trigger Layers, PackBits encoded (t_packed_size bytes)
+//               Track 1: ...
+//
+// The layers are run-length encoded with the PackBits scheme:
+//    n = 0..127:    n+1 literal bytes are following
+//    n = 129..255:  the next byte is repeated 257-n times
+//    n = 128:       no operation
+// Since unused steps and layers mostly contain the same (default) value, a
+// typical pattern only allocates 1..2k instead of 6k, and reading it requires
+// a fraction of the SD Card sectors.
+// A pattern is overwritten at its location if it fits into the reserved size,
+// otherwise it's appended to the end of the file (or extended in place if it's
+// already the last one). The reserved size is rounded up to whole sectors, so
+// that a pattern can grow a bit before it has to be moved, and the file doesn't
+// grow if a pattern is stored again.
+
 // not defined as structure: 
 // file_type[10] will contain "MBSEQV4_B" + 0 (zero-terminated string)
+// or "MBSEQV4_P" + 0 for a packed bank
 typedef struct {
   char name[20];      // bank name consists of 20 characters, no zero termination, patted with spaces
   u16  num_patterns;  // number of patterns per bank (usually 64)
@@ -105,6 +132,7 @@ typedef struct {
 // bank informations stored in RAM
 typedef struct {
   unsigned valid: 1;  // bank is accessible
+  unsigned packed: 1; // bank has been stored in packed format
 
   seq_file_b_header_t header;
 
@@ -112,10 +140,28 @@ typedef struct {
 } seq_file_b_info_t;
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// max. number of patterns which can be indexed in a packed bank
+#define SEQ_FILE_B_PACKED_MAX_PATTERNS 64
+
+// size of an index entry
+#define SEQ_FILE_B_PACKED_INDEX_ENTRY_SIZE 6
+
+// the space reserved for a packed pattern is a multiple of this size (sector size of SD Card)
+#define SEQ_FILE_B_PACKED_RESERVE_SIZE 512
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
 /////////////////////////////////////////////////////////////////////////////
 
+static s32 SEQ_FILE_B_PatternOffsetGet(u8 bank, u8 pattern, u32 *offset);
+static s32 SEQ_FILE_B_Pack(u8 *buffer, u32 len, u8 write);
+static s32 SEQ_FILE_B_Unpack(u8 *buffer, u32 len, u32 max_len);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
@@ -123,6 +169,13 @@ typedef struct {
 
 static seq_file_b_info_t seq_file_b_info[SEQ_FILE_B_NUM_BANKS];
 
+// pattern index of packed banks
+#ifndef AHB_SECTION
+#define AHB_SECTION
+#endif
+static u32 AHB_SECTION seq_file_b_index_offset[SEQ_FILE_B_NUM_BANKS][SEQ_FILE_B_PACKED_MAX_PATTERNS];
+static u16 AHB_SECTION seq_file_b_index_size[SEQ_FILE_B_NUM_BANKS][SEQ_FILE_B_PACKED_MAX_PATTERNS];
+
 static u8 cached_pattern_name[21];
 static u8 cached_bank;
 static u8 cached_pattern;
@@ -251,8 +304,9 @@ s32 SEQ_FILE_B_Create(char *session, u8 bank)
   }
 
   // write seq_file_b_header
-  const char file_type[10] = "MBSEQV4_B";
+  const char file_type[10] = "MBSEQV4_P";
   status |= FILE_WriteBuffer((u8 *)file_type, 10);
+  info->packed = 1;
 
   // write bank name w/o zero terminator
   char bank_name[21];
@@ -264,7 +318,7 @@ s32 SEQ_FILE_B_Create(char *session, u8 bank)
 #endif
 
   // number of patterns
-  info->header.num_patterns = 64;
+  info->header.num_patterns = SEQ_FILE_B_PACKED_MAX_PATTERNS;
   status |= FILE_WriteHWord(info->header.num_patterns);
 
   // write predefined pattern size
@@ -280,16 +334,15 @@ s32 SEQ_FILE_B_Create(char *session, u8 bank)
     num_tracks * (sizeof(seq_file_b_track_t) + num_p_instruments*num_p_layers*p_layer_size + num_t_instruments*num_t_layers*t_layer_size);
   status |= FILE_WriteHWord(info->header.pattern_size);
 
-  // not required anymore with FatFs (was required with DOSFS)
-#if 0
-  // create empty pattern slots
+  // write empty pattern index
+  // the patterns will be appended to the file by SEQ_FILE_B_PatternWrite()
   u32 pattern;
   for(pattern=0; pattern<info->header.num_patterns; ++pattern) {
-    u32 pos;
-    for(pos=0; pos<info->header.pattern_size; ++pos)
-      status |= FILE_WriteByte(0x00);
+    seq_file_b_index_offset[bank][pattern] = 0;
+    seq_file_b_index_size[bank][pattern] = 0;
+    status |= FILE_WriteWord(0);
+    status |= FILE_WriteHWord(0);
   }
-#endif
 
   // close file
   status |= FILE_WriteClose();
@@ -345,7 +398,11 @@ s32 SEQ_FILE_B_Open(char *session, u8 bank)
     return status;
   }
 
-  if( strncmp(file_type, "MBSEQV4_B", 10) != 0 ) {
+  if( strncmp(file_type, "MBSEQV4_B", 10) == 0 ) {
+    info->packed = 0;
+  } else if( strncmp(file_type, "MBSEQV4_P", 10) == 0 ) {
+    info->packed = 1;
+  } else {
 #if DEBUG_VERBOSE_LEVEL >= 1
     file_type[9] = 0; // ensure that string is terminated
     DEBUG_MSG("[SEQ_FILE_B] wrong header type: %s\n", file_type);
@@ -357,6 +414,19 @@ s32 SEQ_FILE_B_Open(char *session, u8 bank)
   status |= FILE_ReadHWord((u16 *)&info->header.num_patterns);
   status |= FILE_ReadHWord((u16 *)&info->header.pattern_size);
 
+  if( info->packed ) {
+    // read pattern index
+    // patterns which exceed the index size are not accessible
+    if( info->header.num_patterns > SEQ_FILE_B_PACKED_MAX_PATTERNS )
+      info->header.num_patterns = SEQ_FILE_B_PACKED_MAX_PATTERNS;
+
+    u32 pattern;
+    for(pattern=0; pattern<info->header.num_patterns; ++pattern) {
+      status |= FILE_ReadWord(&seq_file_b_index_offset[bank][pattern]);
+      status |= FILE_ReadHWord(&seq_file_b_index_size[bank][pattern]);
+    }
+  }
+
   if( status < 0 ) {
 #if DEBUG_VERBOSE_LEVEL >= 1
     DEBUG_MSG("[SEQ_FILE_B] file access error while reading header, status: %d\n", status);
@@ -371,7 +441,7 @@ s32 SEQ_FILE_B_Open(char *session, u8 bank)
   info->valid = 1;
 
 #if DEBUG_VERBOSE_LEVEL >= 1
-  DEBUG_MSG("[SEQ_FILE_B] bank is valid! Number of Patterns: %d, Pattern Size: %d\n", info->header.num_patterns, info->header.pattern_size);
+  DEBUG_MSG("[SEQ_FILE_B] bank is valid! Number of Patterns: %d, Pattern Size: %d%s\n", info->header.num_patterns, info->header.pattern_size, info->packed ? " (packed)" : "");
 #endif
 
   // finally (re-)load cached pattern name - status of this function doesn't matter
@@ -382,6 +452,130 @@ s32 SEQ_FILE_B_Open(char *session, u8 bank)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// returns the file offset of a pattern
+// offset will be 0 if the pattern hasn't been stored in a packed bank yet
+// returns < 0 on errors (error codes are documented in seq_file.h)
+/////////////////////////////////////////////////////////////////////////////
+static s32 SEQ_FILE_B_PatternOffsetGet(u8 bank, u8 pattern, u32 *offset)
+{
+  if( bank >= SEQ_FILE_B_NUM_BANKS )
+    return SEQ_FILE_B_ERR_INVALID_BANK;
+
+  seq_file_b_info_t *info = &seq_file_b_info[bank];
+
+  if( !info->valid )
+    return SEQ_FILE_B_ERR_NO_FILE;
+
+  if( pattern >= info->header.num_patterns )
+    return SEQ_FILE_B_ERR_INVALID_PATTERN;
+
+  if( info->packed )
+    *offset = seq_file_b_index_offset[bank][pattern];
+  else
+    *offset = 10 + sizeof(seq_file_b_header_t) + pattern * info->header.pattern_size;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// packs a buffer with the PackBits scheme
+// if write is 0, the packed data won't be written into the file, so that the
+// function can be used to determine the packed size
+// returns the number of packed bytes
+// returns < 0 on errors (error codes are documented in seq_file.h)
+/////////////////////////////////////////////////////////////////////////////
+static s32 SEQ_FILE_B_Pack(u8 *buffer, u32 len, u8 write)
+{
+  s32 status = 0;
+  u32 packed_size = 0;
+  u32 pos = 0;
+
+  while( pos < len ) {
+    u8 value = buffer[pos];
+
+    // search for repeated bytes
+    u32 run = 1;
+    while( (pos+run) < len && run < 128 && buffer[pos+run] == value )
+      ++run;
+
+    if( run >= 2 ) {
+      if( write ) {
+	status |= FILE_WriteByte((u8)(257 - run));
+	status |= FILE_WriteByte(value);
+      }
+      packed_size += 2;
+      pos += run;
+    } else {
+      // literal bytes until the next repeat
+      u32 num = 1;
+      while( (pos+num) < len && num < 128 &&
+	     !((pos+num+1) < len && buffer[pos+num] == buffer[pos+num+1]) )
+	++num;
+
+      if( write ) {
+	status |= FILE_WriteByte((u8)(num - 1));
+	status |= FILE_WriteBuffer(&buffer[pos], num);
+      }
+      packed_size += 1 + num;
+      pos += num;
+    }
+  }
+
+  return (status < 0) ? status : packed_size;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// unpacks len bytes from file into a buffer
+// bytes which exceed max_len are read, but not stored
+// returns < 0 on errors (error codes are documented in seq_file.h)
+/////////////////////////////////////////////////////////////////////////////
+static s32 SEQ_FILE_B_Unpack(u8 *buffer, u32 len, u32 max_len)
+{
+  s32 status = 0;
+  u32 pos = 0;
+
+  while( pos < len && status >= 0 ) {
+    u8 n;
+    if( (status=FILE_ReadByte(&n)) < 0 )
+      break;
+
+    if( n == 128 )
+      continue; // no operation
+
+    u32 num = (n < 128) ? (n + 1) : (257 - n);
+    if( (pos+num) > len )
+      return SEQ_FILE_B_ERR_FORMAT;
+
+    // bytes which can be taken
+    u32 num_taken = (pos >= max_len) ? 0 : (((pos+num) > max_len) ? (max_len-pos) : num);
+
+    if( n < 128 ) {
+      if( num_taken )
+	status |= FILE_ReadBuffer(&buffer[pos], num_taken);
+
+      // read remaining bytes into dummy buffer
+      u32 i;
+      for(i=num_taken; i<num; ++i) {
+	u8 dummy;
+	status |= FILE_ReadByte(&dummy);
+      }
+    } else {
+      u8 value;
+      status |= FILE_ReadByte(&value);
+      if( num_taken )
+	memset(&buffer[pos], value, num_taken);
+    }
+
+    pos += num;
+  }
+
+  return status;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // reads a pattern from bank into given group
 // returns < 0 on errors (error codes are documented in seq_file.h)
@@ -396,19 +590,19 @@ s32 SEQ_FILE_B_PatternRead(u8 bank, u8 pattern, u8 target_group, u16 remix_map)
 
   seq_file_b_info_t *info = &seq_file_b_info[bank];
 
-  if( !info->valid )
-    return SEQ_FILE_B_ERR_NO_FILE;
+  s32 status;
+  u32 offset;
+  if( (status=SEQ_FILE_B_PatternOffsetGet(bank, pattern, &offset)) < 0 )
+    return status;
 
-  if( pattern >= info->header.num_patterns )
-    return SEQ_FILE_B_ERR_INVALID_PATTERN;
+  if( !offset )
+    return SEQ_FILE_B_ERR_READ; // pattern hasn't been stored yet
 
   // re-open file
   if( FILE_ReadReOpen((file_t*)&info->file) < 0 )
     return -1; // file cannot be re-opened
 
   // change to file position
-  s32 status;
-  u32 offset = 10 + sizeof(seq_file_b_header_t) + pattern * info->header.pattern_size;
   if( (status=FILE_ReadSeek(offset)) < 0 ) {
 #if DEBUG_VERBOSE_LEVEL >= 1
     DEBUG_MSG("[SEQ_FILE_B] failed to change pattern offset in file, status: %d\n", status);
@@ -446,7 +640,8 @@ s32 SEQ_FILE_B_PatternRead(u8 bank, u8 pattern, u8 target_group, u16 remix_map)
   for(track_i=0; track_i<num_tracks; ++track_i, ++track) {
 		
     // if we got the track bit setup inside our remix_map, them do not change him, let it be mixed down
-    if ( ((1 << track) | remix_map) == remix_map ) {
+    // (the u16 map only covers the first 16 tracks, one bit per GP button)
+    if ( track < 16 && ((1 << track) | remix_map) == remix_map ) {
       // Mixed down! no need to change the track pattern
       // but we need to state our file pointer... jump to the next track data
 
@@ -475,7 +670,15 @@ DEBUG_MSG("Skipping Track %d\n", track);
       // skip CC and Par/Trg layer
       u32 par_size = num_p_instruments * num_p_layers * p_layer_size;
       u32 trg_size = num_t_instruments * num_t_layers * t_layer_size;
-      u32 new_pos = FILE_ReadGetCurrentPosition() + 128 + par_size + trg_size;
+      if( info->packed ) {
+	u16 p_packed_size, t_packed_size;
+	status |= FILE_ReadSeek(FILE_ReadGetCurrentPosition() + 128);
+	status |= FILE_ReadHWord(&p_packed_size);
+	status |= FILE_ReadHWord(&t_packed_size);
+	par_size = p_packed_size;
+	trg_size = t_packed_size;
+      }
+      u32 new_pos = FILE_ReadGetCurrentPosition() + (info->packed ? 0 : 128) + par_size + trg_size;
  DEBUG_MSG("Pos change: %d -> %d\n", FILE_ReadGetCurrentPosition(), new_pos);
       if( (status=FILE_ReadSeek(new_pos)) < 0 ) {
 #if DEBUG_VERBOSE_LEVEL >= 1
@@ -512,6 +715,13 @@ DEBUG_MSG("Skipping Track %d\n", track);
 
       u8 cc_buffer[128];
       status |= FILE_ReadBuffer(cc_buffer, 128);
+
+      u16 p_packed_size = 0;
+      u16 t_packed_size = 0;
+      if( info->packed ) {
+	status |= FILE_ReadHWord(&p_packed_size);
+	status |= FILE_ReadHWord(&t_packed_size);
+      }
     
       // before changing CCs: we should stop here on error if read failed
       if( status < 0 ) {
@@ -540,14 +750,21 @@ DEBUG_MSG("Skipping Track %d\n", track);
       // reading Parameter layers
       u32 par_size = num_p_instruments * num_p_layers * p_layer_size;
       u32 par_size_taken = (par_size > SEQ_PAR_MAX_BYTES) ? SEQ_PAR_MAX_BYTES : par_size;
-      if( par_size_taken )
-	FILE_ReadBuffer((u8 *)&seq_par_layer_value[track], par_size_taken);
-
-      // read remaining bytes into dummy buffer
-      while( par_size > par_size_taken ) {
-	u8 dummy;
-	FILE_ReadByte(&dummy);
-	++par_size_taken;
+      if( info->packed ) {
+	u32 packed_pos = FILE_ReadGetCurrentPosition();
+	status |= SEQ_FILE_B_Unpack((u8 *)&seq_par_layer_value[track], par_size, par_size_taken);
+	if( FILE_ReadGetCurrentPosition() != (packed_pos + p_packed_size) )
+	  status |= SEQ_FILE_B_ERR_FORMAT;
+      } else {
+	if( par_size_taken )
+	  FILE_ReadBuffer((u8 *)&seq_par_layer_value[track], par_size_taken);
+
+	// read remaining bytes into dummy buffer
+	while( par_size > par_size_taken ) {
+	  u8 dummy;
+	  FILE_ReadByte(&dummy);
+	  ++par_size_taken;
+	}
       }
 
       // partitionate trigger layer and clear all steps
@@ -556,14 +773,21 @@ DEBUG_MSG("Skipping Track %d\n", track);
       // reading Trigger layers
       u32 trg_size = num_t_instruments * num_t_layers * t_layer_size;
       u32 trg_size_taken = (trg_size > SEQ_TRG_MAX_BYTES) ? SEQ_TRG_MAX_BYTES : trg_size;
-      if( trg_size_taken )
-	FILE_ReadBuffer((u8 *)&seq_trg_layer_value[track], trg_size_taken);
-
-      // read remaining bytes into dummy buffer
-      while( trg_size > trg_size_taken ) {
-	u8 dummy;
-	FILE_ReadByte(&dummy);
-	++trg_size_taken;
+      if( info->packed ) {
+	u32 packed_pos = FILE_ReadGetCurrentPosition();
+	status |= SEQ_FILE_B_Unpack((u8 *)&seq_trg_layer_value[track], trg_size, trg_size_taken);
+	if( FILE_ReadGetCurrentPosition() != (packed_pos + t_packed_size) )
+	  status |= SEQ_FILE_B_ERR_FORMAT;
+      } else {
+	if( trg_size_taken )
+	  FILE_ReadBuffer((u8 *)&seq_trg_layer_value[track], trg_size_taken);
+
+	// read remaining bytes into dummy buffer
+	while( trg_size > trg_size_taken ) {
+	  u8 dummy;
+	  FILE_ReadByte(&dummy);
+	  ++trg_size_taken;
+	}
       }
 
       // finally update CC links again, because some of them depend on SEQ_PAR_NumLayersGet()!!!
@@ -614,6 +838,11 @@ s32 SEQ_FILE_B_PatternWrite(char *session, u8 bank, u8 pattern, u8 source_group,
   // ok, we should at least check, if the resulting size is within the given range
   u16 expected_pattern_size = sizeof(seq_file_b_pattern_t);
 
+  // for packed banks: size of the packed layers
+  u32 packed_pattern_size = sizeof(seq_file_b_pattern_t);
+  u16 p_packed_size[SEQ_CORE_NUM_TRACKS_PER_GROUP];
+  u16 t_packed_size[SEQ_CORE_NUM_TRACKS_PER_GROUP];
+
   u8 track = source_group * SEQ_CORE_NUM_TRACKS_PER_GROUP;
   u8 track_i;
   for(track_i=0; track_i<num_tracks; ++track_i, ++track) {
@@ -627,6 +856,12 @@ s32 SEQ_FILE_B_PatternWrite(char *session, u8 bank, u8 pattern, u8 source_group,
     expected_pattern_size += sizeof(seq_file_b_track_t) + 
       num_p_instruments*num_p_layers*p_layer_size + 
       num_t_instruments*num_t_layers*t_layer_size;
+
+    if( info->packed ) {
+      p_packed_size[track_i] = SEQ_FILE_B_Pack((u8 *)&seq_par_layer_value[track], num_p_instruments*num_p_layers*p_layer_size, 0);
+      t_packed_size[track_i] = SEQ_FILE_B_Pack((u8 *)&seq_trg_layer_value[track], num_t_instruments*num_t_layers*t_layer_size, 0);
+      packed_pattern_size += sizeof(seq_file_b_track_t) + 2*2 + p_packed_size[track_i] + t_packed_size[track_i];
+    }
   }
 
   if( expected_pattern_size > info->header.pattern_size ) {
@@ -654,7 +889,23 @@ s32 SEQ_FILE_B_PatternWrite(char *session, u8 bank, u8 pattern, u8 source_group,
   }
 
   // change to file position
-  u32 offset = 10 + sizeof(seq_file_b_header_t) + pattern * info->header.pattern_size;
+  u32 offset;
+  SEQ_FILE_B_PatternOffsetGet(bank, pattern, &offset);
+
+  u16 reserved_size = 0;
+  u32 file_size = 0;
+  if( info->packed ) {
+    // overwrite pattern if it fits into the reserved space, otherwise append it to the end of file
+    // (or extend it if it's already located at the end)
+    reserved_size = seq_file_b_index_size[bank][pattern];
+    file_size = FILE_WriteGetCurrentSize();
+    if( !offset || packed_pattern_size > reserved_size ) {
+      if( !offset || (offset + reserved_size) != file_size )
+	offset = file_size;
+      reserved_size = (packed_pattern_size + SEQ_FILE_B_PACKED_RESERVE_SIZE - 1) & ~(SEQ_FILE_B_PACKED_RESERVE_SIZE - 1);
+    }
+  }
+
   if( (status=FILE_WriteSeek(offset)) < 0 ) {
 #if DEBUG_VERBOSE_LEVEL >= 1
     DEBUG_MSG("[SEQ_FILE_B] failed to change pattern offset in file, status: %d\n", status);
@@ -737,22 +988,62 @@ s32 SEQ_FILE_B_PatternWrite(char *session, u8 bank, u8 pattern, u8 source_group,
       status |= FILE_WriteByte(cc_value);
     }
 
-    // write parameter layers
-    status |= FILE_WriteBuffer((u8 *)&seq_par_layer_value[track], num_p_instruments*num_p_layers*p_layer_size);
+    if( info->packed ) {
+      // write size of packed layers
+      status |= FILE_WriteHWord(p_packed_size[track_i]);
+      status |= FILE_WriteHWord(t_packed_size[track_i]);
+
+      // write packed parameter layers
+      if( SEQ_FILE_B_Pack((u8 *)&seq_par_layer_value[track], num_p_instruments*num_p_layers*p_layer_size, 1) < 0 )
+	status = SEQ_FILE_B_ERR_WRITE;
+
+      // write packed trigger layers
+      if( SEQ_FILE_B_Pack((u8 *)&seq_trg_layer_value[track], num_t_instruments*num_t_layers*t_layer_size, 1) < 0 )
+	status = SEQ_FILE_B_ERR_WRITE;
+    } else {
+      // write parameter layers
+      status |= FILE_WriteBuffer((u8 *)&seq_par_layer_value[track], num_p_instruments*num_p_layers*p_layer_size);
 
-    // write trigger layers
-    status |= FILE_WriteBuffer((u8 *)&seq_trg_layer_value[track], num_t_instruments*num_t_layers*t_layer_size);
+      // write trigger layers
+      status |= FILE_WriteBuffer((u8 *)&seq_trg_layer_value[track], num_t_instruments*num_t_layers*t_layer_size);
+    }
   }
 
-  // fill remaining bytes with zero if required
-  while( expected_pattern_size < info->header.pattern_size ) {
-    status |= FILE_WriteByte(0x00);
-    ++expected_pattern_size;
+  if( info->packed ) {
+    // allocate the remaining reserved space if the file has been extended
+    if( (offset + reserved_size) > file_size ) {
+      u32 pos;
+      for(pos=offset+packed_pattern_size; pos<(offset + reserved_size); ++pos)
+	status |= FILE_WriteByte(0x00);
+    }
+
+    // update pattern index after the pattern has been written
+    if( status >= 0 &&
+	(offset != seq_file_b_index_offset[bank][pattern] || reserved_size != seq_file_b_index_size[bank][pattern]) ) {
+      status |= FILE_WriteSeek(10 + sizeof(seq_file_b_header_t) + pattern * SEQ_FILE_B_PACKED_INDEX_ENTRY_SIZE);
+      status |= FILE_WriteWord(offset);
+      status |= FILE_WriteHWord(reserved_size);
+
+      if( status >= 0 ) {
+	seq_file_b_index_offset[bank][pattern] = offset;
+	seq_file_b_index_size[bank][pattern] = reserved_size;
+      }
+    }
+  } else {
+    // fill remaining bytes with zero if required
+    while( expected_pattern_size < info->header.pattern_size ) {
+      status |= FILE_WriteByte(0x00);
+      ++expected_pattern_size;
+    }
   }
 
   // close file
   status |= FILE_WriteClose();
 
+  // the file reference for read operations has to be updated if the file has been extended
+  if( info->packed && (offset + reserved_size) > file_size )
+    status |= SEQ_FILE_B_Open(session, bank);
+
 #if DEBUG_VERBOSE_LEVEL >= 1
   DEBUG_MSG("[SEQ_FILE_B] Pattern written with status %d\n", status);
 #endif
@@ -792,40 +1083,40 @@ s32 SEQ_FILE_B_PatternPeekName(u8 bank, u8 pattern, u8 non_cached, char *pattern
   // initial pattern name
   memcpy(cached_pattern_name, "-----<Disk Error>   ", 21);
 
-  if( bank >= SEQ_FILE_B_NUM_BANKS )
-    return SEQ_FILE_B_ERR_INVALID_BANK;
+  s32 status;
+  u32 offset;
+  if( (status=SEQ_FILE_B_PatternOffsetGet(bank, pattern, &offset)) < 0 )
+    return status;
 
   seq_file_b_info_t *info = &seq_file_b_info[bank];
 
-  if( !info->valid )
-    return SEQ_FILE_B_ERR_NO_FILE;
-
-  if( pattern >= info->header.num_patterns )
-    return SEQ_FILE_B_ERR_INVALID_PATTERN;
-
-  // re-open file
-  if( FILE_ReadReOpen((file_t*)&info->file) < 0 )
-    return -1; // file cannot be re-opened
-
-  // change to file position
-  s32 status;
-  u32 offset = 10 + sizeof(seq_file_b_header_t) + pattern * info->header.pattern_size;
-  if( (status=FILE_ReadSeek(offset)) < 0 ) {
+  if( !offset ) {
+    // pattern hasn't been stored yet
+    memset(cached_pattern_name, ' ', 20);
+    cached_pattern_name[20] = 0;
+  } else {
+    // re-open file
+    if( FILE_ReadReOpen((file_t*)&info->file) < 0 )
+      return -1; // file cannot be re-opened
+
+    // change to file position
+    if( (status=FILE_ReadSeek(offset)) < 0 ) {
 #if DEBUG_VERBOSE_LEVEL >= 1
-    DEBUG_MSG("[SEQ_FILE_B] failed to change pattern offset in file, status: %d\n", status);
+      DEBUG_MSG("[SEQ_FILE_B] failed to change pattern offset in file, status: %d\n", status);
 #endif
+      // close file (so that it can be re-opened)
+      FILE_ReadClose((file_t*)&info->file);
+      return SEQ_FILE_B_ERR_READ;
+    }
+
+    // read name
+    status |= FILE_ReadBuffer((u8 *)cached_pattern_name, 20);
+    cached_pattern_name[20] = 0;
+
     // close file (so that it can be re-opened)
     FILE_ReadClose((file_t*)&info->file);
-    return SEQ_FILE_B_ERR_READ;
   }
 
-  // read name
-  status |= FILE_ReadBuffer((u8 *)cached_pattern_name, 20);
-  cached_pattern_name[20] = 0;
-
-  // close file (so that it can be re-opened)
-  FILE_ReadClose((file_t*)&info->file);
-
   // fill category with "-----" if it is empty
   int i;
   u8 found_char = 0;
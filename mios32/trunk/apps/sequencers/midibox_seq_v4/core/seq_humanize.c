@@ -59,7 +59,7 @@ s32 SEQ_HUMANIZE_Event(u8 track, u8 step, seq_layer_evnt_t *e)
 
   if( mode & (1 << 0) ) { // Note Event
     u8 note_intensity = intensity / 4; // important for combination with velocity/gatelength
-    s16 value = e->midi_package.note + ((note_intensity/2) - (s16)SEQ_RANDOM_Gen_Range(0, note_intensity));
+    s16 value = e->midi_package.note + ((note_intensity/2) - (s16)SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_HUMANIZE, 0, note_intensity));
 
     // ensure that note is in the 0..127 range
     value = SEQ_CORE_TrimNote(value, 0, 127);
@@ -68,7 +68,7 @@ s32 SEQ_HUMANIZE_Event(u8 track, u8 step, seq_layer_evnt_t *e)
   }
 
   if( mode & (1 << 1) ) { // Velocity
-    s16 value = e->midi_package.velocity + ((intensity/2) - (s16)SEQ_RANDOM_Gen_Range(0, intensity));
+    s16 value = e->midi_package.velocity + ((intensity/2) - (s16)SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_HUMANIZE, 0, intensity));
     if( value < 1 )
       value = 1;
     else if( value > 127 )
@@ -77,7 +77,7 @@ s32 SEQ_HUMANIZE_Event(u8 track, u8 step, seq_layer_evnt_t *e)
   }
 
   if( e->len < 96 && (mode & (1 << 2)) ) { // Gatelength (only if no glide)
-    s16 value = e->len + ((intensity/2) - (s16)SEQ_RANDOM_Gen_Range(0, intensity));
+    s16 value = e->len + ((intensity/2) - (s16)SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_HUMANIZE, 0, intensity));
     if( value < 1 )
       value = 1;
     else if( value > 95 )
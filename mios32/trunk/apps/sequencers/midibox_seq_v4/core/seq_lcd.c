@@ -908,10 +908,10 @@ s32 SEQ_LCD_PrintLayerEvent(u8 track, u8 step, u8 par_layer, u8 instrument, u8 s
 /////////////////////////////////////////////////////////////////////////////
 // prints selected group/track (4 characters)
 /////////////////////////////////////////////////////////////////////////////
-s32 SEQ_LCD_PrintGxTy(u8 group, u16 selected_tracks)
+s32 SEQ_LCD_PrintGxTy(u8 group, seq_core_trkset_t *selected_tracks)
 {
   const char selected_tracks_tab[16] = { '-', '1', '2', 'M', '3', 'M', 'M', 'M', '4', 'M', 'M', 'M', 'M', 'M', 'M', 'A' };
-  u8 track4 = (selected_tracks >> (group*4)) & 0x0f;
+  u8 track4 = SEQ_CORE_TrkSetGroupGet(selected_tracks, group);
 
   SEQ_LCD_PrintChar('G');
   SEQ_LCD_PrintChar('1' + group);
@@ -965,7 +965,7 @@ static s32 SEQ_MIDI_IN_Receive_ExtCtrlCC(u8 cc, u8 value)
 
       case SEQ_MIDI_IN_EXT_CTRL_MIXER_MAP: {
 	SEQ_MIXER_Load(value);
-	SEQ_MIXER_SendAll();	
+	SEQ_MIXER_SendAll(0);
       } break;
 
       case SEQ_MIDI_IN_EXT_CTRL_BANK_G1:
@@ -1000,9 +1000,9 @@ static s32 SEQ_MIDI_IN_Receive_ExtCtrlCC(u8 cc, u8 value)
       u8 track = cc - mute_cc;
       portENTER_CRITICAL();
       if( value >= 64 ) {
-	seq_core_trk_muted |= (1 << track);
+	SEQ_CORE_TRKSET_SET(&seq_core_trk_muted, track);
       } else {
-	seq_core_trk_muted &= ~(1 << track);
+	SEQ_CORE_TRKSET_CLR(&seq_core_trk_muted, track);
       }
       portEXIT_CRITICAL();      
     }
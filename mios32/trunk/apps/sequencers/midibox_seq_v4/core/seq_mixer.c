@@ -16,6 +16,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <mios32.h>
+#include <string.h>
 #include "tasks.h"
 
 #include "seq_ui.h"
@@ -40,12 +41,46 @@ char seq_mixer_map_name[21];
 u8 seq_mixer_cc1234_before_pc;
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+// values which have been sent last to a MIDI port and channel
+// They are updated by SEQ_MIXER_NotifyMIDITx() for all outgoing Program Changes
+// and CCs, regardless if they have been sent by the mixer, a track or the router
+// (value 0: unknown)
+typedef struct {
+  mios32_midi_port_t port;
+  u8 chn;       // 0xff: entry not allocated
+  u8 value[SEQ_MIXER_PAR_CC4-SEQ_MIXER_PAR_PRG+1];
+  u8 cc_num[4]; // CC numbers of CC1..CC4
+  u16 last_access; // for LRU replacement
+} seq_mixer_sent_t;
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
 
 static u8 mixer_map;
 
+// one entry for each port/channel combination of the mixer channels
+static seq_mixer_sent_t mixer_sent[SEQ_MIXER_NUM_CHANNELS];
+static u16 mixer_sent_access_ctr;
+
+// dump requests: one flag per channel, position of the next value which will be checked
+static u16 dump_req;
+static u8  dump_chn;
+static u8  dump_step;
+static u8  dump_credit;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static seq_mixer_sent_t *SEQ_MIXER_SentGet(u8 chn);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initialisation
@@ -61,6 +96,19 @@ s32 SEQ_MIXER_Init(u32 mode)
   // clear mixer page
   SEQ_MIXER_Clear();
 
+  // values haven't been sent yet
+  u8 i;
+  for(i=0; i<SEQ_MIXER_NUM_CHANNELS; ++i) {
+    memset(&mixer_sent[i], 0, sizeof(seq_mixer_sent_t));
+    mixer_sent[i].chn = 0xff;
+  }
+  mixer_sent_access_ctr = 0;
+
+  dump_req = 0;
+  dump_chn = 0;
+  dump_step = 0;
+  dump_credit = 0;
+
   return 0; // no error
 }
 
@@ -123,11 +171,154 @@ s32 SEQ_MIXER_Get(u8 chn, seq_mixer_par_t par)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Returns the port of a mixer channel as it's passed to the Tx hook
+/////////////////////////////////////////////////////////////////////////////
+static mios32_midi_port_t SEQ_MIXER_PortGet(u8 chn)
+{
+  mios32_midi_port_t port = seq_mixer_value[chn][SEQ_MIXER_PAR_PORT];
+  if( !(port & 0xf0) ) // default/debug port: select mapped port like MIOS32_MIDI_SendPackage()
+    port = (port == MIDI_DEBUG) ? MIOS32_MIDI_DebugPortGet() : MIOS32_MIDI_DefaultPortGet();
+  return port;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the sent-value record for the port/channel of a mixer channel
+// A new record is allocated if required, the values of CC1..CC4 are
+// invalidated if the CC numbers have been changed
+// Never returns NULL: if all records are taken (e.g. because the mixer
+// map has been changed in the meantime), the least recently used record
+// is recycled
+/////////////////////////////////////////////////////////////////////////////
+static seq_mixer_sent_t *SEQ_MIXER_SentGet(u8 chn)
+{
+  mios32_midi_port_t port = SEQ_MIXER_PortGet(chn);
+  u8 midi_chn = seq_mixer_value[chn][SEQ_MIXER_PAR_CHANNEL] & 0xf;
+
+  seq_mixer_sent_t *sent = NULL;
+  u8 i;
+  for(i=0; i<SEQ_MIXER_NUM_CHANNELS; ++i) {
+    if( mixer_sent[i].chn == midi_chn && mixer_sent[i].port == port ) {
+      sent = &mixer_sent[i];
+      break;
+    }
+  }
+
+  if( sent == NULL ) {
+    // take a record which isn't used by any mixer channel
+    // (there are not more port/channel combinations than mixer channels)
+    for(i=0; i<SEQ_MIXER_NUM_CHANNELS && sent == NULL; ++i) {
+      u8 used = 0;
+      if( mixer_sent[i].chn != 0xff ) {
+	u8 mixer_chn;
+	for(mixer_chn=0; mixer_chn<SEQ_MIXER_NUM_CHANNELS; ++mixer_chn) {
+	  if( mixer_sent[i].chn == (seq_mixer_value[mixer_chn][SEQ_MIXER_PAR_CHANNEL] & 0xf) &&
+	      mixer_sent[i].port == SEQ_MIXER_PortGet(mixer_chn) ) {
+	    used = 1;
+	    break;
+	  }
+	}
+      }
+
+      if( !used )
+	sent = &mixer_sent[i];
+    }
+
+    if( sent == NULL ) {
+      sent = &mixer_sent[0];
+      for(i=1; i<SEQ_MIXER_NUM_CHANNELS; ++i) {
+	if( (u16)(mixer_sent_access_ctr - mixer_sent[i].last_access) > (u16)(mixer_sent_access_ctr - sent->last_access) )
+	  sent = &mixer_sent[i];
+      }
+    }
+
+    memset(sent, 0, sizeof(seq_mixer_sent_t));
+    sent->port = port;
+    sent->chn = midi_chn;
+  }
+
+  for(i=0; i<4; ++i) {
+    u8 cc_num = seq_mixer_value[chn][SEQ_MIXER_PAR_CC1_NUM + i];
+    if( sent->cc_num[i] != cc_num ) {
+      sent->cc_num[i] = cc_num;
+      sent->value[SEQ_MIXER_PAR_CC1 + i - SEQ_MIXER_PAR_PRG] = 0;
+    }
+  }
+
+  sent->last_access = ++mixer_sent_access_ctr;
+
+  return sent;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if the value differs from the value which has been sent last
+/////////////////////////////////////////////////////////////////////////////
+static u8 SEQ_MIXER_Changed(u8 chn, seq_mixer_par_t par)
+{
+  if( par < SEQ_MIXER_PAR_PRG || par > SEQ_MIXER_PAR_CC4 )
+    return 0; // no MIDI event
+
+  u8 value = seq_mixer_value[chn][par];
+  if( value == 0 )
+    return 0; // value won't be sent
+
+  return SEQ_MIXER_SentGet(chn)->value[par-SEQ_MIXER_PAR_PRG] != value;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Called by MIDI Tx Notificaton hook in app.c for all outgoing events
+// Keeps track of the Program Changes and CCs which have been sent to the
+// port/channel combinations of the mixer
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_MIXER_NotifyMIDITx(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  if( package.event != CC && package.event != ProgramChange )
+    return 0; // no error
+
+  u8 i;
+  seq_mixer_sent_t *sent = &mixer_sent[0];
+  for(i=0; i<SEQ_MIXER_NUM_CHANNELS; ++i, ++sent) {
+    if( sent->chn != package.chn || sent->port != port )
+      continue;
+
+    u8 value = package.evnt2 + 1;
+    if( package.event == ProgramChange ) {
+      sent->value[SEQ_MIXER_PAR_PRG-SEQ_MIXER_PAR_PRG] = package.evnt1 + 1;
+    } else {
+      switch( package.cc_number ) {
+      case 7:  sent->value[SEQ_MIXER_PAR_VOLUME-SEQ_MIXER_PAR_PRG] = value; break;
+      case 10: sent->value[SEQ_MIXER_PAR_PANORAMA-SEQ_MIXER_PAR_PRG] = value; break;
+      case 91: sent->value[SEQ_MIXER_PAR_REVERB-SEQ_MIXER_PAR_PRG] = value; break;
+      case 93: sent->value[SEQ_MIXER_PAR_CHORUS-SEQ_MIXER_PAR_PRG] = value; break;
+      case 1:  sent->value[SEQ_MIXER_PAR_MODWHEEL-SEQ_MIXER_PAR_PRG] = value; break;
+      }
+
+      u8 cc_ix;
+      for(cc_ix=0; cc_ix<4; ++cc_ix) {
+	if( sent->cc_num[cc_ix] == package.cc_number )
+	  sent->value[SEQ_MIXER_PAR_CC1 + cc_ix - SEQ_MIXER_PAR_PRG] = value;
+      }
+    }
+  }
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Sends a single mixer value
 /////////////////////////////////////////////////////////////////////////////
 s32 SEQ_MIXER_Send(u8 chn, seq_mixer_par_t par)
 {
+  if( chn >= SEQ_MIXER_NUM_CHANNELS )
+    return 0; // don't return error, as it could be misinterpreded as a MIDI interface issue
+
+  // ensure that the sent value will be recorded by SEQ_MIXER_NotifyMIDITx()
+  SEQ_MIXER_SentGet(chn);
+
   mios32_midi_port_t midi_port = SEQ_MIXER_Get(chn, SEQ_MIXER_PAR_PORT);
   mios32_midi_chn_t  midi_chn = SEQ_MIXER_Get(chn, SEQ_MIXER_PAR_CHANNEL);
 
@@ -165,48 +356,126 @@ s32 SEQ_MIXER_Send(u8 chn, seq_mixer_par_t par)
 }
 
 /////////////////////////////////////////////////////////////////////////////
-// Sends all mixer values for a specified Channel
+// Requests to send all mixer values for a specified Channel
+// The values are sent by SEQ_MIXER_Handler() in the background, only values
+// which have been changed since they have been sent last are considered.
+// If force is set, all values will be sent again (e.g. on a manual dump)
 /////////////////////////////////////////////////////////////////////////////
-s32 SEQ_MIXER_SendAllByChannel(u8 chn)
+s32 SEQ_MIXER_SendAllByChannel(u8 chn, u8 force)
 {
-  seq_mixer_par_t par;
-  s32 status = 0;
-	
-  MUTEX_MIDIOUT_TAKE;
+  if( chn >= SEQ_MIXER_NUM_CHANNELS )
+    return -1; // invalid channel number
 
-  // CCs before PC?
-  for(par=0; par<4; ++par) {
-    if( seq_mixer_cc1234_before_pc & (1 << par) ) {
-      status |= SEQ_MIXER_Send(chn, SEQ_MIXER_PAR_CC1 + par);
-    }
+  if( force ) { // forget the values which have been sent to the port/channel
+    MUTEX_MIDIOUT_TAKE;
+    memset(SEQ_MIXER_SentGet(chn)->value, 0, SEQ_MIXER_PAR_CC4-SEQ_MIXER_PAR_PRG+1);
+    MUTEX_MIDIOUT_GIVE;
   }
 
-  for(par=SEQ_MIXER_PAR_PRG; par<=SEQ_MIXER_PAR_MODWHEEL; ++par)
-    status |= SEQ_MIXER_Send(chn, par);
+  MIOS32_IRQ_Disable();
+  if( (dump_req & (1 << chn)) && dump_chn == chn )
+    dump_step = 0; // channel is currently dumped: restart
 
-  // CCs after PC?
-  for(par=0; par<4; ++par) {
-    if( !(seq_mixer_cc1234_before_pc & (1 << par)) ) {
-      status |= SEQ_MIXER_Send(chn, SEQ_MIXER_PAR_CC1 + par);
-    }
-  }
+  dump_req |= (1 << chn);
+  MIOS32_IRQ_Enable();
 
-  MUTEX_MIDIOUT_GIVE;
-	
-  return status;
+  return 0; // no error
 }
 
 /////////////////////////////////////////////////////////////////////////////
-// Sends all mixer values
+// Requests to send all mixer values (see SEQ_MIXER_SendAllByChannel)
 /////////////////////////////////////////////////////////////////////////////
-s32 SEQ_MIXER_SendAll(void)
+s32 SEQ_MIXER_SendAll(u8 force)
 {
   u8 chn;
+
+  for(chn=0; chn<SEQ_MIXER_NUM_CHANNELS; ++chn)
+    SEQ_MIXER_SendAllByChannel(chn, force);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the parameter which is sent at the given step of a channel dump
+// (CC1..CC4 before or after PC depending on seq_mixer_cc1234_before_pc)
+// Returns -1 if no parameter is sent at this step
+/////////////////////////////////////////////////////////////////////////////
+static s32 SEQ_MIXER_DumpParGet(u8 step)
+{
+  if( step < 4 ) // CCs before PC?
+    return (seq_mixer_cc1234_before_pc & (1 << step)) ? (SEQ_MIXER_PAR_CC1 + step) : -1;
+
+  if( step < 10 )
+    return SEQ_MIXER_PAR_PRG + (step - 4);
+
+  if( step < 14 ) // CCs after PC?
+    return (seq_mixer_cc1234_before_pc & (1 << (step-10))) ? -1 : (SEQ_MIXER_PAR_CC1 + (step - 10));
+
+  return -1;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if values for the port of a mixer channel have to be paced
+// Only serial ports (MIDI DIN and IIC) are limited to 31.25 kBaud, USB and
+// OSC can take a complete dump at once
+/////////////////////////////////////////////////////////////////////////////
+static u8 SEQ_MIXER_DumpPaced(u8 chn)
+{
+  u8 port_class = SEQ_MIXER_PortGet(chn) & 0xf0;
+  return port_class == UART0 || port_class == IIC0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This handler should be called each mS
+// It sends requested mixer values which have been changed, but not more than
+// SEQ_MIXER_DUMP_BYTES_PER_MS to serial ports, so that a dump doesn't block
+// the MIDI output of the sequencer (e.g. when a mixer map is loaded during
+// playback)
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_MIXER_Handler(void)
+{
+  if( !dump_req ) {
+    dump_credit = 0;
+    return 0; // nothing to do
+  }
+
+  // the credit allows to send a Program Change or CC even if the budget is less than 3 bytes per mS
+  if( dump_credit < (2*SEQ_MIXER_DUMP_BYTES_PER_MS + 3) )
+    dump_credit += SEQ_MIXER_DUMP_BYTES_PER_MS;
+
   s32 status = 0;
 
   MUTEX_MIDIOUT_TAKE;
-  for(chn=0; chn<SEQ_MIXER_NUM_CHANNELS; ++chn)
-    SEQ_MIXER_SendAllByChannel(chn);
+  while( dump_req ) {
+    // search for next requested channel
+    while( !(dump_req & (1 << dump_chn)) ) {
+      dump_chn = (dump_chn + 1) % SEQ_MIXER_NUM_CHANNELS;
+      dump_step = 0;
+    }
+
+    s32 par = SEQ_MIXER_DumpParGet(dump_step);
+    if( par >= 0 && SEQ_MIXER_Changed(dump_chn, par) ) {
+      if( SEQ_MIXER_DumpPaced(dump_chn) ) {
+	u8 num_bytes = (par == SEQ_MIXER_PAR_PRG) ? 2 : 3;
+	if( dump_credit < num_bytes )
+	  break; // continue with the next call
+	dump_credit -= num_bytes;
+      }
+
+      status |= SEQ_MIXER_Send(dump_chn, par);
+    }
+
+    if( ++dump_step >= 14 ) {
+      // channel completed
+      MIOS32_IRQ_Disable();
+      dump_req &= ~(1 << dump_chn);
+      MIOS32_IRQ_Enable();
+      dump_step = 0;
+    }
+  }
   MUTEX_MIDIOUT_GIVE;
 
   return status;
@@ -26,6 +26,13 @@
 #define SEQ_MIXER_NUM_CHANNELS   16
 #define SEQ_MIXER_NUM_PARAMETERS 16
 
+// max. number of bytes which are sent by SEQ_MIXER_Handler() each mS to
+// MIDI DIN and IIC ports (a MIDI DIN port transfers 3.125 bytes per mS)
+// USB and OSC ports are not paced
+#ifndef SEQ_MIXER_DUMP_BYTES_PER_MS
+#define SEQ_MIXER_DUMP_BYTES_PER_MS 3
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -66,8 +73,10 @@ extern s32 SEQ_MIXER_Set(u8 chn, seq_mixer_par_t par, u8 value);
 extern s32 SEQ_MIXER_Get(u8 chn, seq_mixer_par_t par);
 
 extern s32 SEQ_MIXER_Send(u8 chn, seq_mixer_par_t par);
-extern s32 SEQ_MIXER_SendAll(void);
-extern s32 SEQ_MIXER_SendAllByChannel(u8 chn);
+extern s32 SEQ_MIXER_SendAll(u8 force);
+extern s32 SEQ_MIXER_SendAllByChannel(u8 chn, u8 force);
+extern s32 SEQ_MIXER_Handler(void);
+extern s32 SEQ_MIXER_NotifyMIDITx(mios32_midi_port_t port, mios32_midi_package_t package);
 
 extern s32 SEQ_MIXER_Clear(void);
 
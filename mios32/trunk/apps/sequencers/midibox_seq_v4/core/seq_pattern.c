@@ -212,10 +212,11 @@ s32 SEQ_PATTERN_Handler(void)
 	for(track = group * 4; track<((group+1)*4); ++track) {
 					
 	  // if we got the track bit setup inside our remix_map, them do not send mixer data for that track channel, let it be mixed down
-	  if ( ((1 << track) | seq_pattern_remix_map) == seq_pattern_remix_map ) {
+	  // (the u16 map only covers the first 16 tracks, one bit per GP button)
+	  if ( track < 16 && ((1 << track) | seq_pattern_remix_map) == seq_pattern_remix_map ) {
 	    // do nothing for now...
 	  } else {
-	    SEQ_MIXER_SendAllByChannel(track);
+	    SEQ_MIXER_SendAllByChannel(track, 1);
 	  }
 	}
       }
@@ -230,8 +231,10 @@ s32 SEQ_PATTERN_Handler(void)
 
       // restart *all* patterns?
       if( seq_core_options.RATOPC ) {
+	u8 track;
 	MIOS32_IRQ_Disable(); // must be atomic
-	seq_core_state.reset_trkpos_req |= (0xf << (4*group));
+	for(track=group*SEQ_CORE_NUM_TRACKS_PER_GROUP; track<(group+1)*SEQ_CORE_NUM_TRACKS_PER_GROUP; ++track)
+	  SEQ_CORE_TRKSET_SET(&seq_core_state.reset_trkpos_req, track);
 	MIOS32_IRQ_Enable();
       }
     }
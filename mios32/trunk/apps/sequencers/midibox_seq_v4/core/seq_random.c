@@ -16,15 +16,21 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <mios32.h>
-#include <jsw_rand.h>
+
+#include "seq_core.h"
+#include "seq_random.h"
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local defines
 /////////////////////////////////////////////////////////////////////////////
 
-// Reentrant "rand_r" not supported by MinGW, therefore we are using rand() instead
-// Now using portable jsw_rand() functions due to problems with newlib on windows/linux
-#define REENTRANT 0
+// Counter based random generator:
+// each number is a hash of the seed, the stream (global or track/consumer),
+// the stream position and a draw counter. There is no generator state
+// which has to be shared between tasks, and a track stream returns the same
+// numbers whenever the same step is played again (e.g. after a song position
+// change or during MIDI file export)
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -32,32 +38,42 @@
 /////////////////////////////////////////////////////////////////////////////
 
 // initial seed
-static unsigned int random_value = 0xdeadbabe;
+static u32 random_seed = 0xdeadbabe;
+
+// draw counter of the global stream
+static u32 random_ctr;
+
+// position and draw counters of the track streams
+static u32 track_pos[SEQ_CORE_NUM_TRACKS];
+static u16 track_ctr[SEQ_CORE_NUM_TRACKS][SEQ_RANDOM_NUM_STREAMS];
+
+
+/////////////////////////////////////////////////////////////////////////////
+// 32bit integer hash (good avalanche behaviour, only shifts, xor and multiplications)
+/////////////////////////////////////////////////////////////////////////////
+static inline u32 SEQ_RANDOM_Mix(u32 x)
+{
+  x ^= x >> 16;
+  x *= 0x7feb352d;
+  x ^= x >> 15;
+  x *= 0x846ca68b;
+  x ^= x >> 16;
+  return x;
+}
 
 
 /////////////////////////////////////////////////////////////////////////////
 // random generator function
+// if seed != 0, the generator will be initialized with the given seed
 /////////////////////////////////////////////////////////////////////////////
 u32 SEQ_RANDOM_Gen(u32 seed)
 {
-#if REENTRANT
-  if( seed )
-    random_value = seed;
-	
-
-  // MEMO: for thread safeness, we would have to pass a pointer to random_value through the SEQ_RANDOM_Gen() function
-  // however, multiple threads just increase the randomness even more - therefore this approach is fine ;-)
-
-  // TODO: combine with timer values for even more randomness
-  rand_r(&random_value);
-
-  return random_value;
-#else
-  if( seed )
-	jsw_seed(seed);
-	
-  return random_value = (u32)jsw_rand();
-#endif
+  if( seed ) {
+    random_seed = seed;
+    random_ctr = 0;
+  }
+
+  return SEQ_RANDOM_Mix(SEQ_RANDOM_Mix(random_seed) + random_ctr++);
 }
 
 
@@ -77,13 +93,109 @@ u32 SEQ_RANDOM_Gen_Range(u32 min, u32 max)
     min = max;
     max = tmp;
   }
-  // generate new random number
-#if REENTRANT
-  rand_r(&random_value);
-#else
-  random_value = jsw_rand();
-#endif
 
   // return result within the given range
-  return min + (random_value % (max-min+1));
+  return min + (SEQ_RANDOM_Gen(0) % (max-min+1));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sets the position of the random streams of a track
+// Called by SEQ_CORE_Tick() with the reference bpm_tick of each played step,
+// the draw counters of all streams of the track are reset
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_RANDOM_TrackPosSet(u8 track, u32 pos)
+{
+  if( track >= SEQ_CORE_NUM_TRACKS )
+    return -1; // invalid track
+
+  track_pos[track] = pos;
+
+  int stream;
+  for(stream=0; stream<SEQ_RANDOM_NUM_STREAMS; ++stream)
+    track_ctr[track][stream] = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// returns the next random number of a track stream
+/////////////////////////////////////////////////////////////////////////////
+u32 SEQ_RANDOM_TrackGen(u8 track, seq_random_stream_t stream)
+{
+  if( track >= SEQ_CORE_NUM_TRACKS || stream >= SEQ_RANDOM_NUM_STREAMS )
+    return SEQ_RANDOM_Gen(0);
+
+  u32 key = SEQ_RANDOM_Mix(random_seed ^ ((u32)track << 24) ^ ((u32)stream << 16));
+  key = SEQ_RANDOM_Mix(key ^ track_pos[track]);
+
+  return SEQ_RANDOM_Mix(key + track_ctr[track][stream]++);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// returns random number of a track stream in a given range
+/////////////////////////////////////////////////////////////////////////////
+u32 SEQ_RANDOM_TrackGen_Range(u8 track, seq_random_stream_t stream, u32 min, u32 max)
+{
+  // values equal? -> no random number required
+  if( min == max )
+    return min;
+
+  // swap min/max if reversed
+  if( min > max ) {
+    u32 tmp;
+    tmp = min;
+    min = max;
+    max = tmp;
+  }
+
+  // return result within the given range
+  return min + (SEQ_RANDOM_TrackGen(track, stream) % (max-min+1));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Takes over the position of a track stream, so that the next num values
+// can be generated later with SEQ_RANDOM_TrackStreamGen_Range() (e.g. by
+// echo repeats). The values are skipped in the track stream.
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_RANDOM_TrackStreamTake(u8 track, seq_random_stream_t stream, u16 num, seq_random_track_stream_t *s)
+{
+  if( track >= SEQ_CORE_NUM_TRACKS || stream >= SEQ_RANDOM_NUM_STREAMS ) {
+    s->key = SEQ_RANDOM_Gen(0);
+    s->ctr = 0;
+    return -1; // invalid track or stream
+  }
+
+  u32 key = SEQ_RANDOM_Mix(random_seed ^ ((u32)track << 24) ^ ((u32)stream << 16));
+  s->key = SEQ_RANDOM_Mix(key ^ track_pos[track]);
+  s->ctr = track_ctr[track][stream];
+  track_ctr[track][stream] += num;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// returns the next random number of a stream which has been taken over
+// with SEQ_RANDOM_TrackStreamTake() in a given range
+/////////////////////////////////////////////////////////////////////////////
+u32 SEQ_RANDOM_TrackStreamGen_Range(seq_random_track_stream_t *s, u32 min, u32 max)
+{
+  // values equal? -> no random number required
+  if( min == max )
+    return min;
+
+  // swap min/max if reversed
+  if( min > max ) {
+    u32 tmp;
+    tmp = min;
+    min = max;
+    max = tmp;
+  }
+
+  // return result within the given range
+  return min + (SEQ_RANDOM_Mix(s->key + s->ctr++) % (max-min+1));
 }
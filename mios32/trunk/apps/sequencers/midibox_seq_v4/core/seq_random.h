@@ -15,6 +15,33 @@
 #define _SEQ_RANDOM_H
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+#define SEQ_RANDOM_NUM_STREAMS 5
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global Types
+/////////////////////////////////////////////////////////////////////////////
+
+// consumers of the track streams
+typedef enum {
+  SEQ_RANDOM_STREAM_PROBABILITY = 0, // random gate and step probability
+  SEQ_RANDOM_STREAM_DIRECTION,       // random track directions
+  SEQ_RANDOM_STREAM_ROBOTIZE,
+  SEQ_RANDOM_STREAM_HUMANIZE,
+  SEQ_RANDOM_STREAM_ECHO,
+} seq_random_stream_t;
+
+// a track stream which has been taken over by SEQ_RANDOM_TrackStreamTake()
+typedef struct {
+  u32 key;
+  u16 ctr;
+} seq_random_track_stream_t;
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Prototypes
 /////////////////////////////////////////////////////////////////////////////
@@ -22,6 +49,12 @@
 extern u32 SEQ_RANDOM_Gen(u32 seed);
 extern u32 SEQ_RANDOM_Gen_Range(u32 min, u32 max);
 
+extern s32 SEQ_RANDOM_TrackPosSet(u8 track, u32 pos);
+extern u32 SEQ_RANDOM_TrackGen(u8 track, seq_random_stream_t stream);
+extern u32 SEQ_RANDOM_TrackGen_Range(u8 track, seq_random_stream_t stream, u32 min, u32 max);
+extern s32 SEQ_RANDOM_TrackStreamTake(u8 track, seq_random_stream_t stream, u16 num, seq_random_track_stream_t *s);
+extern u32 SEQ_RANDOM_TrackStreamGen_Range(seq_random_track_stream_t *s, u32 min, u32 max);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
@@ -73,14 +73,15 @@ s32 SEQ_RECORD_Init(u32 mode)
   seq_record_options.POLY_RECORD = 1;
   seq_record_quantize = 10;
 
-  seq_record_state.ALL = 0;
+  seq_record_state.ENABLED = 0;
+  SEQ_CORE_TrkSetClear(&seq_record_state.ARMED_TRACKS);
 
 #ifndef MBSEQV4L
   // default for MBSEQ V4
-  seq_record_state.ARMED_TRACKS = 0x0001; // first track -- currently not relevant, could be provided for MBSEQV4 later
+  SEQ_CORE_TRKSET_SET(&seq_record_state.ARMED_TRACKS, 0); // first track -- currently not relevant, could be provided for MBSEQV4 later
 #else
   // default for MBSEQ V4L
-  seq_record_state.ARMED_TRACKS = 0x00ff; // first sequence
+  SEQ_CORE_TrkSetSet16(&seq_record_state.ARMED_TRACKS, 0, 0x00ff); // first sequence
 #endif
 
   SEQ_RECORD_ResetAllTracks();
@@ -211,11 +212,11 @@ s32 SEQ_RECORD_Receive(mios32_midi_package_t midi_package, u8 track)
 
 #if MBSEQV4L
   // extra for MBSEQ V4L: seq_record_state.ARMED_TRACKS and auto-assignment
-  if( !seq_record_state.ARMED_TRACKS )
+  if( SEQ_CORE_TrkSetIsEmpty(&seq_record_state.ARMED_TRACKS) )
     return 0; // no track armed
 
   track = 0;
-  if( seq_record_state.ARMED_TRACKS & 0xff00)
+  if( SEQ_CORE_TrkSetGet16(&seq_record_state.ARMED_TRACKS, 0) & 0xff00 )
     track = 8;
 
   // search for free track/layer
@@ -251,7 +252,7 @@ s32 SEQ_RECORD_Receive(mios32_midi_package_t midi_package, u8 track)
 
       if( *layer_type_ptr == SEQ_PAR_Type_CC &&
 	  (*layer_cc_ptr >= 0x80 || *layer_cc_ptr == midi_package.cc_number) &&
-	  (seq_record_state.ARMED_TRACKS & (1 << track)) ) {
+	  SEQ_CORE_TRKSET_GET(&seq_record_state.ARMED_TRACKS, track) ) {
 
 	if( *layer_cc_ptr >= 0x80 ) {
 	  *layer_cc_ptr = midi_package.cc_number; // assing CC number to free track
@@ -282,7 +283,7 @@ s32 SEQ_RECORD_Receive(mios32_midi_package_t midi_package, u8 track)
   }
 
   // exit if track not armed
-  if( !(seq_record_state.ARMED_TRACKS & (1 << track)) )
+  if( !SEQ_CORE_TRKSET_GET(&seq_record_state.ARMED_TRACKS, track) )
     return 0;
 #else
   // MBSEQV4 (without L)
@@ -651,17 +652,17 @@ s32 SEQ_RECORD_NewStep(u8 track, u8 prev_step, u8 new_step, u32 bpm_tick)
   if( bpm_tick == 0 )
     return 0; // silently ignore (we don't expect a live recording event at the very first step)
 
+  if( track >= SEQ_CORE_NUM_TRACKS )
+    return -4; // unsupported track
+
 #ifndef MBSEQV4L
   if( track != SEQ_UI_VisibleTrackGet() )
     return -3; // only for visible track
 #else
-  if( !(seq_record_state.ARMED_TRACKS & (1 << track)) )
+  if( !SEQ_CORE_TRKSET_GET(&seq_record_state.ARMED_TRACKS, track) )
     return -3; // MBSEQV4L: only for armed track
 #endif
 
-  if( track >= SEQ_CORE_NUM_TRACKS )
-    return -4; // unsupported track
-
   seq_core_trk_t *t = &seq_core_trk[track];
   seq_cc_trk_t *tcc = &seq_cc_trk[track];
 
@@ -14,6 +14,8 @@
 #ifndef _SEQ_RECORD_H
 #define _SEQ_RECORD_H
 
+#include "seq_core.h"
+
 /////////////////////////////////////////////////////////////////////////////
 // Global definitions
 /////////////////////////////////////////////////////////////////////////////
@@ -35,12 +37,9 @@ typedef union {
 } seq_record_options_t;
 
 
-typedef union {
-  u32 ALL;
-  struct {
-    u16 ARMED_TRACKS;
-    u32 ENABLED:1;
-  };
+typedef struct {
+  seq_core_trkset_t ARMED_TRACKS;
+  u8 ENABLED:1;
 } seq_record_state_t;
 
 
@@ -38,18 +38,12 @@ s32 SEQ_ROBOTIZE_Init(u32 mode)
 // checks robotizing probabilities - overall probability is multiplied with individual probability
 // returns true if the item should be robotized, or false otherwise 
 /////////////////////////////////////////////////////////////////////////////
-u8 SEQ_ROBOTIZE_Check_Probabilities(u8 prob1, u8 prob2, u32 randoms[], u8 *big_randoms_used)
+u8 SEQ_ROBOTIZE_Check_Probabilities(u8 track, u8 prob1, u8 prob2)
 {
 	u8 returnbit = 0;
 	if( prob1 && prob2 ) { //robotize event is possible
- 	  u8 randindex = (*big_randoms_used) / 3;
-	  if ((u8)( (*big_randoms_used) % 3 ) == 0){
-		  randoms[randindex] = SEQ_RANDOM_Gen(0); // get fresh random number if needed
-	  }
-	  
 	  u16 testvar = ( prob1 + 1) * ( prob2 + 1); // multiply the two probabilities together to get 10 bit probability number
-	  u16 big_random = ( (randoms[randindex]) >> ( ( (*big_randoms_used) % 3 ) * 10 ) ) & ( ( 1 << 10 ) - 1 ) ; // extract a new big random number from the longer 32 bit random number
-	  *big_randoms_used += 1; // increment counter
+	  u16 big_random = SEQ_RANDOM_TrackGen(track, SEQ_RANDOM_STREAM_ROBOTIZE) & ( ( 1 << 10 ) - 1 ); // each draw of the track stream is independent, no need to split 32 bit numbers anymore
 	  if ( big_random <= testvar ) returnbit = 1; // we're a go for robotizing!
 	}
 	return returnbit;
@@ -84,25 +78,23 @@ seq_robotize_flags_t SEQ_ROBOTIZE_Event(u8 track, u8 step, seq_layer_evnt_t *e)
 
 
 
-//initialize random number array, counter, and range variables
-u32 randoms[3] = {0} ; //array of 32 bit random numbers.  Only fills if and as needed, to minimize calls to seq_random_gen.  Use array rather than overwriting the same var, so that the old rands are kept in case we want to reuse them in future improvements to the robotizer
-u8 big_randoms_used = 0; //keeps track of how many 10 bit random numbers we've pulled so far
+//initialize range variable
 u8 range = 0; //range - reused in several of the robotizers
 
 /*
-if ( tcc->robotize_X && tcc->robotize_X_probability && SEQ_ROBOTIZE_Check_Probabilities( tcc->robotize_probability, tcc->robotize_X_probability, randoms, &big_randoms_used) ) {
+if ( tcc->robotize_X && tcc->robotize_X_probability && SEQ_ROBOTIZE_Check_Probabilities( track, tcc->robotize_probability, tcc->robotize_X_probability) ) {
 //ROBOTIZING CODE GOES HERE
 }
 
 //debug with
-MIOS32_MIDI_SendDebugMessage("random: %d ", randoms[0]);
+MIOS32_MIDI_SendDebugMessage("range: %d ", range);
 * MIOS32_MIDI_SendDebugString("string")
 */
 
 	//NOTE ROBOTIZER - shift by semitones
-	if ( tcc->robotize_note && tcc->robotize_note_probability && SEQ_ROBOTIZE_Check_Probabilities( tcc->robotize_probability, tcc->robotize_note_probability, randoms, &big_randoms_used) ) {
+	if ( tcc->robotize_note && tcc->robotize_note_probability && SEQ_ROBOTIZE_Check_Probabilities( track, tcc->robotize_probability, tcc->robotize_note_probability) ) {
 		range = tcc->robotize_note * 2;
-		s16 value = e->midi_package.note + ((range/2) - (s16)SEQ_RANDOM_Gen_Range(0, range));
+		s16 value = e->midi_package.note + ((range/2) - (s16)SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_ROBOTIZE, 0, range));
 
 		// ensure that note is in the 0..127 range
 		value = SEQ_CORE_TrimNote(value, 0, 127);
@@ -112,9 +104,9 @@ MIOS32_MIDI_SendDebugMessage("random: %d ", randoms[0]);
 		
 
 	//OCTAVE ROBOTIZER - shift by octaves - cumulative with notes
-	if ( tcc->robotize_oct && tcc->robotize_oct_probability && SEQ_ROBOTIZE_Check_Probabilities( tcc->robotize_probability, tcc->robotize_oct_probability, randoms, &big_randoms_used) ) {
+	if ( tcc->robotize_oct && tcc->robotize_oct_probability && SEQ_ROBOTIZE_Check_Probabilities( track, tcc->robotize_probability, tcc->robotize_oct_probability) ) {
 		range = tcc->robotize_oct * 2;
-		s16 value = e->midi_package.note + (((range/2) - (s16)SEQ_RANDOM_Gen_Range(0, range))*12);
+		s16 value = e->midi_package.note + (((range/2) - (s16)SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_ROBOTIZE, 0, range))*12);
 
 		// ensure that note is in the 0..127 range
 		value = SEQ_CORE_TrimNote(value, 0, 127);
@@ -124,8 +116,8 @@ MIOS32_MIDI_SendDebugMessage("random: %d ", randoms[0]);
 
 
 	//VELOCITY ROBOTIZER - change note velocity
-	if ( tcc->robotize_vel && tcc->robotize_vel_probability && SEQ_ROBOTIZE_Check_Probabilities( tcc->robotize_probability, tcc->robotize_vel_probability, randoms, &big_randoms_used) ) {
-		s16 randnum = SEQ_RANDOM_Gen_Range( 0 , tcc->robotize_vel * 2) - tcc->robotize_vel;
+	if ( tcc->robotize_vel && tcc->robotize_vel_probability && SEQ_ROBOTIZE_Check_Probabilities( track, tcc->robotize_probability, tcc->robotize_vel_probability) ) {
+		s16 randnum = SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_ROBOTIZE, 0, tcc->robotize_vel * 2) - tcc->robotize_vel;
 		s16 value = randnum + e->midi_package.velocity;
 
 		//weight randnum if out of range in a superconvoluted way because I'm terrible at math.
@@ -141,8 +133,8 @@ MIOS32_MIDI_SendDebugMessage("random: %d ", randoms[0]);
 
 
 	//GATELENGTH ROBOTIZER - change note duration
-	if ( tcc->robotize_len && tcc->robotize_len_probability && SEQ_ROBOTIZE_Check_Probabilities( tcc->robotize_probability, tcc->robotize_len_probability, randoms, &big_randoms_used) ) {
-		s16 value = e->len + ((tcc->robotize_len/2) - (s16)SEQ_RANDOM_Gen_Range(0, tcc->robotize_len));
+	if ( tcc->robotize_len && tcc->robotize_len_probability && SEQ_ROBOTIZE_Check_Probabilities( track, tcc->robotize_probability, tcc->robotize_len_probability) ) {
+		s16 value = e->len + ((tcc->robotize_len/2) - (s16)SEQ_RANDOM_TrackGen_Range(track, SEQ_RANDOM_STREAM_ROBOTIZE, 0, tcc->robotize_len));
 		if( value < 1 )
 		  value = 1;
 		else if( value > 95 )
@@ -152,34 +144,34 @@ MIOS32_MIDI_SendDebugMessage("random: %d ", randoms[0]);
 
 
 	// NOTE SKIP ROBOTIZER
-	if ( tcc->robotize_skip_probability && SEQ_ROBOTIZE_Check_Probabilities( tcc->robotize_probability, tcc->robotize_skip_probability, randoms, &big_randoms_used) ) {
+	if ( tcc->robotize_skip_probability && SEQ_ROBOTIZE_Check_Probabilities( track, tcc->robotize_probability, tcc->robotize_skip_probability) ) {
 		e->midi_package.velocity = 0;// play with zero velocity
 	}
 
 
 	// SUSTAIN ROBOTIZER
-	if ( tcc->robotize_sustain_probability && SEQ_ROBOTIZE_Check_Probabilities( tcc->robotize_probability, tcc->robotize_sustain_probability, randoms, &big_randoms_used) ) {
+	if ( tcc->robotize_sustain_probability && SEQ_ROBOTIZE_Check_Probabilities( track, tcc->robotize_probability, tcc->robotize_sustain_probability) ) {
 		//set sustain flag
 		returnflags.SUSTAIN = 1;
 	}
 
 
 	// NOFX ROBOTIZER
-	if ( tcc->robotize_nofx_probability && SEQ_ROBOTIZE_Check_Probabilities( tcc->robotize_probability, tcc->robotize_nofx_probability, randoms, &big_randoms_used) ) {
+	if ( tcc->robotize_nofx_probability && SEQ_ROBOTIZE_Check_Probabilities( track, tcc->robotize_probability, tcc->robotize_nofx_probability) ) {
 		//set NOFX flag
 		returnflags.NOFX = 1;
 	}
 
 
 	// +ECHO ROBOTIZER
-	if ( tcc->robotize_echo_probability && SEQ_ROBOTIZE_Check_Probabilities( tcc->robotize_probability, tcc->robotize_echo_probability, randoms, &big_randoms_used) ) {
+	if ( tcc->robotize_echo_probability && SEQ_ROBOTIZE_Check_Probabilities( track, tcc->robotize_probability, tcc->robotize_echo_probability) ) {
 		//set +ECHO flag
 		returnflags.ECHO = 1;
 	}
 
 
 	// +DUPLICATE ROBOTIZER
-	if ( tcc->robotize_duplicate_probability && SEQ_ROBOTIZE_Check_Probabilities( tcc->robotize_probability, tcc->robotize_duplicate_probability, randoms, &big_randoms_used) ) {
+	if ( tcc->robotize_duplicate_probability && SEQ_ROBOTIZE_Check_Probabilities( track, tcc->robotize_probability, tcc->robotize_duplicate_probability) ) {
 		//set +DUPLICATE flag
 		returnflags.DUPLICATE = 1;
 	}
@@ -280,8 +280,10 @@ static s32 SEQ_SONG_FetchHlp_PatternChange(u8 group, u8 pattern, u8 bank, u8 for
     } else {
       // pattern not reloaded... we have to consider the RATOPC flag which is normally done in SEQ_PATTERN_Handler()
       if( seq_core_options.RATOPC ) {
+	u8 track;
 	MIOS32_IRQ_Disable(); // must be atomic
-	seq_core_state.reset_trkpos_req |= (0xf << (4*group));
+	for(track=group*SEQ_CORE_NUM_TRACKS_PER_GROUP; track<(group+1)*SEQ_CORE_NUM_TRACKS_PER_GROUP; ++track)
+	  SEQ_CORE_TRKSET_SET(&seq_core_state.reset_trkpos_req, track);
 	MIOS32_IRQ_Enable();
       }
     }
@@ -347,7 +349,7 @@ s32 SEQ_SONG_FetchPos(u8 force_immediate_change, u8 dont_dump_mixer_map)
 	SEQ_MIXER_Load(s->action_value);
 	SEQ_MIDI_IN_ExtCtrlSend(SEQ_MIDI_IN_EXT_CTRL_MIXER_MAP, s->action_value, 0);
 	if( !dont_dump_mixer_map )
-	  SEQ_MIXER_SendAll();
+	  SEQ_MIXER_SendAll(0);
 	++song_pos;
 	again = 1;
 	break;
@@ -366,11 +368,12 @@ s32 SEQ_SONG_FetchPos(u8 force_immediate_change, u8 dont_dump_mixer_map)
 	// access to seq_core_trk[] must be atomic!
 	portENTER_CRITICAL();
 
-	seq_core_trk_muted =
-	  ((s->pattern_g1 & 0x0f) <<  0) |
-	  ((s->pattern_g2 & 0x0f) <<  4) |
-	  ((s->pattern_g3 & 0x0f) <<  8) |
-	  ((s->pattern_g4 & 0x0f) << 12);
+	// song steps store the mutes of the first 16 tracks
+	SEQ_CORE_TrkSetSet16(&seq_core_trk_muted, 0,
+			     ((s->pattern_g1 & 0x0f) <<  0) |
+			     ((s->pattern_g2 & 0x0f) <<  4) |
+			     ((s->pattern_g3 & 0x0f) <<  8) |
+			     ((s->pattern_g4 & 0x0f) << 12));
 
 	portEXIT_CRITICAL();
 
@@ -389,7 +392,7 @@ s32 SEQ_SONG_FetchPos(u8 force_immediate_change, u8 dont_dump_mixer_map)
 	// access to seq_core_trk[] must be atomic!
 	portENTER_CRITICAL();
 
-	seq_core_trk_muted = 0x0000;
+	SEQ_CORE_TrkSetClear(&seq_core_trk_muted);
 
 	{
 	  seq_core_trk_t *t = &seq_core_trk[0];
@@ -1082,7 +1082,7 @@ s32 SEQ_TERMINAL_PrintTracks(void *_output_function)
 	    SEQ_MIDI_PORT_OutCheckAvailable(midi_port) ? ' ' : '*',
 	    midi_chn);
 
-    if( seq_core_trk_muted & (1 << track) )
+    if( SEQ_CORE_TRKSET_GET(&seq_core_trk_muted, track) )
       sprintf((char *)(str_buffer + strlen(str_buffer)), "  yes  |");
     else if( seq_core_trk[track].layer_muted )
       sprintf((char *)(str_buffer + strlen(str_buffer)), " layer |");
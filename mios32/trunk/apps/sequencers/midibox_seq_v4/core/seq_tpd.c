@@ -182,7 +182,7 @@ s32 SEQ_TPD_Handler(void)
 	s32 rel_pos = (8*cur_step) / num_steps;
 
 	// set pos LED only if not muted
-	if( !(seq_core_trk_muted & (1 << track)) ) {
+	if( !(SEQ_CORE_TRKSET_GET(&seq_core_trk_muted, track)) ) {
 	  if( horizontal_display ) {
 	    tpd_display[col][TPD_RED][row] = (1 << rel_pos);
 	  } else {
@@ -229,7 +229,7 @@ s32 SEQ_TPD_Handler(void)
 	s32 rel_pos = (8*cur_step) / num_steps;
 
 	// set pos LED only if not muted
-	if( !(seq_core_trk_muted & (1 << track)) ) {
+	if( !(SEQ_CORE_TRKSET_GET(&seq_core_trk_muted, track)) ) {
 	  if( horizontal_display ) {
 	    tpd_display[col][TPD_GREEN][row] = (1 << rel_pos);
 	  } else {
@@ -59,7 +59,7 @@ u8 seq_ui_display_init_req;
 seq_ui_button_state_t seq_ui_button_state;
 
 u8 ui_selected_group;
-u16 ui_selected_tracks;
+seq_core_trkset_t ui_selected_tracks;
 u8 ui_selected_par_layer;
 u8 ui_selected_trg_layer;
 u8 ui_selected_instrument;
@@ -168,7 +168,8 @@ s32 SEQ_UI_Init(u32 mode)
 
   // init selection variables
   ui_selected_group = 0;
-  ui_selected_tracks = (1 << 0);
+  SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+  SEQ_CORE_TRKSET_SET(&ui_selected_tracks, 0);
   ui_selected_par_layer = 0;
   ui_selected_trg_layer = 0;
   ui_selected_instrument = 0;
@@ -859,7 +860,7 @@ static s32 SEQ_UI_Button_MultiCopy(s32 depressed)
   // copy all selected patterns to preset directory
   u8 track, track_id;
   for(track=0, track_id=0; track<SEQ_CORE_NUM_TRACKS; ++track) {
-    if( ui_selected_tracks & (1 << track) ) {
+    if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) ) {
       ++track_id;
       sprintf(path, "/PRESETS/COPY%d.v4t", track_id);
 
@@ -940,7 +941,7 @@ static s32 SEQ_UI_Button_MultiPaste(s32 depressed)
   // paste multi copy presets into selected tracks
   u8 track, track_id;
   for(track=0, track_id=0; track<SEQ_CORE_NUM_TRACKS; ++track) {
-    if( ui_selected_tracks & (1 << track) ) {
+    if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) ) {
       ++track_id;
       sprintf(path, "/PRESETS/COPY%d.v4t", track_id);
 
@@ -950,9 +951,9 @@ static s32 SEQ_UI_Button_MultiPaste(s32 depressed)
 
       // mute track to avoid random effects while loading the file
       MIOS32_IRQ_Disable(); // this operation should be atomic!
-      u8 muted = seq_core_trk_muted & (1 << track);
+      u8 muted = SEQ_CORE_TRKSET_GET(&seq_core_trk_muted, track);
       if( !muted )
-	seq_core_trk_muted |= (1 << track);
+	SEQ_CORE_TRKSET_SET(&seq_core_trk_muted, track);
       MIOS32_IRQ_Enable();
 
       static seq_file_t_import_flags_t import_flags;
@@ -966,7 +967,7 @@ static s32 SEQ_UI_Button_MultiPaste(s32 depressed)
       // unmute track if it wasn't muted before
       MIOS32_IRQ_Disable(); // this operation should be atomic!
       if( !muted )
-	seq_core_trk_muted &= ~(1 << track);
+	SEQ_CORE_TRKSET_CLR(&seq_core_trk_muted, track);
       MIOS32_IRQ_Enable();
 
       if( status == FILE_ERR_OPEN_READ ) {
@@ -1349,7 +1350,7 @@ static s32 SEQ_UI_Button_Solo(s32 depressed)
   // seq_core_trk_soloed currently only used for the BLM16x16+X
   // which overrules the legacy SOLO function
   if( !seq_ui_button_state.SOLO )
-    seq_core_trk_soloed = 0;
+    SEQ_CORE_TrkSetClear(&seq_core_trk_soloed);
 
   return 0; // no error
 }
@@ -1514,13 +1515,14 @@ static s32 SEQ_UI_Button_Group(s32 depressed, u32 group)
   // if group has changed:
   if( group != ui_selected_group ) {
     // get current track selection
-    u16 old_tracks = ui_selected_tracks >> (4*ui_selected_group);
+    u8 old_tracks = SEQ_CORE_TrkSetGroupGet(&ui_selected_tracks, ui_selected_group);
 
     // select new group
     ui_selected_group = group;
 
     // take over old track selection
-    ui_selected_tracks = old_tracks << (4*ui_selected_group);
+    SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+    SEQ_CORE_TrkSetGroupSet(&ui_selected_tracks, ui_selected_group, old_tracks);
   }
 
   // set/clear encoder fast function if required
@@ -1549,10 +1551,11 @@ static s32 SEQ_UI_Button_Track(s32 depressed, u32 track_button)
 
   if( button_state == (~(1 << track_button) & 0xf) ) {
     // if only one select button pressed: radio-button function (1 of 4)
-    ui_selected_tracks = 1 << (track_button + 4*ui_selected_group);
+    SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+    SEQ_CORE_TRKSET_SET(&ui_selected_tracks, 4*ui_selected_group + track_button);
   } else {
     // if more than one select button pressed: toggle function (4 of 4)
-    ui_selected_tracks ^= 1 << (track_button + 4*ui_selected_group);
+    SEQ_CORE_TRKSET_TOGGLE(&ui_selected_tracks, 4*ui_selected_group + track_button);
   }
 
   // set/clear encoder fast function if required
@@ -1576,11 +1579,12 @@ static s32 SEQ_UI_Button_DirectTrack(s32 depressed, u32 track_button)
 
   if( button_state == (~(1 << track_button) & 0xffff) ) {
     // if only one select button pressed: radio-button function (1 of 16)
-    ui_selected_tracks = 1 << track_button;
+    SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+    SEQ_CORE_TRKSET_SET(&ui_selected_tracks, track_button);
     ui_selected_group = track_button / 4;
   } else {
     // if more than one select button pressed: toggle function (16 of 16)
-    ui_selected_tracks ^= 1 << track_button;
+    SEQ_CORE_TRKSET_TOGGLE(&ui_selected_tracks, track_button);
   }
 
   // set/clear encoder fast function if required
@@ -1897,7 +1901,7 @@ static s32 SEQ_UI_Button_TrackTranspose(s32 depressed)
 static s32 SEQ_UI_Button_MuteAllTracks(s32 depressed)
 {
   if( depressed ) return -1; // ignore when button depressed
-  seq_core_trk_muted = 0xffff;
+  SEQ_CORE_TrkSetFill(&seq_core_trk_muted);
   SEQ_UI_Msg(SEQ_UI_MSG_USER_R, 1000, "All Tracks", "muted");
   return 0; // no error
 }
@@ -1917,7 +1921,7 @@ static s32 SEQ_UI_Button_MuteAllTracksAndLayers(s32 depressed)
   int track;
   for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track)
     seq_core_trk[track].layer_muted = 0xffff;
-  seq_core_trk_muted = 0xffff;
+  SEQ_CORE_TrkSetFill(&seq_core_trk_muted);
   SEQ_UI_Msg(SEQ_UI_MSG_USER_R, 1000, "All Layers", "and Tracks muted");
   return 0; // no error
 }
@@ -1925,7 +1929,7 @@ static s32 SEQ_UI_Button_MuteAllTracksAndLayers(s32 depressed)
 static s32 SEQ_UI_Button_UnMuteAllTracks(s32 depressed)
 {
   if( depressed ) return -1; // ignore when button depressed
-  seq_core_trk_muted = 0x0000;
+  SEQ_CORE_TrkSetClear(&seq_core_trk_muted);
   SEQ_UI_Msg(SEQ_UI_MSG_USER_R, 1000, "All Tracks", "unmuted");
   return 0; // no error
 }
@@ -1945,7 +1949,7 @@ static s32 SEQ_UI_Button_UnMuteAllTracksAndLayers(s32 depressed)
   int track;
   for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track)
     seq_core_trk[track].layer_muted = 0x0000;
-  seq_core_trk_muted = 0x0000;
+  SEQ_CORE_TrkSetClear(&seq_core_trk_muted);
   SEQ_UI_Msg(SEQ_UI_MSG_USER_R, 1000, "All Layers", "and Tracks unmuted");
   return 0; // no error
 }
@@ -2223,7 +2227,8 @@ s32 SEQ_UI_BLM_Button_Handler(u32 row, u32 pin, u32 pin_value)
     return -1; // more than 16 step buttons not supported (yet) - could be done by selecting the step view
 
   // select track depending on row
-  ui_selected_tracks = 1 << (row + 4*ui_selected_group);
+  SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+  SEQ_CORE_TRKSET_SET(&ui_selected_tracks, 4*ui_selected_group + row);
 
   // ensure that selections are matching with track constraints
   SEQ_UI_CheckSelections();
@@ -2772,7 +2777,7 @@ s32 SEQ_UI_LED_Handler(void)
     SEQ_LED_PinSet(seq_hwcfg_led.track[2], (ui_selected_item == 5));
     SEQ_LED_PinSet(seq_hwcfg_led.track[3], (ui_selected_item == 6));
   } else {
-    u8 selected_tracks = ui_selected_tracks >> (4*ui_selected_group);
+    u8 selected_tracks = SEQ_CORE_TrkSetGroupGet(&ui_selected_tracks, ui_selected_group);
     SEQ_LED_PinSet(seq_hwcfg_led.track[0], (selected_tracks & (1 << 0)));
     SEQ_LED_PinSet(seq_hwcfg_led.track[1], (selected_tracks & (1 << 1)));
     SEQ_LED_PinSet(seq_hwcfg_led.track[2], (selected_tracks & (1 << 2)));
@@ -2881,9 +2886,9 @@ s32 SEQ_UI_LED_Handler(void)
   SEQ_LED_PinSet(seq_hwcfg_led.down, seq_ui_button_state.DOWN);
   SEQ_LED_PinSet(seq_hwcfg_led.up, seq_ui_button_state.UP);
 
-  SEQ_LED_PinSet(seq_hwcfg_led.mute_all_tracks, seq_core_trk_muted == 0xffff);
+  SEQ_LED_PinSet(seq_hwcfg_led.mute_all_tracks, SEQ_CORE_TrkSetIsFull(&seq_core_trk_muted));
   SEQ_LED_PinSet(seq_hwcfg_led.mute_track_layers, seq_core_trk[visible_track].layer_muted == 0xffff);
-  SEQ_LED_PinSet(seq_hwcfg_led.unmute_all_tracks, seq_core_trk_muted == 0x0000);
+  SEQ_LED_PinSet(seq_hwcfg_led.unmute_all_tracks, SEQ_CORE_TrkSetIsEmpty(&seq_core_trk_muted));
   SEQ_LED_PinSet(seq_hwcfg_led.unmute_track_layers, seq_core_trk[visible_track].layer_muted == 0x0000);
   // only consume CPU time if LEDs really assigned...
   if( seq_hwcfg_led.mute_all_tracks_and_layers || seq_hwcfg_led.unmute_all_tracks_and_layers ) {
@@ -2892,8 +2897,8 @@ s32 SEQ_UI_LED_Handler(void)
     for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track)
       all_layers_muted_mask |= seq_core_trk[track].layer_muted;
 
-    SEQ_LED_PinSet(seq_hwcfg_led.mute_all_tracks_and_layers, seq_core_trk_muted == 0xffff && all_layers_muted_mask == 0xffff);
-    SEQ_LED_PinSet(seq_hwcfg_led.unmute_all_tracks_and_layers, seq_core_trk_muted == 0x0000 && all_layers_muted_mask == 0x0000);
+    SEQ_LED_PinSet(seq_hwcfg_led.mute_all_tracks_and_layers, SEQ_CORE_TrkSetIsFull(&seq_core_trk_muted) && all_layers_muted_mask == 0xffff);
+    SEQ_LED_PinSet(seq_hwcfg_led.unmute_all_tracks_and_layers, SEQ_CORE_TrkSetIsEmpty(&seq_core_trk_muted) && all_layers_muted_mask == 0x0000);
   }
 
   // in MENU page: overrule GP LEDs as long as MENU button is pressed/active
@@ -3040,10 +3045,11 @@ s32 SEQ_UI_LED_Handler_Periodic()
     SEQ_LED_SRSet(seq_hwcfg_led.gp_dout_r2_sr-1, (pos_marker_mask >> 8) & 0xff);
 
   // transfer to optional track LEDs
+  u16 selected_tracks16 = SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0);
   if( seq_hwcfg_led.tracks_dout_l_sr )
-    SEQ_LED_SRSet(seq_hwcfg_led.tracks_dout_l_sr-1, (ui_selected_tracks >> 0) & 0xff);
+    SEQ_LED_SRSet(seq_hwcfg_led.tracks_dout_l_sr-1, (selected_tracks16 >> 0) & 0xff);
   if( seq_hwcfg_led.tracks_dout_r_sr )
-    SEQ_LED_SRSet(seq_hwcfg_led.tracks_dout_r_sr-1, (ui_selected_tracks >> 8) & 0xff);
+    SEQ_LED_SRSet(seq_hwcfg_led.tracks_dout_r_sr-1, (selected_tracks16 >> 8) & 0xff);
 
   if( seq_hwcfg_blm.enabled ) {
     // Red LEDs (position marker)
@@ -3222,8 +3228,13 @@ s32 SEQ_UI_MENU_Handler_Periodic()
 /////////////////////////////////////////////////////////////////////////////
 s32 SEQ_UI_CheckSelections(void)
 {
-  if( ((ui_selected_tracks >> (4*ui_selected_group)) & 0xf) == 0 )
-    ui_selected_tracks = 1 << (4*ui_selected_group);
+  if( ui_selected_group >= SEQ_CORE_NUM_GROUPS )
+    ui_selected_group = 0;
+
+  if( SEQ_CORE_TrkSetGroupGet(&ui_selected_tracks, ui_selected_group) == 0 ) {
+    SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+    SEQ_CORE_TRKSET_SET(&ui_selected_tracks, 4*ui_selected_group);
+  }
 
   u8 visible_track = SEQ_UI_VisibleTrackGet();
 
@@ -3296,7 +3307,7 @@ u8 SEQ_UI_VisibleTrackGet(void)
 {
   u8 offset = 0;
 
-  u8 selected_tracks = ui_selected_tracks >> (4*ui_selected_group);
+  u8 selected_tracks = SEQ_CORE_TrkSetGroupGet(&ui_selected_tracks, ui_selected_group);
   if( selected_tracks & (1 << 3) )
     offset = 3;
   if( selected_tracks & (1 << 2) )
@@ -3315,7 +3326,10 @@ u8 SEQ_UI_VisibleTrackGet(void)
 /////////////////////////////////////////////////////////////////////////////
 s32 SEQ_UI_IsSelectedTrack(u8 track)
 {
-  return (ui_selected_tracks & (1 << track)) ? 1 : 0;
+  if( track >= SEQ_CORE_NUM_TRACKS )
+    return 0; // invalid track
+
+  return SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track);
 }
 
 
@@ -3351,7 +3365,8 @@ s32 SEQ_UI_GxTyInc(s32 incrementer)
   if( gxty == prev_gxty )
     return 0; // no change
 
-  ui_selected_tracks = 1 << gxty;
+  SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+  SEQ_CORE_TRKSET_SET(&ui_selected_tracks, gxty);
   ui_selected_group = gxty / 4;
 
   return 1; // value changed
@@ -3866,8 +3881,8 @@ s32 SEQ_UI_Bookmark_Store(u8 bookmark)
   bm->step_view = ui_selected_step_view;
   bm->step = ui_selected_step;
   bm->edit_view = seq_ui_edit_view;
-  bm->tracks = ui_selected_tracks;
-  bm->mutes = seq_core_trk_muted;
+  bm->tracks = SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0); // bookmarks store the selection of the first 16 tracks
+  bm->mutes = SEQ_CORE_TrkSetGet16(&seq_core_trk_muted, 0); // bookmarks store the mutes of the first 16 tracks
 
   return 0; // no error
 }
@@ -3898,8 +3913,11 @@ s32 SEQ_UI_Bookmark_Restore(u8 bookmark)
   if( bm->enable.STEP_VIEW )         ui_selected_step_view = bm->step_view;
   if( bm->enable.STEP )              ui_selected_step = bm->step;
   if( bm->enable.EDIT_VIEW )         seq_ui_edit_view = bm->edit_view;
-  if( bm->enable.TRACKS )            ui_selected_tracks = bm->tracks;
-  if( bm->enable.MUTES )             seq_core_trk_muted = bm->mutes;
+  if( bm->enable.TRACKS ) {
+    SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+    SEQ_CORE_TrkSetSet16(&ui_selected_tracks, 0, bm->tracks);
+  }
+  if( bm->enable.MUTES )             SEQ_CORE_TrkSetSet16(&seq_core_trk_muted, 0, bm->mutes);
   portEXIT_CRITICAL();
 
   // enter new page if enabled
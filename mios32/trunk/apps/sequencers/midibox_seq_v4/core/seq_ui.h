@@ -15,6 +15,7 @@
 #define _SEQ_UI_H
 
 #include "seq_ui_pages.h"
+#include "seq_core.h"
 
 /////////////////////////////////////////////////////////////////////////////
 // Global definitions
@@ -424,7 +425,7 @@ extern u8 seq_ui_display_init_req;
 extern seq_ui_button_state_t seq_ui_button_state;
 
 extern u8 ui_selected_group;
-extern u16 ui_selected_tracks;
+extern seq_core_trkset_t ui_selected_tracks;
 extern u8 ui_selected_par_layer;
 extern u8 ui_selected_trg_layer;
 extern u8 ui_selected_instrument;
@@ -887,7 +887,7 @@ s32 SEQ_UI_EDIT_LCD_Handler(u8 high_prio, seq_ui_edit_mode_t edit_mode)
   ///////////////////////////////////////////////////////////////////////////
   SEQ_LCD_CursorSet(0, 0);
 
-  SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+  SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
   SEQ_LCD_PrintSpaces(1);
 
 
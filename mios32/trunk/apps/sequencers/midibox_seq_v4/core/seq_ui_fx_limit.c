@@ -174,7 +174,7 @@ static s32 LCD_Handler(u8 high_prio)
   if( ui_selected_item == ITEM_GXTY && ui_cursor_flash ) {
     SEQ_LCD_PrintSpaces(4);
   } else {
-    SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+    SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
   }
   SEQ_LCD_PrintSpaces(2);
 
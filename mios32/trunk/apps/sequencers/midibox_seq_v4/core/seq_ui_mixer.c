@@ -211,11 +211,7 @@ static s32 Encoder_Handler(seq_ui_encoder_t encoder, s32 incrementer)
 	  // send to external
 	  SEQ_MIDI_IN_ExtCtrlSend(SEQ_MIDI_IN_EXT_CTRL_MIXER_MAP, SEQ_MIXER_NumGet(), 0);
 	  // dump all values
-	  {
-	    MUTEX_MIDIOUT_TAKE;
-	    SEQ_MIXER_SendAll();
-	    MUTEX_MIDIOUT_GIVE;
-	  }
+	  SEQ_MIXER_SendAll(1);
 	  // print message
 	  in_menu_msg = MSG_DUMP & 0x7f;
 	  ui_hold_msg_ctr = 1000;
@@ -420,11 +416,7 @@ static s32 Button_Handler(seq_ui_button_t button, s32 depressed)
       ui_selected_item = button;
 
       // dump channel
-      {
-	MUTEX_MIDIOUT_TAKE;
-	SEQ_MIXER_SendAllByChannel(ui_selected_item);
-	MUTEX_MIDIOUT_GIVE;
-      }
+      SEQ_MIXER_SendAllByChannel(ui_selected_item, 1);
 
       return 1; // value always changed
     }
@@ -53,35 +53,35 @@ static s32 LED_Handler(u16 *gp_leds)
       all_layers_muted_mask |= seq_core_trk[track].layer_muted;
 
 #if 1
-    if( seq_core_trk_muted == 0xffff )
+    if( SEQ_CORE_TrkSetIsFull(&seq_core_trk_muted) )
       *gp_leds |= 0x0003;
     if( seq_core_trk[visible_track].layer_muted == 0xffff )
       *gp_leds |= 0x001c;
-    if( seq_core_trk_muted == 0xffff && all_layers_muted_mask == 0xffff )
+    if( SEQ_CORE_TrkSetIsFull(&seq_core_trk_muted) && all_layers_muted_mask == 0xffff )
       *gp_leds |= 0x00e0;
 
-    if( seq_core_trk_muted == 0x0000 )
+    if( SEQ_CORE_TrkSetIsEmpty(&seq_core_trk_muted) )
       *gp_leds |= 0x0300;
     if( seq_core_trk[visible_track].layer_muted == 0x0000 )
       *gp_leds |= 0x1c00;
-    if( seq_core_trk_muted == 0x0000 && all_layers_muted_mask == 0x0000 )
+    if( SEQ_CORE_TrkSetIsEmpty(&seq_core_trk_muted) && all_layers_muted_mask == 0x0000 )
       *gp_leds |= 0xe000;
 #else
     // Better? Mayber to difficult to understand for users, therefore disabled by default
     // e.g. all tracks muted: activate LEDs of the "all tracks unmuted" button.
     // it should signal: something will happen when you push here...
-    if( seq_core_trk_muted == 0xffff )
+    if( SEQ_CORE_TrkSetIsFull(&seq_core_trk_muted) )
       *gp_leds |= 0x0300;
     if( seq_core_trk[visible_track].layer_muted == 0xffff )
       *gp_leds |= 0x1c00;
-    if( seq_core_trk_muted == 0xffff && all_layers_muted_mask == 0xffff )
+    if( SEQ_CORE_TrkSetIsFull(&seq_core_trk_muted) && all_layers_muted_mask == 0xffff )
       *gp_leds |= 0xe000;
 
-    if( seq_core_trk_muted == 0x0000 )
+    if( SEQ_CORE_TrkSetIsEmpty(&seq_core_trk_muted) )
       *gp_leds |= 0x0003;
     if( seq_core_trk[visible_track].layer_muted == 0x0000 )
       *gp_leds |= 0x001c;
-    if( seq_core_trk_muted == 0x0000 && all_layers_muted_mask == 0x0000 )
+    if( SEQ_CORE_TrkSetIsEmpty(&seq_core_trk_muted) && all_layers_muted_mask == 0x0000 )
       *gp_leds |= 0x00e0;
 #endif
 
@@ -92,7 +92,7 @@ static s32 LED_Handler(u16 *gp_leds)
       track = SEQ_UI_VisibleTrackGet();
       *gp_leds = seq_core_trk[track].layer_muted | seq_core_trk[track].layer_muted_from_midi;
     } else {
-      *gp_leds = seq_core_trk_muted;
+      *gp_leds = SEQ_CORE_TrkSetGet16(&seq_core_trk_muted, 0);
     }
   }
 
@@ -128,29 +128,31 @@ static s32 Encoder_Handler(seq_ui_encoder_t encoder, s32 incrementer)
       portENTER_CRITICAL();
 
       u8 visible_track = SEQ_UI_VisibleTrackGet();
+      u8 track = encoder; // the GP buttons select one of the first 16 tracks
       u16 mask = 1 << encoder;
-      u16 *muted = (u16 *)&seq_core_trk_muted;
+      u16 *layer_muted = NULL;
+      seq_core_trkset_t *muted = &seq_core_trk_muted;
 
       if( seq_ui_button_state.CHANGE_ALL_STEPS ) {
 	switch( encoder ) {
 	case SEQ_UI_ENCODER_GP1:
 	case SEQ_UI_ENCODER_GP2:
-	  *muted = 0xffff;
+	  SEQ_CORE_TrkSetFill(muted);
 	  SEQ_UI_Msg(SEQ_UI_MSG_USER, 1000, "All Tracks", "muted");
 	  break;
 
 	case SEQ_UI_ENCODER_GP3:
 	case SEQ_UI_ENCODER_GP4:
 	case SEQ_UI_ENCODER_GP5:
-	  muted = (u16 *)&seq_core_trk[visible_track].layer_muted;
-	  *muted = 0xffff;
+	  layer_muted = &seq_core_trk[visible_track].layer_muted;
+	  *layer_muted = 0xffff;
 	  SEQ_UI_Msg(SEQ_UI_MSG_USER, 1000, "All Layers", "of current Track muted");
 	  break;
 
 	case SEQ_UI_ENCODER_GP6:
 	case SEQ_UI_ENCODER_GP7:
 	case SEQ_UI_ENCODER_GP8: {
-	  *muted = 0xffff;
+	  SEQ_CORE_TrkSetFill(muted);
 
 	  int track;
 	  for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track) {
@@ -161,22 +163,22 @@ static s32 Encoder_Handler(seq_ui_encoder_t encoder, s32 incrementer)
 
 	case SEQ_UI_ENCODER_GP9:
 	case SEQ_UI_ENCODER_GP10:
-	  *muted = 0x0000;
+	  SEQ_CORE_TrkSetClear(muted);
 	  SEQ_UI_Msg(SEQ_UI_MSG_USER_R, 1000, "All Tracks", "unmuted");
 	  break;
 
 	case SEQ_UI_ENCODER_GP11:
 	case SEQ_UI_ENCODER_GP12:
 	case SEQ_UI_ENCODER_GP13:
-	  muted = (u16 *)&seq_core_trk[visible_track].layer_muted;
-	  *muted = 0x0000;
+	  layer_muted = &seq_core_trk[visible_track].layer_muted;
+	  *layer_muted = 0x0000;
 	  SEQ_UI_Msg(SEQ_UI_MSG_USER_R, 1000, "All Layers", "of current Track unmuted");
 	  break;
 
 	case SEQ_UI_ENCODER_GP14:
 	case SEQ_UI_ENCODER_GP15:
 	case SEQ_UI_ENCODER_GP16: {
-	  *muted = 0x0000;
+	  SEQ_CORE_TrkSetClear(muted);
 
 	  int track;
 	  for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track) {
@@ -187,32 +189,41 @@ static s32 Encoder_Handler(seq_ui_encoder_t encoder, s32 incrementer)
 	}
       } else {
 	if( seq_ui_button_state.MUTE_PRESSED )
-	  muted = (u16 *)&seq_core_trk[visible_track].layer_muted;
+	  layer_muted = &seq_core_trk[visible_track].layer_muted;
 	else if( SEQ_BPM_IsRunning() ) { // Synched Mutes only when sequencer is running
-	  if( !(*muted & mask) && seq_core_options.SYNCHED_MUTE && !seq_ui_button_state.FAST_ENCODERS ) { // Fast button will disable synched mute
-	    muted = (u16 *)&seq_core_trk_synched_mute;
-	  } else if( (*muted & mask) && seq_core_options.SYNCHED_UNMUTE && !seq_ui_button_state.FAST_ENCODERS ) { // Fast button will disable synched unmute
-	    muted = (u16 *)&seq_core_trk_synched_unmute;
+	  if( !SEQ_CORE_TRKSET_GET(muted, track) && seq_core_options.SYNCHED_MUTE && !seq_ui_button_state.FAST_ENCODERS ) { // Fast button will disable synched mute
+	    muted = &seq_core_trk_synched_mute;
+	  } else if( SEQ_CORE_TRKSET_GET(muted, track) && seq_core_options.SYNCHED_UNMUTE && !seq_ui_button_state.FAST_ENCODERS ) { // Fast button will disable synched unmute
+	    muted = &seq_core_trk_synched_unmute;
 	  }
 	} else {
 	  // clear synched mutes/unmutes if sequencer not running
-	  seq_core_trk_synched_mute = 0;
-	  seq_core_trk_synched_unmute = 0;
+	  SEQ_CORE_TrkSetClear(&seq_core_trk_synched_mute);
+	  SEQ_CORE_TrkSetClear(&seq_core_trk_synched_unmute);
+	}
+
+	if( layer_muted ) {
+	  if( incrementer < 0 )
+	    *layer_muted |= mask;
+	  else if( incrementer > 0 )
+	    *layer_muted &= ~mask;
+	  else
+	    *layer_muted ^= mask;
+	} else {
+	  if( incrementer < 0 )
+	    SEQ_CORE_TRKSET_SET(muted, track);
+	  else if( incrementer > 0 )
+	    SEQ_CORE_TRKSET_CLR(muted, track);
+	  else
+	    SEQ_CORE_TRKSET_TOGGLE(muted, track);
 	}
-	  
-	if( incrementer < 0 )
-	  *muted |= mask;
-	else if( incrementer > 0 )
-	  *muted &= ~mask;
-	else
-	  *muted ^= mask;
       }
 
       portEXIT_CRITICAL();
 
-      if( muted == ((u16 *)&seq_core_trk_muted) ) {
+      if( !layer_muted && muted == &seq_core_trk_muted ) {
 	// send to external
-	SEQ_MIDI_IN_ExtCtrlSend(SEQ_MIDI_IN_EXT_CTRL_MUTES, (*muted & mask) ? 127 : 0, encoder);
+	SEQ_MIDI_IN_ExtCtrlSend(SEQ_MIDI_IN_EXT_CTRL_MUTES, SEQ_CORE_TRKSET_GET(muted, track) ? 127 : 0, encoder);
       }
     }
 
@@ -253,17 +264,20 @@ static s32 Button_Handler(seq_ui_button_t button, s32 depressed)
 	  u8 visible_track = SEQ_UI_VisibleTrackGet();
 	  seq_core_trk[visible_track].layer_muted = latched_mute;
 	} else {
-	  u16 new_mutes = latched_mute & ~seq_core_trk_muted;
+	  u16 trk_muted = SEQ_CORE_TrkSetGet16(&seq_core_trk_muted, 0);
+	  u16 new_mutes = latched_mute & ~trk_muted;
 	  if( SEQ_BPM_IsRunning() && seq_core_options.SYNCHED_MUTE && !seq_ui_button_state.FAST_ENCODERS ) // Fast button will disable synched mute
-	    seq_core_trk_synched_mute |= new_mutes;
+	    SEQ_CORE_TrkSetSet16(&seq_core_trk_synched_mute, 0, SEQ_CORE_TrkSetGet16(&seq_core_trk_synched_mute, 0) | new_mutes);
 	  else
-	    seq_core_trk_muted |= new_mutes;
+	    trk_muted |= new_mutes;
 
-	  u16 new_unmutes = ~latched_mute & seq_core_trk_muted;
+	  u16 new_unmutes = ~latched_mute & trk_muted;
 	  if( SEQ_BPM_IsRunning() && seq_core_options.SYNCHED_UNMUTE && !seq_ui_button_state.FAST_ENCODERS ) // Fast button will disable synched unmute
-	    seq_core_trk_synched_unmute |= new_unmutes;
+	    SEQ_CORE_TrkSetSet16(&seq_core_trk_synched_unmute, 0, SEQ_CORE_TrkSetGet16(&seq_core_trk_synched_unmute, 0) | new_unmutes);
 	  else
-	    seq_core_trk_muted &= ~new_unmutes;
+	    trk_muted &= ~new_unmutes;
+
+	  SEQ_CORE_TrkSetSet16(&seq_core_trk_muted, 0, trk_muted);
 	}
       } else {
 	// select pressed: init latched mutes which will be taken over once SELECT button released
@@ -271,7 +285,7 @@ static s32 Button_Handler(seq_ui_button_t button, s32 depressed)
 	  u8 visible_track = SEQ_UI_VisibleTrackGet();
 	  latched_mute = seq_core_trk[visible_track].layer_muted;
 	} else {
-	  latched_mute = seq_core_trk_muted;
+	  latched_mute = SEQ_CORE_TrkSetGet16(&seq_core_trk_muted, 0);
 	}
       }
 
@@ -311,9 +325,9 @@ static s32 LCD_Handler(u8 high_prio)
     SEQ_LCD_PrintString("   Mute       Mute       Mute all Tracks  Unmute      Unmute   Unmute all Tracks");
     SEQ_LCD_CursorSet(0, 1);
     SEQ_LCD_PrintString("all Tracks ");
-    SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+    SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
     SEQ_LCD_PrintString(" Layers    and all Layersall Tracks ");
-    SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+    SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
     SEQ_LCD_PrintString(" Layers    and all Layers");
 
     return 0;
@@ -336,7 +350,7 @@ static s32 LCD_Handler(u8 high_prio)
 	mute_flags = seq_core_trk[visible_track].layer_muted;
 	mute_flags_from_midi = seq_core_trk[visible_track].layer_muted_from_midi;
       } else {
-	mute_flags = seq_core_trk_muted;
+	mute_flags = SEQ_CORE_TrkSetGet16(&seq_core_trk_muted, 0);
       }
     }
 
@@ -357,13 +371,13 @@ static s32 LCD_Handler(u8 high_prio)
       u16 mask = (1 << 0);
       for(track=0; track<16; ++t, ++track, mask <<= 1)
 	if( mute_flags & mask ) {
-	  if( !seq_ui_button_state.SELECT_PRESSED && (seq_core_trk_synched_unmute & mask) ) {
+	  if( !seq_ui_button_state.SELECT_PRESSED && SEQ_CORE_TRKSET_GET(&seq_core_trk_synched_unmute, track) ) {
 	    SEQ_LCD_PrintFormattedString("U%3d ", remaining_steps);
 	  } else {
 	    SEQ_LCD_PrintString("Mute ");
 	  }
 	} else {
-	  if( !seq_ui_button_state.SELECT_PRESSED && (seq_core_trk_synched_mute & mask) ) {
+	  if( !seq_ui_button_state.SELECT_PRESSED && SEQ_CORE_TRKSET_GET(&seq_core_trk_synched_mute, track) ) {
 	    SEQ_LCD_PrintFormattedString("M%3d ", remaining_steps);
 	  } else {
 	    SEQ_LCD_PrintHBar(t->vu_meter >> 3);
@@ -732,7 +732,8 @@ static s32 Button_Handler(seq_ui_button_t button, s32 depressed)
           if( visible_track < (SEQ_CORE_NUM_TRACKS - 1) )
             visible_track++;
 					
-          ui_selected_tracks = (1 << visible_track);
+          SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+          SEQ_CORE_TRKSET_SET(&ui_selected_tracks, visible_track);
           ui_selected_group = visible_track / 4;
 
           return 1; // value always changed
@@ -742,7 +743,8 @@ static s32 Button_Handler(seq_ui_button_t button, s32 depressed)
           if( visible_track >= 1 )
             visible_track--;
 					
-          ui_selected_tracks = (1 << visible_track);
+          SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+          SEQ_CORE_TRKSET_SET(&ui_selected_tracks, visible_track);
           ui_selected_group = visible_track / 4;
 
           return 1; // value always changed
@@ -1073,7 +1075,7 @@ static s32 LCD_Handler(u8 high_prio)
 
           SEQ_LCD_CursorSet(track+spacer, 1);
 
-          //if( seq_core_trk_muted & (1 << track) )
+          //if( SEQ_CORE_TRKSET_GET(&seq_core_trk_muted, track) )
           //  SEQ_LCD_PrintVBar('M');
           //else
             SEQ_LCD_PrintVBar(t->vu_meter >> 4);
@@ -1382,9 +1384,9 @@ s32 SEQ_UI_PATTERN_Paste(void)
 			
 		// mute track to avoid random effects while loading the file
 		MIOS32_IRQ_Disable(); // this operation should be atomic!
-		u8 muted = seq_core_trk_muted & (1 << track);
+		u8 muted = SEQ_CORE_TRKSET_GET(&seq_core_trk_muted, track);
 		if( !muted )
-			seq_core_trk_muted |= (1 << track);
+			SEQ_CORE_TRKSET_SET(&seq_core_trk_muted, track);
 		MIOS32_IRQ_Enable();
 			
 		static seq_file_t_import_flags_t import_flags;
@@ -1398,7 +1400,7 @@ s32 SEQ_UI_PATTERN_Paste(void)
 		// unmute track if it wasn't muted before
 		MIOS32_IRQ_Disable(); // this operation should be atomic!
 		if( !muted )
-			seq_core_trk_muted &= ~(1 << track);
+			SEQ_CORE_TRKSET_CLR(&seq_core_trk_muted, track);
 		MIOS32_IRQ_Enable();
 			
 		if( status == FILE_ERR_OPEN_READ ) {
@@ -471,7 +471,7 @@ static s32 Encoder_Handler(seq_ui_encoder_t encoder, s32 incrementer)
 	if( !SEQ_SONG_ActiveGet() ) {
 	  u8 force_immediate_change = seq_core_options.SYNCHED_PATTERN_CHANGE ? 0 : 1;
 	  SEQ_SONG_FetchPos(force_immediate_change, 0);
-	  SEQ_CORE_ManualSynchToMeasure(0xffff); // ensure that the new selection is in sync
+	  SEQ_CORE_ManualSynchToMeasure(NULL); // ensure that the new selection is in sync
 	}
 	return 1; // value has been changed
       }
@@ -950,7 +950,7 @@ static s32 LCD_Handler(u8 high_prio)
 	if( !(track % 4) )
 	  SEQ_LCD_CursorSet(46 + 10*(track>>2), 1);
 	
-	if( seq_core_trk_muted & (1 << track) )
+	if( SEQ_CORE_TRKSET_GET(&seq_core_trk_muted, track) )
 	  SEQ_LCD_PrintVBar('M');
 	else
 	  SEQ_LCD_PrintVBar(t->vu_meter >> 4);
@@ -1204,7 +1204,7 @@ static s32 LCD_Handler(u8 high_prio)
 	  SEQ_LCD_PrintSpaces(4);
         } else {
 	  if( s.action_value )
-	    SEQ_LCD_PrintGxTy((s.action_value-1)/4, (1 << (s.action_value-1)));
+	    SEQ_LCD_PrintFormattedString("G%dT%d", ((s.action_value-1)/4)+1, ((s.action_value-1)%4)+1);
 	  else
 	    SEQ_LCD_PrintString("----");
         }
@@ -1334,7 +1334,7 @@ static s32 LCD_Handler(u8 high_prio)
     if( SEQ_SONG_ActiveGet() ) {
       if( SEQ_SONG_GuideTrackGet() ) {
 	u8 track = SEQ_SONG_GuideTrackGet()-1;
-	SEQ_LCD_PrintGxTy(track / 4, (1 << track));
+	SEQ_LCD_PrintFormattedString("G%dT%d", (track/4)+1, (track%4)+1);
       } else
 	SEQ_LCD_PrintString("----");
     } else {
@@ -1490,10 +1490,11 @@ static s32 createNewPatterns(u8 slot)
     seq_song_step_t s = SEQ_SONG_StepEntryGet(ui_song_edit_pos);
     s.action = SEQ_SONG_ACTION_Mutes;
     s.action_value = 0;
-    s.pattern_g1 = (seq_core_trk_muted >>  0) & 0xf;
-    s.pattern_g2 = (seq_core_trk_muted >>  4) & 0xf;
-    s.pattern_g3 = (seq_core_trk_muted >>  8) & 0xf;
-    s.pattern_g4 = (seq_core_trk_muted >> 12) & 0xf;
+    u16 muted = SEQ_CORE_TrkSetGet16(&seq_core_trk_muted, 0);
+    s.pattern_g1 = (muted >>  0) & 0xf;
+    s.pattern_g2 = (muted >>  4) & 0xf;
+    s.pattern_g3 = (muted >>  8) & 0xf;
+    s.pattern_g4 = (muted >> 12) & 0xf;
     s.bank_g1 = 0;
     s.bank_g2 = 1;
     s.bank_g3 = 2;
@@ -82,7 +82,7 @@ static s32 Encoder_Handler(seq_ui_encoder_t encoder, s32 incrementer)
       seq_core_trk_t *t = &seq_core_trk[0];
       MIOS32_IRQ_Disable();
       for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track, ++t)
-	if( ui_selected_tracks & (1 << track) )
+	if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) )
 	  t->play_section = section;
       MIOS32_IRQ_Enable();
     } else {
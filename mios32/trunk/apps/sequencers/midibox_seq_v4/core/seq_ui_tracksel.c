@@ -39,7 +39,7 @@ static s32 LED_Handler(u16 *gp_leds)
   if( ui_cursor_flash ) // if flashing flag active: no LED flag set
     return 0;
 
-  *gp_leds = ui_selected_tracks;
+  *gp_leds = SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0);
 
   return 0; // no error
 }
@@ -62,20 +62,21 @@ static s32 Encoder_Handler(seq_ui_encoder_t encoder, s32 incrementer)
 #endif
     if( multi_sel ) {
       // next GP: toggle function (16 of 16)
-      ui_selected_tracks ^= (1 << (u8)encoder);
+      SEQ_CORE_TRKSET_TOGGLE(&ui_selected_tracks, (u8)encoder);
     } else {
       // first GP: radio-button function (1 of 16)
-      ui_selected_tracks = (1 << (u8)encoder);
+      SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+      SEQ_CORE_TRKSET_SET(&ui_selected_tracks, (u8)encoder);
       multi_sel = 1; // start multi-selection
     }
 
     ui_selected_group = (u8)encoder / 4;
 
     // if no track selected in current group anymore, search another (valid) group
-    if( (ui_selected_tracks >> (4*ui_selected_group)) == 0 ) {
+    if( SEQ_CORE_TrkSetGroupGet(&ui_selected_tracks, ui_selected_group) == 0 ) {
       u8 group;
       for(group=0; group<SEQ_CORE_NUM_GROUPS; ++group) {
-	if( ((ui_selected_tracks >> (4*group) & 0xf)) != 0 ) {
+	if( SEQ_CORE_TrkSetGroupGet(&ui_selected_tracks, group) != 0 ) {
 	  ui_selected_group = group;
 	  break;
 	}
@@ -95,7 +96,8 @@ static s32 Encoder_Handler(seq_ui_encoder_t encoder, s32 incrementer)
       if( --visible_track < 0 )
 	visible_track = 0;
     }
-    ui_selected_tracks = (1 << visible_track);
+    SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+    SEQ_CORE_TRKSET_SET(&ui_selected_tracks, visible_track);
     multi_sel = 1; // re-start multi-selection
     ui_selected_group = visible_track / 4;
   }
@@ -162,7 +164,7 @@ static s32 LCD_Handler(u8 high_prio)
     u8 track;
     seq_core_trk_t *t = &seq_core_trk[0];
     for(track=0; track<16; ++t, ++track) {
-      if( seq_core_trk_muted & (1 << track) )
+      if( SEQ_CORE_TRKSET_GET(&seq_core_trk_muted, track) )
 	SEQ_LCD_PrintString("Mute ");
       else
 	SEQ_LCD_PrintHBar(t->vu_meter >> 3);
@@ -988,7 +988,7 @@ static s32 LCD_Handler(u8 high_prio)
 
       SEQ_LCD_PrintList((char *)ui_global_dir_list, LIST_ENTRY_WIDTH, dir_num_items, NUM_LIST_DISPLAYED_ITEMS, ui_selected_item, dir_view_offset);
 
-      SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+      SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
       SEQ_LCD_PrintString("     NEW PRESET                 EXIT");
     } break;
 
@@ -997,7 +997,7 @@ static s32 LCD_Handler(u8 high_prio)
       ///////////////////////////////////////////////////////////////////////////
       SEQ_LCD_CursorSet(0, 0);
       SEQ_LCD_PrintFormattedString("Importing /PRESETS/%s.V4T to ", dir_name);
-      SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+      SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
       SEQ_LCD_PrintSpaces(10);
 
       SEQ_LCD_CursorSet(40, 0);
@@ -1126,7 +1126,7 @@ static s32 LCD_Handler(u8 high_prio)
       if( ui_selected_item == ITEM_GXTY && ui_cursor_flash ) {
 	SEQ_LCD_PrintSpaces(5);
       } else {
-	SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+	SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
 	SEQ_LCD_PrintSpaces(1);
       }
 
@@ -1578,9 +1578,9 @@ static s32 DoImport(void)
 
   // mute track to avoid random effects while loading the file
   MIOS32_IRQ_Disable(); // this operation should be atomic!
-  u8 muted = seq_core_trk_muted & (1 << visible_track);
+  u8 muted = SEQ_CORE_TRKSET_GET(&seq_core_trk_muted, visible_track);
   if( !muted )
-    seq_core_trk_muted |= (1 << visible_track);
+    SEQ_CORE_TRKSET_SET(&seq_core_trk_muted, visible_track);
   MIOS32_IRQ_Enable();
 
   // read file
@@ -1591,7 +1591,7 @@ static s32 DoImport(void)
   // unmute track if it wasn't muted before
   MIOS32_IRQ_Disable(); // this operation should be atomic!
   if( !muted )
-    seq_core_trk_muted &= ~(1 << visible_track);
+    SEQ_CORE_TRKSET_CLR(&seq_core_trk_muted, visible_track);
   MIOS32_IRQ_Enable();
 
   if( status < 0 ) {
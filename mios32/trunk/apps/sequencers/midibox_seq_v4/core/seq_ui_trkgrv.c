@@ -50,6 +50,23 @@
 static u8 edit_step;
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local groove selection: stored for the first 16 tracks, remaining tracks
+// always use the global groove
+/////////////////////////////////////////////////////////////////////////////
+static u8 GrooveLocalGet(u8 track)
+{
+  return (track < 16 && (seq_groove_ui_local_selection & (1 << track))) ? 1 : 0;
+}
+
+// selects all tracks which use the global groove
+static void GrooveGlobalTracksSelect(void)
+{
+  SEQ_CORE_TrkSetFill(&ui_selected_tracks);
+  SEQ_CORE_TrkSetSet16(&ui_selected_tracks, 0, ~seq_groove_ui_local_selection);
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local LED handler function
 /////////////////////////////////////////////////////////////////////////////
@@ -146,10 +163,10 @@ static s32 Encoder_Handler(seq_ui_encoder_t encoder, s32 incrementer)
   case ITEM_GXTY:              return SEQ_UI_GxTyInc(incrementer);
 
   case ITEM_GROOVE_STYLE: {
-    u16 tmp = ui_selected_tracks;
-    u8 local_change = (seq_groove_ui_local_selection & (1 << visible_track)) ? 1 : 0;
+    seq_core_trkset_t tmp = ui_selected_tracks;
+    u8 local_change = GrooveLocalGet(visible_track);
     if( !local_change ) {
-      ui_selected_tracks = ~seq_groove_ui_local_selection;
+      GrooveGlobalTracksSelect();
     }
     s32 status = SEQ_UI_CC_Inc(SEQ_CC_GROOVE_STYLE, 0, grooves_total-1, incrementer);
     if( !local_change ) {
@@ -159,10 +176,10 @@ static s32 Encoder_Handler(seq_ui_encoder_t encoder, s32 incrementer)
   } break;
 
   case ITEM_GROOVE_VALUE: {
-    u16 tmp = ui_selected_tracks;
-    u8 local_change = (seq_groove_ui_local_selection & (1 << visible_track)) ? 1 : 0;
+    seq_core_trkset_t tmp = ui_selected_tracks;
+    u8 local_change = GrooveLocalGet(visible_track);
     if( !local_change ) {
-      ui_selected_tracks = ~seq_groove_ui_local_selection;
+      GrooveGlobalTracksSelect();
     }
     s32 status = SEQ_UI_CC_Inc(SEQ_CC_GROOVE_VALUE, 0, 127, incrementer);
     if( !local_change ) {
@@ -172,13 +189,13 @@ static s32 Encoder_Handler(seq_ui_encoder_t encoder, s32 incrementer)
   } break;
 
   case ITEM_GROOVE_GLOBAL: {
-    u8 global = (seq_groove_ui_local_selection & (1 << visible_track)) ? 0 : 1;
+    u8 global = GrooveLocalGet(visible_track) ? 0 : 1;
     if( !incrementer ) incrementer = global ? -1 : 1;
     if( SEQ_UI_Var8_Inc(&global, 0, 1, incrementer) > 0 ) {
       if( global ) {
-	seq_groove_ui_local_selection &= ~ui_selected_tracks;
+	seq_groove_ui_local_selection &= ~SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0);
       } else {
-	seq_groove_ui_local_selection |= ui_selected_tracks;
+	seq_groove_ui_local_selection |= SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0);
       }
       return 1;
     }
@@ -336,7 +353,7 @@ static s32 LCD_Handler(u8 high_prio)
   if( ui_selected_item == ITEM_GXTY && ui_cursor_flash ) {
     SEQ_LCD_PrintSpaces(4);
   } else {
-    SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+    SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
   }
   SEQ_LCD_PrintSpaces(2);
 
@@ -361,7 +378,7 @@ static s32 LCD_Handler(u8 high_prio)
   if( ui_selected_item == ITEM_GROOVE_GLOBAL && ui_cursor_flash ) {
     SEQ_LCD_PrintSpaces(6);
   } else {
-    u8 local = (seq_groove_ui_local_selection & (1 << visible_track)) ? 1 : 0;
+    u8 local = GrooveLocalGet(visible_track);
     SEQ_LCD_PrintString(local ? "  off " : "  on  ");
   }
   SEQ_LCD_PrintSpaces(3);
@@ -401,7 +401,7 @@ static s32 LCD_Handler(u8 high_prio)
       SEQ_LCD_CursorSet(0, 0);
       if( event_mode == SEQ_EVENT_MODE_Drum ) {
 	SEQ_LCD_PrintString("Please enter Drum Label for ");
-	SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+	SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
 	SEQ_LCD_PrintFormattedString("-%2d:", ui_selected_instrument + 1);
 	SEQ_LCD_PrintNote(SEQ_CC_Get(visible_track, SEQ_CC_LAY_CONST_A1 + ui_selected_instrument));
 	SEQ_LCD_PrintSpaces(1);
@@ -422,11 +422,11 @@ static s32 LCD_Handler(u8 high_prio)
       } else {
 	if( ui_edit_name_cursor < 5 ) {
 	  SEQ_LCD_PrintString("Please enter Track Category for ");
-	  SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+	  SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
 	  SEQ_LCD_PrintSpaces(4);
 	} else {
 	  SEQ_LCD_PrintString("Please enter Track Label for ");
-	  SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+	  SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
 	  SEQ_LCD_PrintSpaces(7);
 	}
 	SEQ_LCD_PrintChar('<');
@@ -477,7 +477,7 @@ static s32 LCD_Handler(u8 high_prio)
       if( ui_selected_item == ITEM_GXTY && ui_cursor_flash ) {
 	SEQ_LCD_PrintSpaces(5);
       } else {
-	SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+	SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
 	SEQ_LCD_PrintSpaces(1);
       }
 
@@ -877,7 +877,7 @@ static s32 LCD_Handler(u8 high_prio)
 
     SEQ_LCD_CursorSet(0, 0);
     SEQ_LCD_PrintString("Trk. ");
-    SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+    SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
     SEQ_LCD_PrintFormattedString("   Pattern %2d  ", pattern_num + 1);
     SEQ_UI_TRKJAM_Hlp_PrintPattern(slot->pattern);
     SEQ_LCD_PrintSpaces(30);
@@ -915,7 +915,7 @@ static s32 LCD_Handler(u8 high_prio)
   if( ui_selected_item == ITEM_GXTY && ui_cursor_flash ) {
     SEQ_LCD_PrintSpaces(4);
   } else {
-    SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+    SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
   }
   SEQ_LCD_PrintSpaces(1);
 
@@ -332,7 +332,7 @@ static s32 Button_Handler(seq_ui_button_t button, s32 depressed)
 	// clear steps of all selected tracks
 	u8 track;
 	for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track) {
-	  if( ui_selected_tracks & (1 << track) )
+	  if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) )
 	    CLEAR_Track(track);
 	}
 
@@ -524,7 +524,7 @@ static s32 LCD_Handler(u8 high_prio)
   if( ui_cursor_flash ) {
     SEQ_LCD_PrintSpaces(4);
   } else {
-    SEQ_LCD_PrintGxTy(ui_selected_group, ui_selected_tracks);
+    SEQ_LCD_PrintGxTy(ui_selected_group, &ui_selected_tracks);
   }
 
   SEQ_LCD_PrintString(" Copy Paste Clr Move Scrl Rand Undo ");
@@ -1129,7 +1129,7 @@ static s32 SCROLL_Track(u8 track, u16 first_step, s32 incrementer)
 /////////////////////////////////////////////////////////////////////////////
 static s32 SEQ_UI_UTIL_MuteAllTracks(void)
 {
-  seq_core_trk_muted = 0xffff;
+  SEQ_CORE_TrkSetFill(&seq_core_trk_muted);
 
   return 0; // no error
 }
@@ -1139,7 +1139,7 @@ static s32 SEQ_UI_UTIL_MuteAllTracks(void)
 /////////////////////////////////////////////////////////////////////////////
 static s32 SEQ_UI_UTIL_UnMuteAllTracks(void)
 {
-  seq_core_trk_muted = 0x0000;
+  SEQ_CORE_TrkSetClear(&seq_core_trk_muted);
 
   return 0; // no error
 }
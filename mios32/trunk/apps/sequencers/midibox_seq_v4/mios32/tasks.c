@@ -17,8 +17,10 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <mios32.h>
+#include <seq_bpm.h>
 
 #include "uip_task.h"
+#include "seq_cv.h"
 
 #include "tasks.h"
 
@@ -60,6 +62,20 @@ xSemaphoreHandle xJ16Semaphore;
 
 // priority of uIP task defined in uip_task.c (-> using 3)
 
+// TASK_MIDI is resumed from a software interrupt whenever the BPM generator
+// flags a new request. The BPM timer runs with MIOS32_IRQ_PRIO_HIGHEST, which
+// is higher than the RTOS, therefore it triggers an otherwise unused IRQ
+// channel with low priority which is allowed to give the semaphore.
+#if defined(MIOS32_FAMILY_STM32F10x) || defined(MIOS32_FAMILY_STM32F4xx)
+# define MIDI_TICK_IRQn         FSMC_IRQn
+# define MIDI_TICK_IRQ_HANDLER  void FSMC_IRQHandler(void)
+#elif defined(MIOS32_FAMILY_LPC17xx)
+# define MIDI_TICK_IRQn         QEI_IRQn
+# define MIDI_TICK_IRQ_HANDLER  void QEI_IRQHandler(void)
+#else
+# error "please select an unused IRQ channel for this derivative"
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local Prototypes
@@ -68,6 +84,7 @@ static void TASK_MIDI(void *pvParameters);
 static void TASK_Period1mS(void *pvParameters);
 static void TASK_Period1mS_LowPrio(void *pvParameters);
 static void TASK_Pattern(void *pvParameters);
+static void TASKS_MIDI_TickNotify(void);
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -76,6 +93,9 @@ static void TASK_Pattern(void *pvParameters);
 
 static xTaskHandle xPatternHandle;
 
+// given whenever the BPM generator flagged a new request
+static xSemaphoreHandle xMIDITickSemaphore;
+
  
 /////////////////////////////////////////////////////////////////////////////
 // Initialize all tasks
@@ -88,8 +108,14 @@ s32 TASKS_Init(u32 mode)
   xMIDIOUTSemaphore = xSemaphoreCreateRecursiveMutex();
   xLCDSemaphore = xSemaphoreCreateRecursiveMutex();
   xJ16Semaphore = xSemaphoreCreateRecursiveMutex();
+  vSemaphoreCreateBinary(xMIDITickSemaphore);
   // TODO: here we could check for NULL and bring MBSEQ into halt state
 
+  // resume TASK_MIDI on BPM ticks, and when the CV output stage requests an AOUT update
+  MIOS32_IRQ_Install(MIDI_TICK_IRQn, MIOS32_IRQ_PRIO_LOW);
+  SEQ_BPM_TickCallback_Init(TASKS_MIDI_TickNotify);
+  SEQ_CV_UpdateCallback_Init(TASKS_MIDI_TickNotify);
+
   // start tasks
   xTaskCreate(TASK_MIDI,              (signed portCHAR *)"MIDI",         configMINIMAL_STACK_SIZE, NULL, PRIORITY_TASK_MIDI, NULL);
   xTaskCreate(TASK_Period1mS,         (signed portCHAR *)"Period1mS",    configMINIMAL_STACK_SIZE, NULL, PRIORITY_TASK_PERIOD1MS, NULL);
@@ -106,22 +132,15 @@ s32 TASKS_Init(u32 mode)
 /////////////////////////////////////////////////////////////////////////////
 // This task is called periodically each mS as well
 // it handles sequencer and MIDI events
+// In addition it's resumed immediately whenever the BPM generator has flagged
+// a new tick, so that it doesn't need to wait for the next mS
 /////////////////////////////////////////////////////////////////////////////
 static void TASK_MIDI(void *pvParameters)
 {
-  portTickType xLastExecutionTime;
-
-  // Initialise the xLastExecutionTime variable on task entry
-  xLastExecutionTime = xTaskGetTickCount();
-
   while( 1 ) {
-    vTaskDelayUntil(&xLastExecutionTime, 1 / portTICK_RATE_MS);
-
-    // skip delay gap if we had to wait for more than 5 ticks to avoid 
-    // unnecessary repeats until xLastExecutionTime reached xTaskGetTickCount() again
-    portTickType xCurrentTickCount = xTaskGetTickCount();
-    if( xLastExecutionTime < (xCurrentTickCount-5) )
-      xLastExecutionTime = xCurrentTickCount;
+    // wait for a BPM tick, but not longer than until the next RTOS tick
+    // (the periodic execution is required for timestamped events, MIDI clock, etc.)
+    xSemaphoreTake(xMIDITickSemaphore, 1 / portTICK_RATE_MS);
 
     // continue in application hook
     SEQ_TASK_MIDI();
@@ -129,6 +148,25 @@ static void TASK_MIDI(void *pvParameters)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Called from the BPM and CV timer interrupts: triggers the software interrupt
+/////////////////////////////////////////////////////////////////////////////
+static void TASKS_MIDI_TickNotify(void)
+{
+  NVIC_SetPendingIRQ(MIDI_TICK_IRQn);
+}
+
+MIDI_TICK_IRQ_HANDLER
+{
+  portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+  xSemaphoreGiveFromISR(xMIDITickSemaphore, &xHigherPriorityTaskWoken);
+
+  // switch to TASK_MIDI immediately
+  portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // This task is called periodically each mS
 /////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,311 @@
+// $Id$
+/*
+ * Host based simulation of the MIDIbox SEQ CV/Gate output timing
+ *
+ * Compiles the original core/seq_cv.c and modules/sequencer/seq_midi_out.c
+ * against a virtual clock:
+ *   - the BPM generator increments bpm_tick each tick period
+ *   - SEQ_TASK_MIDI is executed each mS (with optional jitter), it
+ *     schedules gates like the sequencer core and calls
+ *     SEQ_MIDI_OUT_Handler() and SEQ_CV_Update()
+ *   - the timer which has been installed by SEQ_CV_Init() is called
+ *     each SEQ_CV_TIMER_PERIOD_US
+ *
+ * All gate edges are recorded into a timeline together with the ideal
+ * time (the BPM tick they belong to), so that the edge timing error can
+ * be measured.
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2015 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+#include <mios32.h>
+#include <aout.h>
+#include <seq_bpm.h>
+#include <seq_midi_out.h>
+
+#include "seq_cv.h"
+#include "seq_hwcfg.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Simulation parameters (can be changed from command line)
+/////////////////////////////////////////////////////////////////////////////
+
+static float sim_bpm = 140.0;
+static u16   sim_ppqn = 384;
+static u32   sim_step_ticks = 24;  // 1/64 ratchets @384ppqn
+static u32   sim_gate_ticks = 12;  // gate length
+static u32   sim_jitter_us = 200;  // max. delay of SEQ_TASK_MIDI
+static u32   sim_duration_ms = 10000;
+static FILE *timeline = NULL;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Virtual clock
+/////////////////////////////////////////////////////////////////////////////
+
+static u32 sim_time_us;
+static u32 bpm_tick;
+
+static void (*timer_handler)(void);
+static u32 timer_period_us;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Edge statistics
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u32    num;
+  s32    min_error;
+  s32    max_error;
+  double sum_error;
+} edge_stats_t;
+
+static edge_stats_t stats_on;
+static edge_stats_t stats_off;
+static u8 recorded_gates;
+
+
+static void StatsAdd(edge_stats_t *s, s32 error)
+{
+  if( !s->num || error < s->min_error )
+    s->min_error = error;
+  if( !s->num || error > s->max_error )
+    s->max_error = error;
+  s->sum_error += error;
+  ++s->num;
+}
+
+static void StatsPrint(const char *name, edge_stats_t *s)
+{
+  if( !s->num ) {
+    printf("%-10s no edges recorded\n", name);
+    return;
+  }
+
+  printf("%-10s %6u edges, error min=%5d uS max=%5d uS mean=%8.1f uS -> jitter %5d uS\n",
+	 name, (unsigned)s->num, (int)s->min_error, (int)s->max_error,
+	 s->sum_error / s->num, (int)(s->max_error - s->min_error));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32 replacements
+/////////////////////////////////////////////////////////////////////////////
+
+u8 seq_hwcfg_dout_gate_sr[SEQ_HWCFG_NUM_SR_DOUT_GATES];
+u8 seq_hwcfg_cv_gate_sr[SEQ_HWCFG_NUM_SR_CV_GATES];
+u8 seq_hwcfg_clk_sr;
+
+s32 MIOS32_BOARD_J5_PinInit(u8 pin, mios32_board_pin_mode_t mode) { return 0; }
+s32 MIOS32_BOARD_J5_PinSet(u8 pin, u8 value) { return 0; }
+s32 MIOS32_BOARD_J10_PinInit(u8 pin, mios32_board_pin_mode_t mode) { return 0; }
+s32 MIOS32_BOARD_J10_PinSet(u8 pin, u8 value) { return 0; }
+s32 MIOS32_DOUT_PinSet(u32 pin, u32 value) { return 0; }
+s32 MIOS32_DOUT_SRSet(u32 sr, u8 value) { return 0; }
+s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package) { return 0; }
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  return 0;
+}
+
+s32 MIOS32_TIMER_Init(u8 timer, u32 period, void *_irq_handler, u8 irq_priority)
+{
+  timer_handler = _irq_handler;
+  timer_period_us = period;
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// AOUT replacements: gate edges are recorded here
+/////////////////////////////////////////////////////////////////////////////
+
+static aout_config_t aout_config;
+
+s32 AOUT_Init(u32 mode) { return 0; }
+s32 AOUT_IF_Init(u32 mode) { return 0; }
+s32 AOUT_ConfigSet(aout_config_t config) { aout_config = config; return 0; }
+aout_config_t AOUT_ConfigGet(void) { return aout_config; }
+const char* AOUT_IfNameGet(aout_if_t if_type) { return "SIM     "; }
+s32 AOUT_CaliModeSet(u8 cv, aout_cali_mode_t mode) { return 0; }
+aout_cali_mode_t AOUT_CaliModeGet(void) { return AOUT_CALI_MODE_OFF; }
+const char* AOUT_CaliNameGet(aout_cali_mode_t mode) { return "Off   "; }
+s32 AOUT_PinSet(u8 pin, u16 value) { return 0; }
+s32 AOUT_PinSlewRateSet(u8 pin, u8 value) { return 0; }
+s32 AOUT_PinSlewRateGet(u8 pin) { return 0; }
+s32 AOUT_PinPitchRangeSet(u8 pin, u8 value) { return 0; }
+s32 AOUT_PinPitchRangeGet(u8 pin) { return 2; }
+s32 AOUT_PinPitchSet(u8 pin, s16 value) { return 0; }
+s32 AOUT_Update(void) { return 0; }
+
+s32 AOUT_DigitalPinsSet(u32 value)
+{
+  u8 changed = recorded_gates ^ value;
+  recorded_gates = value;
+
+  int gate;
+  for(gate=0; gate<8; ++gate) {
+    if( !(changed & (1 << gate)) )
+      continue;
+
+    u8 level = (value & (1 << gate)) ? 1 : 0;
+
+    // the ideal time is the BPM tick at which the edge has been scheduled
+    float tick_period = 1E6 * (60 / (sim_bpm*24)) / (float)(sim_ppqn/24);
+    u32 ticks = (u32)((float)sim_time_us / tick_period);
+    u32 edge_tick = level
+      ? (ticks / sim_step_ticks) * sim_step_ticks
+      : ((ticks - sim_gate_ticks) / sim_step_ticks) * sim_step_ticks + sim_gate_ticks;
+    u32 ideal_us = (u32)(edge_tick * tick_period);
+    s32 error = (s32)(sim_time_us - ideal_us);
+
+    StatsAdd(level ? &stats_on : &stats_off, error);
+
+    if( timeline )
+      fprintf(timeline, "%u,%d,%d,%u,%d\n", (unsigned)sim_time_us, gate, level, (unsigned)ideal_us, (int)error);
+  }
+
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// BPM generator replacement
+/////////////////////////////////////////////////////////////////////////////
+
+u32 SEQ_BPM_TickGet(void) { return bpm_tick; }
+s32 SEQ_BPM_IsRunning(void) { return 1; }
+s32 SEQ_BPM_Set(float _bpm) { sim_bpm = _bpm; return 0; }
+
+u32 SEQ_BPM_TickPeriod_uS(void)
+{
+  return (u32)(1E6 * (60 / (sim_bpm*24)) / (float)(sim_ppqn/24));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIDI output: forward AOUT port to SEQ_CV (see SEQ_MIDI_PORT_NotifyMIDITx)
+/////////////////////////////////////////////////////////////////////////////
+static s32 SIM_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  if( port == 0x80 )
+    return SEQ_CV_SendPackage(port & 0xf, package);
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sequencer task replacement: one gate per step on CV channel #1
+/////////////////////////////////////////////////////////////////////////////
+static void SIM_TaskMIDI(void)
+{
+  static u32 processed_tick = 0;
+
+  while( processed_tick <= bpm_tick ) {
+    u32 tick = processed_tick++;
+
+    if( (tick % sim_step_ticks) == 0 ) {
+      mios32_midi_package_t p;
+      p.ALL = 0;
+      p.type = NoteOn;
+      p.event = NoteOn;
+      p.chn = Chn1;
+      p.note = 0x3c;
+      p.velocity = 100;
+      SEQ_MIDI_OUT_Send(0x80, p, SEQ_MIDI_OUT_OnOffEvent, tick, sim_gate_ticks);
+    }
+  }
+
+  SEQ_MIDI_OUT_Handler();
+  SEQ_CV_Update();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int opt;
+  while( (opt=getopt(argc, argv, "b:p:s:l:j:t:o:")) != -1 ) {
+    switch( opt ) {
+    case 'b': sim_bpm = atof(optarg); break;
+    case 'p': sim_ppqn = atoi(optarg); break;
+    case 's': sim_step_ticks = atoi(optarg); break;
+    case 'l': sim_gate_ticks = atoi(optarg); break;
+    case 'j': sim_jitter_us = atoi(optarg); break;
+    case 't': sim_duration_ms = atoi(optarg); break;
+    case 'o':
+      if( (timeline=fopen(optarg, "w")) == NULL ) {
+	perror(optarg);
+	return 1;
+      }
+      fprintf(timeline, "time_us,gate,level,ideal_us,error_us\n");
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-b bpm] [-p ppqn] [-s step_ticks] [-l gate_ticks] [-j task_jitter_us] [-t duration_ms] [-o timeline.csv]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if( !sim_step_ticks || sim_gate_ticks >= sim_step_ticks ) {
+    fprintf(stderr, "gate length must be shorter than the step length!\n");
+    return 1;
+  }
+
+  SEQ_MIDI_OUT_Init(0);
+  SEQ_MIDI_OUT_Callback_MIDI_SendPackage_Set(SIM_SendPackage);
+  SEQ_CV_Init(0);
+
+  float tick_period = 1E6 * (60 / (sim_bpm*24)) / (float)(sim_ppqn/24);
+  u32 next_task_us = 1000 + (sim_jitter_us ? (rand() % sim_jitter_us) : 0);
+  u32 next_timer_us = timer_period_us;
+
+  for(sim_time_us=0; sim_time_us < sim_duration_ms*1000; ++sim_time_us) {
+    // BPM generator (timer with highest priority)
+    while( (float)(bpm_tick+1) * tick_period <= (float)sim_time_us )
+      ++bpm_tick;
+
+    // CV output stage
+    if( timer_handler && sim_time_us >= next_timer_us ) {
+      next_timer_us += timer_period_us;
+      timer_handler();
+    }
+
+    // SEQ_TASK_MIDI is executed each mS, but could be delayed by other tasks/interrupts
+    if( sim_time_us >= next_task_us ) {
+      u32 ms = sim_time_us / 1000;
+      next_task_us = (ms+1) * 1000 + (sim_jitter_us ? (rand() % sim_jitter_us) : 0);
+      SIM_TaskMIDI();
+    }
+  }
+
+  printf("CV timing simulation: %s output stage\n", timer_handler ? "timestamped" : "1 mS");
+  printf("%.1f BPM, %d ppqn, tick period %.1f uS, step %u ticks, gate %u ticks, task jitter %u uS, %u mS\n",
+	 sim_bpm, sim_ppqn, tick_period, (unsigned)sim_step_ticks, (unsigned)sim_gate_ticks, (unsigned)sim_jitter_us, (unsigned)sim_duration_ms);
+  StatsPrint("Gate On:", &stats_on);
+  StatsPrint("Gate Off:", &stats_off);
+
+  if( timeline )
+    fclose(timeline);
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+// $Id$
+/*
+ * Minimal MIOS32 replacement for the CV timing simulation
+ * Only the functions which are used by seq_cv.c and seq_midi_out.c are
+ * declared here, they are implemented in cv_timing_sim.c
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2015 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _MIOS32_H
+#define _MIOS32_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// variable types (32bit like on the target)
+/////////////////////////////////////////////////////////////////////////////
+
+typedef int32_t  s32;
+typedef int16_t  s16;
+typedef int8_t   s8;
+typedef uint32_t u32;
+typedef uint16_t u16;
+typedef uint8_t  u8;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// the STM32F4 variant of the CV pin mapping is simulated
+/////////////////////////////////////////////////////////////////////////////
+
+#define MIOS32_FAMILY_STM32F4xx
+
+
+/////////////////////////////////////////////////////////////////////////////
+// take the MIDI types from the original header
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32_midi.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stubs
+/////////////////////////////////////////////////////////////////////////////
+
+#define MIOS32_IRQ_PRIO_LOW       12
+#define MIOS32_IRQ_PRIO_MID        8
+#define MIOS32_IRQ_PRIO_HIGH       5
+#define MIOS32_IRQ_PRIO_HIGHEST    4
+
+// the simulation is single threaded
+#define MIOS32_IRQ_Disable() do {} while(0)
+#define MIOS32_IRQ_Enable()  do {} while(0)
+
+typedef enum {
+  MIOS32_BOARD_PIN_MODE_IGNORE = 0,
+  MIOS32_BOARD_PIN_MODE_ANALOG,
+  MIOS32_BOARD_PIN_MODE_INPUT,
+  MIOS32_BOARD_PIN_MODE_INPUT_PD,
+  MIOS32_BOARD_PIN_MODE_INPUT_PU,
+  MIOS32_BOARD_PIN_MODE_OUTPUT_PP,
+  MIOS32_BOARD_PIN_MODE_OUTPUT_OD,
+} mios32_board_pin_mode_t;
+
+extern s32 MIOS32_BOARD_J5_PinInit(u8 pin, mios32_board_pin_mode_t mode);
+extern s32 MIOS32_BOARD_J5_PinSet(u8 pin, u8 value);
+extern s32 MIOS32_BOARD_J10_PinInit(u8 pin, mios32_board_pin_mode_t mode);
+extern s32 MIOS32_BOARD_J10_PinSet(u8 pin, u8 value);
+
+extern s32 MIOS32_DOUT_PinSet(u32 pin, u32 value);
+extern s32 MIOS32_DOUT_SRSet(u32 sr, u8 value);
+
+extern s32 MIOS32_TIMER_Init(u8 timer, u32 period, void *_irq_handler, u8 irq_priority);
+
+extern s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package);
+extern s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...);
+
+#endif /* _MIOS32_H */
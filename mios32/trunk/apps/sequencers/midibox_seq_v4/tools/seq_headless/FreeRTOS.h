@@ -0,0 +1,27 @@
+// $Id$
+/*
+ * Dummy FreeRTOS header for the headless build
+ * The emulation doesn't run an RTOS: the heap functions are mapped to the
+ * C library, critical sections and task switches are empty.
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdlib.h>
+
+#define pvPortMalloc(size) malloc(size)
+#define vPortFree(ptr)     free(ptr)
+
+#define portENTER_CRITICAL() do {} while( 0 )
+#define portEXIT_CRITICAL()  do {} while( 0 )
+#define taskYIELD()          do {} while( 0 )
+
+#endif /* INC_FREERTOS_H */
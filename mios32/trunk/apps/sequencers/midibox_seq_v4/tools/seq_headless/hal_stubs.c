@@ -0,0 +1,842 @@
+// $Id$
+/*
+ * Stub MIOS32 HAL for the headless build
+ *
+ * Only the functions which are referenced by the sequencer core are
+ * implemented. Most of them don't do anything, the relevant ones are:
+ *   - MIOS32_TIMER: handlers are captured and called from the virtual
+ *     clock (HAL_STUBS_TimeAdvance_mS)
+ *   - MIOS32_TIMESTAMP/MIOS32_SYS_TimeGet are derived from the virtual clock
+ *   - an optional external clock source (with jitter) is serviced by the
+ *     virtual clock as well, e.g. to send F8 events to SEQ_BPM
+ *   - MIOS32_SDCARD accesses an image file, so that FatFs and the
+ *     SEQ file layer run unmodified
+ *   - MIOS32_MIDI_SendPackage writes the events into a log file
+ *   - MIOS32_STOPWATCH measures real (host) time, so that the statistics
+ *     of SEQ_STATISTICS are still meaningful
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include <mios32.h>
+#include <ff.h>
+#include <seq_bpm.h>
+
+#include "tasks.h"
+#include "hal_stubs.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  void (*handler)(void);
+  u32 period_us;
+  u32 next_us;
+} hal_timer_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u32 time_us;
+static u32 timestamp;
+static hal_timer_t timer[HAL_STUBS_NUM_TIMERS];
+
+static hal_timer_t ext_clock;
+static u32 ext_clock_nominal_us;
+static u32 ext_clock_jitter_us;
+static u32 ext_clock_seed;
+
+static u8 pattern_resume_req;
+
+static FILE *sdcard_image;
+static u32 sdcard_num_sectors;
+
+static FILE *midi_log;
+static u32 midi_log_num_events;
+
+static u8 debug_enabled;
+
+static mios32_midi_port_t debug_port = USB0;
+static mios32_midi_port_t default_port = USB0;
+static s32 (*direct_tx_callback_func)(mios32_midi_port_t port, mios32_midi_package_t package);
+
+static u8 dout_sr[MIOS32_SRIO_NUM_SR];
+static mios32_enc_config_t enc_config[MIOS32_ENC_NUM_MAX];
+
+static struct timespec stopwatch_start;
+static u32 stopwatch_resolution = 1;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Initialisation
+/////////////////////////////////////////////////////////////////////////////
+s32 HAL_STUBS_Init(u32 mode)
+{
+  if( mode != 0 )
+    return -1; // only mode 0 supported
+
+  time_us = 0;
+  timestamp = 0;
+  memset(timer, 0, sizeof(timer));
+  memset(&ext_clock, 0, sizeof(ext_clock));
+  pattern_resume_req = 0;
+  midi_log_num_events = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Virtual clock
+/////////////////////////////////////////////////////////////////////////////
+
+u32 HAL_STUBS_TimeGet_uS(void)
+{
+  return time_us;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// External clock source: the handler is called with the given period,
+// each event is randomly shifted by +/- jitter_us (uniform distribution,
+// fixed seed so that the results are reproducible)
+/////////////////////////////////////////////////////////////////////////////
+static u32 HAL_STUBS_ExtClockJitter(void)
+{
+  if( !ext_clock_jitter_us )
+    return 0;
+
+  ext_clock_seed = ext_clock_seed * 1664525 + 1013904223;
+  return (ext_clock_seed >> 8) % (2*ext_clock_jitter_us + 1);
+}
+
+s32 HAL_STUBS_ExtClockInit(u32 period_us, u32 jitter_us, void (*handler)(void))
+{
+  if( handler && (period_us == 0 || 2*jitter_us >= period_us) )
+    return -1; // events would overtake each other
+
+  ext_clock.handler = handler;
+  ext_clock.period_us = period_us;
+  ext_clock_jitter_us = jitter_us;
+  ext_clock_seed = 12345;
+
+  // first event after one period (+ max jitter, so that it's never in the past)
+  ext_clock_nominal_us = time_us + period_us + jitter_us;
+  ext_clock.next_us = ext_clock_nominal_us - jitter_us + HAL_STUBS_ExtClockJitter();
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Advances the virtual clock by 1 mS, all timer handlers which are due
+// within this period are called in chronological order
+// The optional timer_hook is called after each timer handler, it emulates
+// tasks which are resumed from an interrupt
+/////////////////////////////////////////////////////////////////////////////
+s32 HAL_STUBS_TimeAdvance_mS(void (*timer_hook)(void))
+{
+  u32 target_us = time_us + 1000;
+
+  while( 1 ) {
+    hal_timer_t *next = NULL;
+    int i;
+
+    for(i=0; i<HAL_STUBS_NUM_TIMERS; ++i) {
+      hal_timer_t *t = &timer[i];
+      if( t->handler && t->period_us && (s32)(t->next_us - target_us) <= 0 ) {
+	if( next == NULL || (s32)(t->next_us - next->next_us) < 0 )
+	  next = t;
+      }
+    }
+
+    if( ext_clock.handler && (s32)(ext_clock.next_us - target_us) <= 0 ) {
+      if( next == NULL || (s32)(ext_clock.next_us - next->next_us) < 0 )
+	next = &ext_clock;
+    }
+
+    if( next == NULL )
+      break;
+
+    time_us = next->next_us;
+    if( next == &ext_clock ) {
+      ext_clock_nominal_us += ext_clock.period_us;
+      ext_clock.next_us = ext_clock_nominal_us - ext_clock_jitter_us + HAL_STUBS_ExtClockJitter();
+    } else {
+      next->next_us += next->period_us;
+    }
+    next->handler();
+
+    if( timer_hook )
+      timer_hook();
+  }
+
+  time_us = target_us;
+  ++timestamp;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Pattern task: SEQ_TASK_PatternResume() only sets a request flag which
+// is polled by the main loop
+/////////////////////////////////////////////////////////////////////////////
+
+s32 HAL_STUBS_PatternResumeChkAndClear(void)
+{
+  s32 req = pattern_resume_req;
+  pattern_resume_req = 0;
+  return req;
+}
+
+void SEQ_TASK_PatternResume(void)
+{
+  pattern_resume_req = 1;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIDI log
+/////////////////////////////////////////////////////////////////////////////
+
+s32 HAL_STUBS_MIDILogSet(FILE *log)
+{
+  midi_log = log;
+  midi_log_num_events = 0;
+
+  if( midi_log )
+    fprintf(midi_log, "# time_us tick port evnt0 evnt1 evnt2\n");
+
+  return 0; // no error
+}
+
+u32 HAL_STUBS_MIDILogNumEvents(void)
+{
+  return midi_log_num_events;
+}
+
+s32 HAL_STUBS_DebugSet(u8 enable)
+{
+  debug_enabled = enable;
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// SD Card image
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Opens the image file, if create_mb != 0, a new (empty) image with the
+// given size will be created
+// The number of sectors is rounded down to a multiple of 1024, because
+// the size is reported via the CSD of a SD V2 card
+/////////////////////////////////////////////////////////////////////////////
+s32 HAL_STUBS_SDCardImageOpen(const char *path, u32 create_mb)
+{
+  HAL_STUBS_SDCardImageClose();
+
+  if( create_mb ) {
+    if( (sdcard_image=fopen(path, "w+b")) == NULL )
+      return -1; // can't create file
+
+    if( ftruncate(fileno(sdcard_image), (off_t)create_mb * 1024 * 1024) < 0 ) {
+      HAL_STUBS_SDCardImageClose();
+      return -2; // can't resize file
+    }
+  } else {
+    if( (sdcard_image=fopen(path, "r+b")) == NULL )
+      return -1; // file doesn't exist
+  }
+
+  fseeko(sdcard_image, 0, SEEK_END);
+  sdcard_num_sectors = (u32)(ftello(sdcard_image) / 512) & ~(u32)(1024-1);
+
+  if( sdcard_num_sectors < 1024 ) {
+    HAL_STUBS_SDCardImageClose();
+    return -3; // image too small
+  }
+
+  return 0; // no error
+}
+
+s32 HAL_STUBS_SDCardImageClose(void)
+{
+  if( sdcard_image ) {
+    fclose(sdcard_image);
+    sdcard_image = NULL;
+  }
+  sdcard_num_sectors = 0;
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Formats the image with a FAT file system
+// has to be called before the file system is mounted by FILE_CheckSDCard()
+/////////////////////////////////////////////////////////////////////////////
+s32 HAL_STUBS_SDCardImageFormat(void)
+{
+  FATFS fs;
+  FRESULT res;
+
+  if( !sdcard_image )
+    return -1; // no image
+
+  if( (res=f_mount(0, &fs)) != FR_OK )
+    return -2;
+
+  res = f_mkfs(0, 1, 0); // SFD, automatic cluster size
+  f_mount(0, NULL);
+
+  return (res == FR_OK) ? 0 : -3;
+}
+
+s32 MIOS32_SDCARD_Init(u32 mode)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_SDCARD_CheckAvailable(u8 was_available)
+{
+  return sdcard_image != NULL;
+}
+
+s32 MIOS32_SDCARD_SectorRead(u32 sector, u8 *buffer)
+{
+  if( !sdcard_image || sector >= sdcard_num_sectors )
+    return -1;
+
+  if( fseeko(sdcard_image, (off_t)sector * 512, SEEK_SET) < 0 ||
+      fread(buffer, 512, 1, sdcard_image) != 1 )
+    return -2;
+
+  return 0; // no error
+}
+
+s32 MIOS32_SDCARD_SectorWrite(u32 sector, u8 *buffer)
+{
+  if( !sdcard_image || sector >= sdcard_num_sectors )
+    return -1;
+
+  if( fseeko(sdcard_image, (off_t)sector * 512, SEEK_SET) < 0 ||
+      fwrite(buffer, 512, 1, sdcard_image) != 1 )
+    return -2;
+
+  return 0; // no error
+}
+
+s32 MIOS32_SDCARD_CIDRead(mios32_sdcard_cid_t *cid)
+{
+  memset(cid, 0, sizeof(mios32_sdcard_cid_t));
+  strcpy(cid->ProdName, "IMAGE");
+  return 0; // no error
+}
+
+s32 MIOS32_SDCARD_CSDRead(mios32_sdcard_csd_t *csd)
+{
+  memset(csd, 0, sizeof(mios32_sdcard_csd_t));
+
+  if( !sdcard_image )
+    return -1;
+
+  // SD V2: sectors = (DeviceSize+1) << 10
+  csd->CSDStruct = 1;
+  csd->DeviceSize = (sdcard_num_sectors >> 10) - 1;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32_TIMER and MIOS32_TIMESTAMP
+/////////////////////////////////////////////////////////////////////////////
+
+s32 MIOS32_TIMER_Init(u8 timer_num, u32 period, void (*_irq_handler)(void), u8 irq_priority)
+{
+  if( timer_num >= HAL_STUBS_NUM_TIMERS )
+    return -1; // invalid timer
+
+  hal_timer_t *t = &timer[timer_num];
+  t->handler = _irq_handler;
+  t->period_us = period;
+  t->next_us = time_us + period;
+
+  return 0; // no error
+}
+
+s32 MIOS32_TIMER_ReInit(u8 timer_num, u32 period)
+{
+  if( timer_num >= HAL_STUBS_NUM_TIMERS )
+    return -1; // invalid timer
+
+  hal_timer_t *t = &timer[timer_num];
+  t->period_us = period;
+  t->next_us = time_us + period;
+
+  return 0; // no error
+}
+
+s32 MIOS32_TIMESTAMP_Get(void)
+{
+  return timestamp;
+}
+
+s32 MIOS32_TIMESTAMP_GetDelay(u32 captured_timestamp)
+{
+  return timestamp - captured_timestamp;
+}
+
+u32 MIOS32_TIMESTAMP_Get_uS(void)
+{
+  return time_us;
+}
+
+u32 MIOS32_TIMESTAMP_GetDelay_uS(u32 captured_timestamp_us)
+{
+  return time_us - captured_timestamp_us;
+}
+
+mios32_sys_time_t MIOS32_SYS_TimeGet(void)
+{
+  mios32_sys_time_t t = { .seconds = timestamp / 1000, .fraction_ms = timestamp % 1000 };
+  return t;
+}
+
+s32 MIOS32_DELAY_Wait_uS(u16 uS)
+{
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32_STOPWATCH: measures host time
+/////////////////////////////////////////////////////////////////////////////
+
+s32 MIOS32_STOPWATCH_Init(u32 resolution)
+{
+  stopwatch_resolution = resolution ? resolution : 1;
+  return MIOS32_STOPWATCH_Reset();
+}
+
+s32 MIOS32_STOPWATCH_Reset(void)
+{
+  clock_gettime(CLOCK_MONOTONIC, &stopwatch_start);
+  return 0; // no error
+}
+
+u32 MIOS32_STOPWATCH_ValueGet(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  long long delta_us = (now.tv_sec - stopwatch_start.tv_sec) * 1000000LL + (now.tv_nsec - stopwatch_start.tv_nsec) / 1000;
+  u32 value = delta_us / stopwatch_resolution;
+
+  return (value > 0xfffffffe) ? 0xffffffff : value;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32_MIDI
+/////////////////////////////////////////////////////////////////////////////
+
+s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  // same like in MIOS32: the Tx callback can filter the package
+  if( direct_tx_callback_func != NULL ) {
+    s32 status;
+    if( (status=direct_tx_callback_func(port, package)) )
+      return status;
+  }
+
+  if( midi_log ) {
+    fprintf(midi_log, "%10u %8u %02X %02X %02X %02X\n",
+	    (unsigned)time_us, (unsigned)SEQ_BPM_TickGet(), port,
+	    package.evnt0, package.evnt1, package.evnt2);
+  }
+  ++midi_log_num_events;
+
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendCC(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 cc_number, u8 val)
+{
+  mios32_midi_package_t p;
+  p.ALL = 0;
+  p.type = CC;
+  p.event = CC;
+  p.chn = chn;
+  p.cc_number = cc_number;
+  p.value = val;
+  return MIOS32_MIDI_SendPackage(port, p);
+}
+
+s32 MIOS32_MIDI_SendNoteOn(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 note, u8 vel)
+{
+  mios32_midi_package_t p;
+  p.ALL = 0;
+  p.type = NoteOn;
+  p.event = NoteOn;
+  p.chn = chn;
+  p.note = note;
+  p.velocity = vel;
+  return MIOS32_MIDI_SendPackage(port, p);
+}
+
+s32 MIOS32_MIDI_SendProgramChange(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 prg)
+{
+  mios32_midi_package_t p;
+  p.ALL = 0;
+  p.type = ProgramChange;
+  p.event = ProgramChange;
+  p.chn = chn;
+  p.program_change = prg;
+  return MIOS32_MIDI_SendPackage(port, p);
+}
+
+s32 MIOS32_MIDI_SendSysEx(mios32_midi_port_t port, u8 *stream, u32 count)
+{
+  if( midi_log ) {
+    fprintf(midi_log, "%10u %8u %02X SysEx %u bytes\n",
+	    (unsigned)time_us, (unsigned)SEQ_BPM_TickGet(), port, (unsigned)count);
+  }
+
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  if( debug_enabled ) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+  }
+
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugString(const char *str)
+{
+  if( debug_enabled )
+    fputs(str, stderr);
+
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugHexDump(const u8 *src, u32 len)
+{
+  if( debug_enabled ) {
+    u32 i;
+    for(i=0; i<len; ++i)
+      fprintf(stderr, "%02X%c", src[i], ((i % 16) == 15) ? '\n' : ' ');
+    fputc('\n', stderr);
+  }
+
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugStringHeader(mios32_midi_port_t port, char command, char first_byte)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugStringBody(mios32_midi_port_t port, char *str_from_second_byte, u32 len)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugStringFooter(mios32_midi_port_t port)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_CheckAvailable(mios32_midi_port_t port)
+{
+  return 1; // all ports are available
+}
+
+s32 MIOS32_MIDI_RS_OptimisationSet(mios32_midi_port_t port, u8 enable)
+{
+  return 0; // no error
+}
+
+mios32_midi_port_t MIOS32_MIDI_DebugPortGet(void)
+{
+  return debug_port;
+}
+
+s32 MIOS32_MIDI_DebugPortSet(mios32_midi_port_t port)
+{
+  debug_port = port;
+  return 0; // no error
+}
+
+mios32_midi_port_t MIOS32_MIDI_DefaultPortGet(void)
+{
+  return default_port;
+}
+
+s32 MIOS32_MIDI_DefaultPortSet(mios32_midi_port_t port)
+{
+  default_port = port;
+  return 0; // no error
+}
+
+u8 MIOS32_MIDI_DeviceIDGet(void)
+{
+  return 0x00;
+}
+
+s32 MIOS32_MIDI_DirectTxCallback_Init(s32 (*callback_tx)(mios32_midi_port_t port, mios32_midi_package_t package))
+{
+  direct_tx_callback_func = callback_tx;
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_DirectRxCallback_Init(s32 (*callback_rx)(mios32_midi_port_t port, u8 midi_byte))
+{
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SysExCallback_Init(s32 (*callback_sysex)(mios32_midi_port_t port, u8 sysex_byte))
+{
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_TimeOutCallback_Init(s32 (*callback_timeout)(mios32_midi_port_t port))
+{
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_DebugCommandCallback_Init(s32 (*callback_debug_command)(mios32_midi_port_t port, char c))
+{
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_FilebrowserCommandCallback_Init(s32 (*callback_filebrowser_command)(mios32_midi_port_t port, char c))
+{
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// OSC (not emulated)
+/////////////////////////////////////////////////////////////////////////////
+
+u8 *MIOS32_OSC_PutInt(u8 *buffer, s32 value)
+{
+  *buffer++ = (value >> 24) & 0xff;
+  *buffer++ = (value >> 16) & 0xff;
+  *buffer++ = (value >>  8) & 0xff;
+  *buffer++ = (value >>  0) & 0xff;
+  return buffer;
+}
+
+u8 *MIOS32_OSC_PutString(u8 *buffer, char *str)
+{
+  u8 *buffer_start = buffer;
+
+  do {
+    *buffer++ = *str;
+  } while( *str++ != 0 );
+
+  // 32bit alignment
+  while( (buffer - buffer_start) % 4 )
+    *buffer++ = 0;
+
+  return buffer;
+}
+
+s32 OSC_CLIENT_SendMIDIEvent(u8 osc_port, mios32_midi_package_t p)
+{
+  return 0; // no error
+}
+
+s32 OSC_SERVER_SendPacket(u8 con, u8 *packet, u32 len)
+{
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Tasks and Mutexes (single threaded)
+/////////////////////////////////////////////////////////////////////////////
+
+s32 TASKS_Init(u32 mode)
+{
+  return 0; // no error
+}
+
+void TASKS_MIDIOUTSemaphoreTake(void) {}
+void TASKS_MIDIOUTSemaphoreGive(void) {}
+void TASKS_MIDIINSemaphoreTake(void) {}
+void TASKS_MIDIINSemaphoreGive(void) {}
+void TASKS_SDCardSemaphoreTake(void) {}
+void TASKS_SDCardSemaphoreGive(void) {}
+void TASKS_LCDSemaphoreTake(void) {}
+void TASKS_LCDSemaphoreGive(void) {}
+
+s32 MIOS32_IRQ_Disable(void)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_IRQ_Enable(void)
+{
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32_SYS
+/////////////////////////////////////////////////////////////////////////////
+
+s32 MIOS32_SYS_Reset(void)
+{
+  fprintf(stderr, "MIOS32_SYS_Reset() called - exit!\n");
+  exit(1);
+}
+
+u32 MIOS32_SYS_FlashSizeGet(void)
+{
+  return 1024*1024;
+}
+
+u32 MIOS32_SYS_RAMSizeGet(void)
+{
+  return 192*1024;
+}
+
+s32 MIOS32_SYS_SerialNumberGet(char *str)
+{
+  strcpy(str, "000000000000000000000000");
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// SRIO, DIN, DOUT, ENC: no buttons are pressed, DOUT values are stored
+/////////////////////////////////////////////////////////////////////////////
+
+// generated table of reversed bytes (see mios32_dout.c)
+#define R2(n) n, n + 2*64, n + 1*64, n + 3*64
+#define R4(n) R2(n), R2(n + 2*16), R2(n + 1*16), R2(n + 3*16)
+#define R6(n) R4(n), R4(n + 2*4), R4(n + 1*4), R4(n + 3*4)
+const u8 mios32_dout_reverse_tab[256] = { R6(0), R6(2), R6(1), R6(3) };
+
+s32 MIOS32_SRIO_DebounceSet(u8 debounce_time)
+{
+  return 0; // no error
+}
+
+u8 MIOS32_SRIO_ScanNumGet(void)
+{
+  return MIOS32_SRIO_NUM_SR;
+}
+
+s32 MIOS32_SRIO_ScanNumSet(u8 new_num_sr)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_DIN_SRGet(u32 sr)
+{
+  return (sr < MIOS32_SRIO_NUM_SR) ? 0xff : -1;
+}
+
+u8 MIOS32_DIN_SRChangedGetAndClear(u32 sr, u8 mask)
+{
+  return 0;
+}
+
+s32 MIOS32_DOUT_SRGet(u32 sr)
+{
+  return (sr < MIOS32_SRIO_NUM_SR) ? dout_sr[sr] : -1;
+}
+
+s32 MIOS32_DOUT_SRSet(u32 sr, u8 value)
+{
+  if( sr >= MIOS32_SRIO_NUM_SR )
+    return -1;
+  dout_sr[sr] = value;
+  return 0; // no error
+}
+
+s32 MIOS32_DOUT_PinSet(u32 pin, u32 value)
+{
+  u32 sr = pin / 8;
+  if( sr >= MIOS32_SRIO_NUM_SR )
+    return -1;
+
+  u8 mask = 1 << (pin % 8);
+  if( value )
+    dout_sr[sr] |= mask;
+  else
+    dout_sr[sr] &= ~mask;
+
+  return 0; // no error
+}
+
+mios32_enc_config_t MIOS32_ENC_ConfigGet(u32 encoder)
+{
+  if( encoder >= MIOS32_ENC_NUM_MAX ) {
+    mios32_enc_config_t dummy = { .all=0 };
+    return dummy;
+  }
+  return enc_config[encoder];
+}
+
+s32 MIOS32_ENC_ConfigSet(u32 encoder, mios32_enc_config_t config)
+{
+  if( encoder >= MIOS32_ENC_NUM_MAX )
+    return -1;
+  enc_config[encoder] = config;
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Board, LCD and SPI: no-ops
+/////////////////////////////////////////////////////////////////////////////
+
+s32 MIOS32_BOARD_LED_Init(u32 leds) { return 0; }
+s32 MIOS32_BOARD_LED_Set(u32 leds, u32 value) { return 0; }
+s32 MIOS32_BOARD_J5_PinInit(u8 pin, mios32_board_pin_mode_t mode) { return 0; }
+s32 MIOS32_BOARD_J5_PinSet(u8 pin, u8 value) { return 0; }
+s32 MIOS32_BOARD_DAC_PinInit(u8 chn, u8 enable) { return 0; }
+s32 MIOS32_BOARD_DAC_PinSet(u8 chn, u16 value) { return 0; }
+
+s32 MIOS32_LCD_DeviceSet(u8 device) { return 0; }
+s32 MIOS32_LCD_CursorSet(u16 column, u16 line) { return 0; }
+s32 MIOS32_LCD_PrintChar(char c) { return 0; }
+s32 MIOS32_LCD_SpecialCharsInit(u8 table[64]) { return 0; }
+
+s32 MIOS32_SPI_IO_Init(u8 spi, mios32_spi_pin_driver_t spi_pin_driver) { return 0; }
+s32 MIOS32_SPI_RC_PinSet(u8 spi, u8 rc_pin, u8 pin_value) { return 0; }
+s32 MIOS32_SPI_TransferByte(u8 spi, u8 b) { return 0xff; }
+s32 MIOS32_SPI_TransferModeInit(u8 spi, mios32_spi_mode_t spi_mode, mios32_spi_prescaler_t spi_prescaler) { return 0; }
@@ -0,0 +1,53 @@
+// $Id$
+/*
+ * Stub MIOS32 HAL for the headless build
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HAL_STUBS_H
+#define _HAL_STUBS_H
+
+#include <stdio.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of emulated MIOS32_TIMERs
+#define HAL_STUBS_NUM_TIMERS 4
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern s32 HAL_STUBS_Init(u32 mode);
+
+extern s32 HAL_STUBS_SDCardImageOpen(const char *path, u32 create_mb);
+extern s32 HAL_STUBS_SDCardImageClose(void);
+extern s32 HAL_STUBS_SDCardImageFormat(void);
+
+extern u32 HAL_STUBS_TimeGet_uS(void);
+extern s32 HAL_STUBS_TimeAdvance_mS(void (*timer_hook)(void));
+extern s32 HAL_STUBS_ExtClockInit(u32 period_us, u32 jitter_us, void (*handler)(void));
+
+extern s32 HAL_STUBS_PatternResumeChkAndClear(void);
+
+extern s32 HAL_STUBS_MIDILogSet(FILE *log);
+extern u32 HAL_STUBS_MIDILogNumEvents(void);
+
+extern s32 HAL_STUBS_DebugSet(u8 enable);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Export global variables
+/////////////////////////////////////////////////////////////////////////////
+
+#endif /* _HAL_STUBS_H */
@@ -0,0 +1,79 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the headless build
+ *
+ * Only the switches which are relevant for the sequencer core are
+ * taken over from ../../mios32/mios32_config.h
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+
+// tasks.h doesn't include FreeRTOS for MIOS32_FAMILY_EMULATION, but the core
+// uses portENTER_CRITICAL()/portEXIT_CRITICAL() - take them from the dummy header
+#include <FreeRTOS.h>
+
+
+#define MIOS32_LCD_BOOT_MSG_LINE1 "MIDIbox SEQ V4.090"
+#define MIOS32_LCD_BOOT_MSG_LINE2 "(C) 2015 T. Klose"
+
+// function used to output debug messages (must be printf compatible!)
+extern void APP_SendDebugMessage(char *format, ...);
+#define DEBUG_MSG APP_SendDebugMessage
+
+// no special memory sections
+#define AHB_SECTION
+
+// same number of SRs like on the target (SEQ_LED/SEQ_HWCFG use it)
+#define MIOS32_SRIO_NUM_SR 23
+#define MIOS32_ENC_NUM_MAX 32
+#define MIOS32_UART_NUM 4
+
+// maximum idle counter value to be expected (only used for statistics)
+#define MAX_IDLE_CTR 228000
+
+
+// same allocation method like on the target, so that dropouts are reported
+// as they would happen on the hardware
+#define SEQ_MIDI_OUT_MALLOC_METHOD 3
+#define SEQ_MIDI_OUT_MAX_EVENTS 256
+#define SEQ_MIDI_OUT_MALLOC_ANALYSIS 1
+#define SEQ_MIDI_OUT_SUPPORT_DELAY 1
+
+
+// configure BLM driver (stubbed)
+#define BLM_DOUT_L1_SR	255
+#define BLM_DOUT_R1_SR	255
+#define BLM_DOUT_CATHODES_SR1	255
+#define BLM_DOUT_CATHODES_SR2	255
+#define BLM_CATHODES_INV_MASK	0x00
+#define BLM_DOUT_L2_SR	255
+#define BLM_DOUT_R2_SR	255
+#define BLM_DOUT_L3_SR	0
+#define BLM_DOUT_R3_SR	0
+#define BLM_DIN_L_SR	255
+#define BLM_DIN_R_SR	255
+#define BLM_NUM_COLOURS 2
+#define BLM_NUM_ROWS    8
+#define BLM_DEBOUNCE_MODE 1
+
+// configure BLM_X driver (stubbed)
+#define BLM_X_NUM_ROWS            8
+#define BLM_X_BTN_NUM_COLS        8
+#define BLM_X_LED_NUM_COLS        8
+#define BLM_X_LED_NUM_COLORS      1
+#define BLM_X_ROWSEL_DOUT_SR      255
+#define BLM_X_LED_FIRST_DOUT_SR   255
+#define BLM_X_BTN_FIRST_DIN_SR    255
+#define BLM_X_ROWSEL_INV_MASK     0
+#define BLM_X_DEBOUNCE_MODE       0
+
+#endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1,604 @@
+// $Id$
+/*
+ * Headless MIDIbox SEQ V4 for Linux
+ *
+ * Runs the complete sequencer core without hardware:
+ *   - the SD Card is emulated by an image file, FatFs and the SEQ file
+ *     layer are used unmodified to load a session
+ *   - optionally a session directory of the host is imported into the
+ *     image before it's loaded
+ *   - the sequencer is clocked by a virtual clock, so that N bars are
+ *     played as fast as possible. Each virtual mS the timers which have
+ *     been installed via MIOS32_TIMER_Init() are serviced, and
+ *     SEQ_TASK_Period1mS() and SEQ_TASK_MIDI() are executed like on the
+ *     target
+ *   - all outgoing MIDI events are written into a log file together with
+ *     the virtual time and the BPM tick, so that two builds can be
+ *     compared with diff (timing regression tests)
+ *   - at the end the number of processed ticks per second is reported
+ *     (benchmark)
+ *   - optionally the sequencer runs in slave mode, clocked by a synthetic
+ *     MIDI clock with jitter. The timing error of the interpolated BPM
+ *     ticks is reported, so that the tempo tracker of SEQ_BPM can be
+ *     evaluated
+ *   - optionally the patterns are stored into a packed bank and read back
+ *     (round trip test of the PackBits encoding and the space reservation
+ *     of SEQ_FILE_B)
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <mios32.h>
+#include <file.h>
+#include <seq_bpm.h>
+#include <seq_midi_out.h>
+
+#include "app.h"
+#include "tasks.h"
+#include "seq_core.h"
+#include "seq_cc.h"
+#include "seq_par.h"
+#include "seq_trg.h"
+#include "seq_pattern.h"
+#include "seq_file.h"
+#include "seq_file_b.h"
+#include "seq_file_c.h"
+
+#include "hal_stubs.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Parameters (can be changed from command line)
+/////////////////////////////////////////////////////////////////////////////
+
+static char *image_path = NULL;
+static u32   image_create_mb = 0;
+static char *import_dir = NULL;
+static char *session_name = NULL;
+static u32   num_bars = 16;
+static float bpm_override = 0;
+static FILE *midi_log = NULL;
+static float ext_clock_bpm = 0;
+static u32   ext_clock_jitter_us = 0;
+static u32   pattern_test_rounds = 0;
+
+static u8 midi_tick_req;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+// timing error of events against an ideal grid
+typedef struct {
+  u32    num;
+  double sum;
+  double sum_sqr;
+  double min;
+  double max;
+} timing_stat_t;
+
+static timing_stat_t ext_clock_stat;
+static timing_stat_t tick_stat;
+
+static u32 ext_clock_ctr;
+static u32 ext_clock_period_us;
+static u32 tick_period_us;
+static u32 stat_start_tick;
+static u32 stat_start_us;
+static u32 last_tick;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Copies all files of a host directory into /SESSIONS/<name>
+/////////////////////////////////////////////////////////////////////////////
+static s32 SessionImport(char *dir, char *name)
+{
+  DIR *d;
+  struct dirent *de;
+  char path[30];
+  s32 num_files = 0;
+
+  if( (d=opendir(dir)) == NULL ) {
+    perror(dir);
+    return -1;
+  }
+
+  if( !FILE_DirExists(SEQ_FILE_SESSION_PATH) )
+    FILE_MakeDir(SEQ_FILE_SESSION_PATH);
+
+  sprintf(path, "%s/%s", SEQ_FILE_SESSION_PATH, name);
+  if( !FILE_DirExists(path) && FILE_MakeDir(path) < 0 ) {
+    fprintf(stderr, "ERROR: can't create %s\n", path);
+    closedir(d);
+    return -2;
+  }
+
+  while( (de=readdir(d)) != NULL ) {
+    char host_path[1024];
+    struct stat st;
+
+    snprintf(host_path, sizeof(host_path), "%s/%s", dir, de->d_name);
+    if( stat(host_path, &st) < 0 || !S_ISREG(st.st_mode) )
+      continue;
+
+    // no LFN support: only 8.3 filenames
+    char *ext = strrchr(de->d_name, '.');
+    size_t base_len = ext ? (size_t)(ext - de->d_name) : strlen(de->d_name);
+    if( base_len == 0 || base_len > 8 || (ext && strlen(ext) > 4) ) {
+      fprintf(stderr, "WARNING: skipped %s (no 8.3 filename)\n", de->d_name);
+      continue;
+    }
+
+    char filepath[30];
+    char *p;
+    sprintf(filepath, "%s/%s", path, de->d_name);
+    for(p=filepath; *p; ++p)
+      *p = toupper((unsigned char)*p);
+
+    FILE *f;
+    u8 *buffer;
+    if( (f=fopen(host_path, "rb")) == NULL || (buffer=malloc(st.st_size + 1)) == NULL ) {
+      perror(host_path);
+      if( f ) fclose(f);
+      continue;
+    }
+
+    size_t len = fread(buffer, 1, st.st_size, f);
+    fclose(f);
+
+    s32 status;
+    if( (status=FILE_WriteOpen(filepath, 1)) >= 0 ) {
+      status = FILE_WriteBuffer(buffer, len);
+      FILE_WriteClose();
+    }
+    free(buffer);
+
+    if( status < 0 ) {
+      fprintf(stderr, "ERROR: failed to write %s (status %d)\n", filepath, (int)status);
+      closedir(d);
+      return -3;
+    }
+
+    ++num_files;
+  }
+
+  closedir(d);
+
+  return num_files;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the size of a file in the image
+/////////////////////////////////////////////////////////////////////////////
+static s32 FileSizeGet(char *filepath)
+{
+  s32 status;
+  if( (status=FILE_WriteOpen(filepath, 0)) < 0 ) {
+    FILE_WriteClose();
+    return status;
+  }
+
+  u32 size = FILE_WriteGetCurrentSize();
+  FILE_WriteClose();
+
+  return size;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stores the patterns of all groups into a new packed bank of session
+// PTEST and reads them back:
+//   - each round changes more bytes of the layers (the last one is random
+//     noise), so that the patterns grow and have to be moved in the file
+//   - after each round trip the tracks are compared with the stored data
+//   - finally the original patterns are stored into a second bank, and
+//     stored again with a changed step, so that their packed size varies
+//     by some bytes: the bank file must not grow
+// returns < 0 if the test failed
+/////////////////////////////////////////////////////////////////////////////
+static s32 PatternStoreTest(u32 num_rounds)
+{
+  static u8 par_copy[SEQ_CORE_NUM_TRACKS][SEQ_PAR_MAX_BYTES];
+  static u8 trg_copy[SEQ_CORE_NUM_TRACKS][SEQ_TRG_MAX_BYTES];
+  static u8 cc_copy[SEQ_CORE_NUM_TRACKS][128];
+  static u8 par_init[SEQ_CORE_NUM_TRACKS][SEQ_PAR_MAX_BYTES];
+  static u8 trg_init[SEQ_CORE_NUM_TRACKS][SEQ_TRG_MAX_BYTES];
+  char session[] = "PTEST";
+  char path[30];
+  u8 bank = 0;
+  u32 num_mismatches = 0;
+  s32 status;
+
+  if( !FILE_DirExists(SEQ_FILE_SESSION_PATH) )
+    FILE_MakeDir(SEQ_FILE_SESSION_PATH);
+
+  sprintf(path, "%s/%s", SEQ_FILE_SESSION_PATH, session);
+  if( !FILE_DirExists(path) && FILE_MakeDir(path) < 0 ) {
+    fprintf(stderr, "ERROR: can't create %s\n", path);
+    return -1;
+  }
+
+  if( (status=SEQ_FILE_B_Create(session, bank)) < 0 || (status=SEQ_FILE_B_Open(session, bank)) < 0 ) {
+    fprintf(stderr, "ERROR: can't create bank in %s (status %d)\n", path, (int)status);
+    return -1;
+  }
+  sprintf(path, "%s/%s/MBSEQ_B%d.V4", SEQ_FILE_SESSION_PATH, session, bank+1);
+
+  memcpy(par_init, seq_par_layer_value, sizeof(par_init));
+  memcpy(trg_init, seq_trg_layer_value, sizeof(trg_init));
+
+  srand(1);
+
+  u32 round;
+  for(round=0; round<num_rounds; ++round) {
+    u8 group;
+    for(group=0; group<SEQ_CORE_NUM_GROUPS; ++group) {
+      u8 track_i;
+      u8 track = group * SEQ_CORE_NUM_TRACKS_PER_GROUP;
+      for(track_i=0; track_i<SEQ_CORE_NUM_TRACKS_PER_GROUP; ++track_i, ++track) {
+	u32 p_size = SEQ_PAR_NumInstrumentsGet(track) * SEQ_PAR_NumLayersGet(track) * SEQ_PAR_NumStepsGet(track);
+	u32 t_size = SEQ_TRG_NumInstrumentsGet(track) * SEQ_TRG_NumLayersGet(track) * SEQ_TRG_NumStepsGet(track) / 8;
+
+	// the first round stores the loaded patterns
+	u32 i;
+	u32 num_changes = (round * p_size) / (num_rounds > 1 ? (num_rounds-1) : 1);
+	for(i=0; i<num_changes; ++i)
+	  seq_par_layer_value[track][rand() % p_size] = rand();
+	num_changes = (round * t_size) / (num_rounds > 1 ? (num_rounds-1) : 1);
+	for(i=0; i<num_changes; ++i)
+	  seq_trg_layer_value[track][rand() % t_size] = rand();
+
+	memcpy(par_copy[track], seq_par_layer_value[track], p_size);
+	memcpy(trg_copy[track], seq_trg_layer_value[track], t_size);
+	u8 cc;
+	for(cc=0; cc<128; ++cc)
+	  cc_copy[track][cc] = SEQ_CC_Get(track, cc);
+      }
+
+      if( (status=SEQ_FILE_B_PatternWrite(session, bank, group, group, 0)) < 0 ) {
+	fprintf(stderr, "ERROR: failed to write pattern %d (status %d)\n", group, (int)status);
+	return -1;
+      }
+
+      // overwrite layers, so that the comparison fails if they aren't restored
+      track = group * SEQ_CORE_NUM_TRACKS_PER_GROUP;
+      for(track_i=0; track_i<SEQ_CORE_NUM_TRACKS_PER_GROUP; ++track_i, ++track) {
+	memset(seq_par_layer_value[track], 0xaa, SEQ_PAR_MAX_BYTES);
+	memset(seq_trg_layer_value[track], 0xaa, SEQ_TRG_MAX_BYTES);
+      }
+
+      if( (status=SEQ_FILE_B_PatternRead(bank, group, group, 0)) < 0 ) {
+	fprintf(stderr, "ERROR: failed to read pattern %d (status %d)\n", group, (int)status);
+	return -1;
+      }
+
+      track = group * SEQ_CORE_NUM_TRACKS_PER_GROUP;
+      for(track_i=0; track_i<SEQ_CORE_NUM_TRACKS_PER_GROUP; ++track_i, ++track) {
+	u32 p_size = SEQ_PAR_NumInstrumentsGet(track) * SEQ_PAR_NumLayersGet(track) * SEQ_PAR_NumStepsGet(track);
+	u32 t_size = SEQ_TRG_NumInstrumentsGet(track) * SEQ_TRG_NumLayersGet(track) * SEQ_TRG_NumStepsGet(track) / 8;
+	u8 cc;
+	for(cc=0; cc<128; ++cc)
+	  if( (u8)SEQ_CC_Get(track, cc) != cc_copy[track][cc] )
+	    break;
+
+	if( memcmp(par_copy[track], seq_par_layer_value[track], p_size) != 0 ||
+	    memcmp(trg_copy[track], seq_trg_layer_value[track], t_size) != 0 ||
+	    cc < 128 ) {
+	  fprintf(stderr, "ERROR: track %d differs after round trip %u\n", track+1, (unsigned)round);
+	  ++num_mismatches;
+	}
+      }
+    }
+
+    printf("Round %u: bank size %d bytes\n", (unsigned)round, (int)FileSizeGet(path));
+  }
+
+  // store the original patterns into a new bank, and store them again with a changed step
+  bank = 1;
+  if( (status=SEQ_FILE_B_Create(session, bank)) < 0 || (status=SEQ_FILE_B_Open(session, bank)) < 0 ) {
+    fprintf(stderr, "ERROR: can't create bank in %s (status %d)\n", path, (int)status);
+    return -1;
+  }
+  sprintf(path, "%s/%s/MBSEQ_B%d.V4", SEQ_FILE_SESSION_PATH, session, bank+1);
+
+  memcpy(seq_par_layer_value, par_init, sizeof(par_init));
+  memcpy(seq_trg_layer_value, trg_init, sizeof(trg_init));
+
+  u8 group;
+  for(group=0; group<SEQ_CORE_NUM_GROUPS; ++group)
+    SEQ_FILE_B_PatternWrite(session, bank, group, group, 0);
+
+  s32 size = FileSizeGet(path);
+  for(round=0; round<num_rounds; ++round) {
+    for(group=0; group<SEQ_CORE_NUM_GROUPS; ++group) {
+      u8 track = group * SEQ_CORE_NUM_TRACKS_PER_GROUP;
+      u32 step = SEQ_PAR_NumStepsGet(track) / 2;
+      seq_par_layer_value[track][step] = par_init[track][step] ^ ((round & 1) ? 0x00 : 0x55);
+      SEQ_FILE_B_PatternWrite(session, bank, group, group, 0);
+    }
+  }
+  s32 new_size = FileSizeGet(path);
+
+  printf("Pattern store test: %u rounds, %u mismatches, second bank size %d bytes, %d bytes after %u saves\n",
+	 (unsigned)num_rounds, (unsigned)num_mismatches, (int)size, (int)new_size, (unsigned)(num_rounds*SEQ_CORE_NUM_GROUPS));
+
+  return (num_mismatches || new_size != size) ? -1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Timing statistics
+/////////////////////////////////////////////////////////////////////////////
+static void TimingStatAdd(timing_stat_t *stat, double error_us)
+{
+  if( !stat->num || error_us < stat->min ) stat->min = error_us;
+  if( !stat->num || error_us > stat->max ) stat->max = error_us;
+  stat->sum += error_us;
+  stat->sum_sqr += error_us * error_us;
+  ++stat->num;
+}
+
+static void TimingStatPrint(const char *name, timing_stat_t *stat)
+{
+  if( !stat->num )
+    return;
+
+  // the constant offset (latency) is removed
+  double mean = stat->sum / stat->num;
+  double rms = sqrt(stat->sum_sqr / stat->num - mean*mean);
+  printf("%s: %u events, jitter %.0f..%.0f uS (rms %.1f uS), latency %.0f uS\n",
+	 name, (unsigned)stat->num, stat->min - mean, stat->max - mean, rms, mean);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Synthetic MIDI clock (slave mode)
+/////////////////////////////////////////////////////////////////////////////
+static void ExtClockHandler(void)
+{
+  u32 now_us = HAL_STUBS_TimeGet_uS();
+
+  // the first bar is used to lock the tempo tracker
+  if( ext_clock_ctr == 4*24 )
+    stat_start_us = now_us;
+
+  if( ext_clock_ctr >= 4*24 )
+    TimingStatAdd(&ext_clock_stat, (double)(now_us - stat_start_us) - (double)(ext_clock_ctr - 4*24) * ext_clock_period_us);
+  ++ext_clock_ctr;
+
+  SEQ_BPM_NotifyMIDIRx(0xf8);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Same like in mios32/tasks.c: the BPM generator resumes TASK_MIDI
+/////////////////////////////////////////////////////////////////////////////
+static void MIDI_TickNotify(void)
+{
+  midi_tick_req = 1;
+
+  // measure the timing of the BPM ticks in slave mode, the grid starts with the first F8 of the second bar
+  if( ext_clock_bpm > 0 && stat_start_us ) {
+    u32 tick = SEQ_BPM_TickGet();
+
+    if( !stat_start_tick )
+      stat_start_tick = tick;
+    else if( tick != last_tick )
+      TimingStatAdd(&tick_stat, (double)(HAL_STUBS_TimeGet_uS() - stat_start_us) - (double)(tick - stat_start_tick) * tick_period_us);
+
+    last_tick = tick;
+  }
+}
+
+static void MIDI_TickHook(void)
+{
+  if( midi_tick_req ) {
+    midi_tick_req = 0;
+    SEQ_TASK_MIDI();
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Executes the tasks for one virtual mS
+/////////////////////////////////////////////////////////////////////////////
+static void Tick1mS(void)
+{
+  HAL_STUBS_TimeAdvance_mS(MIDI_TickHook);
+
+  SEQ_TASK_Period1mS();
+  SEQ_TASK_MIDI();
+
+  if( HAL_STUBS_PatternResumeChkAndClear() )
+    SEQ_TASK_Pattern();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int opt;
+  s32 status;
+
+  while( (opt=getopt(argc, argv, "i:c:s:n:b:t:o:x:j:p:v")) != -1 ) {
+    switch( opt ) {
+    case 'i': image_path = optarg; break;
+    case 'c': image_create_mb = atoi(optarg); break;
+    case 's': import_dir = optarg; break;
+    case 'n': session_name = optarg; break;
+    case 'b': num_bars = atoi(optarg); break;
+    case 't': bpm_override = atof(optarg); break;
+    case 'x': ext_clock_bpm = atof(optarg); break;
+    case 'j': ext_clock_jitter_us = atoi(optarg); break;
+    case 'p': pattern_test_rounds = atoi(optarg); break;
+    case 'o':
+      if( (midi_log=fopen(optarg, "w")) == NULL ) {
+	perror(optarg);
+	return 1;
+      }
+      break;
+    case 'v': HAL_STUBS_DebugSet(1); break;
+    default:
+      fprintf(stderr, "Usage: %s -i <image> [-c <create_mb>] [-s <session_dir>] [-n <session_name>] [-b <bars>] [-t <bpm>] [-o <midi_log>] [-x <ext_bpm> [-j <jitter_us>]] [-p <rounds>] [-v]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if( image_path == NULL ) {
+    fprintf(stderr, "ERROR: no SD Card image specified (-i)!\n");
+    return 1;
+  }
+
+  if( import_dir && session_name == NULL ) {
+    fprintf(stderr, "ERROR: a session name (-n) is required to import a directory!\n");
+    return 1;
+  }
+
+  if( session_name && strlen(session_name) > 8 ) {
+    fprintf(stderr, "ERROR: session name must not be longer than 8 characters!\n");
+    return 1;
+  }
+
+  HAL_STUBS_Init(0);
+
+  if( (status=HAL_STUBS_SDCardImageOpen(image_path, image_create_mb)) < 0 ) {
+    fprintf(stderr, "ERROR: can't open image %s (status %d)\n", image_path, (int)status);
+    return 1;
+  }
+
+  if( image_create_mb && (status=HAL_STUBS_SDCardImageFormat()) < 0 ) {
+    fprintf(stderr, "ERROR: failed to format image (status %d)\n", (int)status);
+    return 1;
+  }
+
+  APP_Init();
+  SEQ_BPM_TickCallback_Init(MIDI_TickNotify);
+
+  if( FILE_CheckSDCard() != 1 || !FILE_VolumeAvailable() ) {
+    fprintf(stderr, "ERROR: image doesn't contain a valid FAT!\n");
+    return 1;
+  }
+
+  if( import_dir ) {
+    if( (status=SessionImport(import_dir, session_name)) < 0 )
+      return 1;
+    printf("Imported %d files into %s/%s\n", (int)status, SEQ_FILE_SESSION_PATH, session_name);
+  }
+
+  // select session
+  if( session_name ) {
+    char *p;
+    strcpy(seq_file_session_name, session_name);
+    for(p=seq_file_session_name; *p; ++p)
+      *p = toupper((unsigned char)*p);
+  } else {
+    SEQ_FILE_LoadSessionName();
+  }
+
+  if( SEQ_FILE_LoadAllFiles(1) < 0 )
+    fprintf(stderr, "WARNING: some files of session '%s' couldn't be loaded\n", seq_file_session_name);
+
+  // without MBSEQ_C.V4 the patterns haven't been changed by SEQ_FILE_LoadAllFiles()
+  if( !SEQ_FILE_C_Valid() ) {
+    int group;
+    for(group=0; group<SEQ_CORE_NUM_GROUPS; ++group)
+      SEQ_PATTERN_Change(group, seq_pattern[group], 1);
+  }
+
+  if( pattern_test_rounds ) {
+    status = PatternStoreTest(pattern_test_rounds);
+    HAL_STUBS_SDCardImageClose();
+    return (status < 0) ? 1 : 0;
+  }
+
+  if( bpm_override > 0 )
+    SEQ_CORE_BPM_Update(bpm_override, 0);
+
+  HAL_STUBS_MIDILogSet(midi_log);
+
+  // play N bars (4/4)
+  u32 end_tick = num_bars * 4 * SEQ_BPM_PPQN_Get();
+  u32 num_ms = 0;
+
+  struct timespec t_start, t_end;
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+  if( ext_clock_bpm > 0 ) {
+    // slave mode: period in uS of the 24 ppqn MIDI clock, ideal period of the interpolated ticks
+    ext_clock_period_us = (u32)(60E6 / (ext_clock_bpm * 24) + 0.5);
+    tick_period_us = ext_clock_period_us / (SEQ_BPM_PPQN_Get() / 24);
+    ext_clock_period_us = tick_period_us * (SEQ_BPM_PPQN_Get() / 24); // avoid rounding drift
+
+    SEQ_BPM_ModeSet(SEQ_BPM_MODE_Slave);
+    if( HAL_STUBS_ExtClockInit(ext_clock_period_us, ext_clock_jitter_us, ExtClockHandler) < 0 ) {
+      fprintf(stderr, "ERROR: jitter must be less than half of the clock period (%u uS)!\n", (unsigned)ext_clock_period_us);
+      return 1;
+    }
+    SEQ_BPM_NotifyMIDIRx(0xfa);
+  } else {
+    SEQ_BPM_Start();
+  }
+
+  while( SEQ_BPM_TickGet() < end_tick ) {
+    Tick1mS();
+    ++num_ms;
+  }
+
+  // stop sequencer and send remaining events (e.g. Note Offs)
+  if( ext_clock_bpm > 0 ) {
+    HAL_STUBS_ExtClockInit(0, 0, NULL);
+    SEQ_BPM_NotifyMIDIRx(0xfc);
+  } else {
+    SEQ_BPM_Stop();
+  }
+  int i;
+  for(i=0; i<10; ++i) {
+    Tick1mS();
+    ++num_ms;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t_end);
+  double wall_s = (t_end.tv_sec - t_start.tv_sec) + (t_end.tv_nsec - t_start.tv_nsec) / 1E9;
+
+  printf("Session '%s': %u bars @ %.1f BPM, %u ppqn\n",
+	 seq_file_session_name, (unsigned)num_bars, SEQ_BPM_EffectiveGet(), (unsigned)SEQ_BPM_PPQN_Get());
+  printf("%u ticks in %u virtual mS, %u MIDI events, max. %u allocated events, %u dropouts\n",
+	 (unsigned)end_tick, (unsigned)num_ms, (unsigned)HAL_STUBS_MIDILogNumEvents(),
+	 (unsigned)seq_midi_out_max_allocated, (unsigned)seq_midi_out_dropouts);
+  printf("Wall time: %.3f s -> %.0f ticks/s (%.1fx realtime)\n",
+	 wall_s, wall_s > 0 ? end_tick / wall_s : 0, wall_s > 0 ? (num_ms / 1000.0) / wall_s : 0);
+
+  if( ext_clock_bpm > 0 ) {
+    TimingStatPrint("MIDI Clock", &ext_clock_stat);
+    TimingStatPrint("BPM Ticks ", &tick_stat);
+  }
+
+  if( midi_log )
+    fclose(midi_log);
+  HAL_STUBS_SDCardImageClose();
+
+  return 0;
+}
@@ -50,7 +50,7 @@
 seq_ui_button_state_t seq_ui_button_state;
 
 u8 ui_selected_group;
-u16 ui_selected_tracks;
+seq_core_trkset_t ui_selected_tracks;
 u8 ui_selected_par_layer;
 u8 ui_selected_trg_layer;
 u8 ui_selected_instrument;
@@ -110,7 +110,8 @@ s32 SEQ_UI_Init(u32 mode)
   seq_ui_button_state.ALL = 0;
 
   ui_selected_group = 0;
-  ui_selected_tracks = 0x00ff;
+  SEQ_CORE_TrkSetClear(&ui_selected_tracks);
+  SEQ_CORE_TrkSetSet16(&ui_selected_tracks, 0, 0x00ff);
   ui_selected_par_layer = 0;
   ui_selected_trg_layer = 0;
   ui_selected_instrument = 0;
@@ -214,17 +215,18 @@ s32 SEQ_UI_Button_Seq(s32 depressed, u32 seq)
     seq_pressed &= ~selected_tracks;
   } else {
     seq_pressed |= selected_tracks;
-    ui_selected_tracks = seq_pressed;
+    SEQ_CORE_TrkSetSet16(&ui_selected_tracks, 0, seq_pressed);
   }
 
   // armed tracks handling: alternate and select all tracks depending on seq selection
   // can be changed in RecArm page
+  u16 armed_tracks = SEQ_CORE_TrkSetGet16(&seq_record_state.ARMED_TRACKS, 0);
   if( seq ) {
-    if( (seq_record_state.ARMED_TRACKS & 0x00ff) )
-      seq_record_state.ARMED_TRACKS = 0xff00;
+    if( (armed_tracks & 0x00ff) )
+      SEQ_CORE_TrkSetSet16(&seq_record_state.ARMED_TRACKS, 0, 0xff00);
   } else {
-    if( (seq_record_state.ARMED_TRACKS & 0xff00) )
-      seq_record_state.ARMED_TRACKS = 0x00ff;
+    if( (armed_tracks & 0xff00) )
+      SEQ_CORE_TrkSetSet16(&seq_record_state.ARMED_TRACKS, 0, 0x00ff);
   }
 
   // if clear button is pressed: clear entire sequence
@@ -1045,8 +1047,8 @@ s32 SEQ_UI_LED_Handler(void)
 
   switch( ui_controller_mode ) {
   case UI_CONTROLLER_MODE_OFF:
-    SEQ_LED_PinSet(seq_hwcfg_led.seq1, ui_selected_tracks & (1 << 0));
-    SEQ_LED_PinSet(seq_hwcfg_led.seq2, ui_selected_tracks & (1 << 8));
+    SEQ_LED_PinSet(seq_hwcfg_led.seq1, SEQ_CORE_TRKSET_GET(&ui_selected_tracks, 0));
+    SEQ_LED_PinSet(seq_hwcfg_led.seq2, SEQ_CORE_TRKSET_GET(&ui_selected_tracks, 8));
 
     SEQ_LED_PinSet(seq_hwcfg_led.load, ui_page == SEQ_UI_PAGE_LOAD);
     SEQ_LED_PinSet(seq_hwcfg_led.save, ui_page == SEQ_UI_PAGE_SAVE);
@@ -1384,8 +1386,8 @@ s32 SEQ_UI_MENU_Handler_Periodic()
 /////////////////////////////////////////////////////////////////////////////
 s32 SEQ_UI_CheckSelections(void)
 {
-  if( !ui_selected_tracks )
-    ui_selected_tracks = 0x00ff;
+  if( SEQ_CORE_TrkSetIsEmpty(&ui_selected_tracks) )
+    SEQ_CORE_TrkSetSet16(&ui_selected_tracks, 0, 0x00ff);
 
   return 0; // no error
 }
@@ -1397,9 +1399,8 @@ s32 SEQ_UI_CheckSelections(void)
 u8 SEQ_UI_VisibleTrackGet(void)
 {
   u8 track;
-  u16 mask = 1;
-  for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track, mask<<=1)
-    if( ui_selected_tracks & mask )
+  for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track)
+    if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) )
       return track;
 
   return 0; // first track
@@ -1411,7 +1412,10 @@ u8 SEQ_UI_VisibleTrackGet(void)
 /////////////////////////////////////////////////////////////////////////////
 s32 SEQ_UI_IsSelectedTrack(u8 track)
 {
-  return (ui_selected_tracks & (1 << track)) ? 1 : 0;
+  if( track >= SEQ_CORE_NUM_TRACKS )
+    return 0; // invalid track
+
+  return SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track);
 }
 
 
@@ -14,6 +14,7 @@
 #ifndef _SEQ_UI_H
 #define _SEQ_UI_H
 
+#include "seq_core.h"
 
 /////////////////////////////////////////////////////////////////////////////
 // Global definitions
@@ -214,7 +215,7 @@ extern s32 SEQ_UI_UTIL_Undo(void);
 extern seq_ui_button_state_t seq_ui_button_state;
 
 extern u8 ui_selected_group;
-extern u16 ui_selected_tracks;
+extern seq_core_trkset_t ui_selected_tracks;
 extern u8 ui_selected_par_layer;
 extern u8 ui_selected_trg_layer;
 extern u8 ui_selected_instrument;
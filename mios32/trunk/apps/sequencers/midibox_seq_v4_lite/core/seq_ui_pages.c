@@ -272,7 +272,7 @@ u16 SEQ_UI_PAGES_GP_LED_Handler(void)
   case SEQ_UI_PAGE_REC_STEP:
   case SEQ_UI_PAGE_REC_LIVE: {
     u8 record_track = 8;
-    if( seq_record_state.ARMED_TRACKS & (1 << 0) )
+    if( SEQ_CORE_TRKSET_GET(&seq_record_state.ARMED_TRACKS, 0) )
       record_track = 0;
 
     u8 *trg_ptr = (u8 *)&seq_trg_layer_value[record_track][2*ui_selected_step_view];
@@ -421,7 +421,7 @@ u16 SEQ_UI_PAGES_GP_LED_Handler(void)
     // check if selection still valid
     if( check_100mS_ctr == 0 ) {
       u8 note_track = 8;
-      if( ui_selected_tracks & (1 << 0) )
+      if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, 0) )
 	note_track = 0;
 
       if( !seq_cc_trk[note_track].mode.FORCE_SCALE )
@@ -448,10 +448,10 @@ u16 SEQ_UI_PAGES_GP_LED_Handler(void)
 
   ///////////////////////////////////////////////////////////////////////////
   case SEQ_UI_PAGE_MUTE: {
-    u16 muted = seq_core_trk_muted;
+    u16 muted = SEQ_CORE_TrkSetGet16(&seq_core_trk_muted, 0);
     if( ui_cursor_flash && seq_ui_button_state.SOLO ) {
       //muted |= !ui_selected_tracks; // doesn't work with gcc version 4.2.1 ?!?
-      muted |= ui_selected_tracks ^ 0xffff;
+      muted |= SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0) ^ 0xffff;
     }
     return muted;
   } break;
@@ -464,7 +464,7 @@ u16 SEQ_UI_PAGES_GP_LED_Handler(void)
 
   ///////////////////////////////////////////////////////////////////////////
   case SEQ_UI_PAGE_REC_ARM: {
-    return seq_record_state.ARMED_TRACKS;
+    return SEQ_CORE_TrkSetGet16(&seq_record_state.ARMED_TRACKS, 0);
   } break;
 
   ///////////////////////////////////////////////////////////////////////////
@@ -507,8 +507,8 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
   if( seq_ui_button_state.CLEAR ) {
     u8 seq = (button >= 8) ? 1 : 0;
     u8 track_offset = seq ? 8 : 0;
-    ui_selected_tracks = seq ? 0xff00 : 0x00ff;
-    seq_record_state.ARMED_TRACKS = seq ? 0xff00 : 0x00ff;
+    SEQ_CORE_TrkSetSet16(&ui_selected_tracks, 0, seq ? 0xff00 : 0x00ff);
+    SEQ_CORE_TrkSetSet16(&seq_record_state.ARMED_TRACKS, 0, seq ? 0xff00 : 0x00ff);
 
     u8 seq_button = button % 8;
     switch( seq_button ) {
@@ -651,7 +651,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
 
     u8 track; // only change triggers if track 0 and 8
     for(track=0; track<SEQ_CORE_NUM_TRACKS; track+=8)
-      if( ui_selected_tracks & (1 << track) ) {
+      if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) ) {
 	u8 *trg_ptr = (u8 *)&seq_trg_layer_value[track][2*ui_selected_step_view + (button>>3)];
 	*trg_ptr ^= (1 << (button&7));
       }
@@ -667,7 +667,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
 
     u8 track;
     for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track) {
-      if( ui_selected_tracks & (1 << track) ) {
+      if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) ) {
 	if( seq_ui_button_state.LENGTH_PRESSED ) {
 	  if( (track >= 0 && track <= 2) || (track >= 8 && track <= 10) )
 	    SEQ_CC_Set(track, SEQ_CC_LOOP, 16*ui_selected_step_view + button);
@@ -695,7 +695,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
     seq_ui_pages_progression_presets_t *preset = (seq_ui_pages_progression_presets_t *)&seq_ui_pages_progression_presets[ui_selected_progression_preset];
     u8 track;
     for(track=0; track<SEQ_CORE_NUM_TRACKS; track+=8) {
-      if( ui_selected_tracks & (1 << track) ) {
+      if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) ) {
 	SEQ_CC_Set(track, SEQ_CC_STEPS_FORWARD, (preset->steps_forward > 0) ? (preset->steps_forward-1) : 0);
 	SEQ_CC_Set(track, SEQ_CC_STEPS_JMPBCK, preset->steps_jump_back);
 	SEQ_CC_Set(track, SEQ_CC_STEPS_REPLAY, preset->steps_replay);
@@ -708,7 +708,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
     // GP1 also requests synch to measure
     // it's a good idea to do this for all tracks so that both sequences are in synch again
     if( button == 0 )
-      SEQ_CORE_ManualSynchToMeasure(0xffff);
+      SEQ_CORE_ManualSynchToMeasure(NULL);
 
     portEXIT_CRITICAL();
     return 0;
@@ -738,7 +738,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
     seq_ui_pages_echo_presets_t *preset = (seq_ui_pages_echo_presets_t *)&seq_ui_pages_echo_presets[ui_selected_echo_preset];
     u8 track;
     for(track=0; track<SEQ_CORE_NUM_TRACKS; track+=8) {
-      if( ui_selected_tracks & (1 << track) ) {
+      if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) ) {
 	SEQ_CC_Set(track, SEQ_CC_ECHO_REPEATS, preset->repeats);
 	SEQ_CC_Set(track, SEQ_CC_ECHO_DELAY, preset->delay);
 	SEQ_CC_Set(track, SEQ_CC_ECHO_VELOCITY, preset->velocity);
@@ -761,7 +761,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
     seq_ui_pages_humanizer_presets_t *preset = (seq_ui_pages_humanizer_presets_t *)&seq_ui_pages_humanizer_presets[ui_selected_humanizer_preset];
     u8 track;
     for(track=0; track<SEQ_CORE_NUM_TRACKS; track+=8) {
-      if( ui_selected_tracks & (1 << track) ) {
+      if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) ) {
 	SEQ_CC_Set(track, SEQ_CC_HUMANIZE_MODE, preset->mode);
 	SEQ_CC_Set(track, SEQ_CC_HUMANIZE_VALUE, preset->value);
       }
@@ -780,7 +780,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
     seq_ui_pages_lfo_presets_t *preset = (seq_ui_pages_lfo_presets_t *)&seq_ui_pages_lfo_presets[ui_selected_lfo_preset];
     u8 track;
     for(track=0; track<SEQ_CORE_NUM_TRACKS; track+=8) {
-      if( ui_selected_tracks & (1 << track) ) {
+      if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) ) {
 	SEQ_CC_Set(track, SEQ_CC_LFO_WAVEFORM, preset->waveform);
 	SEQ_CC_Set(track, SEQ_CC_LFO_AMPLITUDE, preset->amplitude);
 	SEQ_CC_Set(track, SEQ_CC_LFO_PHASE, preset->phase);
@@ -839,7 +839,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
     // should be atomic
     portENTER_CRITICAL();
 
-    seq_core_trk_muted ^= (1 << button);
+    SEQ_CORE_TRKSET_TOGGLE(&seq_core_trk_muted, button);
 
     portEXIT_CRITICAL();
     return 0;
@@ -852,7 +852,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
 
     u8 track;
     for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track)
-      if( ui_selected_tracks & (1 << track) )
+      if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) )
 	SEQ_CC_Set(track, SEQ_CC_MIDI_CHANNEL, button);
 
     portEXIT_CRITICAL();
@@ -865,12 +865,13 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
     portENTER_CRITICAL();
 
     // allow to select an unplayed track
-    if( button >= 8 && (seq_record_state.ARMED_TRACKS & 0x00ff) )
-      seq_record_state.ARMED_TRACKS = 0xff00;
-    else if( button < 8 && (seq_record_state.ARMED_TRACKS & 0xff00) )
-      seq_record_state.ARMED_TRACKS = 0x00ff;
+    u16 armed_tracks = SEQ_CORE_TrkSetGet16(&seq_record_state.ARMED_TRACKS, 0);
+    if( button >= 8 && (armed_tracks & 0x00ff) )
+      SEQ_CORE_TrkSetSet16(&seq_record_state.ARMED_TRACKS, 0, 0xff00);
+    else if( button < 8 && (armed_tracks & 0xff00) )
+      SEQ_CORE_TrkSetSet16(&seq_record_state.ARMED_TRACKS, 0, 0x00ff);
     else {
-      seq_record_state.ARMED_TRACKS ^= (1 << button);
+      SEQ_CORE_TRKSET_TOGGLE(&seq_record_state.ARMED_TRACKS, button);
     }
 
     portEXIT_CRITICAL();
@@ -889,7 +890,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
     // (no need to select the Trigger page for doing this)
     u8 track; // only change triggers if track 0 and 8
     for(track=0; track<SEQ_CORE_NUM_TRACKS; track+=8)
-      if( seq_record_state.ARMED_TRACKS & (1 << track) ) {
+      if( SEQ_CORE_TRKSET_GET(&seq_record_state.ARMED_TRACKS, track) ) {
 	u8 *trg_ptr = (u8 *)&seq_trg_layer_value[track][2*ui_selected_step_view + (button>>3)];
 	*trg_ptr &= ~(1 << (button&7));
 
@@ -909,7 +910,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
     seq_ui_pages_tempo_presets_t *preset = (seq_ui_pages_tempo_presets_t *)&seq_ui_pages_tempo_presets[ui_selected_tempo_preset];
     u8 track;
     for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track) {
-      if( ui_selected_tracks & (1 << track) ) {
+      if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) ) {
 	seq_cc_trk_t *tcc = &seq_cc_trk[track];
 	if( (track % 8) < 3 ) {
 	  tcc->clkdiv.value = preset->clkdiv;
@@ -922,7 +923,7 @@ s32 SEQ_UI_PAGES_GP_Button_Handler(u8 button, u8 depressed)
 
     // we also request synch to measure
     // it's a good idea to do this for all tracks so that both sequences are in synch again
-    SEQ_CORE_ManualSynchToMeasure(0xffff);
+    SEQ_CORE_ManualSynchToMeasure(NULL);
 
     portEXIT_CRITICAL();
     return 0;
@@ -265,7 +265,7 @@ static s32 SEQ_UI_UTIL_UndoUpdate(void)
 #endif
 
   if( status >= 0 )
-    undo_tracks = ui_selected_tracks;
+    undo_tracks = SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0);
 
   return status;
 }
@@ -284,7 +284,7 @@ s32 SEQ_UI_UTIL_Copy(void)
 #endif
   s32 status = SEQ_UI_UTIL_WriteTracks((char *)copy_filename);
   if( status >= 0 )
-    copy_tracks = ui_selected_tracks;
+    copy_tracks = SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0);
 #if DEBUG_VERBOSE_LEVEL >= 2
   DEBUG_MSG("COPY Write End\n");
 #endif
@@ -309,7 +309,7 @@ s32 SEQ_UI_UTIL_Paste(void)
 #if DEBUG_VERBOSE_LEVEL >= 2
   DEBUG_MSG("COPY Read Begin\n");
 #endif
-  SEQ_UI_UTIL_ReadTracks((char *)copy_filename, copy_tracks, ui_selected_tracks);
+  SEQ_UI_UTIL_ReadTracks((char *)copy_filename, copy_tracks, SEQ_CORE_TrkSetGet16(&ui_selected_tracks, 0));
 #if DEBUG_VERBOSE_LEVEL >= 2
   DEBUG_MSG("COPY Read End\n");
 #endif
@@ -340,7 +340,7 @@ s32 SEQ_UI_UTIL_Clear(void)
   for(track=0;track<SEQ_CORE_NUM_TRACKS; ++track) {
     u16 track_mask = (1 << track);
 
-    if( ui_selected_tracks & track_mask ) {
+    if( SEQ_CORE_TRKSET_GET(&ui_selected_tracks, track) ) {
       // copy preset
       SEQ_LAYER_CopyPreset(track, only_layers, all_triggers_cleared, init_assignments);
     }
@@ -19,6 +19,7 @@
 
 #include <mios32.h>
 #include "app.h"
+#include "stream.h"
 #include <file.h>
 #include <string.h>
 
@@ -32,26 +33,19 @@ static void TASK_BANKSWITCH_SCAN(void *pvParameters);
 // Local definitions
 /////////////////////////////////////////////////////////////////////////////
 
-#define NUM_SAMPLES_TO_OPEN 64	// Maximum number of file handles to use, and how many samples to open
-#define POLYPHONY 8				// Max voices to sound simultaneously
-
-// Following accounts for: 7 bits (envelope decay) + 7 bits (velocity related volume) + 1-3 bits (mixing up to 8 samples but depends how hot your samples are)
-#define SAMPLE_SCALING 15        // Number of bits to scale samples down by in order to not distort - added 7 bits for midi volume now
+// NUM_SAMPLES_TO_OPEN, POLYPHONY and the mixer settings are located in stream.h
 
 #define MAX_TIME_IN_DMA 45		// Time (*0.1ms) to read sample data for, e.g. 40 = 4.0 mS
 
 #define SAMPLE_BUFFER_SIZE 512  // -> 512 L/R samples, 80 Hz refill rate (11.6~ mS period). DMA refill routine called every 5.8mS.
 // NB sample rate and SPI prescaler set in mios32_config file - at 44.1kHz, reading 2 bytes per sample is SD card average rate of 86.13kB/s for a single sample
+#if (SAMPLE_BUFFER_SIZE/2) != STREAM_FRAMES_PER_SECTOR
+# error "half of the sample buffer has to match with one sector of each voice (see stream.h)"
+#endif
 
 #define DEBUG_VERBOSE_LEVEL 10
 #define DEBUG_MSG MIOS32_MIDI_SendDebugMessage
 
-// Now mandatory to have this set as legacy read code removed
-#define CLUSTER_CACHE_SIZE 32 // typically for 32 * 64*512 bytes = max sample file length of 1 MB !!!
-
-// set to 1 to perform right channel inversion for PCM1725 DAC
-#define DAC_FIX 0
-
 // name of config file on SD card to read
 #define CONFIG_FNAME "player.cfg"
 
@@ -81,17 +75,12 @@ u8 no_samples_loaded;								// Stores number of samples we read in from bank fi
 
 static u32 sample_buffer[SAMPLE_BUFFER_SIZE]; // sample buffer used for DMA
 
-static u32 samplefile_pos[NUM_SAMPLES_TO_OPEN];	// Current position in the sample file
-static u32 samplefile_len[NUM_SAMPLES_TO_OPEN];	// Length of the sample file
 static s16 sample_on[NUM_SAMPLES_TO_OPEN];	// To track whether each sample should be on or not
 static s8 sample_vel[NUM_SAMPLES_TO_OPEN];	// Sample velocity
 static u8 sample_decay[NUM_SAMPLES_TO_OPEN];	// Sample decay parameter (used to calculate per sample, based on velocity the decrement value)
 static u8 sample_decval[NUM_SAMPLES_TO_OPEN];	// Decay time read in from bank file
 static u8 no_decay;								// Used to speed up decay routine if this bank has no decay time
 static u8 hold_sample[NUM_SAMPLES_TO_OPEN];		// Used to hold sample (for drums)
-static file_t samplefile_fileinfo[NUM_SAMPLES_TO_OPEN];	// Create the right number of file descriptors
-static u8 samplebyte_buf[POLYPHONY][SAMPLE_BUFFER_SIZE];	// Create a buffer for each voice
-static u32 sample_cluster_cache[NUM_SAMPLES_TO_OPEN][CLUSTER_CACHE_SIZE];	// Array of sample cluster positions on SD card
 
 static u8 sample_bank_no=1;	// The sample bank number being played
 static u8 switch_bank_no=1;	// The sample bank selected via switch for J10 
@@ -114,48 +103,6 @@ static const u8 velocity_curve[128] = {
 };
 
 
-// Call this routine with the sample array number to reference, and the filename to open
-s32 SAMP_FILE_open(u8 sample_n, char fname[])
-{
-  DEBUG_MSG("Filename is %s.",fname);
-  s32 status = FILE_ReadOpen(&samplefile_fileinfo[sample_n], fname);
-  FILE_ReadClose(&samplefile_fileinfo[sample_n]); // close again - file will be reopened by read handler
-
-  if( status < 0 ) {
-    DEBUG_MSG("[APP] failed to open file, status: %d\n", status);
-  } else {
-
-    // got it
-    samplefile_pos[sample_n] = 0;
-    samplefile_len[sample_n] = samplefile_fileinfo[sample_n].fsize;
-
-    DEBUG_MSG("[APP] Sample no %d filename %s opened of length %u\n", sample_n,fname,samplefile_len[sample_n]);
-  }
-  
-  return status;
-}
-
-/////////////////////////////////////////////////////////////////////////////
-// reads <len> bytes from the .mid file into <buffer>
-// returns number of read bytes
-/////////////////////////////////////////////////////////////////////////////
-int SAMP_FILE_read(void *buffer, u32 len, u8 sample_n)
-{
-  // determine sector based on sample position
-  u32 pos = samplefile_pos[sample_n];
-  u32 sector_ix = pos / 512;
-  u32 sectors_per_cluster = FILE_VolumeSectorsPerCluster();
-  u32 cluster_ix = sector_ix / sectors_per_cluster;
-  if( cluster_ix >= CLUSTER_CACHE_SIZE )
-    return -1;
-
-  u32 cluster = sample_cluster_cache[sample_n][cluster_ix];
-  u32 phys_sector = FILE_VolumeCluster2Sector(cluster) + (sector_ix % sectors_per_cluster);
-  if( MIOS32_SDCARD_SectorRead(phys_sector, buffer) < 0 )
-    return -2;
-  return len;
-}
-
 void Open_Bank(u8 b_num)	// Open the bank number passed and parse the bank information, load samples, set midi notes, number of samples and cache cluster positions
 {
   u8 samp_no;
@@ -174,6 +121,8 @@ void Open_Bank(u8 b_num)	// Open the bank number passed and parse the bank infor
   
   no_samples_loaded=0;
   no_decay=1;						// Default to no decay for bank
+
+  STREAM_Init(0);					// Release all voice buffers
   
   DEBUG_MSG("Opening bank file %s",b_file);
   if(FILE_ReadOpen(&bank_fileinfo, b_file)<0) { DEBUG_MSG("Failed to open bank file."); }
@@ -195,36 +144,10 @@ void Open_Bank(u8 b_num)	// Open the bank number passed and parse the bank infor
 		   }
 		  FILE_ReadClose(&bank_fileinfo);
 			
-		 for(samp_no=0;samp_no<no_samples_loaded;samp_no++)	// Open all sample files and mark all samples as off
+		 for(samp_no=0;samp_no<no_samples_loaded;samp_no++)	// Open all sample files (and cache their cluster positions) and mark all samples as off
 		 {
-		   if(SAMP_FILE_open(samp_no,sample_filenames[samp_no])) {
+		   if(STREAM_SampleOpen(samp_no,sample_filenames[samp_no])<0) {
 		   DEBUG_MSG("Open sample file failed.");
-		   } else {
-			 // Pre-read all the cluster positions for all samples to open
-			 u32 num_sectors_per_cluster = FILE_VolumeSectorsPerCluster();
-			 u32 cluster_ix;
-			 for(cluster_ix=0; cluster_ix < CLUSTER_CACHE_SIZE; ++cluster_ix) {
-			   u32 pos = cluster_ix*num_sectors_per_cluster*SAMPLE_BUFFER_SIZE;
-
-			   if( pos >= samplefile_len[samp_no] )
-			 break; // end of file reached
-			   else {
-			 s32 status;
-			 if( (status=FILE_ReadReOpen(&samplefile_fileinfo[samp_no])) >= 0 ) {
-			   status = FILE_ReadSeek(pos);
-			   if( status >= 0 ) {
-				 u8 dummy; // dummy read to update cluster
-				 status = FILE_ReadBuffer(&dummy, 1);
-			   }
-			   FILE_ReadClose(&samplefile_fileinfo[samp_no]);
-			 }
-			 if( status < 0 )
-			   break;
-			   }
-
-			   sample_cluster_cache[samp_no][cluster_ix] = samplefile_fileinfo[samp_no].curr_clust;
-			   DEBUG_MSG("Cluster %d: %d ", cluster_ix, sample_cluster_cache[samp_no][cluster_ix]);
-			 }
 		   }
 
 		   sample_on[samp_no]=0;	// Set sample to off
@@ -446,70 +369,31 @@ void SYNTH_ReloadSampleBuffer(u32 state)
   // Therefore for mono samples, we'll need to read in SAMPLE_BUFFER_SIZE bytes
 
   u8 voice;
-
-  s16 OutWavs16;	// 16 bit output to DAC
-  s32 OutWavs32;	// 32 bit accumulator to mix samples into
+  u32 finished_mask;	// voices which reached EOF
   u32 ms_so_far;		// used to measure time of DMA routine
 
   MIOS32_STOPWATCH_Reset();			// Reset the stopwatch at start of DMA routine
   MIOS32_BOARD_LED_Set(0x1, 0x1);	// Turn on LED at start of DMA routine
-  
 
 	// Here we have voice_no samples to play simultaneously, and the samples contained in voice_samples array
+	// Top up the read-ahead buffers of all voices (sorted by SD card position), thereafter mix one sector of each voice
+	if(STREAM_Refill(voice_no,voice_samples,MAX_TIME_IN_DMA)<0)
+	{	// voices without data will be continued next time
+	 ms_so_far= MIOS32_STOPWATCH_ValueGet();
+	 DEBUG_MSG("Read-ahead incomplete after %d.%d ms, %d voices",ms_so_far/10,ms_so_far%10,voice_no);
+	}
 
-	if(voice_no)	// if there's anything to play, read the samples and mix otherwise output silence
+	finished_mask=STREAM_Mix(buffer,voice_no,voice_samples,voice_velocity);	// Fill half the sample buffer
+	for(voice=0;voice<voice_no;voice++)
 	{
-		for(voice=0;voice<voice_no;voice++) 	// read up to SAMPLE_BUFFER_SIZE characters into buffer for each voice
+		if(finished_mask & (1<<voice)) // We've reached EOF (or a read error) - don't play this sample next time and also free up the voice
 		{
-			if(SAMP_FILE_read(samplebyte_buf[voice],SAMPLE_BUFFER_SIZE,voice_samples[voice])<0) // Read in the appropriate number of sectors for each sample thats on
-			{	// if <0 then there was an error reading, so turn this sample off and mute it
-			 sample_on[voice_samples[voice]]=0; // Turn sample off
-			 voice_velocity[voice]=0;			// Silence it in the mix as we don't have a complete buffer
-			}
-			
-			samplefile_pos[voice_samples[voice]]+=SAMPLE_BUFFER_SIZE;	// Move along the file position by the read buffer size
-			if(samplefile_pos[voice_samples[voice]] >= samplefile_len[voice_samples[voice]]) // We've reached EOF - don't play this sample next time and also free up the voice
-			{ 
-				sample_on[voice_samples[voice]]=0; // Turn sample off
-				//DEBUG_MSG("Reached EOF on sample %d",voice_samples[voice]);
-			}
-			 ms_so_far= MIOS32_STOPWATCH_ValueGet();	// Check how long we've been in the routine up until this point
-			if(ms_so_far>MAX_TIME_IN_DMA)				
-				{ 
-				 DEBUG_MSG("Abandoning DMA routine after %d.%d ms, after %d voices out of %d",ms_so_far/10,ms_so_far%10,voice+1,voice_no);
-				 voice_no=voice+1;	// don't mix un-read voices (eg if break after 1st voice, voice_no should =1)
-				 break;	// go straight to sample mixing
-				}
+			sample_on[voice_samples[voice]]=0; // Turn sample off
+			//DEBUG_MSG("Reached EOF on sample %d",voice_samples[voice]);
 		}
-
-		for(i=0; i<SAMPLE_BUFFER_SIZE; i+=2) // Fill half the sample buffer
-			{	
-				OutWavs32=0;	// zero the voice accumulator for this sample output
-				for(voice=0;voice<voice_no;voice++)
-				{
-						OutWavs32+=voice_velocity[voice]*(s16)((samplebyte_buf[voice][i+1] << 8) + samplebyte_buf[voice][i]);		// else mix it in
-				}
-				OutWavs32 = (OutWavs32>>SAMPLE_SCALING);	// Round down the wave to prevent distortion, and factor in the velocity multiply
-				if(OutWavs32>32767) { OutWavs32=32767; }	// Saturate positive
-				if(OutWavs32<-32768) { OutWavs32=-32768; }	// Saturate negative			
-				OutWavs16 = (s16)OutWavs32;					// Required to make following bit shift work correctly including sign bit
-#if DAC_FIX
-				*buffer++ = (OutWavs16 << 16) | (-OutWavs16 & 0xffff);	// make up the 32 bit word for L and R and write into buffer with fix for PCM1725 DAC
-#else
-				*buffer++ = (OutWavs16 << 16) | (OutWavs16 & 0xffff);	// make up the 32 bit word for L and R and write into buffer
-#endif
-				}
 	}
-	else	// There were no voices on
-	 {	
-	   for(i=0; i<SAMPLE_BUFFER_SIZE; i+=2) {	// Fill half the sample buffer with silence
-	   *buffer++ = 0;	// Muted output
-		}
-	 }
 
 	 MIOS32_BOARD_LED_Set(0x1, 0x0);	// Turn off LED at end of DMA routine
-	//ms_so_far= MIOS32_STOPWATCH_ValueGet();	// Check how long we've been in the routine up until this point
-	//DEBUG_MSG("%d.%d ms,%d.%d ms,%d.%d ms, %d voices",ms2_so_far/10,ms2_so_far%10,ms3_so_far/10,ms3_so_far%10,ms_so_far/10,ms_so_far%10,voice_no);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -576,7 +460,7 @@ static void TASK_VOICE_SCAN(void *pvParameters)
 						new_voice_no++;							// And increment number of voices in use
 						if(sample_on[samp_no]==-1)					// Newly triggered sample (set to -1 by midi receive routine)
 						{
-						 samplefile_pos[samp_no]=0;	// Mark at position zero (used for sector reads and EOF calculations)
+						 STREAM_SampleRestart(samp_no);	// Mark at position zero (used for sector reads and EOF calculations)
 						 sample_on[samp_no]=-2;		// Mark as on and don't retrigger on next loop
 						 }
 					}
@@ -30,6 +30,13 @@
 // avoid disk_read in FILE_ReadReOpen
 #define FILE_NO_DISK_READ_ON_READREOPEN 1
 
+// for LPC17: locate the read-ahead buffers of the voices (see stream.c) into the AHB section
+#if defined(MIOS32_FAMILY_LPC17xx)
+# define AHB_SECTION __attribute__ ((section (".bss_ahb")))
+#else
+# define AHB_SECTION
+#endif
+
 
 // I2S support has to be enabled explicitely
 #define MIOS32_USE_I2S
@@ -0,0 +1,450 @@
+// $Id$
+/*
+ * Sample streaming from SD Card
+ * (formerly part of app.c)
+ *
+ * Each playing sample owns a ring buffer of STREAM_RING_SECTORS sectors.
+ * STREAM_Refill() tops up the ring buffers within a given time budget:
+ *   - the pending reads of all voices are served in the order of their
+ *     sector positions on the card (elevator/C-SCAN), starting from the
+ *     position of the previous read
+ *   - consecutive sectors of a sample are fetched with a single multi-block
+ *     read command (MIOS32_SDCARD_SectorsRead)
+ *   - voices which would run dry at the next mix are served first,
+ *     thereafter all rings which have been drained down to the low watermark
+ * STREAM_Mix() consumes one sector of each voice and mixes it into the
+ * I2S buffer. A voice without data is skipped (it continues at the same
+ * position during the next call) instead of being cut off.
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2011 Lee O'Donnell (lee@bassmaker.co.uk)
+ *  Base software Copyright (C) 2009 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <file.h>
+#include <string.h>
+
+#include "stream.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+#define DEBUG_VERBOSE_LEVEL 10
+#define DEBUG_MSG MIOS32_MIDI_SendDebugMessage
+
+// marks an unused ring buffer
+#define RING_FREE 0xff
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u8  sample;        // sample which owns the ring, RING_FREE if not used
+  u8  error;         // set on read errors, the sample will be stopped once the ring is empty
+  u8  rd_ix;         // ring slot which will be mixed next
+  u8  num_filled;    // number of valid slots
+  u32 play_pos;      // file position of slot rd_ix
+  u8  buf[STREAM_RING_SECTORS][STREAM_SECTOR_SIZE];
+} stream_ring_t;
+
+typedef struct {
+  u32 sector;        // physical sector
+  u8  ring;
+  u8  num_sectors;
+} stream_read_req_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u32 samplefile_pos[NUM_SAMPLES_TO_OPEN];	// Current position in the sample file
+static u32 samplefile_len[NUM_SAMPLES_TO_OPEN];	// Length of the sample file
+static file_t samplefile_fileinfo[NUM_SAMPLES_TO_OPEN];	// Create the right number of file descriptors
+static u32 sample_cluster_cache[NUM_SAMPLES_TO_OPEN][CLUSTER_CACHE_SIZE];	// Array of sample cluster positions on SD card
+static u8 sample_ring[NUM_SAMPLES_TO_OPEN];	// Ring buffer assigned to the sample, RING_FREE if none
+
+static stream_ring_t ring[POLYPHONY] AHB_SECTION;
+
+static u32 head_sector;	// card position after the last read command
+static stream_stats_t stats;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Initialisation: releases all ring buffers
+// Has to be called whenever a new bank is opened, while the I2S callback
+// doesn't access the stream
+/////////////////////////////////////////////////////////////////////////////
+s32 STREAM_Init(u32 mode)
+{
+  int i;
+
+  if( mode != 0 )
+    return -1; // only mode 0 supported
+
+  for(i=0; i<POLYPHONY; ++i) {
+    ring[i].sample = RING_FREE;
+    ring[i].num_filled = 0;
+  }
+
+  memset(sample_ring, RING_FREE, sizeof(sample_ring));
+  head_sector = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Call this routine with the sample array number to reference, and the filename to open
+// The cluster positions of the file are cached, so that sectors can be read directly
+/////////////////////////////////////////////////////////////////////////////
+s32 STREAM_SampleOpen(u8 sample, char *fname)
+{
+  if( sample >= NUM_SAMPLES_TO_OPEN )
+    return -1; // invalid sample
+
+  DEBUG_MSG("Filename is %s.",fname);
+  s32 status = FILE_ReadOpen(&samplefile_fileinfo[sample], fname);
+  FILE_ReadClose(&samplefile_fileinfo[sample]); // close again - file will be reopened by read handler
+
+  samplefile_pos[sample] = 0;
+
+  if( status < 0 ) {
+    DEBUG_MSG("[APP] failed to open file, status: %d\n", status);
+    samplefile_len[sample] = 0;
+    return status;
+  }
+
+  // got it
+  samplefile_len[sample] = samplefile_fileinfo[sample].fsize;
+  DEBUG_MSG("[APP] Sample no %d filename %s opened of length %u\n", sample,fname,samplefile_len[sample]);
+
+  // Pre-read all the cluster positions
+  u32 num_sectors_per_cluster = FILE_VolumeSectorsPerCluster();
+  u32 cluster_ix;
+  for(cluster_ix=0; cluster_ix < CLUSTER_CACHE_SIZE; ++cluster_ix) {
+    u32 pos = cluster_ix*num_sectors_per_cluster*STREAM_SECTOR_SIZE;
+
+    if( pos >= samplefile_len[sample] )
+      break; // end of file reached
+
+    if( (status=FILE_ReadReOpen(&samplefile_fileinfo[sample])) >= 0 ) {
+      status = FILE_ReadSeek(pos);
+      if( status >= 0 ) {
+	u8 dummy; // dummy read to update cluster
+	status = FILE_ReadBuffer(&dummy, 1);
+      }
+      FILE_ReadClose(&samplefile_fileinfo[sample]);
+    }
+    if( status < 0 )
+      break;
+
+    sample_cluster_cache[sample][cluster_ix] = samplefile_fileinfo[sample].curr_clust;
+    DEBUG_MSG("Cluster %d: %d ", cluster_ix, sample_cluster_cache[sample][cluster_ix]);
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Restarts the sample from the beginning
+// The ring buffer will be flushed with the next refill
+/////////////////////////////////////////////////////////////////////////////
+s32 STREAM_SampleRestart(u8 sample)
+{
+  if( sample >= NUM_SAMPLES_TO_OPEN )
+    return -1; // invalid sample
+
+  samplefile_pos[sample] = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Determines the physical sector of a file position
+// *num_sectors: in: max. number of sectors, out: number of consecutive sectors
+// returns < 0 if the position isn't covered by the cluster cache
+/////////////////////////////////////////////////////////////////////////////
+static s32 STREAM_SectorGet(u8 sample, u32 pos, u32 *phys_sector, u32 *num_sectors)
+{
+  u32 sectors_per_cluster = FILE_VolumeSectorsPerCluster();
+  u32 sector_ix = pos / STREAM_SECTOR_SIZE;
+  u32 cluster_ix = sector_ix / sectors_per_cluster;
+  if( cluster_ix >= CLUSTER_CACHE_SIZE )
+    return -1;
+
+  u32 cluster = sample_cluster_cache[sample][cluster_ix];
+  u32 sector = FILE_VolumeCluster2Sector(cluster);
+  if( !sector )
+    return -2; // invalid cluster
+  *phys_sector = sector + (sector_ix % sectors_per_cluster);
+
+  // the sectors are consecutive until the end of the cluster, and continue
+  // if the next cluster follows directly on the card
+  u32 num = sectors_per_cluster - (sector_ix % sectors_per_cluster);
+  while( num < *num_sectors && ++cluster_ix < CLUSTER_CACHE_SIZE &&
+	 sample_cluster_cache[sample][cluster_ix] == (cluster+1) ) {
+    ++cluster;
+    num += sectors_per_cluster;
+  }
+
+  if( num < *num_sectors )
+    *num_sectors = num;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Reads the pending sectors of all ring buffers in the order of their
+// card positions (one read command per ring)
+// max_filled: only rings which contain less or equal sectors are served
+// returns the number of read commands, or < 0 if the time budget is exhausted
+/////////////////////////////////////////////////////////////////////////////
+static s32 STREAM_Sweep(u8 max_filled, u32 max_time)
+{
+  stream_read_req_t req[POLYPHONY];
+  int num_req = 0;
+  int i, j;
+
+  // collect the read requests
+  for(i=0; i<POLYPHONY; ++i) {
+    stream_ring_t *r = &ring[i];
+
+    if( r->sample == RING_FREE || r->error || r->num_filled > max_filled )
+      continue;
+
+    u32 fetch_pos = r->play_pos + r->num_filled * STREAM_SECTOR_SIZE;
+    u32 len = samplefile_len[r->sample];
+    if( fetch_pos >= len )
+      continue; // end of file reached
+
+    // an empty ring can be filled from the first slot
+    if( !r->num_filled )
+      r->rd_ix = 0;
+
+    // free consecutive slots until the end of the ring, and remaining sectors of the file
+    u32 wr_ix = r->rd_ix + r->num_filled;
+    if( wr_ix >= STREAM_RING_SECTORS )
+      wr_ix -= STREAM_RING_SECTORS;
+    u32 num_sectors = (wr_ix < r->rd_ix) ? (r->rd_ix - wr_ix) : (STREAM_RING_SECTORS - wr_ix);
+    u32 file_sectors = (len - fetch_pos + STREAM_SECTOR_SIZE - 1) / STREAM_SECTOR_SIZE;
+    if( num_sectors > file_sectors )
+      num_sectors = file_sectors;
+
+    u32 sector;
+    if( STREAM_SectorGet(r->sample, fetch_pos, &sector, &num_sectors) < 0 ) {
+      r->error = 1; // beyond cluster cache
+      continue;
+    }
+
+    // insertion sort by sector
+    for(j=num_req; j>0 && req[j-1].sector > sector; --j)
+      req[j] = req[j-1];
+    req[j].sector = sector;
+    req[j].ring = i;
+    req[j].num_sectors = num_sectors;
+    ++num_req;
+  }
+
+  if( !num_req )
+    return 0;
+
+  // continue at the current card position, wrap around at the end
+  int start;
+  for(start=0; start<num_req && req[start].sector < head_sector; ++start);
+
+  for(i=0; i<num_req; ++i) {
+    stream_read_req_t *q = &req[(start + i) % num_req];
+    stream_ring_t *r = &ring[q->ring];
+
+    // limit the number of sectors to the remaining time
+    u32 time = MIOS32_STOPWATCH_ValueGet();
+    if( time >= max_time )
+      return -1;
+    u32 max_sectors = (max_time - time) / STREAM_SECTOR_READ_TIME;
+    if( !max_sectors )
+      return -1;
+    u32 num_sectors = (q->num_sectors > max_sectors) ? max_sectors : q->num_sectors;
+
+    u32 wr_ix = r->rd_ix + r->num_filled;
+    if( wr_ix >= STREAM_RING_SECTORS )
+      wr_ix -= STREAM_RING_SECTORS;
+
+    ++stats.read_cmds;
+    if( q->sector != head_sector )
+      ++stats.seeks;
+
+    if( MIOS32_SDCARD_SectorsRead(q->sector, r->buf[wr_ix], num_sectors) < 0 ) {
+      ++stats.read_errors;
+      r->error = 1;
+    } else {
+      stats.read_sectors += num_sectors;
+      r->num_filled += num_sectors;
+    }
+
+    head_sector = q->sector + num_sectors;
+  }
+
+  return num_req;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Assigns the ring buffers to the voices and fills them
+// Should be called before STREAM_Mix() with the same voices
+// max_time: time budget (*0.1ms, measured with MIOS32_STOPWATCH)
+// returns < 0 if voices couldn't be served within the time budget
+/////////////////////////////////////////////////////////////////////////////
+s32 STREAM_Refill(u8 num_voices, const u8 *voice_samples, u32 max_time)
+{
+  u32 used_mask = 0;
+  int voice, i;
+
+  ++stats.refills;
+
+  // release the rings of samples which are not played anymore
+  for(voice=0; voice<num_voices; ++voice) {
+    u8 r = sample_ring[voice_samples[voice]];
+    if( r != RING_FREE )
+      used_mask |= (1 << r);
+  }
+
+  for(i=0; i<POLYPHONY; ++i) {
+    if( ring[i].sample != RING_FREE && !(used_mask & (1 << i)) ) {
+      sample_ring[ring[i].sample] = RING_FREE;
+      ring[i].sample = RING_FREE;
+    }
+  }
+
+  // assign rings to new voices, and flush the rings of retriggered samples
+  for(voice=0; voice<num_voices; ++voice) {
+    u8 sample = voice_samples[voice];
+    u8 r = sample_ring[sample];
+
+    if( r == RING_FREE ) {
+      for(r=0; r<POLYPHONY && ring[r].sample != RING_FREE; ++r);
+      if( r >= POLYPHONY )
+	continue; // no free ring (more voices than POLYPHONY?)
+      ring[r].sample = sample;
+      sample_ring[sample] = r;
+    } else if( ring[r].play_pos == samplefile_pos[sample] ) {
+      continue; // ring still valid
+    }
+
+    ring[r].error = 0;
+    ring[r].rd_ix = 0;
+    ring[r].num_filled = 0;
+    ring[r].play_pos = samplefile_pos[sample];
+  }
+
+  // first serve the voices which would run dry, thereafter top up the rings
+  // which reached the low watermark until the time budget is exhausted
+  if( STREAM_Sweep(0, max_time) < 0 ) {
+    ++stats.timeouts;
+    return -1;
+  }
+
+  while( STREAM_Sweep(STREAM_LOW_WATERMARK, max_time) > 0 );
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Mixes one sector of each voice into STREAM_FRAMES_PER_SECTOR L/R words of
+// the I2S buffer
+// returns a mask of voices which reached the end of the sample (or failed),
+// they should be turned off
+/////////////////////////////////////////////////////////////////////////////
+u32 STREAM_Mix(u32 *buffer, u8 num_voices, const u8 *voice_samples, const s16 *voice_velocity)
+{
+  u8 *voice_buf[POLYPHONY];
+  s16 mix_velocity[POLYPHONY];
+  u8 num_mixed = 0;
+  u32 finished_mask = 0;
+  int voice, i;
+
+  for(voice=0; voice<num_voices && num_mixed<POLYPHONY; ++voice) {
+    u8 sample = voice_samples[voice];
+    u8 r = sample_ring[sample];
+
+    if( samplefile_pos[sample] >= samplefile_len[sample] ) {
+      finished_mask |= (1 << voice);
+      continue;
+    }
+
+    if( r == RING_FREE || ring[r].play_pos != samplefile_pos[sample] || !ring[r].num_filled ) {
+      if( r != RING_FREE && ring[r].error )
+	finished_mask |= (1 << voice); // read error: turn sample off
+      else
+	++stats.underruns; // no data yet: continue at the same position next time
+      continue;
+    }
+
+    // consume the sector
+    stream_ring_t *rp = &ring[r];
+    voice_buf[num_mixed] = rp->buf[rp->rd_ix];
+    mix_velocity[num_mixed] = voice_velocity[voice];
+    ++num_mixed;
+
+    if( ++rp->rd_ix >= STREAM_RING_SECTORS )
+      rp->rd_ix = 0;
+    --rp->num_filled;
+    rp->play_pos += STREAM_SECTOR_SIZE;
+    samplefile_pos[sample] = rp->play_pos;
+
+    if( samplefile_pos[sample] >= samplefile_len[sample] ) // We've reached EOF - don't play this sample next time and also free up the voice
+      finished_mask |= (1 << voice);
+  }
+
+  for(i=0; i<STREAM_SECTOR_SIZE; i+=2) { // Fill half the sample buffer
+    s32 OutWavs32 = 0; // zero the voice accumulator for this sample output
+    for(voice=0; voice<num_mixed; ++voice) {
+      OutWavs32 += mix_velocity[voice]*(s16)((voice_buf[voice][i+1] << 8) + voice_buf[voice][i]); // mix it in
+    }
+    OutWavs32 = (OutWavs32>>SAMPLE_SCALING);	// Round down the wave to prevent distortion, and factor in the velocity multiply
+    if(OutWavs32>32767) { OutWavs32=32767; }	// Saturate positive
+    if(OutWavs32<-32768) { OutWavs32=-32768; }	// Saturate negative
+    s16 OutWavs16 = (s16)OutWavs32;		// Required to make following bit shift work correctly including sign bit
+#if DAC_FIX
+    *buffer++ = (OutWavs16 << 16) | (-OutWavs16 & 0xffff);	// make up the 32 bit word for L and R and write into buffer with fix for PCM1725 DAC
+#else
+    *buffer++ = (OutWavs16 << 16) | (OutWavs16 & 0xffff);	// make up the 32 bit word for L and R and write into buffer
+#endif
+  }
+
+  return finished_mask;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Streaming statistics
+/////////////////////////////////////////////////////////////////////////////
+s32 STREAM_StatsGet(stream_stats_t *s)
+{
+  *s = stats;
+  return 0; // no error
+}
+
+s32 STREAM_StatsClear(void)
+{
+  memset(&stats, 0, sizeof(stats));
+  return 0; // no error
+}
@@ -0,0 +1,107 @@
+// $Id$
+/*
+ * Header file for sample streaming from SD Card
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2011 Lee O'Donnell (lee@bassmaker.co.uk)
+ *  Base software Copyright (C) 2009 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _STREAM_H
+#define _STREAM_H
+
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+#define NUM_SAMPLES_TO_OPEN 64	// Maximum number of file handles to use, and how many samples to open
+
+// Max voices to sound simultaneously, and the time which is read ahead for each voice
+// (can be overruled in mios32_config.h)
+#ifndef POLYPHONY
+# if defined(MIOS32_FAMILY_STM32F4xx) || defined(MIOS32_FAMILY_EMULATION)
+#  define POLYPHONY 16
+# else
+#  define POLYPHONY 8
+# endif
+#endif
+
+#ifndef STREAM_READ_AHEAD_MS
+# if defined(MIOS32_FAMILY_STM32F4xx) || defined(MIOS32_FAMILY_EMULATION)
+#  define STREAM_READ_AHEAD_MS 30
+# else
+#  define STREAM_READ_AHEAD_MS 12
+# endif
+#endif
+
+// Now mandatory to have this set as legacy read code removed
+#define CLUSTER_CACHE_SIZE 32 // typically for 32 * 64*512 bytes = max sample file length of 1 MB !!!
+
+// Each voice consumes one sector (256 mono 16bit samples) per half I2S buffer
+#define STREAM_SECTOR_SIZE 512
+#define STREAM_FRAMES_PER_SECTOR (STREAM_SECTOR_SIZE/2)
+
+// Ring buffer depth of each voice: the read-ahead time converted into sectors based on the playback rate,
+// +1 for rounding and +1 for the sector which is mixed
+// e.g. 30 mS at 44.1kHz -> 7 sectors
+#define STREAM_RING_SECTORS (((STREAM_READ_AHEAD_MS * MIOS32_I2S_AUDIO_FREQ) / (1000 * STREAM_FRAMES_PER_SECTOR)) + 2)
+
+// Rings are only topped up once they have been drained down to this number of sectors,
+// so that they are refilled with multi-block reads instead of a single sector each period
+#ifndef STREAM_LOW_WATERMARK
+#define STREAM_LOW_WATERMARK ((STREAM_RING_SECTORS-1)/2)
+#endif
+
+// Worst case time (*0.1ms) to read a single sector, used to keep multi-block reads within the time budget
+#define STREAM_SECTOR_READ_TIME 5
+
+// Following accounts for: 7 bits (envelope decay) + 7 bits (velocity related volume) + 1-3 bits (mixing up to 8 samples but depends how hot your samples are)
+#define SAMPLE_SCALING 15        // Number of bits to scale samples down by in order to not distort - added 7 bits for midi volume now
+
+// set to 1 to perform right channel inversion for PCM1725 DAC
+#ifndef DAC_FIX
+#define DAC_FIX 0
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global Types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u32 refills;       // number of STREAM_Refill() calls
+  u32 timeouts;      // refills which ran out of time before all voices got data
+  u32 underruns;     // voices which couldn't be mixed since their ring buffer was empty
+  u32 read_cmds;     // number of read commands sent to the SD Card
+  u32 read_sectors;  // number of sectors read
+  u32 read_errors;   // number of failed read commands
+  u32 seeks;         // read commands which didn't continue at the previous card position
+} stream_stats_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern s32 STREAM_Init(u32 mode);
+
+extern s32 STREAM_SampleOpen(u8 sample, char *fname);
+extern s32 STREAM_SampleRestart(u8 sample);
+
+extern s32 STREAM_Refill(u8 num_voices, const u8 *voice_samples, u32 max_time);
+extern u32 STREAM_Mix(u32 *buffer, u8 num_voices, const u8 *voice_samples, const s16 *voice_velocity);
+
+extern s32 STREAM_StatsGet(stream_stats_t *stats);
+extern s32 STREAM_StatsClear(void);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Export global variables
+/////////////////////////////////////////////////////////////////////////////
+
+#endif /* _STREAM_H */
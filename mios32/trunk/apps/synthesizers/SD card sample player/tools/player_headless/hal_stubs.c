@@ -0,0 +1,319 @@
+// $Id$
+/*
+ * Stub MIOS32 HAL for the headless build
+ *
+ * Only the functions which are used by the streaming engine, the FILE
+ * module and FatFs are available:
+ *   - MIOS32_SDCARD accesses an image file. Each read command advances
+ *     a virtual clock by the simulated access time of the card, so that
+ *     the time budget of STREAM_Refill() behaves like on the target
+ *   - MIOS32_STOPWATCH measures the virtual clock
+ *   - MIOS32_MIDI_SendDebugMessage prints to stderr (if enabled)
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include <mios32.h>
+#include <ff.h>
+
+#include "hal_stubs.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u32 time_us;
+
+static FILE *sdcard_image;
+static u32 sdcard_num_sectors;
+static u32 sdcard_next_sector;
+static u8  sdcard_timing_enabled;
+static u32 sdcard_cmd_us = HAL_STUBS_SDCARD_CMD_US;
+static u32 sdcard_sector_us = HAL_STUBS_SDCARD_SECTOR_US;
+static u32 sdcard_seek_us = HAL_STUBS_SDCARD_SEEK_US;
+
+static u8 debug_enabled;
+
+static u32 stopwatch_start_us;
+static u32 stopwatch_resolution = 1;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Initialisation
+/////////////////////////////////////////////////////////////////////////////
+s32 HAL_STUBS_Init(u32 mode)
+{
+  if( mode != 0 )
+    return -1; // only mode 0 supported
+
+  time_us = 0;
+  sdcard_next_sector = 0;
+  sdcard_timing_enabled = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Virtual clock
+/////////////////////////////////////////////////////////////////////////////
+
+u32 HAL_STUBS_TimeGet_uS(void)
+{
+  return time_us;
+}
+
+s32 HAL_STUBS_TimeSet_uS(u32 time)
+{
+  time_us = time;
+  return 0; // no error
+}
+
+s32 HAL_STUBS_DebugSet(u8 enable)
+{
+  debug_enabled = enable;
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// SD Card image
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Opens the image file, if create_mb != 0, a new (empty) image with the
+// given size will be created
+// The number of sectors is rounded down to a multiple of 1024, because
+// the size is reported via the CSD of a SD V2 card
+/////////////////////////////////////////////////////////////////////////////
+s32 HAL_STUBS_SDCardImageOpen(const char *path, u32 create_mb)
+{
+  HAL_STUBS_SDCardImageClose();
+
+  if( create_mb ) {
+    if( (sdcard_image=fopen(path, "w+b")) == NULL )
+      return -1; // can't create file
+
+    if( ftruncate(fileno(sdcard_image), (off_t)create_mb * 1024 * 1024) < 0 ) {
+      HAL_STUBS_SDCardImageClose();
+      return -2; // can't resize file
+    }
+  } else {
+    if( (sdcard_image=fopen(path, "r+b")) == NULL )
+      return -1; // file doesn't exist
+  }
+
+  fseeko(sdcard_image, 0, SEEK_END);
+  sdcard_num_sectors = (u32)(ftello(sdcard_image) / 512) & ~(u32)(1024-1);
+
+  if( sdcard_num_sectors < 1024 ) {
+    HAL_STUBS_SDCardImageClose();
+    return -3; // image too small
+  }
+
+  return 0; // no error
+}
+
+s32 HAL_STUBS_SDCardImageClose(void)
+{
+  if( sdcard_image ) {
+    fclose(sdcard_image);
+    sdcard_image = NULL;
+  }
+  sdcard_num_sectors = 0;
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Formats the image with a FAT file system
+// has to be called before the file system is mounted by FILE_CheckSDCard()
+/////////////////////////////////////////////////////////////////////////////
+s32 HAL_STUBS_SDCardImageFormat(void)
+{
+  FATFS fs;
+  FRESULT res;
+
+  if( !sdcard_image )
+    return -1; // no image
+
+  if( (res=f_mount(0, &fs)) != FR_OK )
+    return -2;
+
+  res = f_mkfs(0, 1, 32768); // SFD, 32k clusters like on most SD Cards (CLUSTER_CACHE_SIZE covers 1 MB)
+  f_mount(0, NULL);
+
+  return (res == FR_OK) ? 0 : -3;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Access times which are added to the virtual clock by read commands
+/////////////////////////////////////////////////////////////////////////////
+s32 HAL_STUBS_SDCardTimingSet(u32 cmd_us, u32 sector_us, u32 seek_us)
+{
+  sdcard_cmd_us = cmd_us;
+  sdcard_sector_us = sector_us;
+  sdcard_seek_us = seek_us;
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// The access times are only simulated while enabled (e.g. not while the
+// samples are opened)
+/////////////////////////////////////////////////////////////////////////////
+s32 HAL_STUBS_SDCardTimingEnable(u8 enable)
+{
+  sdcard_timing_enabled = enable;
+  return 0; // no error
+}
+
+static s32 HAL_STUBS_SDCardRead(u32 sector, u8 *buffer, u32 num_sectors)
+{
+  if( !sdcard_image || (sector + num_sectors) > sdcard_num_sectors )
+    return -1;
+
+  if( fseeko(sdcard_image, (off_t)sector * 512, SEEK_SET) < 0 ||
+      fread(buffer, 512, num_sectors, sdcard_image) != num_sectors )
+    return -2;
+
+  if( sdcard_timing_enabled ) {
+    time_us += sdcard_cmd_us + num_sectors * sdcard_sector_us;
+    if( sector != sdcard_next_sector )
+      time_us += sdcard_seek_us;
+  }
+  sdcard_next_sector = sector + num_sectors;
+
+  return 0; // no error
+}
+
+s32 MIOS32_SDCARD_Init(u32 mode)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_SDCARD_CheckAvailable(u8 was_available)
+{
+  return sdcard_image != NULL;
+}
+
+s32 MIOS32_SDCARD_SectorRead(u32 sector, u8 *buffer)
+{
+  return HAL_STUBS_SDCardRead(sector, buffer, 1);
+}
+
+s32 MIOS32_SDCARD_SectorsRead(u32 sector, u8 *buffer, u32 num_sectors)
+{
+  return HAL_STUBS_SDCardRead(sector, buffer, num_sectors);
+}
+
+s32 MIOS32_SDCARD_SectorWrite(u32 sector, u8 *buffer)
+{
+  if( !sdcard_image || sector >= sdcard_num_sectors )
+    return -1;
+
+  if( fseeko(sdcard_image, (off_t)sector * 512, SEEK_SET) < 0 ||
+      fwrite(buffer, 512, 1, sdcard_image) != 1 )
+    return -2;
+
+  return 0; // no error
+}
+
+s32 MIOS32_SDCARD_CIDRead(mios32_sdcard_cid_t *cid)
+{
+  memset(cid, 0, sizeof(mios32_sdcard_cid_t));
+  strcpy(cid->ProdName, "IMAGE");
+  return 0; // no error
+}
+
+s32 MIOS32_SDCARD_CSDRead(mios32_sdcard_csd_t *csd)
+{
+  memset(csd, 0, sizeof(mios32_sdcard_csd_t));
+
+  if( !sdcard_image )
+    return -1;
+
+  // SD V2: sectors = (DeviceSize+1) << 10
+  csd->CSDStruct = 1;
+  csd->DeviceSize = (sdcard_num_sectors >> 10) - 1;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32_STOPWATCH: measures the virtual clock
+/////////////////////////////////////////////////////////////////////////////
+
+s32 MIOS32_STOPWATCH_Init(u32 resolution)
+{
+  stopwatch_resolution = resolution ? resolution : 1;
+  return MIOS32_STOPWATCH_Reset();
+}
+
+s32 MIOS32_STOPWATCH_Reset(void)
+{
+  stopwatch_start_us = time_us;
+  return 0; // no error
+}
+
+u32 MIOS32_STOPWATCH_ValueGet(void)
+{
+  return (time_us - stopwatch_start_us) / stopwatch_resolution;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32_MIDI
+/////////////////////////////////////////////////////////////////////////////
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  if( debug_enabled ) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+  }
+
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendSysEx(mios32_midi_port_t port, u8 *stream, u32 count)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugStringHeader(mios32_midi_port_t port, char command, char first_byte)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugStringBody(mios32_midi_port_t port, char *str_from_second_byte, u32 len)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugStringFooter(mios32_midi_port_t port)
+{
+  return 0; // no error
+}
@@ -0,0 +1,50 @@
+// $Id$
+/*
+ * Stub MIOS32 HAL for the headless build
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HAL_STUBS_H
+#define _HAL_STUBS_H
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// default access times of the emulated SD Card
+// a single sector read takes ca. 500 uS on the target (see mios32_sdcard.c)
+#define HAL_STUBS_SDCARD_CMD_US    300  // command + access latency of a read command
+#define HAL_STUBS_SDCARD_SECTOR_US 200  // transfer of 512 bytes + CRC
+#define HAL_STUBS_SDCARD_SEEK_US     0  // additional latency if a read doesn't continue the previous one
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern s32 HAL_STUBS_Init(u32 mode);
+
+extern s32 HAL_STUBS_SDCardImageOpen(const char *path, u32 create_mb);
+extern s32 HAL_STUBS_SDCardImageClose(void);
+extern s32 HAL_STUBS_SDCardImageFormat(void);
+extern s32 HAL_STUBS_SDCardTimingSet(u32 cmd_us, u32 sector_us, u32 seek_us);
+extern s32 HAL_STUBS_SDCardTimingEnable(u8 enable);
+
+extern u32 HAL_STUBS_TimeGet_uS(void);
+extern s32 HAL_STUBS_TimeSet_uS(u32 time);
+
+extern s32 HAL_STUBS_DebugSet(u8 enable);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Export global variables
+/////////////////////////////////////////////////////////////////////////////
+
+#endif /* _HAL_STUBS_H */
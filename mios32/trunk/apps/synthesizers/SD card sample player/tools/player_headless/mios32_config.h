@@ -0,0 +1,32 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the headless build
+ *
+ * Only the switches which are relevant for the streaming engine are
+ * taken over from ../../mios32_config.h
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// same sampling rate like on the target
+#define MIOS32_I2S_AUDIO_FREQ   44100
+
+// avoid disk_read in FILE_ReadReOpen
+#define FILE_NO_DISK_READ_ON_READREOPEN 1
+
+// no special memory sections
+#define AHB_SECTION
+
+// POLYPHONY and STREAM_READ_AHEAD_MS can be overruled from the command line of make, e.g.
+//   make clean; make CFLAGS_EXTRA="-DPOLYPHONY=8 -DSTREAM_READ_AHEAD_MS=12"
+// otherwise the STM32F4 settings are used (see stream.h)
+
+#endif /* _MIOS32_CONFIG_H */
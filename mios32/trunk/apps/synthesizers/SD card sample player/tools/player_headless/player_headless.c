@@ -0,0 +1,373 @@
+// $Id$
+/*
+ * Headless SD card sample player for Linux
+ *
+ * Runs the streaming engine (stream.c) of the sample player without
+ * hardware:
+ *   - the SD Card is emulated by an image file, FatFs and the FILE module
+ *     are used unmodified to open the bank and the samples
+ *   - optionally the files of a host directory (bank files and samples)
+ *     are imported into the image
+ *   - the samples of the bank are triggered one after another with a
+ *     given delay, and played until they end (or for a given time)
+ *   - the I2S callback is emulated: each period of 256 samples
+ *     STREAM_Refill() and STREAM_Mix() are called like in
+ *     SYNTH_ReloadSampleBuffer(). The read commands advance a virtual
+ *     clock by the simulated access times of the card, so that the time
+ *     budget and underruns behave like on the target
+ *   - the mixed output can be written into a raw file (16bit stereo,
+ *     little endian, 44.1 kHz)
+ *   - at the end the streaming statistics are reported
+ *
+ * ==========================================================================
+ *
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <mios32.h>
+#include <file.h>
+
+#include "stream.h"
+#include "hal_stubs.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// same like in app.c
+#define MAX_TIME_IN_DMA 45		// Time (*0.1ms) to read sample data for, e.g. 40 = 4.0 mS
+
+// duration of one I2S period (half buffer) in uS
+#define PERIOD_US ((STREAM_FRAMES_PER_SECTOR * 1000000) / MIOS32_I2S_AUDIO_FREQ)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Parameters (can be changed from command line)
+/////////////////////////////////////////////////////////////////////////////
+
+static char *image_path = NULL;
+static u32   image_create_mb = 0;
+static char *import_dir = NULL;
+static u32   bank_no = 1;
+static u32   num_triggers = 0;
+static u32   trigger_delay_ms = 0;
+static u32   play_length_ms = 0;
+static u32   max_time = MAX_TIME_IN_DMA;
+static FILE *out_file = NULL;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u8  num_samples;
+static u8  sample_on[NUM_SAMPLES_TO_OPEN];
+static u32 sample_trigger_period[NUM_SAMPLES_TO_OPEN];
+
+static u32 sample_buffer[STREAM_FRAMES_PER_SECTOR];
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Copies all files of a host directory into the root directory
+/////////////////////////////////////////////////////////////////////////////
+static s32 DirImport(char *dir)
+{
+  DIR *d;
+  struct dirent *de;
+  s32 num_files = 0;
+
+  if( (d=opendir(dir)) == NULL ) {
+    perror(dir);
+    return -1;
+  }
+
+  while( (de=readdir(d)) != NULL ) {
+    char host_path[1024];
+    struct stat st;
+
+    snprintf(host_path, sizeof(host_path), "%s/%s", dir, de->d_name);
+    if( stat(host_path, &st) < 0 || !S_ISREG(st.st_mode) )
+      continue;
+
+    // no LFN support: only 8.3 filenames
+    char *ext = strrchr(de->d_name, '.');
+    size_t base_len = ext ? (size_t)(ext - de->d_name) : strlen(de->d_name);
+    if( base_len == 0 || base_len > 8 || (ext && strlen(ext) > 4) ) {
+      fprintf(stderr, "WARNING: skipped %s (no 8.3 filename)\n", de->d_name);
+      continue;
+    }
+
+    char filepath[20];
+    char *p;
+    sprintf(filepath, "%s", de->d_name);
+    for(p=filepath; *p; ++p)
+      *p = toupper((unsigned char)*p);
+
+    FILE *f;
+    u8 *buffer;
+    if( (f=fopen(host_path, "rb")) == NULL || (buffer=malloc(st.st_size + 1)) == NULL ) {
+      perror(host_path);
+      if( f ) fclose(f);
+      continue;
+    }
+
+    size_t len = fread(buffer, 1, st.st_size, f);
+    fclose(f);
+
+    s32 status;
+    if( (status=FILE_WriteOpen(filepath, 1)) >= 0 ) {
+      status = FILE_WriteBuffer(buffer, len);
+      FILE_WriteClose();
+    }
+    free(buffer);
+
+    if( status < 0 ) {
+      fprintf(stderr, "ERROR: failed to write %s (status %d)\n", filepath, (int)status);
+      closedir(d);
+      return -3;
+    }
+
+    ++num_files;
+  }
+
+  closedir(d);
+
+  return num_files;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Opens the bank file and all samples (same format like in app.c)
+/////////////////////////////////////////////////////////////////////////////
+static s32 BankOpen(u32 b_num)
+{
+  static file_t bank_fileinfo;
+  char b_file[13];
+  u8 f_line[63];
+  static char sample_filenames[NUM_SAMPLES_TO_OPEN][30];
+  int i;
+
+  sprintf(b_file, "bank.%u", (unsigned)b_num);
+
+  STREAM_Init(0);
+
+  num_samples = 0;
+  if( FILE_ReadOpen(&bank_fileinfo, b_file) < 0 ) {
+    fprintf(stderr, "ERROR: failed to open bank file %s\n", b_file);
+    return -1;
+  }
+
+  while( num_samples < NUM_SAMPLES_TO_OPEN && FILE_ReadLine(f_line, 63) ) {
+    char *p;
+    size_t len = strnlen((char *)(f_line+12), sizeof(sample_filenames[0])-1);
+    memcpy(sample_filenames[num_samples], f_line+12, len);
+    sample_filenames[num_samples][len] = 0;
+    for(p=sample_filenames[num_samples]; *p; ++p) {
+      if( *p == '\r' || *p == '\n' ) {
+	*p = 0;
+	break;
+      }
+    }
+    ++num_samples;
+  }
+  FILE_ReadClose(&bank_fileinfo);
+
+  for(i=0; i<num_samples; ++i) {
+    if( STREAM_SampleOpen(i, sample_filenames[i]) < 0 )
+      fprintf(stderr, "WARNING: failed to open sample %s\n", sample_filenames[i]);
+  }
+
+  return num_samples;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int opt;
+  s32 status;
+  u32 cmd_us = HAL_STUBS_SDCARD_CMD_US;
+  u32 sector_us = HAL_STUBS_SDCARD_SECTOR_US;
+  u32 seek_us = HAL_STUBS_SDCARD_SEEK_US;
+
+  while( (opt=getopt(argc, argv, "i:c:s:b:n:d:l:m:o:L:S:K:v")) != -1 ) {
+    switch( opt ) {
+    case 'i': image_path = optarg; break;
+    case 'c': image_create_mb = atoi(optarg); break;
+    case 's': import_dir = optarg; break;
+    case 'b': bank_no = atoi(optarg); break;
+    case 'n': num_triggers = atoi(optarg); break;
+    case 'd': trigger_delay_ms = atoi(optarg); break;
+    case 'l': play_length_ms = atoi(optarg); break;
+    case 'm': max_time = atoi(optarg); break;
+    case 'L': cmd_us = atoi(optarg); break;
+    case 'S': sector_us = atoi(optarg); break;
+    case 'K': seek_us = atoi(optarg); break;
+    case 'o':
+      if( (out_file=fopen(optarg, "wb")) == NULL ) {
+	perror(optarg);
+	return 1;
+      }
+      break;
+    case 'v': HAL_STUBS_DebugSet(1); break;
+    default:
+      fprintf(stderr, "Usage: %s -i <image> [-c <create_mb>] [-s <sample_dir>] [-b <bank>] [-n <num_samples>] [-d <delay_ms>] [-l <length_ms>] [-m <max_time>] [-L <cmd_us>] [-S <sector_us>] [-K <seek_us>] [-o <out.raw>] [-v]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if( image_path == NULL ) {
+    fprintf(stderr, "ERROR: no SD Card image specified (-i)!\n");
+    return 1;
+  }
+
+  HAL_STUBS_Init(0);
+  HAL_STUBS_SDCardTimingSet(cmd_us, sector_us, seek_us);
+
+  if( (status=HAL_STUBS_SDCardImageOpen(image_path, image_create_mb)) < 0 ) {
+    fprintf(stderr, "ERROR: can't open image %s (status %d)\n", image_path, (int)status);
+    return 1;
+  }
+
+  if( image_create_mb && (status=HAL_STUBS_SDCardImageFormat()) < 0 ) {
+    fprintf(stderr, "ERROR: failed to format image (status %d)\n", (int)status);
+    return 1;
+  }
+
+  FILE_Init(0);
+  MIOS32_STOPWATCH_Init(100); // same resolution like in APP_Init()
+
+  if( FILE_CheckSDCard() != 1 || !FILE_VolumeAvailable() ) {
+    fprintf(stderr, "ERROR: image doesn't contain a valid FAT!\n");
+    return 1;
+  }
+
+  if( import_dir ) {
+    if( (status=DirImport(import_dir)) < 0 )
+      return 1;
+    printf("Imported %d files\n", (int)status);
+  }
+
+  if( BankOpen(bank_no) <= 0 )
+    return 1;
+
+  if( !num_triggers || num_triggers > num_samples )
+    num_triggers = num_samples;
+
+  {
+    int i;
+    for(i=0; i<num_triggers; ++i)
+      sample_trigger_period[i] = ((unsigned long long)i * trigger_delay_ms * 1000) / PERIOD_US;
+  }
+
+  // emulate the I2S callback
+  u32 num_periods = play_length_ms ? (((unsigned long long)play_length_ms * 1000) / PERIOD_US) : 0xffffffff;
+  u32 period;
+  u32 num_triggered = 0;
+  u32 max_voices = 0;
+  u32 num_mixed = 0;
+  u32 num_late = 0;
+  u32 sum_time = 0;
+  u32 max_time_measured = 0;
+
+  STREAM_StatsClear();
+  HAL_STUBS_SDCardTimingEnable(1);
+
+  for(period=0; period<num_periods; ++period) {
+    u8 voice_samples[POLYPHONY];
+    s16 voice_velocity[POLYPHONY];
+    u8 voice_no = 0;
+    int i;
+
+    // trigger samples
+    while( num_triggered < num_triggers && sample_trigger_period[num_triggered] <= period ) {
+      sample_on[num_triggered] = 1;
+      STREAM_SampleRestart(num_triggered);
+      ++num_triggered;
+    }
+
+    if( !play_length_ms && num_triggered >= num_triggers ) {
+      for(i=0; i<num_samples && !sample_on[i]; ++i);
+      if( i >= num_samples )
+	break; // all samples finished
+    }
+
+    // voice allocation like TASK_VOICE_SCAN: lowest sample number has priority
+    for(i=0; i<num_samples && voice_no < POLYPHONY; ++i) {
+      if( sample_on[i] ) {
+	voice_samples[voice_no] = i;
+	voice_velocity[voice_no] = 127*127; // max. velocity * midi volume
+	++voice_no;
+      }
+    }
+    if( voice_no > max_voices )
+      max_voices = voice_no;
+
+    // like SYNTH_ReloadSampleBuffer()
+    HAL_STUBS_TimeSet_uS(period * PERIOD_US);
+    MIOS32_STOPWATCH_Reset();
+
+    STREAM_Refill(voice_no, voice_samples, max_time);
+    u32 finished_mask = STREAM_Mix(sample_buffer, voice_no, voice_samples, voice_velocity);
+    for(i=0; i<voice_no; ++i) {
+      if( finished_mask & (1 << i) )
+	sample_on[voice_samples[i]] = 0;
+    }
+    num_mixed += voice_no;
+
+    u32 time = HAL_STUBS_TimeGet_uS() - period * PERIOD_US;
+    sum_time += time;
+    if( time > max_time_measured )
+      max_time_measured = time;
+    if( time > PERIOD_US )
+      ++num_late; // the DMA would output the previous buffer again
+
+    if( out_file ) {
+      // 16bit stereo, little endian
+      for(i=0; i<STREAM_FRAMES_PER_SECTOR; ++i) {
+	u32 w = sample_buffer[i];
+	u8 b[4] = { (w >> 16) & 0xff, (w >> 24) & 0xff, w & 0xff, (w >> 8) & 0xff };
+	fwrite(b, 4, 1, out_file);
+      }
+    }
+  }
+
+  stream_stats_t stats;
+  STREAM_StatsGet(&stats);
+
+  printf("Bank %u: %u samples triggered, %u periods (%u mS), polyphony %d, max. %u voices, %d sectors read-ahead\n",
+	 (unsigned)bank_no, (unsigned)num_triggered, (unsigned)period, (unsigned)(((unsigned long long)period * PERIOD_US) / 1000),
+	 POLYPHONY, (unsigned)max_voices, STREAM_RING_SECTORS);
+  printf("Underruns: %u of %u voice periods, %u timeouts, %u late periods\n",
+	 (unsigned)stats.underruns, (unsigned)num_mixed, (unsigned)stats.timeouts, (unsigned)num_late);
+  printf("Reads: %u commands, %u sectors (%.2f sectors/command), %u seeks, %u errors\n",
+	 (unsigned)stats.read_cmds, (unsigned)stats.read_sectors,
+	 stats.read_cmds ? (double)stats.read_sectors / stats.read_cmds : 0.0,
+	 (unsigned)stats.seeks, (unsigned)stats.read_errors);
+  printf("Refill+Mix: avg. %u uS, max. %u uS (period %u uS)\n",
+	 (unsigned)(period ? (sum_time / period) : 0), (unsigned)max_time_measured, (unsigned)PERIOD_US);
+
+  if( out_file )
+    fclose(out_file);
+  HAL_STUBS_SDCardImageClose();
+
+  return 0;
+}
@@ -3307,6 +3307,7 @@ s32 parseRouter(u32 line, char *cmd, char *brkt)
     n->src_chn = src_chn;
     n->dst_port = dst_port;
     n->dst_chn = dst_chn;
+    MIDI_ROUTER_NodesChanged();
   }
 
   return 0; // no error
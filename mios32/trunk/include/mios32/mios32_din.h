@@ -33,6 +33,7 @@ extern s32 MIOS32_DIN_Init(u32 mode);
 extern s32 MIOS32_DIN_PinGet(u32 pin);
 extern s32 MIOS32_DIN_SRGet(u32 sr);
 extern u8 MIOS32_DIN_SRChangedGetAndClear(u32 sr, u8 mask);
+extern s32 MIOS32_DIN_SRChangedSet(u32 sr, u8 mask);
 extern s32 MIOS32_DIN_Handler(void *callback);
 
 
@@ -60,6 +60,15 @@
 // Global Types
 /////////////////////////////////////////////////////////////////////////////
 
+// receive statistics (back-pressure indicators)
+typedef struct {
+  u32 packets;      // number of received packets
+  u32 discarded;    // packets with CRC/symbol errors or zero length
+  u32 truncated;    // packets which didn't fit into the receive buffer
+  u32 overflows;    // receive FIFO overflows of the chip (packets have been dropped)
+  u8  max_pending;  // max. number of packets which were waiting in the receive FIFO
+} mios32_enc28j60_rx_stats_t;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Prototypes
@@ -80,6 +89,9 @@ extern s32 MIOS32_ENC28J60_PackageSend(u8 *buffer, u16 len, u8 *buffer2, u16 len
 extern s32 MIOS32_ENC28J60_PackageReceive(u8 *buffer, u16 buffer_size);
 extern s32 MIOS32_ENC28J60_MACDiscardRx(void);
 
+extern s32 MIOS32_ENC28J60_RxStatsGet(mios32_enc28j60_rx_stats_t *stats);
+extern s32 MIOS32_ENC28J60_RxStatsClear(void);
+
 extern s32 MIOS32_ENC28J60_ReadETHReg(u8 address);
 extern s32 MIOS32_ENC28J60_ReadMACReg(u8 address);
 extern s32 MIOS32_ENC28J60_ReadPHYReg(u8 reg);
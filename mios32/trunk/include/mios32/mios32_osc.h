@@ -29,6 +29,17 @@
 #define MIOS32_OSC_MAX_ARGS 8
 #endif
 
+// OSC: number of entries of an address cache (see MIOS32_OSC_ParsePacketCached())
+#ifndef MIOS32_OSC_ADDRESS_CACHE_SIZE
+#define MIOS32_OSC_ADDRESS_CACHE_SIZE 4
+#endif
+
+// OSC: maximum length of an OSC address which can be stored in the address cache
+// (longer addresses are always resolved via the search tree)
+#ifndef MIOS32_OSC_ADDRESS_CACHE_MAX_PATH_LEN
+#define MIOS32_OSC_ADDRESS_CACHE_MAX_PATH_LEN 32
+#endif
+
 // the output function which is used to print debug messages
 // could be replaced by printf (e.g. for emulations)
 #ifndef MIOS32_OSC_DEBUG_MSG
@@ -48,6 +59,23 @@ typedef struct mios32_osc_search_tree_t {
 } mios32_osc_search_tree_t;
 
 
+typedef struct {
+  u32                            hash;        // hash of the OSC address
+  const mios32_osc_search_tree_t *leaf;       // the matching leaf or NULL if entry is invalid
+  u32                            method_arg;  // combined method arguments of all nodes
+  u8                             num_path_parts; // number of address parts
+  const char                     *path_part[MIOS32_OSC_MAX_PATH_PARTS]; // address parts of the tree
+  char                           path[MIOS32_OSC_ADDRESS_CACHE_MAX_PATH_LEN]; // copy of the OSC address (w/o leading '/')
+} mios32_osc_address_cache_entry_t;
+
+typedef struct {
+  const mios32_osc_search_tree_t *search_tree; // the search tree to which the entries belong
+  u32                            hits;        // statistics: number of addresses taken from cache
+  u32                            misses;      // statistics: number of addresses resolved via search tree
+  mios32_osc_address_cache_entry_t entry[MIOS32_OSC_ADDRESS_CACHE_SIZE];
+} mios32_osc_address_cache_t;
+
+
 typedef struct {
   u32 seconds;
   u32 fraction;
@@ -104,6 +132,8 @@ extern mios32_midi_package_t MIOS32_OSC_GetMIDI(u8 *buffer);
 extern u8 *MIOS32_OSC_PutMIDI(u8 *buffer, mios32_midi_package_t p);
 
 extern s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *search_tree);
+extern s32 MIOS32_OSC_ParsePacketCached(u8 *packet, u32 len, const mios32_osc_search_tree_t *search_tree, mios32_osc_address_cache_t *cache);
+extern s32 MIOS32_OSC_AddressCacheClear(mios32_osc_address_cache_t *cache);
 
 extern s32 MIOS32_OSC_SendDebugMessage(mios32_osc_args_t *osc_args, u32 method_arg);
 
@@ -62,6 +62,15 @@
 #endif
 #endif
 
+// SPI prescaler which defines the scan frequency
+// 128 results into ca. 2 uS per bit @ 72 MHz, lower values are possible for short chains
+#ifndef MIOS32_SRIO_SPI_PRESCALER
+#define MIOS32_SRIO_SPI_PRESCALER MIOS32_SPI_PRESCALER_128
+#endif
+
+// number of words in the mios32_srio_din_changed_sr[] mask (one bit per SR)
+#define MIOS32_SRIO_NUM_SR_MASK_WORDS ((MIOS32_SRIO_NUM_SR+31)/32)
+
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -96,6 +105,7 @@ extern volatile u8 mios32_srio_dout[MIOS32_SRIO_NUM_DOUT_PAGES][MIOS32_SRIO_NUM_
 extern volatile u8 mios32_srio_din[MIOS32_SRIO_NUM_SR];
 extern volatile u8 mios32_srio_din_buffer[MIOS32_SRIO_NUM_SR]; // only required for emulation
 extern volatile u8 mios32_srio_din_changed[MIOS32_SRIO_NUM_SR];
+extern volatile u32 mios32_srio_din_changed_sr[MIOS32_SRIO_NUM_SR_MASK_WORDS];
 
 // the current DOUT page
 #if MIOS32_SRIO_NUM_DOUT_PAGES > 1
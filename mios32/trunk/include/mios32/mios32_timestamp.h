@@ -34,6 +34,9 @@ extern s32 MIOS32_TIMESTAMP_Inc(void);
 extern s32 MIOS32_TIMESTAMP_Get(void);
 extern s32 MIOS32_TIMESTAMP_GetDelay(u32 captured_timestamp);
 
+extern u32 MIOS32_TIMESTAMP_Get_uS(void);
+extern u32 MIOS32_TIMESTAMP_GetDelay_uS(u32 captured_timestamp_us);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
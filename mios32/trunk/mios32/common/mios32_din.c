@@ -128,11 +128,45 @@ u8 MIOS32_DIN_SRChangedGetAndClear(u32 sr, u8 mask)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Notifies pin changes of a DIN register, so that they will be dispatched
+//! by MIOS32_DIN_Handler() with the next call.<BR>
+//! This function should be used by emulations or applications which inject
+//! DIN events: MIOS32_DIN_Handler() only checks the SRs which are flagged
+//! in mios32_srio_din_changed_sr[], therefore a direct write into
+//! mios32_srio_din_changed[] would be ignored.
+//! \param[in] sr shift register number (0..MIOS32_SRIO_NUM_SR-1)
+//! \param[in] mask pin mask of the changed pins (8bit value)
+//! \return -1 if unavailable SR selected
+//! \return 0 on success
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_DIN_SRChangedSet(u32 sr, u8 mask)
+{
+  // check if SR available
+  if( sr >= MIOS32_SRIO_NUM_SR )
+    return -1;
+
+  // set changed flags and SR flag - must be atomic!
+  MIOS32_IRQ_Disable();
+  mios32_srio_din_changed[sr] |= mask;
+  if( mask )
+    mios32_srio_din_changed_sr[sr / 32] |= 1 << (sr % 32);
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Checks for pin changes, and calls given callback function with following parameters:
 //! \code
 //!   void DIN_NotifyToggle(u32 pin, u32 value)
 //! \endcode
+//!
+//! Only SRs which have been notified as changed by the SRIO driver
+//! (mios32_srio_din_changed_sr) are checked, and only the changed pins
+//! are dispatched, so that the handler takes almost no time on long
+//! chains as long as no button is moved.
 //! \param[in] _callback pointer to callback function
 //! \return < 0 on errors
 /////////////////////////////////////////////////////////////////////////////
@@ -140,6 +174,7 @@ s32 MIOS32_DIN_Handler(void *_callback)
 {
   s32 sr;
   s32 sr_pin;
+  s32 word;
   u8 changed;
   void (*callback)(u32 pin, u32 value) = _callback;
   u8 num_sr = MIOS32_SRIO_ScanNumGet();
@@ -156,25 +191,34 @@ s32 MIOS32_DIN_Handler(void *_callback)
   if( _callback == NULL )
     return -1;
 
-  // check all shift registers for DIN pin changes
-  for(sr=0; sr<num_sr; ++sr) {
-    
-    // check if there are pin changes (mask all pins)
-    changed = MIOS32_DIN_SRChangedGetAndClear(sr, 0xff);
+  // check all shift registers which have been notified as changed
+  for(word=0; word<MIOS32_SRIO_NUM_SR_MASK_WORDS; ++word) {
+    // get and clear SR mask - must be atomic!
+    MIOS32_IRQ_Disable();
+    u32 sr_mask = mios32_srio_din_changed_sr[word];
+    mios32_srio_din_changed_sr[word] = 0;
+    MIOS32_IRQ_Enable();
+
+    while( sr_mask ) {
+      sr = 32*word + __builtin_ctz(sr_mask);
+      sr_mask &= sr_mask - 1; // clear lowest bit
+
+      // check if there are pin changes (mask all pins)
+      // (flags could have been taken by another driver, e.g. the encoder handler)
+      changed = MIOS32_DIN_SRChangedGetAndClear(sr, 0xff);
 
-    // any pin change at this SR?
-    if( !changed )
-      continue;
+      // dispatch the changed pins only
+      while( changed ) {
+	sr_pin = __builtin_ctz(changed);
+	changed &= changed - 1; // clear lowest bit
 
-    // check all 8 pins of the SR
-    for(sr_pin=0; sr_pin<8; ++sr_pin)
-      if( changed & (1 << sr_pin) ) {
 	// call the notification function
 	callback(8*sr+sr_pin, (mios32_srio_din[sr] & (1 << sr_pin)) ? 1 : 0);
 
 	// start debouncing (if enabled in SRIO driver)
 	MIOS32_SRIO_DebounceStart();
       }
+    }
   }
 
   return 0;
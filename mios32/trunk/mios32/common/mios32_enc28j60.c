@@ -23,6 +23,15 @@
 //! MIOS32_ENC28J60_PackageSend() and MIOS32_ENC28J60_PackageReceive()
 //! Will handle mutexes themselves all other functions will not.
 //!
+//! Received packets stay in the 4k receive FIFO of the chip until they are
+//! fetched with MIOS32_ENC28J60_PackageReceive(), which copies the packet
+//! directly into the buffer of the caller (e.g. uip_buf).<BR>
+//! The caller should fetch all pending packets in a burst (until 0 is returned,
+//! a discarded packet is notified with -17 and doesn't end the burst),
+//! so that the FIFO doesn't overflow if a controller sends many packets at once.
+//! MIOS32_ENC28J60_RxStatsGet() returns counters which help to determine
+//! if packets have been dropped.
+//!
 //! \{
 /* ==========================================================================
  *
@@ -108,6 +117,8 @@ static u8 rev_id;
 
 static u8 mac_addr[6];
 
+static mios32_enc28j60_rx_stats_t rx_stats;
+
 
 /////////////////////////////////////////////////////////////////////////////
 //! Initializes SPI pins and peripheral to access ENC28J60
@@ -134,6 +145,9 @@ s32 MIOS32_ENC28J60_Init(u32 mode)
     MIOS32_ENC28J60_MY_MAC_ADDR4, MIOS32_ENC28J60_MY_MAC_ADDR5, MIOS32_ENC28J60_MY_MAC_ADDR6
   };
   memcpy(mac_addr, default_mac_addr, 6);
+
+  MIOS32_ENC28J60_RxStatsClear();
+
   MIOS32_ENC28J60_MUTEX_TAKE;
   ret=MIOS32_ENC28J60_PowerOn();
   MIOS32_ENC28J60_MUTEX_GIVE;
@@ -606,6 +620,8 @@ error:
 //! param[in] buffer_size Max. number of bytes which can be received
 //! \return < 0 on errors
 //! \return -16 if inconsistencies have been detected, and the ENC28J60 device has been reseted
+//! \return -17 if a package has been discarded (empty package or CRC/symbol error),
+//!         further packages could be pending, so that the caller should continue
 //! \return 0 if no package has been received
 //! \return > 0 number of received bytes
 /////////////////////////////////////////////////////////////////////////////
@@ -640,11 +656,29 @@ s32 MIOS32_ENC28J60_PackageReceive(u8 *buffer, u16 buffer_size)
     status=package_count;
     goto error;
   }
+
+  // back-pressure statistics
+  if( package_count > rx_stats.max_pending )
+    rx_stats.max_pending = package_count;
+
+  // receive FIFO overflow? (EIR is available in all banks)
+  s32 eir = MIOS32_ENC28J60_ReadETHReg(EIR);
+  if( eir >= 0 && (eir & EIR_RXERIF) ) {
+    ++rx_stats.overflows;
+    status |= MIOS32_ENC28J60_BFCReg(EIR, EIR_RXERIF);
+  }
+
   // Make absolutely certain that any previous packet was discarded
+  // (this will also decrement the packet counter)
   if( !WasDiscarded ) {
-    status = MIOS32_ENC28J60_MACDiscardRx();
-    status = (status < 0) ? status : 0;
-    goto error;
+    status |= MIOS32_ENC28J60_MACDiscardRx();
+    if( status < 0 )
+      goto error;
+
+    if( --package_count <= 0 ) {
+      status = 0;
+      goto error;
+    }
   }
 
   // Set the SPI read pointer to the beginning of the next unprocessed packet
@@ -689,14 +723,20 @@ s32 MIOS32_ENC28J60_PackageReceive(u8 *buffer, u16 buffer_size)
   // empty package or CRC/symbol errors?
   packet_len = header.StatusVector.bits.ByteCount;
   if( !packet_len || header.StatusVector.bits.CRCError || !header.StatusVector.bits.ReceiveOk ) {
+    ++rx_stats.discarded;
+    packet_len = 0;
     status = MIOS32_ENC28J60_MACDiscardRx(); // discard package immediately
-    status = (status < 0) ? status : 0;
+    status = (status < 0) ? status : -17; // the caller can continue with the next package
     goto error;
   }
 
   // ensure that we don't read more bytes than the buffer can store
-  if( packet_len > buffer_size )
+  if( packet_len > buffer_size ) {
+    ++rx_stats.truncated;
     packet_len = buffer_size;
+  }
+
+  ++rx_stats.packets;
 
   // read bytes into buffer
   status = MIOS32_ENC28J60_MACGetArray(buffer, packet_len);
@@ -715,6 +755,39 @@ error:
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the receive statistics
+//! \param[out] stats the counters will be copied into this structure
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_ENC28J60_RxStatsGet(mios32_enc28j60_rx_stats_t *stats)
+{
+  MIOS32_IRQ_Disable();
+  *stats = rx_stats;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Clears the receive statistics
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_ENC28J60_RxStatsClear(void)
+{
+  MIOS32_IRQ_Disable();
+  rx_stats.packets = 0;
+  rx_stats.discarded = 0;
+  rx_stats.truncated = 0;
+  rx_stats.overflows = 0;
+  rx_stats.max_pending = 0;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Marks the last received packet (obtained using MIOS32_ENC28J60_PackageReceive())
 //! as being processed and frees the buffer memory associated with it
@@ -38,8 +38,16 @@
 //! address)
 //!
 //! OSC allows to use wildcards in the address path like *, ?, [] and {}.<BR>
-//! The MIOS32 implementation currently only supports '*' and '?'<BR>
-//! Examples: '/sid?/osc/finetune' or '/sid?/osc/fine*' or '/cs/led/*'
+//! All of them are supported in incoming addresses, the search tree itself can
+//! use '*' (matches the remaining address part) and '?'<BR>
+//! Examples: '/sid?/osc/finetune' or '/sid?/osc/fine*' or '/cs/led/*' or
+//! '/sid[1-4]/osc/{fine,coarse}'
+//!
+//! Controllers like Lemur or TouchOSC are sending the same addresses again and
+//! again (e.g. while a fader is moved). Instead of MIOS32_OSC_ParsePacket() an
+//! application can call MIOS32_OSC_ParsePacketCached() with a small address cache
+//! for each connection. The cache stores the resolved leaf of recently received
+//! addresses, so that the search tree only has to be walked once for each address.
 //! 
 //! While searching through the tree, the appr. functions of all matching methods 
 //! will be called with the OSC arguments which are part of the packet (+ the method argument):<BR>
@@ -144,12 +152,25 @@
 #if !defined(MIOS32_DONT_USE_OSC)
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+// used to record the matching leaf while the search tree is walked
+typedef struct {
+  u8 num_matches;
+  mios32_osc_address_cache_entry_t entry;
+} search_result_t;
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
 /////////////////////////////////////////////////////////////////////////////
 
-static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree);
-static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *search_tree);
+static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree, mios32_osc_address_cache_t *cache);
+static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *search_tree, search_result_t *result);
+static u8 MIOS32_OSC_MatchAddressPart(const char *pattern, const char *pattern_end, const char *name);
+static u32 MIOS32_OSC_AddressHash(const char *address, size_t *len);
 
 static size_t my_strnlen(char *str, size_t max_len);
 
@@ -489,6 +510,43 @@ u8 *MIOS32_OSC_PutMIDI(u8 *buffer, mios32_midi_package_t p)
 /////////////////////////////////////////////////////////////////////////////
 s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *search_tree)
 {
+  return MIOS32_OSC_ParsePacketCached(packet, len, search_tree, NULL);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Same as MIOS32_OSC_ParsePacket(), but OSC addresses are looked up in the
+//! given address cache first.<BR>
+//! Addresses which are not in the cache are resolved via the search tree.
+//! If exactly one method matches, the leaf is stored in the cache, so that
+//! the next packet with the same address can be dispatched without walking
+//! through the tree again.
+//!
+//! Each connection should use its own cache, so that controllers which are
+//! sending different addresses don't evict the entries of each other.
+//! \code
+//!   static mios32_osc_address_cache_t osc_cache[OSC_SERVER_NUM_CONNECTIONS];
+//!
+//!   MIOS32_OSC_ParsePacketCached(packet, len, parse_root, &osc_cache[con]);
+//! \endcode
+//! \param[in] packet pointer to OSC packet
+//! \param[in] len length of packet
+//! \param[in] search_tree a tree which defines address parts and methods to be called
+//! \param[in] cache pointer to the address cache, or NULL if no cache should be used
+//! \return 0 if packet has been parsed w/o errors
+//! \return -1 if packet format invalid
+//! \return -2 if the packet contains an OSC element with invalid format
+//! \return -3 if the packet contains an OSC element with an unsupported format
+//! returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_OSC_ParsePacketCached(u8 *packet, u32 len, const mios32_osc_search_tree_t *search_tree, mios32_osc_address_cache_t *cache)
+{
+  // the cache is only valid for the search tree which has been used to fill it
+  if( cache != NULL && cache->search_tree != search_tree ) {
+    MIOS32_OSC_AddressCacheClear(cache);
+    cache->search_tree = search_tree;
+  }
+
   // store osc arguments (and more...) into osc_args variable
   mios32_osc_args_t osc_args;
 
@@ -517,7 +575,7 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
 
       // parse element if size > 0
       if( elem_size ) {
-	s32 status = MIOS32_OSC_SearchElement((u8 *)(packet+pos), elem_size, &osc_args, search_tree);
+	s32 status = MIOS32_OSC_SearchElement((u8 *)(packet+pos), elem_size, &osc_args, search_tree, cache);
 	if( status < 0 )
 	  return status;
       }
@@ -531,7 +589,7 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
     osc_args.timetag.seconds = 0;
     osc_args.timetag.fraction = 1;
 
-    s32 status = MIOS32_OSC_SearchElement(packet, len, &osc_args, search_tree);
+    s32 status = MIOS32_OSC_SearchElement(packet, len, &osc_args, search_tree, cache);
     if( status < 0 )
       return status;
   }
@@ -540,6 +598,33 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Invalidates all entries of an address cache.<BR>
+//! Has to be called before the cache is used the first time, and it can be
+//! called whenever the methods of the search tree should be resolved again.
+//! \param[in] cache pointer to the address cache
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_OSC_AddressCacheClear(mios32_osc_address_cache_t *cache)
+{
+  if( cache == NULL )
+    return -1; // no cache
+
+  int i;
+  mios32_osc_address_cache_entry_t *entry = &cache->entry[0];
+  for(i=0; i<MIOS32_OSC_ADDRESS_CACHE_SIZE; ++i, ++entry) {
+    entry->hash = 0;
+    entry->leaf = NULL;
+  }
+
+  cache->search_tree = NULL;
+  cache->hits = 0;
+  cache->misses = 0;
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Internal function:
 // parses a single OSC element
@@ -547,7 +632,7 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
 // returns -3 if element contains an unsupported format
 // returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
 /////////////////////////////////////////////////////////////////////////////
-static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree)
+static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree, mios32_osc_address_cache_t *cache)
 {
   // exit immediately if element is empty
   if( !len )
@@ -676,54 +761,66 @@ static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_
 
   // finally parse for elements which are matching the OSC address
   osc_args->num_path_parts = 0;
-  return MIOS32_OSC_SearchPath((char *)&path[1], osc_args, 0x00000000, search_tree);
+  char *address = (char *)&path[1];
+
+  if( cache == NULL )
+    return MIOS32_OSC_SearchPath(address, osc_args, 0x00000000, search_tree, NULL);
+
+  // check if the address has been resolved before
+  size_t address_len;
+  u32 hash = MIOS32_OSC_AddressHash(address, &address_len);
+  mios32_osc_address_cache_entry_t *entry = &cache->entry[hash % MIOS32_OSC_ADDRESS_CACHE_SIZE];
+
+  if( entry->leaf != NULL && entry->hash == hash && strcmp(entry->path, address) == 0 ) {
+    ++cache->hits;
+
+    osc_args->num_path_parts = entry->num_path_parts;
+    memcpy(osc_args->path_part, entry->path_part, entry->num_path_parts * sizeof(char *));
+
+    s32 (*osc_method)(mios32_osc_args_t *osc_args, u32 method_arg) = entry->leaf->osc_method;
+    osc_method(osc_args, entry->method_arg);
+
+    return 0; // no error
+  }
+
+  ++cache->misses;
+
+  // walk through the search tree and record the matching leaf
+  search_result_t result;
+  result.num_matches = 0;
+  s32 status = MIOS32_OSC_SearchPath(address, osc_args, 0x00000000, search_tree, &result);
+
+  // only unique matches are cached, addresses which match multiple methods (e.g. due to
+  // wildcards) or no method at all will always be resolved via the search tree
+  if( status >= 0 && result.num_matches == 1 && address_len < MIOS32_OSC_ADDRESS_CACHE_MAX_PATH_LEN ) {
+    *entry = result.entry;
+    entry->hash = hash;
+    memcpy(entry->path, address, address_len+1);
+  }
+
+  return status;
 }
 
 
 /////////////////////////////////////////////////////////////////////////////
 // Internal function:
 // searches in search_tree for matching OSC addresses
+// if result != NULL, the first matching leaf will be recorded
 // returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
 /////////////////////////////////////////////////////////////////////////////
-static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *search_tree)
+static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *search_tree, search_result_t *result)
 {
   if( osc_args->num_path_parts >= MIOS32_OSC_MAX_PATH_PARTS )
     return -4; // maximum number of path parts exceeded
 
+  // determine end of address part
+  size_t sep_pos = 0;
+  while( path[sep_pos] != 0 && path[sep_pos] != '/' )
+    ++sep_pos;
+
   while( search_tree->address != NULL ) {
     // compare OSC address with name of tree item
-    u8 match = 1;
-    u8 wildcard = 0;
-
-    char *str1 = path;
-    char *str2 = (char *)search_tree->address;
-    size_t sep_pos = 0;
-
-    while( *str1 != 0 && *str1 != '/' ) {
-      if( *str1 == '*' || *str2 == '*' ) {
-	// '*' wildcard: continue to end of address part
-	while( *str1 != 0 && *str1 != '/' ) {
-	  ++sep_pos;
-	  ++str1;
-	}
-	wildcard = 1;
-	break;
-      } else {
-	// no wildcard: check for matching characters
-	++sep_pos;
-	if( *str2 == 0 || (*str2 != *str1 && *str1 != '?' && *str2 != '?') ) {
-	  match = 0;
-	  break;
-	}
-	++str1;
-	++str2;
-      }
-    }
-    
-    if( !wildcard && *str2 != 0 ) // we haven't parsed the complete string
-      match = 0;
-
-    if( match ) {
+    if( MIOS32_OSC_MatchAddressPart(path, (char *)&path[sep_pos], search_tree->address) ) {
       // store number of path parts in local variable, since content of osc_args is changed recursively
       // we don't want to copy the whole structure to save (a lot of...) memory
       u8 num_path_parts = osc_args->num_path_parts;
@@ -735,12 +832,19 @@ static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 me
       u32 combined_method_arg = method_arg | search_tree->method_arg;
 
       if( search_tree->osc_method ) {
+	if( result != NULL && result->num_matches++ == 0 ) {
+	  result->entry.leaf = search_tree;
+	  result->entry.method_arg = combined_method_arg;
+	  result->entry.num_path_parts = osc_args->num_path_parts;
+	  memcpy(result->entry.path_part, osc_args->path_part, osc_args->num_path_parts * sizeof(char *));
+	}
+
 	s32 (*osc_method)(mios32_osc_args_t *osc_args, u32 method_arg) = search_tree->osc_method;
 	osc_method(osc_args, combined_method_arg);
-      } else if( search_tree->next ) {
+      } else if( search_tree->next && path[sep_pos] == '/' ) {
 
 	// continue search in next hierarchy level
-	s32 status = MIOS32_OSC_SearchPath((char *)&path[sep_pos+1], osc_args, combined_method_arg, search_tree->next);
+	s32 status = MIOS32_OSC_SearchPath((char *)&path[sep_pos+1], osc_args, combined_method_arg, search_tree->next, result);
 	if( status < 0 )
 	  return status;
       }
@@ -756,6 +860,139 @@ static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 me
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// matches an address part of an incoming OSC address (which ends at pattern_end)
+// against the name of a search tree node.
+// The incoming address can contain '*', '?', '[]' and '{}' wildcards,
+// the node name can contain '*' (matches the remaining address part) and '?'
+// returns 1 on match, 0 on mismatch
+/////////////////////////////////////////////////////////////////////////////
+static u8 MIOS32_OSC_MatchAddressPart(const char *pattern, const char *pattern_end, const char *name)
+{
+  while( pattern < pattern_end ) {
+    if( *name == '*' )
+      return 1; // wildcard in search tree: matches the remaining part
+
+    switch( *pattern ) {
+    case '*': {
+      // skip consecutive '*'
+      while( pattern < pattern_end && *pattern == '*' )
+	++pattern;
+
+      if( pattern == pattern_end )
+	return 1; // '*' at the end matches everything
+
+      // try to match the remaining pattern at any position
+      for(; *name != 0; ++name) {
+	if( MIOS32_OSC_MatchAddressPart(pattern, pattern_end, name) )
+	  return 1;
+      }
+      return 0;
+    }
+
+    case '?':
+      if( *name == 0 )
+	return 0;
+      ++pattern;
+      ++name;
+      break;
+
+    case '[': {
+      if( *name == 0 )
+	return 0;
+
+      ++pattern;
+      u8 negate = 0;
+      if( pattern < pattern_end && *pattern == '!' ) {
+	negate = 1;
+	++pattern;
+      }
+
+      u8 found = 0;
+      while( pattern < pattern_end && *pattern != ']' ) {
+	if( (pattern+2) < pattern_end && pattern[1] == '-' && pattern[2] != ']' ) {
+	  // range, e.g. [1-4]
+	  if( *name >= pattern[0] && *name <= pattern[2] )
+	    found = 1;
+	  pattern += 3;
+	} else {
+	  if( *name == *pattern )
+	    found = 1;
+	  ++pattern;
+	}
+      }
+
+      if( pattern >= pattern_end )
+	return 0; // missing ']'
+
+      if( found == negate )
+	return 0;
+
+      ++pattern; // skip ']'
+      ++name;
+    } break;
+
+    case '{': {
+      // search for the end of the alternatives list
+      const char *list_end = pattern;
+      while( list_end < pattern_end && *list_end != '}' )
+	++list_end;
+
+      if( list_end >= pattern_end )
+	return 0; // missing '}'
+
+      // try each comma separated alternative, e.g. {fine,coarse}
+      const char *alt = pattern + 1;
+      while( alt <= list_end ) {
+	const char *alt_end = alt;
+	while( alt_end < list_end && *alt_end != ',' )
+	  ++alt_end;
+
+	size_t alt_len = alt_end - alt;
+	if( strncmp(alt, name, alt_len) == 0 &&
+	    MIOS32_OSC_MatchAddressPart(list_end+1, pattern_end, (char *)&name[alt_len]) )
+	  return 1;
+
+	alt = alt_end + 1;
+      }
+      return 0;
+    }
+
+    default:
+      // no wildcard: check for matching characters ('?' in search tree matches any character)
+      if( *name == 0 || (*name != *pattern && *name != '?') )
+	return 0;
+      ++pattern;
+      ++name;
+    }
+  }
+
+  // complete name must be parsed as well
+  return *name == 0 || *name == '*';
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// calculates a FNV-1a hash over the OSC address, and returns the length
+/////////////////////////////////////////////////////////////////////////////
+static u32 MIOS32_OSC_AddressHash(const char *address, size_t *len)
+{
+  u32 hash = 2166136261u;
+  const char *str = address;
+
+  while( *str != 0 ) {
+    hash ^= (u8)*str++;
+    hash *= 16777619u;
+  }
+
+  *len = (size_t)(str - address);
+
+  return hash;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Sends the argument list of a method to the debug terminal.
 //!
@@ -69,6 +69,16 @@
 #endif
 #endif
 
+// Timeout for the start token of a data block in MIOS32_SDCARD_SectorsRead()
+// The SD spec limits the read access time (NAC) to 100 mS: it's the fixed
+// read timeout of SDHC/SDXC cards, and the upper limit of the value given
+// by TAAC/NSAC in the CSD of SDSC cards. The token is polled with single
+// byte transfers; at the max. SPI clock of ca. 18 MBit/s a poll takes at
+// least 0.44 uS, so that the number of polls below covers 100 mS (slower
+// SPI clocks only wait longer)
+#define MIOS32_SDCARD_READ_TIMEOUT_MS    100
+#define MIOS32_SDCARD_READ_TIMEOUT_POLLS (MIOS32_SDCARD_READ_TIMEOUT_MS * (18000/8))
+
 
 
 /* Definitions for MMC/SDC command */
@@ -102,6 +112,12 @@
 #define SDCMD_READ_SINGLE_BLOCK	(0x40+17)
 #define SDCMD_READ_SINGLE_BLOCK_CRC 0xff
 
+#define SDCMD_READ_MULTIPLE_BLOCK	(0x40+18)
+#define SDCMD_READ_MULTIPLE_BLOCK_CRC 0xff
+
+#define SDCMD_STOP_TRANSMISSION	(0x40+12)
+#define SDCMD_STOP_TRANSMISSION_CRC 0xff
+
 #define SDCMD_SET_BLOCKLEN		(0x40+16)
 #define SDCMD_SET_BLOCKLEN_CRC 	0xff
 
@@ -486,6 +502,101 @@ error:
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Reads consecutive sectors with a single READ_MULTIPLE_BLOCK command.\n
+//! Compared to a loop of MIOS32_SDCARD_SectorRead calls, the command overhead
+//! and the access latency of the card only apply once, which speeds up
+//! sequential reads (e.g. audio streaming) significantly.
+//! \param[in] sector 32bit number of the first sector
+//! \param[in] *buffer pointer to a buffer of num_sectors*512 bytes
+//! \param[in] num_sectors number of sectors which should be read
+//! \return 0 if all sectors have been successfully read
+//! \return -error if error occured during read operation (see MIOS32_SDCARD_SectorRead)
+//! \return -256 if timeout during command has been sent
+//! \return -257 if timeout while waiting for start token
+//! \return -258 if timeout while stopping the transmission
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SDCARD_SectorsRead(u32 sector, u8 *buffer, u32 num_sectors)
+{
+  s32 status = 0;
+  int i;
+
+  if( num_sectors == 0 )
+    return 0; // nothing to do
+
+  if( num_sectors == 1 )
+    return MIOS32_SDCARD_SectorRead(sector, buffer);
+
+  if (!(CardType & CT_BLOCK)) 
+	sector *= 512;
+
+  MIOS32_SDCARD_MUTEX_TAKE;
+
+  // init SPI port for fast frequency access (ca. 18 MBit/s)
+  // this is required for the case that the SPI port is shared with other devices
+  MIOS32_SPI_TransferModeInit(MIOS32_SDCARD_SPI, MIOS32_SPI_MODE_CLK1_PHASE1, MIOS32_SDCARD_SPI_PRESCALER);
+
+  if( (status=MIOS32_SDCARD_SendSDCCmd(SDCMD_READ_MULTIPLE_BLOCK, sector, SDCMD_READ_MULTIPLE_BLOCK_CRC)) ) {
+    status=(status < 0) ? -256 : status; // return timeout indicator or error flags
+    goto error;
+  }
+
+  while( num_sectors-- ) {
+    // wait for start token of the data block (NAC applies to each block)
+    for(i=0; i<MIOS32_SDCARD_READ_TIMEOUT_POLLS; ++i) {
+      u8 ret = MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+      if( ret != 0xff )
+	break;
+    }
+    if( i == MIOS32_SDCARD_READ_TIMEOUT_POLLS ) {
+      status= -257;
+      break; // stop transmission
+    }
+
+    // read 512 bytes via DMA
+    MIOS32_SPI_TransferBlock(MIOS32_SDCARD_SPI, NULL, buffer, 512, NULL);
+    buffer += 512;
+
+    // read (and ignore) CRC
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+  }
+
+  // stop transmission
+  // the card already sends the next data block while the command is transfered,
+  // therefore the R1 response follows after a stuff byte
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, SDCMD_STOP_TRANSMISSION);
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0x00);
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0x00);
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0x00);
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0x00);
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, SDCMD_STOP_TRANSMISSION_CRC);
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff); // stuff byte
+
+  for(i=0; i<8; ++i) {
+    if( MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff) != 0xff )
+      break;
+  }
+
+  // wait until the card isn't busy anymore (R1b response)
+  for(i=0; i<65536; ++i) {
+    if( MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff) != 0x00 )
+      break;
+  }
+  if( i == 65536 && status >= 0 )
+    status= -258;
+
+error:
+  // deactivate chip select
+  MIOS32_SPI_RC_PinSet(MIOS32_SDCARD_SPI, MIOS32_SDCARD_SPI_RC_PIN, 1); // spi, rc_pin, pin_value
+
+  // Send dummy byte once deactivated to drop cards DO
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+  MIOS32_SDCARD_MUTEX_GIVE;
+  return status; 
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Writes 512 bytes into selected sector
 //! \param[in] sector 32bit sector
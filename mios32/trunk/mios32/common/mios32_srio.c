@@ -37,17 +37,23 @@ extern void MIOS32_SRIO_CALLBACK_BEFORE_DIN_COMPARE(void);
 // As long as the array is accessed via MIOS32_DOUT_* functions, they programmer won't notice a difference!
 volatile u8 mios32_srio_dout[MIOS32_SRIO_NUM_DOUT_PAGES][MIOS32_SRIO_NUM_SR];
 
+// Note: the DIN arrays are 32bit aligned, so that they can be compared word-wise after the scan
+
 // DIN values of last scan
-volatile u8 mios32_srio_din[MIOS32_SRIO_NUM_SR];
+volatile u8 mios32_srio_din[MIOS32_SRIO_NUM_SR] __attribute__((aligned(4)));
 
 // DIN values of ongoing scan
 // Note: during SRIO scan it is required to copy new DIN values into a temporary buffer
 // to avoid that a task already takes a new DIN value before the whole chain has been scanned
 // (e.g. relevant for encoder handler: it has to clear the changed flags, so that the DIN handler doesn't take the value)
-volatile u8 mios32_srio_din_buffer[MIOS32_SRIO_NUM_SR];
+volatile u8 mios32_srio_din_buffer[MIOS32_SRIO_NUM_SR] __attribute__((aligned(4)));
 
 // change notification flags
-volatile u8 mios32_srio_din_changed[MIOS32_SRIO_NUM_SR];
+volatile u8 mios32_srio_din_changed[MIOS32_SRIO_NUM_SR] __attribute__((aligned(4)));
+
+// one bit per SR which notifies that mios32_srio_din_changed[sr] has been set
+// allows MIOS32_DIN_Handler() to skip unchanged SRs
+volatile u32 mios32_srio_din_changed_sr[MIOS32_SRIO_NUM_SR_MASK_WORDS];
 
 // the current DOUT page
 #if MIOS32_SRIO_NUM_DOUT_PAGES > 1
@@ -118,6 +124,9 @@ s32 MIOS32_SRIO_Init(u32 mode)
     mios32_srio_din_changed[i] = 0;   // no change
   }
 
+  for(i=0; i<MIOS32_SRIO_NUM_SR_MASK_WORDS; ++i)
+    mios32_srio_din_changed_sr[i] = 0;
+
   // initial debounce time (debouncing disabled)
   debounce_time = 0;
   debounce_ctr = 0;
@@ -142,8 +151,8 @@ s32 MIOS32_SRIO_Init(u32 mode)
   MIOS32_SPI_IO_Init(MIOS32_SRIO_SPI, MIOS32_SPI_PIN_DRIVER_WEAK);
 #endif
 
-  // init SPI port for baudrate of ca. 2 uS period @ 72 MHz
-  MIOS32_SPI_TransferModeInit(MIOS32_SRIO_SPI, MIOS32_SPI_MODE_CLK1_PHASE1, MIOS32_SPI_PRESCALER_128);
+  // init SPI port for baudrate of ca. 2 uS period @ 72 MHz (by default)
+  MIOS32_SPI_TransferModeInit(MIOS32_SRIO_SPI, MIOS32_SPI_MODE_CLK1_PHASE1, MIOS32_SRIO_SPI_PRESCALER);
 
   // notify that SRIO values have been transfered
   // (cleared on each ScanStart, set on each DMA IRQ invokation for proper synchronisation)
@@ -348,10 +357,36 @@ static void MIOS32_SRIO_DMA_Callback(void)
 #endif
 
   // copy/or buffered DIN values/changed flags
+  // compare 4 SRs at once, and notify changed SRs in mios32_srio_din_changed_sr
   int i;
-  for(i=0; i<num_sr; ++i) {
-    mios32_srio_din_changed[i] |= mios32_srio_din[i] ^ mios32_srio_din_buffer[i];
-    mios32_srio_din[i] = mios32_srio_din_buffer[i];
+  {
+    u32 *din = (u32 *)&mios32_srio_din[0];
+    u32 *din_buffer = (u32 *)&mios32_srio_din_buffer[0];
+    u32 *din_changed = (u32 *)&mios32_srio_din_changed[0];
+    int num_words = num_sr / 4;
+    for(i=0; i<num_words; ++i, ++din, ++din_buffer, ++din_changed) {
+      u32 changed = *din ^ *din_buffer;
+      if( changed ) {
+	*din_changed |= changed;
+	*din = *din_buffer;
+
+	u32 sr_mask = ((changed & 0x000000ff) ? 1 : 0) |
+	              ((changed & 0x0000ff00) ? 2 : 0) |
+	              ((changed & 0x00ff0000) ? 4 : 0) |
+	              ((changed & 0xff000000) ? 8 : 0);
+	mios32_srio_din_changed_sr[i / 8] |= sr_mask << (4*(i % 8));
+      }
+    }
+
+    // remaining SRs
+    for(i=4*num_words; i<num_sr; ++i) {
+      u8 changed = mios32_srio_din[i] ^ mios32_srio_din_buffer[i];
+      if( changed ) {
+	mios32_srio_din_changed[i] |= changed;
+	mios32_srio_din[i] = mios32_srio_din_buffer[i];
+	mios32_srio_din_changed_sr[i / 32] |= 1 << (i % 32);
+      }
+    }
   }
 
   // call user specific hook if requested
@@ -374,6 +409,9 @@ static void MIOS32_SRIO_DMA_Callback(void)
       mios32_srio_din[i] ^= mios32_srio_din_changed[i];
       mios32_srio_din_changed[i] = 0;
     }
+
+    for(i=0; i<MIOS32_SRIO_NUM_SR_MASK_WORDS; ++i)
+      mios32_srio_din_changed_sr[i] = 0;
   }
 
   // next transfer has to be started with MIOS32_SRIO_ScanStart
@@ -95,6 +95,57 @@ s32 MIOS32_TIMESTAMP_GetDelay(u32 captured_timestamp)
   return timestamp - captured_timestamp;
 }
 
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns a uS accurate timestamp.\n
+//! The mS timestamp is combined with the current value of the SysTick
+//! counter, which is used by FreeRTOS to generate the 1 mS tick.
+//!
+//! Can be called from interrupts, e.g. to timestamp DIN changes in
+//! APP_SRIO_ServiceFinish()
+//!
+//! \note the value overruns each ca. 71 minutes, always use
+//! MIOS32_TIMESTAMP_GetDelay_uS() or a u32 subtraction to determine delays
+//! \return the current timestamp in uS
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_TIMESTAMP_Get_uS(void)
+{
+#if defined(MIOS32_FAMILY_EMULATION)
+  return timestamp * 1000;
+#else
+  u32 ms, ticks;
+  u32 reload = SysTick->LOAD + 1;
+
+  MIOS32_IRQ_Disable();
+  ms = timestamp;
+  ticks = reload - SysTick->VAL;
+
+  // counter overrun before the tick hook has incremented the timestamp?
+  if( SCB->ICSR & SCB_ICSR_PENDSTSET_Msk ) {
+    ++ms;
+    ticks = reload - SysTick->VAL; // read again, since overrun could happen after the first read
+  }
+  MIOS32_IRQ_Enable();
+
+  if( ticks >= reload )
+    ticks = reload - 1;
+
+  return ms * 1000 + (ticks * 1000) / reload;
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the delay in uS between the given and the current uS timestamp
+//! \param[in] captured_timestamp_us timestamp captured with MIOS32_TIMESTAMP_Get_uS()
+//! \return the delay between the given and the current timestamp in uS
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_TIMESTAMP_GetDelay_uS(u32 captured_timestamp_us)
+{
+  // will automatically roll over
+  return MIOS32_TIMESTAMP_Get_uS() - captured_timestamp_us;
+}
+
 //! \}
 
 #endif /* MIOS32_DONT_USE_TIMESTAMP */
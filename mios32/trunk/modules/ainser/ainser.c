@@ -22,6 +22,18 @@
 #include "ainser.h"
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// one conversion per channel and module in each scan frame
+#define AINSER_FRAME_SIZE (8*AINSER_NUM_MODULES)
+
+#if AINSER_FRAME_SIZE > 32
+# error "The changed mask of AINSER_FrameEvaluate() has to be enhanced for more than 4 modules"
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
@@ -36,12 +48,35 @@ static u16 previous_ain_pin_value;
 
 static u8 ain_deadband[AINSER_NUM_MODULES];
 
+// the mux_ctr -> pin mappin is layout dependend
+//static const u8 mux_pin_map[8] = {0, 1, 2, 3, 4, 5, 6, 7 };
+//static const u8 mux_pin_map[8] = {1, 4, 3, 5, 2, 7, 0, 6 }; // reversed pins
+static const u8 mux_pin_map[8] = {6, 3, 4, 2, 5, 0, 7, 1 }; // order of MUX channels
+
+// conversion list of the current scan frame (one multiplexer selection)
+static u8 frame_tx[AINSER_FRAME_SIZE][3];
+static u8 frame_rx[AINSER_FRAME_SIZE][3]; // raw conversion results
+static u8 frame_module[AINSER_FRAME_SIZE];
+static u8 frame_pin[AINSER_FRAME_SIZE];
+static u8 frame_num;
+static u8 frame_mux_ctr;
+
+#if AINSER_DMA_SCAN
+static volatile u8 frame_pos;
+static volatile u8 frame_busy;
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local Prototypes
 /////////////////////////////////////////////////////////////////////////////
 
 static s32 AINSER_SetCs(u8 module, u8 value);
+static void AINSER_FrameBuild(u8 mux_ctr, u8 next_mux_ctr, u8 link_status);
+static void AINSER_FrameEvaluate(u8 notify, void (*_callback)(u32 module, u32 pin, u32 value));
+#if AINSER_DMA_SCAN
+static void AINSER_FrameTransferNext(void);
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -69,6 +104,13 @@ s32 AINSER_Init(u32 mode)
 
   // SPI Port will be initialized in AINSER_Update()
 
+  // no frame scanned yet
+  frame_num = 0;
+  frame_mux_ctr = 0xff;
+#if AINSER_DMA_SCAN
+  frame_busy = 0;
+#endif
+
   num_used_modules = AINSER_NUM_MODULES;
 #if AINSER_NUM_MODULES > 8
 # error "If more than 8 AINSER_NUM_MODULES should be supported, the ainser_enable_mask variable type has to be changed from u8 to u16 (up to 16) or u32 (up to 32)"
@@ -267,6 +309,9 @@ s32 AINSER_PreviousPinValueGet(void)
 //!
 //! A scan of a single multiplexer selection takes ca. 50 uS on a LPC1769 with MIOS32_SPI_PRESCALER_8
 //!
+//! With AINSER_DMA_SCAN the conversions are transfered in background,
+//! and the results are evaluated with the next AINSER_Handler() call.
+//!
 //! Whenever a pin has changed, the given callback function will be called.\n
 //! Example:
 //! \code
@@ -277,20 +322,30 @@ s32 AINSER_PreviousPinValueGet(void)
 /////////////////////////////////////////////////////////////////////////////
 s32 AINSER_Handler(void (*_callback)(u32 module, u32 pin, u32 value))
 {
-  // the mux_ctr -> pin mappin is layout dependend
-  //const u8 mux_pin_map[8] = {0, 1, 2, 3, 4, 5, 6, 7 };
-  //const u8 mux_pin_map[8] = {1, 4, 3, 5, 2, 7, 0, 6 }; // reversed pins
-  const u8 mux_pin_map[8] = {6, 3, 4, 2, 5, 0, 7, 1 }; // order of MUX channels
   static u8 mux_ctr = 0; // will be incremented on each update to select the next AIN pin
   static u8 first_scan_done = 0;
   static u16 link_status_ctr = 0;
-  s32 status = 0;
+
+#if AINSER_DMA_SCAN
+  // previous frame still in progress? Try again with the next call
+  if( frame_busy )
+    return 0; // no error
+
+  // evaluate the conversion results of the previous frame
+  if( frame_mux_ctr < 8 ) {
+    AINSER_FrameEvaluate(first_scan_done, _callback);
+
+    // one complete scan done?
+    if( frame_mux_ctr == 7 )
+      first_scan_done = 1;
+  }
+#endif
 
   // init SPI port for fast frequency access
   // we will do this here, so that other handlers (e.g. AOUT) could use SPI in different modes
   // Maxmimum allowed SCLK is 2 MHz according to datasheet
   // We select prescaler 64 @120 MHz (-> ca. 500 nS period)
-  status |= MIOS32_SPI_TransferModeInit(AINSER_SPI, MIOS32_SPI_MODE_CLK0_PHASE0, MIOS32_SPI_PRESCALER_64);
+  MIOS32_SPI_TransferModeInit(AINSER_SPI, MIOS32_SPI_MODE_CLK0_PHASE0, MIOS32_SPI_PRESCALER_64);
 
   // determine next MUX selection
   int next_mux_ctr = (mux_ctr + 1) % 8;
@@ -304,6 +359,63 @@ s32 AINSER_Handler(void (*_callback)(u32 module, u32 pin, u32 value))
     pwm_duty = pwm_period-pwm_duty; // negative direction each 20*25 ticks
   u32 link_status = ((link_status_ctr % pwm_period) > pwm_duty) ? 1 : 0;
 
+  // prepare the conversions of all enabled modules
+  AINSER_FrameBuild(mux_ctr, next_mux_ctr, link_status);
+
+#if AINSER_DMA_SCAN
+  // start the transfer, it's continued from the DMA interrupt
+  if( frame_num ) {
+    frame_busy = 1;
+    frame_pos = 0;
+    AINSER_SetCs(frame_module[0], 0);
+    if( MIOS32_SPI_TransferBlock(AINSER_SPI, frame_tx[0], frame_rx[0], 3, AINSER_FrameTransferNext) < 0 ) {
+      AINSER_SetCs(frame_module[0], 1);
+      frame_num = 0;
+      frame_busy = 0;
+    }
+  }
+#else
+  // retrieve conversion values
+  int i;
+  for(i=0; i<frame_num; ++i) {
+    u8 *tx = frame_tx[i];
+    u8 *rx = frame_rx[i];
+
+    // CS=0
+    AINSER_SetCs(frame_module[i], 0);
+
+    // shift in start bit + SGL + MSB of channel selection, shift out dummy byte
+    rx[0] = MIOS32_SPI_TransferByte(AINSER_SPI, tx[0]);
+    // shift in remaining 2 bits of channel selection, shift out MSBs of conversion value
+    rx[1] = MIOS32_SPI_TransferByte(AINSER_SPI, tx[1]);
+    // shift in mux_ctr + "Link LED" status to 74HC595, shift out LSBs of conversion value
+    rx[2] = MIOS32_SPI_TransferByte(AINSER_SPI, tx[2]);
+
+    // CS=1 (the rising edge will update the 74HC595)
+    AINSER_SetCs(frame_module[i], 1);
+  }
+
+  AINSER_FrameEvaluate(first_scan_done, _callback);
+
+  // one complete scan done?
+  if( next_mux_ctr == 0 )
+    first_scan_done = 1;
+#endif
+
+  // select MUX input
+  mux_ctr = next_mux_ctr;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function to prepare the conversion list for a MUX selection
+/////////////////////////////////////////////////////////////////////////////
+static void AINSER_FrameBuild(u8 mux_ctr, u8 next_mux_ctr, u8 link_status)
+{
+  u8 num = 0;
+
   // loop over connected modules
   int module;
   u32 module_mask = 1;
@@ -316,50 +428,102 @@ s32 AINSER_Handler(void (*_callback)(u32 module, u32 pin, u32 value))
 
     // loop over channels
     int chn;
-    for(chn=0; chn<8; ++chn) {
-      // CS=0
-      status |= AINSER_SetCs(module, 0);
-
-      // retrieve conversion values
-      // shift in start bit + SGL + MSB of channel selection, shift out dummy byte
-      MIOS32_SPI_TransferByte(AINSER_SPI, 0x06 | (chn>>2));
-      // shift in remaining 2 bits of channel selection, shift out MSBs of conversion value
-      u8 b1 = MIOS32_SPI_TransferByte(AINSER_SPI, chn << 6);
-      // shift in mux_ctr + "Link LED" status to 74HC595, shift out LSBs of conversion value
-      u8 b2 = MIOS32_SPI_TransferByte(AINSER_SPI, ((chn == 7 ? next_mux_ctr : mux_ctr) << 5) | link_status);
-
-      // CS=1 (the rising edge will update the 74HC595)
-      AINSER_SetCs(module, 1);
-
-      // store conversion value if difference to old value is outside the deadband
-      u16 pin = muxed ? (mux_pin_map[mux_ctr] + 8*(7-chn)) : (7-chn); // the mux/chn -> pin mapping is layout dependend
-      u16 value = (b2 | (b1 << 8)) & 0xfff;
-      previous_ain_pin_value = ain_pin_values[module][pin];
-      int diff = value - previous_ain_pin_value;
-      int abs_diff = (diff > 0 ) ? diff : -diff;
-
-      if( !first_scan_done || abs_diff > ain_deadband[module] ) {
-	ain_pin_values[module][pin] = value;
-
-	// notify callback function
-	// check pin number as well... just to ensure
-	if( first_scan_done && _callback && pin < num_used_pins[module] )
-	  _callback(module, pin, value);
-      }
+    for(chn=0; chn<8; ++chn, ++num) {
+      u8 *tx = frame_tx[num];
+
+      // start bit + SGL + MSB of channel selection
+      tx[0] = 0x06 | (chn>>2);
+      // remaining 2 bits of channel selection
+      tx[1] = chn << 6;
+      // mux_ctr + "Link LED" status for 74HC595
+      tx[2] = ((chn == 7 ? next_mux_ctr : mux_ctr) << 5) | link_status;
+
+      frame_module[num] = module;
+      frame_pin[num] = muxed ? (mux_pin_map[mux_ctr] + 8*(7-chn)) : (7-chn); // the mux/chn -> pin mapping is layout dependend
     }
   }
 
-  // select MUX input
-  mux_ctr = next_mux_ctr;
+  frame_num = num;
+  frame_mux_ctr = mux_ctr;
+}
 
-  // one complete scan done?
-  if( next_mux_ctr == 0 )
-    first_scan_done = 1;
 
-  return 0; // no error
+/////////////////////////////////////////////////////////////////////////////
+// Internal function to evaluate the conversion results of a frame
+// The deadband check is done for all conversions at once, thereafter only
+// the changed pins are taken over and notified
+// If notify == 0 (first scan) all values are taken over without notification
+/////////////////////////////////////////////////////////////////////////////
+static void AINSER_FrameEvaluate(u8 notify, void (*_callback)(u32 module, u32 pin, u32 value))
+{
+  u16 value[AINSER_FRAME_SIZE];
+  u32 changed = 0;
+  int i;
+
+  for(i=0; i<frame_num; ++i) {
+    u8 *rx = frame_rx[i];
+    u8 module = frame_module[i];
+
+    value[i] = ((rx[1] << 8) | rx[2]) & 0xfff;
+    int diff = value[i] - ain_pin_values[module][frame_pin[i]];
+    int abs_diff = (diff > 0 ) ? diff : -diff;
+    changed |= (u32)(abs_diff > ain_deadband[module]) << i;
+  }
+
+  if( !notify )
+    changed = (frame_num >= 32) ? 0xffffffff : ((1 << frame_num) - 1);
+
+  while( changed ) {
+    i = __builtin_ctz(changed);
+    changed &= changed - 1;
+
+    u8 module = frame_module[i];
+    u8 pin = frame_pin[i];
+
+    // store conversion value (difference to old value is outside the deadband)
+    previous_ain_pin_value = ain_pin_values[module][pin];
+    ain_pin_values[module][pin] = value[i];
+
+    // notify callback function
+    // check pin number as well... just to ensure
+    if( notify && _callback && pin < num_used_pins[module] )
+      _callback(module, pin, value[i]);
+  }
 }
 
 
+#if AINSER_DMA_SCAN
+/////////////////////////////////////////////////////////////////////////////
+// Called from the DMA interrupt once a conversion has been transfered
+/////////////////////////////////////////////////////////////////////////////
+static void AINSER_FrameTransferNext(void)
+{
+  u8 pos = frame_pos;
+
+  // CS=1 (the rising edge will update the 74HC595)
+  AINSER_SetCs(frame_module[pos], 1);
+
+  if( ++pos >= frame_num ) {
+    frame_busy = 0; // frame finished
+    return;
+  }
+  frame_pos = pos;
+
+  // CS must stay high for at least 500 nS between conversions
+  MIOS32_DELAY_Wait_uS(1);
+
+  // CS=0 and start next conversion
+  AINSER_SetCs(frame_module[pos], 0);
+  if( MIOS32_SPI_TransferBlock(AINSER_SPI, frame_tx[pos], frame_rx[pos], 3, AINSER_FrameTransferNext) < 0 ) {
+    // transfer failed: only evaluate the conversions which have been done so far
+    AINSER_SetCs(frame_module[pos], 1);
+    frame_num = pos;
+    frame_busy = 0;
+  }
+}
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Internal function to set CS line depending on module
 /////////////////////////////////////////////////////////////////////////////
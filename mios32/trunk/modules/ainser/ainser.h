@@ -55,6 +55,15 @@ extern "C" {
 #endif
 // more CS lines are possible, but not prepared yet (AINSER_SetCs() has to be enhanced)
 
+// Scan the modules in background via SPI DMA?
+// The conversions of a MUX selection are transfered as chained DMA blocks, CS is
+// toggled from the DMA interrupt. The results are evaluated with the next AINSER_Handler() call.
+// Note: other drivers which access AINSER_SPI (e.g. AOUT) shouldn't be called before the
+// frame has been transfered (two modules take ca. 500 uS with the selected prescaler)
+#ifndef AINSER_DMA_SCAN
+#define AINSER_DMA_SCAN 0
+#endif
+
 // should output pins be used in Open Drain mode? (perfect for 3.3V->5V levelshifting)
 #ifndef AINSER_SPI_OUTPUTS_OD
 #if MIOS32_BOARD_MBHP_CORE_STM32
@@ -708,9 +708,9 @@ s32 AOUT_PinSet(u8 pin, u16 value)
       c->incrementer = 0;
       c->value = value;
     } else {
-      c->incrementer = (value - c->value) / c->slewrate;
+      c->incrementer = ((s32)value - (s32)c->value) / c->slewrate;
       if( c->incrementer == 0 )
-	c->incrementer = 1;
+	c->incrementer = (value > c->value) ? 1 : -1;
     }
 
     aout_update_req |= 1 << pin;
@@ -4,6 +4,14 @@
  * provides a resolution of 256x64)
  * Referenced from MIOS32_LCD routines
  *
+ * With APP_LCD_USE_SPI_DMA the display is connected to a hardware SPI port
+ * (default: J19, RC1: CS, RC2: DC). The LCD functions only render into a
+ * local 4bit framebuffer, changed rows are transfered via DMA in background.
+ * J19 supports DMA only on STM32F4, on STM32F1 and LPC17 another SPI port
+ * has to be selected with APP_LCD_SPI.
+ * Set/Write Column/Row Address commands are emulated for the framebuffer,
+ * all other commands are directly forwarded to the display.
+ *
  * ==========================================================================
  *
  *  Copyright (C) 2011 Thorsten Klose (tk@midibox.org)
@@ -18,6 +26,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <mios32.h>
+#include <string.h>
 
 #include <glcd_font.h>
 
@@ -52,12 +61,74 @@
 #define APP_LCD_USE_J10_FOR_CS 0
 #endif
 
+// 0: bytes are shifted out via J15 (serial mode)
+// 1: local framebuffer, transfered via hardware SPI and DMA
+#ifndef APP_LCD_USE_SPI_DMA
+#define APP_LCD_USE_SPI_DMA 0
+#endif
+
+// SPI port, CS and DC lines in framebuffer mode (2: J19, RC1 and RC2)
+// The SPI port shouldn't be used by other drivers (e.g. AOUT or AINSER)
+// The port has to support DMA: on STM32F1 and LPC17 J19 is transfered by
+// software, so that only J16 (0) or J8/9 (1) can be used if they are free
+#ifndef APP_LCD_SPI
+#define APP_LCD_SPI 2
+#endif
+
+#if APP_LCD_USE_SPI_DMA && APP_LCD_SPI == 2 && (defined(MIOS32_FAMILY_STM32F10x) || defined(MIOS32_FAMILY_LPC17xx))
+# error "APP_LCD_USE_SPI_DMA: J19 (APP_LCD_SPI 2) doesn't support DMA on this MIOS32_FAMILY - select another APP_LCD_SPI"
+#endif
+
+#ifndef APP_LCD_SPI_CS_RC_PIN
+#define APP_LCD_SPI_CS_RC_PIN 0
+#endif
+
+#ifndef APP_LCD_SPI_DC_RC_PIN
+#define APP_LCD_SPI_DC_RC_PIN 1
+#endif
+
+// SSD1322 allows max. 10 MHz
+#ifndef APP_LCD_SPI_PRESCALER
+#define APP_LCD_SPI_PRESCALER MIOS32_SPI_PRESCALER_8
+#endif
+
+// first column address of the SSD1322 RAM (each column contains 4 pixels)
+#define APP_LCD_COLUMN_OFFSET 0x1c
+#define APP_LCD_NUM_COLUMNS   (APP_LCD_WIDTH/4)
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
 
 static u32 display_available = 0;
 
+#if APP_LCD_USE_SPI_DMA
+static u8 fb[APP_LCD_HEIGHT][APP_LCD_WIDTH/2]; // 2 pixels per byte
+
+static volatile u8 fb_dirty_row_min; // nothing to transfer if min > max
+static volatile u8 fb_dirty_row_max;
+static volatile u8 fb_transfer_active;
+
+// emulated address commands
+static u8 fb_cmd;
+static u8 fb_cmd_par;
+static u8 fb_col_start, fb_col_end, fb_col;
+static u8 fb_row_start, fb_row_end, fb_row;
+static u8 fb_col_byte;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static void APP_LCD_FB_RowDirty(u8 row);
+static void APP_LCD_FB_Forward(u8 dc, u8 value);
+static void APP_LCD_FB_SendByte(u8 dc, u8 value);
+static void APP_LCD_FB_TransferNext(void);
+static void APP_LCD_FB_TransferFinished(void);
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initializes application specific LCD driver
@@ -70,8 +141,25 @@ s32 APP_LCD_Init(u32 mode)
   if( mode != 0 )
     return -1; // unsupported mode
 
+#if APP_LCD_USE_SPI_DMA
+  if( MIOS32_SPI_IO_Init(APP_LCD_SPI, APP_LCD_OUTPUT_MODE ? MIOS32_SPI_PIN_DRIVER_STRONG_OD : MIOS32_SPI_PIN_DRIVER_STRONG) < 0 )
+    return -2; // failed to initialize SPI port
+  MIOS32_SPI_TransferModeInit(APP_LCD_SPI, MIOS32_SPI_MODE_CLK1_PHASE1, APP_LCD_SPI_PRESCALER);
+  MIOS32_SPI_RC_PinSet(APP_LCD_SPI, APP_LCD_SPI_CS_RC_PIN, 1);
+
+  fb_dirty_row_min = 0xff;
+  fb_dirty_row_max = 0;
+  fb_transfer_active = 0;
+  fb_cmd = 0;
+  fb_col_start = fb_col = 0;
+  fb_col_end = APP_LCD_NUM_COLUMNS-1;
+  fb_row_start = fb_row = 0;
+  fb_row_end = APP_LCD_HEIGHT-1;
+  fb_col_byte = 0;
+#else
   if( MIOS32_BOARD_J15_PortInit(APP_LCD_OUTPUT_MODE) < 0 )
     return -2; // failed to initialize J15
+#endif
 
 #if APP_LCD_USE_J10_FOR_CS
   int pin;
@@ -154,6 +242,55 @@ s32 APP_LCD_Init(u32 mode)
 /////////////////////////////////////////////////////////////////////////////
 s32 APP_LCD_Data(u8 data)
 {
+#if APP_LCD_USE_SPI_DMA
+  switch( fb_cmd ) {
+  case 0x15: // Set_Column_Address
+  case 0x75: { // Set_Row_Address
+    u8 value;
+    if( fb_cmd == 0x15 ) {
+      value = (data < APP_LCD_COLUMN_OFFSET) ? 0 : (data - APP_LCD_COLUMN_OFFSET);
+      if( value >= APP_LCD_NUM_COLUMNS )
+        value = APP_LCD_NUM_COLUMNS-1;
+      if( fb_cmd_par == 0 )
+        fb_col_start = fb_col = value;
+      else
+        fb_col_end = value;
+    } else {
+      value = (data >= APP_LCD_HEIGHT) ? (APP_LCD_HEIGHT-1) : data;
+      if( fb_cmd_par == 0 )
+        fb_row_start = fb_row = value;
+      else
+        fb_row_end = value;
+    }
+    fb_col_byte = 0;
+    ++fb_cmd_par;
+  } break;
+
+  case 0x5c: // Write_RAM
+    fb[fb_row][2*fb_col + fb_col_byte] = data;
+    APP_LCD_FB_RowDirty(fb_row);
+
+    // auto-increment like the SSD1322
+    if( ++fb_col_byte >= 2 ) {
+      fb_col_byte = 0;
+      if( fb_col < fb_col_end ) {
+        ++fb_col;
+      } else {
+        fb_col = fb_col_start;
+        fb_row = (fb_row < fb_row_end) ? (fb_row + 1) : fb_row_start;
+      }
+    }
+    break;
+
+  default:
+    APP_LCD_FB_Forward(1, data);
+  }
+
+  // increment graphical cursor
+  ++mios32_lcd_x;
+
+  return 0; // no error
+#else
 #if 0  // TODO
   // select LCD depending on current cursor position
   // THIS PART COULD BE CHANGED TO ARRANGE THE 8 DISPLAYS ON ANOTHER WAY
@@ -189,6 +326,7 @@ s32 APP_LCD_Data(u8 data)
 #endif
 
   return 0; // no error
+#endif
 }
 
 
@@ -199,6 +337,16 @@ s32 APP_LCD_Data(u8 data)
 /////////////////////////////////////////////////////////////////////////////
 s32 APP_LCD_Cmd(u8 cmd)
 {
+#if APP_LCD_USE_SPI_DMA
+  fb_cmd = cmd;
+  fb_cmd_par = 0;
+
+  // address commands are handled by the framebuffer
+  if( cmd != 0x15 && cmd != 0x75 && cmd != 0x5c )
+    APP_LCD_FB_Forward(0, cmd);
+
+  return 0; // no error
+#else
   // select all LCDs
 #if APP_LCD_USE_J10_FOR_CS
   MIOS32_BOARD_J10_Set(0x00);
@@ -210,6 +358,7 @@ s32 APP_LCD_Cmd(u8 cmd)
   MIOS32_BOARD_J15_SerDataShift(cmd);
 
   return 0; // no error
+#endif
 }
 
 
@@ -220,6 +369,11 @@ s32 APP_LCD_Cmd(u8 cmd)
 /////////////////////////////////////////////////////////////////////////////
 s32 APP_LCD_Clear(void)
 {
+#if APP_LCD_USE_SPI_DMA
+  memset(fb, 0, sizeof(fb));
+  APP_LCD_FB_RowDirty(0);
+  APP_LCD_FB_RowDirty(APP_LCD_HEIGHT-1);
+#else
   u8 i, j;
 
   for (j=0; j<64; j++)
@@ -238,6 +392,7 @@ s32 APP_LCD_Clear(void)
        APP_LCD_Data(0);
     }
   }
+#endif
 
   return 0;
 }
@@ -341,8 +496,38 @@ s32 APP_LCD_BitmapPixelSet(mios32_lcd_bitmap_t bitmap, u16 x, u16 y, u32 colour)
 /////////////////////////////////////////////////////////////////////////////
 s32 APP_LCD_BitmapPrint(mios32_lcd_bitmap_t bitmap)
 {
+#if APP_LCD_USE_SPI_DMA
+  // render into framebuffer: set pixels with max. brightness, cleared pixels with 0
+  int x, y;
+  for(y=0; y<bitmap.height; ++y) {
+    u16 lcd_y = mios32_lcd_y + y;
+    if( lcd_y >= APP_LCD_HEIGHT )
+      break;
+
+    u8 *memory_ptr = bitmap.memory + (y / 8) * bitmap.line_offset;
+    u8 mask = 1 << (y % 8);
+    for(x=0; x<bitmap.width; ++x) {
+      u16 lcd_x = mios32_lcd_x + x;
+      if( lcd_x >= APP_LCD_WIDTH )
+        break;
+
+      u8 *pixel = &fb[lcd_y][lcd_x / 2];
+      if( lcd_x & 1 )
+        *pixel = (*pixel & 0xf0) | ((memory_ptr[x] & mask) ? 0x0f : 0x00);
+      else
+        *pixel = (*pixel & 0x0f) | ((memory_ptr[x] & mask) ? 0xf0 : 0x00);
+    }
+
+    APP_LCD_FB_RowDirty(lcd_y);
+  }
+
+  mios32_lcd_x += bitmap.width;
+
+  return 0; // no error
+#else
   // not implemented yet
   return -1;
+#endif
 
 #if 0
   int line;
@@ -371,3 +556,122 @@ s32 APP_LCD_BitmapPrint(mios32_lcd_bitmap_t bitmap)
 
   return 0; // no error
 }
+
+
+#if APP_LCD_USE_SPI_DMA
+/////////////////////////////////////////////////////////////////////////////
+// Marks a framebuffer row as changed and starts the transfer if the SPI
+// is idle
+/////////////////////////////////////////////////////////////////////////////
+static void APP_LCD_FB_RowDirty(u8 row)
+{
+  u8 start;
+
+  MIOS32_IRQ_Disable();
+  if( row < fb_dirty_row_min )
+    fb_dirty_row_min = row;
+  if( row > fb_dirty_row_max )
+    fb_dirty_row_max = row;
+
+  start = !fb_transfer_active;
+  fb_transfer_active = 1;
+  MIOS32_IRQ_Enable();
+
+  if( start )
+    APP_LCD_FB_TransferNext();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sends a command or parameter directly to the display
+// Waits until an ongoing framebuffer transfer has been finished
+/////////////////////////////////////////////////////////////////////////////
+static void APP_LCD_FB_Forward(u8 dc, u8 value)
+{
+  while( 1 ) {
+    MIOS32_IRQ_Disable();
+    if( !fb_transfer_active ) {
+      fb_transfer_active = 1;
+      MIOS32_IRQ_Enable();
+      break;
+    }
+    MIOS32_IRQ_Enable();
+  }
+
+  APP_LCD_FB_SendByte(dc, value);
+
+  // continue with changed rows (or release the SPI)
+  APP_LCD_FB_TransferNext();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sends a single byte (dc == 0: command, dc == 1: data)
+/////////////////////////////////////////////////////////////////////////////
+static void APP_LCD_FB_SendByte(u8 dc, u8 value)
+{
+  MIOS32_SPI_RC_PinSet(APP_LCD_SPI, APP_LCD_SPI_DC_RC_PIN, dc);
+  MIOS32_SPI_RC_PinSet(APP_LCD_SPI, APP_LCD_SPI_CS_RC_PIN, 0);
+  MIOS32_SPI_TransferByte(APP_LCD_SPI, value);
+  MIOS32_SPI_RC_PinSet(APP_LCD_SPI, APP_LCD_SPI_CS_RC_PIN, 1);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Transfers the changed rows via DMA, or releases the SPI if there are
+// no changes anymore.
+// Only called by the owner of fb_transfer_active (task or DMA callback)
+/////////////////////////////////////////////////////////////////////////////
+static void APP_LCD_FB_TransferNext(void)
+{
+  u8 row_min, row_max;
+
+  MIOS32_IRQ_Disable();
+  row_min = fb_dirty_row_min;
+  row_max = fb_dirty_row_max;
+  if( row_min > row_max ) {
+    fb_transfer_active = 0;
+    MIOS32_IRQ_Enable();
+    return;
+  }
+  fb_dirty_row_min = 0xff;
+  fb_dirty_row_max = 0;
+  MIOS32_IRQ_Enable();
+
+  APP_LCD_FB_SendByte(0, 0x15); // Set_Column_Address
+  APP_LCD_FB_SendByte(1, APP_LCD_COLUMN_OFFSET);
+  APP_LCD_FB_SendByte(1, APP_LCD_COLUMN_OFFSET + APP_LCD_NUM_COLUMNS-1);
+  APP_LCD_FB_SendByte(0, 0x75); // Set_Row_Address
+  APP_LCD_FB_SendByte(1, row_min);
+  APP_LCD_FB_SendByte(1, row_max);
+  APP_LCD_FB_SendByte(0, 0x5c); // Write_RAM
+
+  MIOS32_SPI_RC_PinSet(APP_LCD_SPI, APP_LCD_SPI_DC_RC_PIN, 1);
+  MIOS32_SPI_RC_PinSet(APP_LCD_SPI, APP_LCD_SPI_CS_RC_PIN, 0);
+  if( MIOS32_SPI_TransferBlock(APP_LCD_SPI, &fb[row_min][0], NULL, (row_max-row_min+1) * (APP_LCD_WIDTH/2), APP_LCD_FB_TransferFinished) < 0 ) {
+    // transfer not started (e.g. SPI busy): release the SPI, the rows
+    // will be transfered again with the next change
+    MIOS32_SPI_RC_PinSet(APP_LCD_SPI, APP_LCD_SPI_CS_RC_PIN, 1);
+
+    MIOS32_IRQ_Disable();
+    if( row_min < fb_dirty_row_min )
+      fb_dirty_row_min = row_min;
+    if( row_max > fb_dirty_row_max )
+      fb_dirty_row_max = row_max;
+    fb_transfer_active = 0;
+    MIOS32_IRQ_Enable();
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Called from the DMA interrupt once the rows have been transfered
+/////////////////////////////////////////////////////////////////////////////
+static void APP_LCD_FB_TransferFinished(void)
+{
+  MIOS32_SPI_RC_PinSet(APP_LCD_SPI, APP_LCD_SPI_CS_RC_PIN, 1);
+
+  // rows which have been changed meanwhile
+  APP_LCD_FB_TransferNext();
+}
+#endif
@@ -8,8 +8,15 @@
  *  Licensed for personal non-commercial use only.
  *  All other rights reserved.
  * 
- * The default configuration is currently to use the first serial port for DMX
- * This can be changed in dmx.h
+ * The default configuration is currently to use USART1 for DMX
+ * This can be changed in dmx.h (see DMX_UNIVERSE0_USART2)
+ *
+ * Each universe is double-buffered: the application changes the channels
+ * of a work buffer, DMX_UniverseUpdate() copies the complete universe into
+ * the spare transmit buffer, which is taken over by the interrupt handler
+ * at the end of the current frame. Start code and slots are sent by DMA
+ * (or by the TXE interrupt if the USART has no free DMA channel),
+ * break/MAB is generated with a reduced baudrate.
  * ==========================================================================
  */
 
@@ -18,31 +25,68 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <mios32.h>
-#include <FreeRTOS.h>
-#include <portmacro.h>
-#include <task.h>
-#include <queue.h>
-#include <semphr.h>
-#include <FreeRTOS.h>
-#include <portmacro.h>
+#include <string.h>
 
 #include "dmx.h"
 
-#define PRIORITY_TASK_DMX		( tskIDLE_PRIORITY + 3 )
 
-xSemaphoreHandle xDMXSemaphore;
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  USART_TypeDef *usart;
+  GPIO_TypeDef *tx_port;
+  u16 tx_pin;
+  DMA_Channel_TypeDef *dma;
+  u8 irq_channel;
+} dmx_universe_hw_t;
+
+typedef struct {
+  u8 tx_buffer[2][1+DMX_UNIVERSE_SIZE]; // start code + slots, sent by DMA or TXE interrupt
+  u8 work_buffer[DMX_UNIVERSE_SIZE];    // changed by the application
+  volatile u8 tx_front;   // buffer which is currently sent
+  volatile u8 swap_req;   // the spare buffer contains a new frame
+  volatile u8 state;
+  u16 tx_pos;             // next slot which is sent by the TXE interrupt (if no DMA)
+  u16 dmx_baudrate_brr;   // This stores the contents of the BRR register for DMX sending
+  u16 break_baudrate_brr; // This is the BRR register when sending a break.
+  volatile u32 frame_ctr;
+} dmx_universe_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local constants
+/////////////////////////////////////////////////////////////////////////////
+
+static const dmx_universe_hw_t dmx_universe_hw[DMX_NUM_UNIVERSES] = {
+  { DMX0_USART, DMX0_TX_PORT, DMX0_TX_PIN, DMX0_DMA, DMX0_IRQ_CHANNEL },
+#if DMX_NUM_UNIVERSES > 1
+  { DMX1_USART, DMX1_TX_PORT, DMX1_TX_PIN, DMX1_DMA, DMX1_IRQ_CHANNEL },
+#endif
+#if DMX_NUM_UNIVERSES > 2
+  { DMX2_USART, DMX2_TX_PORT, DMX2_TX_PIN, DMX2_DMA, DMX2_IRQ_CHANNEL },
+#endif
+#if DMX_NUM_UNIVERSES > 3
+  { DMX3_USART, DMX3_TX_PORT, DMX3_TX_PIN, DMX3_DMA, DMX3_IRQ_CHANNEL },
+#endif
+};
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
-static u8 dmx_tx_buffer[DMX_UNIVERSE_SIZE]; // Buffer for outgoing DMX universe.
 
-static u16 dmx_baudrate_brr;		// This stores the contents of the BRR register for DMX sending
-static u16 break_baudrate_brr;	// This is the BRR register when sending a break.
-static volatile u16	dmx_current_channel;
-static volatile u8 dmx_state;
+static dmx_universe_t dmx_universe[DMX_NUM_UNIVERSES];
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static void DMX_USART_ClockEnable(USART_TypeDef *usart);
+static void DMX_BreakStart(u8 universe);
 
-static void TASK_DMX(void *pvParameters);
 
 ////////////////////////////////////////////////////////////////////////////
 //! Initialize DMX Interface
@@ -51,155 +95,281 @@ static void TASK_DMX(void *pvParameters);
 /////////////////////////////////////////////////////////////////////////////
 s32 DMX_Init(u32 mode)
 {
+  int universe;
 
   // currently only mode 0 supported
   if( mode != 0 )
     return -1; // unsupported mode
-  // configure UART pins
-	GPIO_InitTypeDef GPIO_InitStructure;
-  GPIO_StructInit(&GPIO_InitStructure);
-  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_2MHz;
-
-  // outputs as push-pull
-  GPIO_InitStructure.GPIO_Pin = DMX_TX_PIN;
-  GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
-  GPIO_Init(DMX_TX_PORT, &GPIO_InitStructure);	
-	
-  // inputs with internal pull-up
-  GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IPU;
-  GPIO_InitStructure.GPIO_Pin = DMX_RX_PIN;
-  GPIO_Init(DMX_RX_PORT, &GPIO_InitStructure);
-	
-  // enable USART clock
-  RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1, ENABLE);
-
-	// Set DMX data format and baud rate (8 bit, 2 stop bits and 250000 baud)
-  USART_InitTypeDef USART_InitStructure;
-  USART_InitStructure.USART_WordLength = USART_WordLength_8b;
-  USART_InitStructure.USART_StopBits = USART_StopBits_2;
-  USART_InitStructure.USART_Parity = USART_Parity_No;
-  USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
-  USART_InitStructure.USART_Mode = USART_Mode_Tx | USART_Mode_Rx;
-
-  USART_InitStructure.USART_BaudRate = BREAK_BAUDRATE;
-  USART_Init(DMX, &USART_InitStructure);
-  break_baudrate_brr=DMX->BRR;	// Store the BRR value for quick changes.
-
-  USART_InitStructure.USART_BaudRate = DMX_BAUDRATE;
-  USART_Init(DMX, &USART_InitStructure);
-  dmx_baudrate_brr=DMX->BRR;	// Store the BRR value for quick changes.
-	
-	// configure and enable UART interrupts
-  NVIC_InitTypeDef NVIC_InitStructure;
-
-  NVIC_InitStructure.NVIC_IRQChannel = DMX_IRQ_CHANNEL;
-  NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 11; //MIOS32_IRQ_UART_PRIORITY; // defined in mios32_irq.h
-  NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
-  NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
-  NVIC_Init(&NVIC_InitStructure);
-	USART_Cmd(DMX, ENABLE); 
-	dmx_state=DMX_IDLE;
-	dmx_current_channel=0;
-	// Create timer to send DMX universe.
-	vSemaphoreCreateBinary(xDMXSemaphore);
-  xTaskCreate(TASK_DMX, (signed portCHAR *)"DMX", configMINIMAL_STACK_SIZE, NULL, PRIORITY_TASK_DMX, NULL);
-	return 0;
+
+  RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+  for(universe=0; universe<DMX_NUM_UNIVERSES; ++universe) {
+    const dmx_universe_hw_t *hw = &dmx_universe_hw[universe];
+    dmx_universe_t *u = &dmx_universe[universe];
+
+    // all channels off, start code 0
+    memset(u, 0, sizeof(dmx_universe_t));
+    u->state = DMX_IDLE;
+
+    // configure UART pin
+    GPIO_InitTypeDef GPIO_InitStructure;
+    GPIO_StructInit(&GPIO_InitStructure);
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_2MHz;
+
+    // output as push-pull
+    GPIO_InitStructure.GPIO_Pin = hw->tx_pin;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+    GPIO_Init(hw->tx_port, &GPIO_InitStructure);
+
+    // enable USART clock
+    DMX_USART_ClockEnable(hw->usart);
+
+    // Set DMX data format and baud rate (8 bit, 2 stop bits and 250000 baud)
+    USART_InitTypeDef USART_InitStructure;
+    USART_InitStructure.USART_WordLength = USART_WordLength_8b;
+    USART_InitStructure.USART_StopBits = USART_StopBits_2;
+    USART_InitStructure.USART_Parity = USART_Parity_No;
+    USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+    USART_InitStructure.USART_Mode = USART_Mode_Tx;
+
+    USART_InitStructure.USART_BaudRate = BREAK_BAUDRATE;
+    USART_Init(hw->usart, &USART_InitStructure);
+    u->break_baudrate_brr = hw->usart->BRR; // Store the BRR value for quick changes.
+
+    USART_InitStructure.USART_BaudRate = DMX_BAUDRATE;
+    USART_Init(hw->usart, &USART_InitStructure);
+    u->dmx_baudrate_brr = hw->usart->BRR; // Store the BRR value for quick changes.
+
+    // DMA channel: transmit buffer -> USART data register
+    // (memory address and length are set whenever a frame is started)
+    if( hw->dma != NULL ) {
+      if( (u32)hw->dma >= (u32)DMA2_Channel1 )
+        RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA2, ENABLE);
+
+      DMA_Cmd(hw->dma, DISABLE);
+      DMA_InitTypeDef DMA_InitStructure;
+      DMA_StructInit(&DMA_InitStructure);
+      DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)&hw->usart->DR;
+      DMA_InitStructure.DMA_MemoryBaseAddr = (u32)&u->tx_buffer[0][0];
+      DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+      DMA_InitStructure.DMA_BufferSize = 1+DMX_UNIVERSE_SIZE;
+      DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+      DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+      DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+      DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+      DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+      DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+      DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+      DMA_Init(hw->dma, &DMA_InitStructure);
+      USART_DMACmd(hw->usart, USART_DMAReq_Tx, ENABLE);
+    }
+
+    // configure and enable UART interrupt (TC, and TXE if no DMA channel is available)
+    MIOS32_IRQ_Install(hw->irq_channel, DMX_IRQ_PRIORITY);
+    USART_Cmd(hw->usart, ENABLE);
+    USART_ITConfig(hw->usart, USART_IT_TC, ENABLE);
+
+    // frames are sent endless from now on
+    MIOS32_IRQ_Disable();
+    DMX_BreakStart(universe);
+    MIOS32_IRQ_Enable();
+  }
+
+  return 0;
 }
 
+
 /////////////////////////////////////////////////////////////////////////////
-// This task handles sending the DMX universe
+//! Change the value of a single channel in the work buffer of a universe
+//! The change will be sent with the next DMX_UniverseUpdate()
 /////////////////////////////////////////////////////////////////////////////
-static void TASK_DMX(void *pvParameters)
+s32 DMX_UniverseSetChannel(u8 universe, u16 channel, u8 value)
 {
-  portTickType xLastExecutionTime;
-
-  // Initialise the xLastExecutionTime variable on task entry
-  xLastExecutionTime = xTaskGetTickCount();
-
-  while( 1 ) {
-    vTaskDelayUntil(&xLastExecutionTime, 35 / portTICK_RATE_MS);
-		if (dmx_state==DMX_IDLE)
-		{
-		  if (xSemaphoreTake(xDMXSemaphore, 10)==pdTRUE) { // Stop the universe from being changed while we are sending it.
-		    // send break and MAB with slow baudrate
-		    DMX->SR &= ~USART_FLAG_TC;
-		    USART_ITConfig(DMX, USART_IT_TC, ENABLE); // enable TC interrupt - triggered when transmission of break/MAB is completed
-		    DMX->BRR=break_baudrate_brr;		// Set baudrate to 90.9K so send break/MAB
-		    dmx_state=DMX_BREAK;
-		    //DMX->DR = 0x80;                           // start transmission (MSB used for MAB)
-		    DMX->DR = 0x00;                           // start transmission (stop bits provide MAB)
-		  }
-		}
-  }
+  if( universe >= DMX_NUM_UNIVERSES || channel >= DMX_UNIVERSE_SIZE )
+    return -1;
+
+  dmx_universe[universe].work_buffer[channel] = value;
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Get the value of a single channel from the work buffer of a universe
+/////////////////////////////////////////////////////////////////////////////
+s32 DMX_UniverseGetChannel(u8 universe, u16 channel)
+{
+  if( universe >= DMX_NUM_UNIVERSES || channel >= DMX_UNIVERSE_SIZE )
+    return -1;
+
+  return dmx_universe[universe].work_buffer[channel];
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Takes over the work buffer of a universe into the spare transmit buffer.
+//! It will be sent as a whole, starting with the next frame.
+//! Has to be called from task context, a pending update which hasn't been
+//! sent yet is replaced.
+/////////////////////////////////////////////////////////////////////////////
+s32 DMX_UniverseUpdate(u8 universe)
+{
+  if( universe >= DMX_NUM_UNIVERSES )
+    return -1;
+
+  dmx_universe_t *u = &dmx_universe[universe];
+
+  // once the request is cleared, the interrupt handler won't switch the
+  // buffers anymore, so that the spare buffer can be written safely
+  u->swap_req = 0;
+  memcpy(&u->tx_buffer[u->tx_front ^ 1][1], u->work_buffer, DMX_UNIVERSE_SIZE);
+  u->swap_req = 1;
+
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return the number of frames which have been sent for a universe
+/////////////////////////////////////////////////////////////////////////////
+u32 DMX_UniverseFrameCtrGet(u8 universe)
+{
+  if( universe >= DMX_NUM_UNIVERSES )
+    return 0;
+
+  return dmx_universe[universe].frame_ctr;
 }
 
+
 /////////////////////////////////////////////////////////////////////////////
-// Change the value of a single channel
+//! Change the value of a single channel of universe 0
 /////////////////////////////////////////////////////////////////////////////
 s32 DMX_SetChannel(u16 channel, u8 value)
 {
-	
-	if (channel<DMX_UNIVERSE_SIZE) {
-			//if (xSemaphoreTake(xDMXSemaphore, 1)==pdTRUE)
-			//{
-				dmx_tx_buffer[channel]=value;
-			//	xSemaphoreGive(xDMXSemaphore);
-			//}
-	}
-	else 
-		return -1;
-	return 0;
-	
-	}
-
-/////////////////////////////////////////////////////////////////////////////
-// Get the value of a single channel
+  return DMX_UniverseSetChannel(0, channel, value);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Get the value of a single channel of universe 0
 /////////////////////////////////////////////////////////////////////////////
 s32 DMX_GetChannel(u16 channel)
 {
-	if (channel<DMX_UNIVERSE_SIZE) {
-		u32 val=(s32)dmx_tx_buffer[channel];
-		return val;
-	}
-	else 
-		return -1;
+  return DMX_UniverseGetChannel(0, channel);
 }
 
+/////////////////////////////////////////////////////////////////////////////
+//! Sends the changed channels of universe 0
+/////////////////////////////////////////////////////////////////////////////
+s32 DMX_Update(void)
+{
+  return DMX_UniverseUpdate(0);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Enables the USART clock
+/////////////////////////////////////////////////////////////////////////////
+static void DMX_USART_ClockEnable(USART_TypeDef *usart)
+{
+  if( usart == USART1 )
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_USART1, ENABLE);
+  else if( usart == USART2 )
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_USART2, ENABLE);
+  else if( usart == USART3 )
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_USART3, ENABLE);
+  else if( usart == UART4 )
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_UART4, ENABLE);
+}
 
 
 /////////////////////////////////////////////////////////////////////////////
-// Interrupt handler for DMX UART
+// Starts the break/MAB with slow baudrate
+// (called with disabled interrupts or from the interrupt handler)
 /////////////////////////////////////////////////////////////////////////////
-signed portBASE_TYPE x=pdFALSE;
-DMX_IRQHANDLER_FUNC
+static void DMX_BreakStart(u8 universe)
 {
-  if( (dmx_state == DMX_BREAK) && (DMX->SR & USART_FLAG_TC) ) { // Transmission Complete flag
-    // the combined break/MAB has been sent - disable TC interrupt, clear current TXE and enable TXE for next byte
-    USART_ITConfig(DMX, USART_IT_TC, DISABLE);
-    DMX->SR &= ~USART_FLAG_TXE;
-    USART_ITConfig(DMX, USART_IT_TXE, ENABLE);
-
-    dmx_current_channel=0;
-    DMX->BRR=dmx_baudrate_brr;		// Set baudrate to 250K to send universe
-    DMX->DR = 0x00; // start code
-    dmx_state=DMX_SENDING;
+  const dmx_universe_hw_t *hw = &dmx_universe_hw[universe];
+  dmx_universe_t *u = &dmx_universe[universe];
+
+  if( hw->dma != NULL )
+    hw->dma->CCR &= ~DMA_CCR1_EN;
+  hw->usart->SR &= ~USART_FLAG_TC;
+  hw->usart->BRR = u->break_baudrate_brr; // Set baudrate to 40K so send break/MAB
+  u->state = DMX_BREAK;
+  hw->usart->DR = 0x00; // start transmission (stop bits provide MAB)
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Interrupt handler for DMX UARTs
+// With DMA only two interrupts per frame: break/MAB completed, and frame completed
+// Without DMA the slots are additionally sent with the TXE interrupt
+/////////////////////////////////////////////////////////////////////////////
+static void DMX_IRQHandler(u8 universe)
+{
+  const dmx_universe_hw_t *hw = &dmx_universe_hw[universe];
+  dmx_universe_t *u = &dmx_universe[universe];
+
+  if( u->state == DMX_SENDING && u->tx_pos < (1+DMX_UNIVERSE_SIZE) ) {
+    // no DMA: send next slot
+    if( hw->usart->SR & USART_FLAG_TXE ) {
+      hw->usart->DR = u->tx_buffer[u->tx_front][u->tx_pos];
+      if( ++u->tx_pos >= (1+DMX_UNIVERSE_SIZE) )
+	USART_ITConfig(hw->usart, USART_IT_TXE, DISABLE); // TC notifies the end of frame
+    }
+    return;
   }
 
-  if( DMX->SR & USART_FLAG_TXE ) {
-    // send next byte
-    if( (dmx_state==DMX_SENDING) && (dmx_current_channel < DMX_UNIVERSE_SIZE) ) {
-      s32 c=DMX_GetChannel(dmx_current_channel);
-      DMX->DR=c; 
-      dmx_current_channel++;
+  if( !(hw->usart->SR & USART_FLAG_TC) )
+    return;
+
+  if( u->state == DMX_BREAK ) {
+    // the combined break/MAB has been sent - start code and slots are sent by DMA
+    hw->usart->SR &= ~USART_FLAG_TC;
+    hw->usart->BRR = u->dmx_baudrate_brr; // Set baudrate to 250K to send universe
+    if( hw->dma != NULL ) {
+      hw->dma->CMAR = (u32)&u->tx_buffer[u->tx_front][0];
+      hw->dma->CNDTR = 1+DMX_UNIVERSE_SIZE;
+      hw->dma->CCR |= DMA_CCR1_EN;
+      u->tx_pos = 1+DMX_UNIVERSE_SIZE;
     } else {
-      // all bytes have been sent
-      dmx_state = DMX_IDLE;
-      USART_ITConfig(DMX, USART_IT_TXE, DISABLE);
-      MIOS32_BOARD_LED_Set(0xffffffff, ~MIOS32_BOARD_LED_Get());
-      xSemaphoreGiveFromISR(xDMXSemaphore,&x);
+      u->tx_pos = 0;
+      USART_ITConfig(hw->usart, USART_IT_TXE, ENABLE);
     }
+    u->state = DMX_SENDING;
+  } else {
+    // frame completed: switch to the new frame (if available) and continue with next break
+    if( u->swap_req ) {
+      u->tx_front ^= 1;
+      u->swap_req = 0;
+    }
+    ++u->frame_ctr;
+
+    if( universe == 0 )
+      MIOS32_BOARD_LED_Set(0xffffffff, ~MIOS32_BOARD_LED_Get());
+
+    DMX_BreakStart(universe);
   }
 }
 
+DMX0_IRQHANDLER_FUNC
+{
+  DMX_IRQHandler(0);
+}
+
+#if DMX_NUM_UNIVERSES > 1
+DMX1_IRQHANDLER_FUNC
+{
+  DMX_IRQHandler(1);
+}
+#endif
 
-	
+#if DMX_NUM_UNIVERSES > 2
+DMX2_IRQHANDLER_FUNC
+{
+  DMX_IRQHandler(2);
+}
+#endif
+
+#if DMX_NUM_UNIVERSES > 3
+DMX3_IRQHANDLER_FUNC
+{
+  DMX_IRQHandler(3);
+}
+#endif
@@ -23,21 +23,114 @@
 #define DMX_BREAK	1
 #define DMX_SENDING	2
 
-#define DMX_TX_PORT     GPIOA
-#define DMX_TX_PIN      GPIO_Pin_9
-#define DMX_RX_PORT     GPIOA
-#define DMX_RX_PIN      GPIO_Pin_10
-#define DMX             USART1
-#define DMX_IRQ_CHANNEL USART1_IRQn
-#define DMX_IRQHANDLER_FUNC void USART1_IRQHandler(void)
+// number of universes (1..4)
+// Each universe is sent by its own USART, the start code + 512 slots are
+// transfered by DMA (if available, see below), the CPU only gets two
+// interrupts per frame (end of break/MAB and end of frame). Frames are sent
+// back-to-back (ca. 44 Hz).
+#ifndef DMX_NUM_UNIVERSES
+#define DMX_NUM_UNIVERSES 1
+#endif
+
+#ifndef DMX_IRQ_PRIORITY
+#define DMX_IRQ_PRIORITY 11
+#endif
+
+// USART/DMA assignments of the universes (STM32F10x)
+// Note: USART1 (DMA1 Channel 4) and USART3 (DMA1 Channel 2) share their
+// DMA channels with the RX streams of MIOS32_SPI1 (SRIO) and MIOS32_SPI0
+// (SD Card). Therefore a universe on USART1 sends its slots with the TXE
+// interrupt (DMXn_DMA is NULL), which costs one interrupt per slot.
+// Universe 3 can only be used if the SD Card doesn't run DMA transfers!
+//
+// By default universe 0 uses USART1 (Tx: PA9) like the MBHP_DMX module
+// has always been connected, universe 1 UART4 (Tx: PC10), universe 2
+// USART2 (Tx: PA2) and universe 3 USART3 (Tx: PB10).
+//
+// With DMX_UNIVERSE0_USART2 set to 1, universe 0 and 2 are swapped: universe 0
+// is sent from USART2 (Tx: PA2) by DMA, so that it only needs two interrupts
+// per frame. The module has to be connected to PA2 in this case!
+#ifndef DMX_UNIVERSE0_USART2
+#define DMX_UNIVERSE0_USART2 0
+#endif
+
+#if DMX_UNIVERSE0_USART2
+#define DMX_USART1_UNIVERSE 2
+#define DMX_USART2_UNIVERSE 0
+#else
+#define DMX_USART1_UNIVERSE 0
+#define DMX_USART2_UNIVERSE 2
+#endif
+
+#if DMX_USART1_UNIVERSE == 0 && !defined(DMX0_USART)
+#define DMX0_USART      USART1
+#define DMX0_TX_PORT    GPIOA
+#define DMX0_TX_PIN     GPIO_Pin_9
+#define DMX0_DMA        NULL
+#define DMX0_IRQ_CHANNEL USART1_IRQn
+#define DMX0_IRQHANDLER_FUNC void USART1_IRQHandler(void)
+#endif
+
+#if DMX_USART2_UNIVERSE == 0 && !defined(DMX0_USART)
+#define DMX0_USART      USART2
+#define DMX0_TX_PORT    GPIOA
+#define DMX0_TX_PIN     GPIO_Pin_2
+#define DMX0_DMA        DMA1_Channel7
+#define DMX0_IRQ_CHANNEL USART2_IRQn
+#define DMX0_IRQHANDLER_FUNC void USART2_IRQHandler(void)
+#endif
+
+#ifndef DMX1_USART
+#define DMX1_USART      UART4
+#define DMX1_TX_PORT    GPIOC
+#define DMX1_TX_PIN     GPIO_Pin_10
+#define DMX1_DMA        DMA2_Channel5
+#define DMX1_IRQ_CHANNEL UART4_IRQn
+#define DMX1_IRQHANDLER_FUNC void UART4_IRQHandler(void)
+#endif
+
+#if DMX_USART1_UNIVERSE == 2 && !defined(DMX2_USART)
+#define DMX2_USART      USART1
+#define DMX2_TX_PORT    GPIOA
+#define DMX2_TX_PIN     GPIO_Pin_9
+#define DMX2_DMA        NULL
+#define DMX2_IRQ_CHANNEL USART1_IRQn
+#define DMX2_IRQHANDLER_FUNC void USART1_IRQHandler(void)
+#endif
+
+#if DMX_USART2_UNIVERSE == 2 && !defined(DMX2_USART)
+#define DMX2_USART      USART2
+#define DMX2_TX_PORT    GPIOA
+#define DMX2_TX_PIN     GPIO_Pin_2
+#define DMX2_DMA        DMA1_Channel7
+#define DMX2_IRQ_CHANNEL USART2_IRQn
+#define DMX2_IRQHANDLER_FUNC void USART2_IRQHandler(void)
+#endif
+
+#ifndef DMX3_USART
+#define DMX3_USART      USART3
+#define DMX3_TX_PORT    GPIOB
+#define DMX3_TX_PIN     GPIO_Pin_10
+#define DMX3_DMA        DMA1_Channel2
+#define DMX3_IRQ_CHANNEL USART3_IRQn
+#define DMX3_IRQHANDLER_FUNC void USART3_IRQHandler(void)
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
 // Global definitions
 /////////////////////////////////////////////////////////////////////////////
 s32 DMX_Init(u32 mode);
+
+s32 DMX_UniverseSetChannel(u8 universe, u16 channel, u8 value);
+s32 DMX_UniverseGetChannel(u8 universe, u16 channel);
+s32 DMX_UniverseUpdate(u8 universe);
+u32 DMX_UniverseFrameCtrGet(u8 universe);
+
+// universe 0
 s32 DMX_SetChannel(u16 channel, u8 value);
 s32 DMX_GetChannel(u16 channel);
+s32 DMX_Update(void);
 
 
 
@@ -61,9 +61,16 @@ static u8 connected_keyboards_num;
 static u16 din_value[KEYBOARD_NUM][MATRIX_NUM_ROWS];
 static u16 din_value_changed[KEYBOARD_NUM][MATRIX_NUM_ROWS];
 
-// for velocity
-static u16 timestamp;
-static u16 din_activated_timestamp[KEYBOARD_NUM][KEYBOARD_NUM_PINS];
+// for velocity (uS timestamps, 0 is used as reset value)
+static u32 scan_timestamp;
+static u32 din_activated_timestamp[KEYBOARD_NUM][KEYBOARD_NUM_PINS];
+
+// pin changes, written by KEYBOARD_SRIO_ServiceFinish(), read by KEYBOARD_Periodic_1mS()
+static keyboard_event_t event_queue[KEYBOARD_EVENT_QUEUE_SIZE];
+static volatile u16 event_queue_head;
+static volatile u16 event_queue_tail;
+static volatile u8  event_queue_overrun;
+static u32 event_queue_overruns;
 
 #if (KEYBOARD_NUM_PINS % 8)
 # error "KEYBOARD_NUM_PINS must be dividable by 8!"
@@ -88,6 +95,7 @@ static s32 KEYBOARD_MIDI_SendCtrl(u8 kb, u8 ctrl_number, u8 value);
 #endif
 static char *KEYBOARD_GetNoteName(u8 note, char str[4]);
 static int KEYBOARD_GetVelocity(u16 delay, u16 delay_slowest, u16 delay_fastest);
+static u16 KEYBOARD_GetDelay(u32 ts_first, u32 ts_second);
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -105,6 +113,11 @@ s32 KEYBOARD_Init(u32 mode)
   ain_cali_mode_pin = 0;
 #endif
 
+  event_queue_head = 0;
+  event_queue_tail = 0;
+  event_queue_overrun = 0;
+  event_queue_overruns = 0;
+
   int kb;
   keyboard_config_t *kc = (keyboard_config_t *)&keyboard_config[0];
   for(kb=0; kb<KEYBOARD_NUM; ++kb, ++kc) {
@@ -202,7 +215,7 @@ s32 KEYBOARD_Init(u32 mode)
 
     // initialize timestamps
     int i;
-    timestamp = 0;
+    scan_timestamp = 0;
     for(i=0; i<KEYBOARD_NUM_PINS; ++i) {
       din_activated_timestamp[kb][i] = 0;
     }
@@ -239,11 +252,6 @@ u8 KEYBOARD_ConnectedNumGet(void)
 /////////////////////////////////////////////////////////////////////////////
 void KEYBOARD_SRIO_ServicePrepare(void)
 {
-  // increment timestamp for velocity delay measurements
-  // but skip 0, which is used as reset of ts_make and ts_break values
-  if ( !(++timestamp))
-    ++timestamp;
-
   int kb;
   keyboard_config_t *kc = (keyboard_config_t *)&keyboard_config[0];
   for(kb=0; kb<connected_keyboards_num; ++kb, ++kc) {
@@ -312,6 +320,13 @@ void KEYBOARD_SRIO_ServicePrepare(void)
 /////////////////////////////////////////////////////////////////////////////
 void KEYBOARD_SRIO_ServiceFinish(void)
 {
+  // timestamp for velocity delay measurements, taken at the end of the scan
+  // skip 0, which is used as reset of ts_make and ts_break values
+  u32 timestamp = MIOS32_TIMESTAMP_Get_uS();
+  if( !timestamp )
+    ++timestamp;
+  scan_timestamp = timestamp;
+
   // check DINs
   int kb;
   keyboard_config_t *kc = (keyboard_config_t *)&keyboard_config[0];
@@ -358,7 +373,7 @@ void KEYBOARD_SRIO_ServiceFinish(void)
       int pins_per_row = kc->din_sr2 ? 16 : 8;
       u8 sr_pin;
       u16 mask = 0x01;
-      u16 *ts_ptr = (u16 *)&din_activated_timestamp[kb][prev_row * MATRIX_NUM_ROWS];
+      u32 *ts_ptr = (u32 *)&din_activated_timestamp[kb][prev_row * MATRIX_NUM_ROWS];
 
       /*-----------------02.03.2013 13:31-----------------
        * key on velocity only : 40,4 us over all 16 scanlines -> 2,53 us/row
@@ -396,6 +411,33 @@ void KEYBOARD_SRIO_ServiceFinish(void)
 	}
       }
 /* --------------------------------------------------*/
+
+      // queue the pin changes for KEYBOARD_Periodic_1mS()
+      // on overrun the changes are only available in din_value_changed[] until the queue has been processed
+      if( !event_queue_overrun ) {
+	u16 pending = changed;
+	while( pending ) {
+	  u16 next_head = event_queue_head + 1;
+	  if( next_head >= KEYBOARD_EVENT_QUEUE_SIZE )
+	    next_head = 0;
+
+	  if( next_head == event_queue_tail ) {
+	    event_queue_overrun = 1;
+	    ++event_queue_overruns;
+	    break;
+	  }
+
+	  u8 sr_pin = __builtin_ctz(pending);
+	  pending &= pending - 1;
+
+	  keyboard_event_t *ev = &event_queue[event_queue_head];
+	  ev->kb = kb;
+	  ev->row = prev_row;
+	  ev->column = sr_pin;
+	  ev->depressed = (sr_value & (1 << sr_pin)) ? 1 : 0;
+	  event_queue_head = next_head;
+	}
+      }
     }
   }
 }
@@ -504,8 +546,8 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
   }
 
   // determine timestamps pointers between break and make contact
-  u16 *ts_break_ptr = (u16 *)&din_activated_timestamp[kb][pin_break];
-  u16 *ts_make_ptr  = (u16 *)&din_activated_timestamp[kb][pin_make];
+  u32 *ts_break_ptr = (u32 *)&din_activated_timestamp[kb][pin_break];
+  u32 *ts_make_ptr  = (u32 *)&din_activated_timestamp[kb][pin_make];
 
   if( kc->verbose_level >= 2 )
     DEBUG_MSG("Entry: timestamp_break=%d timestamp_make=%d\n", *ts_break_ptr, *ts_make_ptr);
@@ -563,7 +605,7 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
 		    break_contact ? "Break" : "Make",
 		    depressed ? "released without" : "pressed with remaining",
 		    break_contact ? "ts_make" : "ts_break",
-		    timestamp, *ts_break_ptr, *ts_make_ptr);
+		    scan_timestamp, *ts_break_ptr, *ts_make_ptr);
 
 	if( !kc->break_is_make )
 	  return;
@@ -587,9 +629,9 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
           !(din_value_changed[kb][row_make] & key16_mask) && (din_value[kb][row_make] & key16_mask) ) {
 	if( kc->verbose_level >= 2 )
 	  DEBUG_MSG("RELEASED note=%s\n", KEYBOARD_GetNoteName(note_number, note_str));
-	// and the delta delay (IMPORTANT: delay variable needs same resolution like timestamps to handle overrun correctly!)
+	// and the delta delay
         MIOS32_IRQ_Disable();
-	u16 delay = *ts_break_ptr - *ts_make_ptr;
+	u16 delay = KEYBOARD_GetDelay(*ts_make_ptr, *ts_break_ptr);
 	*ts_make_ptr = 0;
 	*ts_break_ptr = 0;
         MIOS32_IRQ_Enable();
@@ -649,9 +691,9 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
         // or make contact reached (1->0) (not bouncing yet) and break contact remains pressed (0) ?
 	(note_trigger_contact && *ts_break_ptr &&
 	 !(din_value_changed[kb][row_break] & key16_mask) && !(din_value[kb][row_break] & key16_mask)) ) {
-      // and the delta delay (IMPORTANT: delay variable needs same resolution like timestamps to handle overrun correctly!)
+      // and the delta delay
       MIOS32_IRQ_Disable();
-      u16 delay = *ts_make_ptr - *ts_break_ptr;
+      u16 delay = KEYBOARD_GetDelay(*ts_break_ptr, *ts_make_ptr);
       *ts_break_ptr = 0;
       *ts_make_ptr = 0;
       MIOS32_IRQ_Enable();
@@ -692,11 +734,75 @@ static void KEYBOARD_NotifyToggle(u8 kb, u8 row, u8 column, u8 depressed)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Returns 1 if another change of the given pin is waiting in the queue
+//! (the entries between tail and head are not touched by the scan interrupt)
+/////////////////////////////////////////////////////////////////////////////
+static u8 KEYBOARD_EventQueuePending(u16 tail, u16 head, keyboard_event_t *ev)
+{
+  while( tail != head ) {
+    keyboard_event_t *q = &event_queue[tail];
+    if( q->kb == ev->kb && q->row == ev->row && q->column == ev->column )
+      return 1;
+
+    if( ++tail >= KEYBOARD_EVENT_QUEUE_SIZE )
+      tail = 0;
+  }
+
+  return 0;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! This function should be called periodically (each mS) to check for pin changes
+//!
+//! The pin changes are taken from a queue which is filled by
+//! KEYBOARD_SRIO_ServiceFinish(), so that they are processed in the order
+//! they have been scanned, and MIDI events are never sent from the scan
+//! interrupt.
+//!
+//! On a queue overrun the queued events are dropped, and the changes are
+//! taken from din_value_changed[] instead.
 /////////////////////////////////////////////////////////////////////////////
 void KEYBOARD_Periodic_1mS(void)
 {
+  while( 1 ) {
+    keyboard_event_t ev;
+
+    // take the next event - must be atomic!
+    MIOS32_IRQ_Disable();
+    if( event_queue_overrun ) {
+      // drop the queue, all changes are flagged in din_value_changed[]
+      event_queue_tail = event_queue_head;
+      event_queue_overrun = 0;
+      MIOS32_IRQ_Enable();
+      break;
+    }
+
+    u16 tail = event_queue_tail;
+    if( tail == event_queue_head ) {
+      MIOS32_IRQ_Enable();
+      return; // no overrun: nothing else to do
+    }
+
+    ev = event_queue[tail];
+    if( ++tail >= KEYBOARD_EVENT_QUEUE_SIZE )
+      tail = 0;
+    event_queue_tail = tail;
+    MIOS32_IRQ_Enable();
+
+    // change has been taken, unless the pin has toggled again meanwhile - must be atomic!
+    // (the flag is checked by KEYBOARD_NotifyToggle() for the related contact)
+    MIOS32_IRQ_Disable();
+    if( !KEYBOARD_EventQueuePending(tail, event_queue_head, &ev) )
+      din_value_changed[ev.kb][ev.row] &= ~(1 << ev.column);
+    MIOS32_IRQ_Enable();
+
+    KEYBOARD_NotifyToggle(ev.kb, ev.row, ev.column, ev.depressed);
+  }
+
+  // queue overrun: continue with the pins which are flagged in din_value_changed[]
+
   int kb;
   keyboard_config_t *kc = (keyboard_config_t *)&keyboard_config[0];
   for(kb=0; kb<connected_keyboards_num; ++kb, ++kc) {
@@ -830,6 +936,29 @@ void KEYBOARD_AIN_NotifyChange(u32 pin, u32 pin_value)
 }
 #endif
 
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the number of pin changes which couldn't be queued since
+//! KEYBOARD_Init() (they are processed nevertheless, but without the
+//! original order)
+/////////////////////////////////////////////////////////////////////////////
+u32 KEYBOARD_EventQueueOverrunsGet(void)
+{
+  return event_queue_overruns;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Help function to convert the time between two contact timestamps (in uS)
+// into the unit of the delay_* parameters
+/////////////////////////////////////////////////////////////////////////////
+static u16 KEYBOARD_GetDelay(u32 ts_first, u32 ts_second)
+{
+  u32 delay = (ts_second - ts_first) / KEYBOARD_DELAY_UNIT_US; // u32 subtraction handles overrun
+
+  return (delay > 0xffff) ? 0xffff : delay;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Help function to get MIDI velocity from measured delay
 /////////////////////////////////////////////////////////////////////////////
@@ -1050,6 +1179,7 @@ s32 KEYBOARD_TerminalHelp(void *_output_function)
   out("  set kb <1|2> delay_fastest_release_black_keys <0-65535>: opt.fastest release delay for black keys");
   out("  set kb <1|2> delay_slowest <0-65535>:   slowest delay for velocity calculation");
   out("  set kb <1|2> delay_slowest_release <0-65535>: slowest release delay for velocity calculation");
+  out("  (delays are specified in units of %d uS)", KEYBOARD_DELAY_UNIT_US);
 #if !KEYBOARD_DONT_USE_AIN
   out("  set kb <1|2> ain_pitchwheel <0..7/128..135> or off: assigns pitchwheel to given analog pin");
   out("  set kb <1|2> ctrl_pitchwheel <0-129>:               assigns CC/PB(=128)/AT(=129) to PitchWheel");
@@ -60,6 +60,20 @@
 #define KEYBOARD_MAX_KEYS 128
 #endif
 
+// contacts are timestamped with MIOS32_TIMESTAMP_Get_uS(), so that the measured
+// delays don't depend on the scan rate and number of rows.
+// This defines the unit of the delay_* parameters in uS. 25 uS correspond to the
+// scan period of a MIDIbox KB with 2 SRs, accordingly stored calibrations remain valid
+#ifndef KEYBOARD_DELAY_UNIT_US
+#define KEYBOARD_DELAY_UNIT_US 25
+#endif
+
+// size of the queue which transfers pin changes from KEYBOARD_SRIO_ServiceFinish()
+// to KEYBOARD_Periodic_1mS()
+#ifndef KEYBOARD_EVENT_QUEUE_SIZE
+#define KEYBOARD_EVENT_QUEUE_SIZE 64
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -120,6 +134,18 @@ typedef struct {
 } keyboard_config_t;
 
 
+// pin change, queued by KEYBOARD_SRIO_ServiceFinish()
+typedef union {
+  u32 ALL;
+  struct {
+    u8 kb;
+    u8 row;
+    u8 column;
+    u8 depressed;
+  };
+} keyboard_event_t;
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Prototypes
 /////////////////////////////////////////////////////////////////////////////
@@ -142,6 +168,8 @@ extern s32 KEYBOARD_TerminalParseLine(char *input, void *_output_function);
 extern s32 KEYBOARD_TerminalPrintConfig(int kb, void *_output_function);
 extern s32 KEYBOARD_TerminalPrintDelays(int kb, void *_output_function);
 
+extern u32 KEYBOARD_EventQueueOverrunsGet(void);
+
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
 /////////////////////////////////////////////////////////////////////////////
@@ -35,6 +35,30 @@
 #define MBNET_TX_PIN      GPIO_Pin_9
 #define MBNET_REMAP_FUNC  { GPIO_PinRemapConfig(GPIO_Remap1_CAN1, ENABLE); }
 
+// size of the acknowledge receive FIFO (filled by the CAN1_RX1 interrupt)
+// Note: the CAN1_RX0 and CAN1_TX interrupts are shared with USB on STM32F10x,
+// therefore request messages are still polled from the hardware FIFO, and
+// messages are sent directly via the transmit mailboxes
+#ifndef MBNET_RX_FIFO_SIZE
+#define MBNET_RX_FIFO_SIZE 16
+#endif
+
+// priority of the CAN interrupt
+#ifndef MBNET_IRQ_PRIORITY
+#define MBNET_IRQ_PRIORITY MIOS32_IRQ_PRIO_HIGH
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+// receive fifo
+static mbnet_packet_t mbnet_fifo_ack[MBNET_RX_FIFO_SIZE];
+static volatile u8 mbnet_fifo_ack_tail;
+static volatile u8 mbnet_fifo_ack_head;
+static volatile u8 mbnet_fifo_ack_size;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initializes CAN interface
@@ -49,6 +73,9 @@ s32 MBNET_HAL_Init(u32 mode)
   if( mode != 0 )
     return -1; // unsupported mode
 
+  // clear FIFO
+  mbnet_fifo_ack_tail = mbnet_fifo_ack_head = mbnet_fifo_ack_size = 0;
+
   // map CAN pins
   MBNET_REMAP_FUNC;
 
@@ -102,6 +129,10 @@ s32 MBNET_HAL_Init(u32 mode)
     }
   }
 
+  // enable receive interrupt for acknowledge (FIFO1) messages
+  CAN1->IER = CAN_IER_FMPIE1;
+  MIOS32_IRQ_Install(CAN1_RX1_IRQn, MBNET_IRQ_PRIORITY);
+
   return 0; // no error
 }
 
@@ -190,20 +221,22 @@ s32 MBNET_HAL_Send(mbnet_id_t mbnet_id, mbnet_msg_t msg, u8 dlc)
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNET_HAL_ReceiveAck(mbnet_packet_t *p)
 {
-  if( CAN1->RF1R & 0x3 ) { // FMP1 contains number of messages
-    // get EID, MSG and DLC
-    p->id.ALL = CAN1->sFIFOMailBox[1].RIR >> 3;
-    p->dlc = CAN1->sFIFOMailBox[1].RDTR & 0xf;
-    p->msg.data_l = CAN1->sFIFOMailBox[1].RDLR;
-    p->msg.data_h = CAN1->sFIFOMailBox[1].RDHR;
-
-    // release FIFO
-    CAN1->RF1R = (1 << 5); // set RFOM1 flag
-
-    return 1; // message received
+  u8 got_msg = 0;
+
+  MIOS32_IRQ_Disable();
+  if( mbnet_fifo_ack_size ) {
+    got_msg = 1;
+    *p = mbnet_fifo_ack[mbnet_fifo_ack_tail];
+    if( ++mbnet_fifo_ack_tail >= MBNET_RX_FIFO_SIZE )
+      mbnet_fifo_ack_tail = 0;
+    --mbnet_fifo_ack_size;
+
+    // re-enable receive interrupt (it has been disabled if the FIFO was full)
+    CAN1->IER |= CAN_IER_FMPIE1;
   }
+  MIOS32_IRQ_Enable();
 
-  return 0; // no message received
+  return got_msg;
 }
 
 
@@ -258,6 +291,37 @@ s32 MBNET_HAL_BusErrorCheck(void)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Interrupt handler for CAN acknowledge messages
+// The hardware FIFO is copied into the software FIFO. If the software
+// FIFO is full, the interrupt will be disabled until the application has
+// read a message, the remaining messages stay in the hardware FIFO.
+/////////////////////////////////////////////////////////////////////////////
+void CAN1_RX1_IRQHandler(void)
+{
+  while( CAN1->RF1R & 0x3 ) { // FMP1 contains number of messages
+    if( mbnet_fifo_ack_size >= MBNET_RX_FIFO_SIZE ) {
+      CAN1->IER &= ~CAN_IER_FMPIE1;
+      return;
+    }
+
+    // get EID, MSG and DLC
+    mbnet_packet_t *p = &mbnet_fifo_ack[mbnet_fifo_ack_head];
+    p->id.ALL = CAN1->sFIFOMailBox[1].RIR >> 3;
+    p->dlc = CAN1->sFIFOMailBox[1].RDTR & 0xf;
+    p->msg.data_l = CAN1->sFIFOMailBox[1].RDLR;
+    p->msg.data_h = CAN1->sFIFOMailBox[1].RDHR;
+
+    // release FIFO
+    CAN1->RF1R = (1 << 5); // set RFOM1 flag
+
+    if( ++mbnet_fifo_ack_head >= MBNET_RX_FIFO_SIZE )
+      mbnet_fifo_ack_head = 0;
+    ++mbnet_fifo_ack_size;
+  }
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Installs an optional Tx Handler which is called via interrupt whenever
 // a new message can be sent
@@ -35,6 +35,54 @@
 #define MBNET_TX_PIN      GPIO_Pin_1
 #define MBNET_REMAP_FUNC  { GPIO_PinAFConfig(GPIOD, GPIO_PinSource0, GPIO_AF_CAN1); GPIO_PinAFConfig(GPIOD, GPIO_PinSource1, GPIO_AF_CAN1); }
 
+// size of the two request/acknowledge receive FIFOs
+// (filled by the CAN1_RX0/RX1 interrupts)
+#ifndef MBNET_RX_FIFO_SIZE
+#define MBNET_RX_FIFO_SIZE 16
+#endif
+
+// size of the transmit FIFO
+// (messages are queued here if all three CAN mailboxes are busy, and sent from the CAN1_TX interrupt)
+#ifndef MBNET_TX_FIFO_SIZE
+#define MBNET_TX_FIFO_SIZE 16
+#endif
+
+// priority of the CAN interrupts
+#ifndef MBNET_IRQ_PRIORITY
+#define MBNET_IRQ_PRIORITY MIOS32_IRQ_PRIO_HIGH
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+// receive fifos
+static mbnet_packet_t mbnet_fifo_req[MBNET_RX_FIFO_SIZE];
+static volatile u8 mbnet_fifo_req_tail;
+static volatile u8 mbnet_fifo_req_head;
+static volatile u8 mbnet_fifo_req_size;
+
+static mbnet_packet_t mbnet_fifo_ack[MBNET_RX_FIFO_SIZE];
+static volatile u8 mbnet_fifo_ack_tail;
+static volatile u8 mbnet_fifo_ack_head;
+static volatile u8 mbnet_fifo_ack_size;
+
+// transmit fifo
+static mbnet_packet_t mbnet_fifo_tx[MBNET_TX_FIFO_SIZE];
+static volatile u8 mbnet_fifo_tx_tail;
+static volatile u8 mbnet_fifo_tx_head;
+static volatile u8 mbnet_fifo_tx_size;
+
+// optional TX handler callback
+static s32 (*tx_handler_callback)(mbnet_id_t *mbnet_id, mbnet_msg_t *msg, u8 *dlc);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+static void MBNET_HAL_TxFill(void);
+
 /////////////////////////////////////////////////////////////////////////////
 // Initializes CAN interface
 // IN: <mode>: currently only mode 0 supported
@@ -48,6 +96,14 @@ s32 MBNET_HAL_Init(u32 mode)
   if( mode != 0 )
     return -1; // unsupported mode
 
+  // clear FIFOs
+  mbnet_fifo_req_tail = mbnet_fifo_req_head = mbnet_fifo_req_size = 0;
+  mbnet_fifo_ack_tail = mbnet_fifo_ack_head = mbnet_fifo_ack_size = 0;
+  mbnet_fifo_tx_tail = mbnet_fifo_tx_head = mbnet_fifo_tx_size = 0;
+
+  // disable TX handler callback
+  tx_handler_callback = NULL;
+
   // map CAN pins
   MBNET_REMAP_FUNC;
 
@@ -88,6 +144,10 @@ s32 MBNET_HAL_Init(u32 mode)
   // enable receive FIFO locked mode (if FIFO is full, next incoming message will be discarded)
   CAN1->MCR |= (1 << 3); // CAN_MCR_RFLM
 
+  // transmit mailboxes are served in chronological order (and not by identifier),
+  // so that queued messages are sent in the same order as MBNET_HAL_Send() has been called
+  CAN1->MCR |= (1 << 2); // CAN_MCR_TXFP
+
   // bit timings for 2 MBaud:
   // -> 84 Mhz / 2 / 3 -> 14 MHz --> 7 quanta for 2 MBaud
   //          normal mode               Resynch. Jump Width   Time Segment 1         Time Segment 2       Prescaler
@@ -103,6 +163,13 @@ s32 MBNET_HAL_Init(u32 mode)
     }
   }
 
+  // enable receive interrupts for request (FIFO0) and acknowledge (FIFO1) messages
+  // the transmit interrupt will be enabled on demand
+  CAN1->IER = CAN_IER_FMPIE0 | CAN_IER_FMPIE1;
+  MIOS32_IRQ_Install(CAN1_RX0_IRQn, MBNET_IRQ_PRIORITY);
+  MIOS32_IRQ_Install(CAN1_RX1_IRQn, MBNET_IRQ_PRIORITY);
+  MIOS32_IRQ_Install(CAN1_TX_IRQn, MBNET_IRQ_PRIORITY);
+
   return 0; // no error
 }
 
@@ -149,34 +216,73 @@ s32 MBNET_HAL_FilterInit(u8 node_id)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local function: returns a free transmit mailbox, or -1 if all are busy
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNET_HAL_TxMailboxFree(void)
+{
+  u32 tsr = CAN1->TSR;
+
+  if( tsr & (1 << 26) ) // TME0
+    return 0;
+  if( tsr & (1 << 27) ) // TME1
+    return 1;
+  if( tsr & (1 << 28) ) // TME2
+    return 2;
+
+  return -1; // all mailboxes busy
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function: requests the transmission of a message via mailbox
+/////////////////////////////////////////////////////////////////////////////
+static void MBNET_HAL_TxMailboxSet(u8 mailbox, mbnet_id_t mbnet_id, mbnet_msg_t msg, u8 dlc)
+{
+  CAN1->sTxMailBox[mailbox].TDTR = (dlc << 0); // set dlc, disable timestamp
+  CAN1->sTxMailBox[mailbox].TDLR = msg.data_l;
+  CAN1->sTxMailBox[mailbox].TDHR = msg.data_h;
+  CAN1->sTxMailBox[mailbox].TIR = (mbnet_id.ALL << 3) | (1 << 2) | (1 << 0); // id field, EID flag, TX Req flag
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Send a MBNet packet
+// The message is either written into a free mailbox, or queued in the
+// transmit FIFO if all mailboxes are busy. Queued messages are sent from
+// the CAN1_TX interrupt, so that the caller doesn't need to wait for the bus.
 // IN: the packet which should be sent
 // returns 1 if message sent successfully
 // returns -3 on transmission error
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNET_HAL_Send(mbnet_id_t mbnet_id, mbnet_msg_t msg, u8 dlc)
 {
-  // select an empty transmit mailbox
-  s8 mailbox = -1;
+  // wait until the transmit FIFO has a free slot (it's drained by the TX interrupt)
   do {
     // exit immediately if CAN bus errors (CAN doesn't send messages anymore)
     if( MBNET_HAL_BusErrorCheck() < 0 )
       return -3; // transmission error
-
-    // TODO: timeout required?
-    if     ( CAN1->TSR & (1 << 26) ) // TME0
-      mailbox = 0;
-    else if( CAN1->TSR & (1 << 27) ) // TME1
-      mailbox = 1;
-    else if( CAN1->TSR & (1 << 28) ) // TME2
-      mailbox = 2;
-  } while( mailbox == -1 ); // TODO: provide timeout mechanism
-
-  CAN1->sTxMailBox[mailbox].TDTR = (dlc << 0); // set dlc, disable timestamp
-  CAN1->sTxMailBox[mailbox].TDLR = msg.data_l;
-  CAN1->sTxMailBox[mailbox].TDHR = msg.data_h;
-  CAN1->sTxMailBox[mailbox].TIR = (mbnet_id.ALL << 3) | (1 << 2) | (1 << 0); // id field, EID flag, TX Req flag
+  } while( mbnet_fifo_tx_size >= MBNET_TX_FIFO_SIZE );
+
+  MIOS32_IRQ_Disable();
+  s32 mailbox;
+  if( !mbnet_fifo_tx_size && (mailbox=MBNET_HAL_TxMailboxFree()) >= 0 ) {
+    // send immediately
+    MBNET_HAL_TxMailboxSet(mailbox, mbnet_id, msg, dlc);
+  } else {
+    // all mailboxes busy: queue message
+    mbnet_packet_t *p = &mbnet_fifo_tx[mbnet_fifo_tx_head];
+    p->id = mbnet_id;
+    p->dlc = dlc;
+    p->msg = msg;
+    if( ++mbnet_fifo_tx_head >= MBNET_TX_FIFO_SIZE )
+      mbnet_fifo_tx_head = 0;
+    ++mbnet_fifo_tx_size;
+
+    // TX interrupt will be triggered once a mailbox has been sent
+    CAN1->IER |= CAN_IER_TMEIE;
+  }
+  MIOS32_IRQ_Enable();
 
   return 1; // no error, message sent
 }
@@ -191,20 +297,22 @@ s32 MBNET_HAL_Send(mbnet_id_t mbnet_id, mbnet_msg_t msg, u8 dlc)
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNET_HAL_ReceiveAck(mbnet_packet_t *p)
 {
-  if( CAN1->RF1R & 0x3 ) { // FMP1 contains number of messages
-    // get EID, MSG and DLC
-    p->id.ALL = CAN1->sFIFOMailBox[1].RIR >> 3;
-    p->dlc = CAN1->sFIFOMailBox[1].RDTR & 0xf;
-    p->msg.data_l = CAN1->sFIFOMailBox[1].RDLR;
-    p->msg.data_h = CAN1->sFIFOMailBox[1].RDHR;
-
-    // release FIFO
-    CAN1->RF1R = (1 << 5); // set RFOM1 flag
-
-    return 1; // message received
+  u8 got_msg = 0;
+
+  MIOS32_IRQ_Disable();
+  if( mbnet_fifo_ack_size ) {
+    got_msg = 1;
+    *p = mbnet_fifo_ack[mbnet_fifo_ack_tail];
+    if( ++mbnet_fifo_ack_tail >= MBNET_RX_FIFO_SIZE )
+      mbnet_fifo_ack_tail = 0;
+    --mbnet_fifo_ack_size;
+
+    // re-enable receive interrupt (it has been disabled if the FIFO was full)
+    CAN1->IER |= CAN_IER_FMPIE1;
   }
+  MIOS32_IRQ_Enable();
 
-  return 0; // no message received
+  return got_msg;
 }
 
 
@@ -217,20 +325,22 @@ s32 MBNET_HAL_ReceiveAck(mbnet_packet_t *p)
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNET_HAL_ReceiveReq(mbnet_packet_t *p)
 {
-  if( CAN1->RF0R & 0x3 ) { // FMP1 contains number of messages
-    // get EID, MSG and DLC
-    p->id.ALL = CAN1->sFIFOMailBox[0].RIR >> 3;
-    p->dlc = CAN1->sFIFOMailBox[0].RDTR & 0xf;
-    p->msg.data_l = CAN1->sFIFOMailBox[0].RDLR;
-    p->msg.data_h = CAN1->sFIFOMailBox[0].RDHR;
-
-    // release FIFO
-    CAN1->RF0R = (1 << 5); // set RFOM0 flag
-
-    return 1; // message received
+  u8 got_msg = 0;
+
+  MIOS32_IRQ_Disable();
+  if( mbnet_fifo_req_size ) {
+    got_msg = 1;
+    *p = mbnet_fifo_req[mbnet_fifo_req_tail];
+    if( ++mbnet_fifo_req_tail >= MBNET_RX_FIFO_SIZE )
+      mbnet_fifo_req_tail = 0;
+    --mbnet_fifo_req_size;
+
+    // re-enable receive interrupt (it has been disabled if the FIFO was full)
+    CAN1->IER |= CAN_IER_FMPIE0;
   }
+  MIOS32_IRQ_Enable();
 
-  return 0; // no message received
+  return got_msg;
 }
 
 
@@ -253,21 +363,140 @@ s32 MBNET_HAL_BusErrorCheck(void)
   // abort all pending transmissions
   CAN1->TSR |= (1 << 23) | (1 << 15) | (1 << 7); // set ABRQ[210]
 
+  // and drop the queued messages
+  MIOS32_IRQ_Disable();
+  mbnet_fifo_tx_tail = mbnet_fifo_tx_head = mbnet_fifo_tx_size = 0;
+  MIOS32_IRQ_Enable();
+
   // TODO: try to recover
 
   return -2; // PANIC state reached
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local function:
+// Fills the free transmit mailboxes with queued messages, thereafter with
+// messages of the optional Tx Handler
+// Has to be called with disabled interrupts (or from the TX interrupt)
+/////////////////////////////////////////////////////////////////////////////
+static void MBNET_HAL_TxFill(void)
+{
+  s32 mailbox;
+
+  while( (mailbox=MBNET_HAL_TxMailboxFree()) >= 0 ) {
+    if( mbnet_fifo_tx_size ) {
+      mbnet_packet_t *p = &mbnet_fifo_tx[mbnet_fifo_tx_tail];
+      MBNET_HAL_TxMailboxSet(mailbox, p->id, p->msg, p->dlc);
+      if( ++mbnet_fifo_tx_tail >= MBNET_TX_FIFO_SIZE )
+	mbnet_fifo_tx_tail = 0;
+      --mbnet_fifo_tx_size;
+    } else {
+      mbnet_id_t mbnet_id;
+      mbnet_msg_t msg;
+      u8 dlc;
+
+      if( tx_handler_callback == NULL || tx_handler_callback(&mbnet_id, &msg, &dlc) <= 0 )
+	break; // nothing to send
+
+      MBNET_HAL_TxMailboxSet(mailbox, mbnet_id, msg, dlc);
+    }
+  }
+
+  // TX interrupt only required as long as messages are queued, or a Tx Handler is installed
+  if( !mbnet_fifo_tx_size && tx_handler_callback == NULL )
+    CAN1->IER &= ~CAN_IER_TMEIE;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Interrupt handlers for CAN receive messages
+// The hardware FIFOs are copied into the software FIFOs. If a software
+// FIFO is full, the interrupt will be disabled until the application has
+// read a message, the remaining messages stay in the hardware FIFO.
+/////////////////////////////////////////////////////////////////////////////
+void CAN1_RX0_IRQHandler(void)
+{
+  while( CAN1->RF0R & 0x3 ) { // FMP0 contains number of messages
+    if( mbnet_fifo_req_size >= MBNET_RX_FIFO_SIZE ) {
+      CAN1->IER &= ~CAN_IER_FMPIE0;
+      return;
+    }
+
+    // get EID, MSG and DLC
+    mbnet_packet_t *p = &mbnet_fifo_req[mbnet_fifo_req_head];
+    p->id.ALL = CAN1->sFIFOMailBox[0].RIR >> 3;
+    p->dlc = CAN1->sFIFOMailBox[0].RDTR & 0xf;
+    p->msg.data_l = CAN1->sFIFOMailBox[0].RDLR;
+    p->msg.data_h = CAN1->sFIFOMailBox[0].RDHR;
+
+    // release FIFO
+    CAN1->RF0R = (1 << 5); // set RFOM0 flag
+
+    if( ++mbnet_fifo_req_head >= MBNET_RX_FIFO_SIZE )
+      mbnet_fifo_req_head = 0;
+    ++mbnet_fifo_req_size;
+  }
+}
+
+void CAN1_RX1_IRQHandler(void)
+{
+  while( CAN1->RF1R & 0x3 ) { // FMP1 contains number of messages
+    if( mbnet_fifo_ack_size >= MBNET_RX_FIFO_SIZE ) {
+      CAN1->IER &= ~CAN_IER_FMPIE1;
+      return;
+    }
+
+    // get EID, MSG and DLC
+    mbnet_packet_t *p = &mbnet_fifo_ack[mbnet_fifo_ack_head];
+    p->id.ALL = CAN1->sFIFOMailBox[1].RIR >> 3;
+    p->dlc = CAN1->sFIFOMailBox[1].RDTR & 0xf;
+    p->msg.data_l = CAN1->sFIFOMailBox[1].RDLR;
+    p->msg.data_h = CAN1->sFIFOMailBox[1].RDHR;
+
+    // release FIFO
+    CAN1->RF1R = (1 << 5); // set RFOM1 flag
+
+    if( ++mbnet_fifo_ack_head >= MBNET_RX_FIFO_SIZE )
+      mbnet_fifo_ack_head = 0;
+    ++mbnet_fifo_ack_size;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Interrupt handler for CAN transmit mailboxes
+/////////////////////////////////////////////////////////////////////////////
+void CAN1_TX_IRQHandler(void)
+{
+  // clear request completed flags
+  CAN1->TSR = (1 << 16) | (1 << 8) | (1 << 0); // RQCP[210]
+
+  MBNET_HAL_TxFill();
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Installs an optional Tx Handler which is called via interrupt whenever
 // a new message can be sent
-// Currently only supported by LPC17xx HAL!
 // tx_handler_callback == NULL will disable the handler
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNET_HAL_InstallTxHandler(s32 (*_tx_handler_callback)(mbnet_id_t *mbnet_id, mbnet_msg_t *msg, u8 *dlc))
 {
-  return -1; // not supported by this HAL
+  MIOS32_IRQ_Disable();
+  tx_handler_callback = _tx_handler_callback;
+  if( tx_handler_callback == NULL ) {
+    // disable transmit interrupt if no messages are queued anymore
+    if( !mbnet_fifo_tx_size )
+      CAN1->IER &= ~CAN_IER_TMEIE;
+  }
+  MIOS32_IRQ_Enable();
+
+  // request to send first frame
+  if( tx_handler_callback != NULL )
+    MBNET_HAL_TriggerTxHandler();
+
+  return 0; // no error
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -277,6 +506,15 @@ s32 MBNET_HAL_InstallTxHandler(s32 (*_tx_handler_callback)(mbnet_id_t *mbnet_id,
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNET_HAL_TriggerTxHandler(void)
 {
-  return -1; // not supported by this HAL
+  if( tx_handler_callback == NULL )
+    return -1; // no callback installed
+
+  // fill free mailboxes, the TX interrupt continues once they have been sent
+  MIOS32_IRQ_Disable();
+  CAN1->IER |= CAN_IER_TMEIE;
+  MBNET_HAL_TxFill();
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
 }
 
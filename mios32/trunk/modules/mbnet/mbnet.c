@@ -37,10 +37,21 @@
 
 
 /////////////////////////////////////////////////////////////////////////////
-// Local defines
+// Local types
 /////////////////////////////////////////////////////////////////////////////
 
-#define MBNET_TIMEOUT_CTR_MAX 5000
+// request which waits for an acknowledge
+typedef struct {
+  u8          slave_id;   // 0xff: slot not allocated
+  u8          got_ack;    // set once the acknowledge has been received
+  u8          dlc;
+  u8          ack_tos;
+  u8          ack_dlc;
+  u32         timestamp;  // when the request has been sent
+  mbnet_id_t  mbnet_id;   // for retry mechanism
+  mbnet_msg_t msg;
+  mbnet_msg_t ack_msg;
+} mbnet_req_slot_t;
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -63,11 +74,8 @@ static u8 slave_nodes_ix[MBNET_SLAVE_NODES_END-MBNET_SLAVE_NODES_BEGIN+1];
 // informations about scanned nodes (contains "pong" reply)
 static mbnet_msg_t slave_nodes_info[MBNET_SLAVE_NODES_MAX];
 
-// for retry mechanism
-static u8          last_req_slave_id = 0xff;
-static mbnet_id_t  last_req_mbnet_id;
-static mbnet_msg_t last_req_msg;
-static u8          last_req_dlc;
+// pending requests (also used for retry mechanism)
+static mbnet_req_slot_t req_slot[MBNET_REQ_SLOTS];
 
 // turns to 1 if scan for MBNet nodes is finished
 static u8 scan_finished;
@@ -101,6 +109,13 @@ s32 MBNET_Init(u32 mode)
   // The application has to use MBNET_NodeIDSet() to initialise it, and to configure the CAN filters
   my_node_id = 0xff;
 
+  // no pending requests
+  {
+    int i;
+    for(i=0; i<MBNET_REQ_SLOTS; ++i)
+      req_slot[i].slave_id = 0xff;
+  }
+
   // invalidate slave informations
   MBNET_Reconnect();
 
@@ -292,8 +307,108 @@ static s32 MBNET_SendMsg(mbnet_id_t mbnet_id, mbnet_msg_t msg, u8 dlc)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local function: returns the request slot of a slave, NULL if no request pending
+/////////////////////////////////////////////////////////////////////////////
+static mbnet_req_slot_t *MBNET_ReqSlotGet(u8 slave_id)
+{
+  mbnet_req_slot_t *slot = &req_slot[0];
+  int i;
+
+  for(i=0; i<MBNET_REQ_SLOTS; ++i, ++slot)
+    if( slot->slave_id == slave_id )
+      return slot;
+
+  return NULL;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function: allocates a request slot for a slave
+// If all slots are allocated, the oldest request will be dropped
+/////////////////////////////////////////////////////////////////////////////
+static mbnet_req_slot_t *MBNET_ReqSlotAlloc(u8 slave_id)
+{
+  mbnet_req_slot_t *slot;
+
+  if( (slot=MBNET_ReqSlotGet(slave_id)) == NULL ) {
+    mbnet_req_slot_t *s = &req_slot[0];
+    u32 max_delay = 0;
+    int i;
+
+    slot = s;
+    for(i=0; i<MBNET_REQ_SLOTS; ++i, ++s) {
+      if( s->slave_id == 0xff ) {
+	slot = s;
+	break;
+      }
+
+      u32 delay = MIOS32_TIMESTAMP_GetDelay(s->timestamp);
+      if( delay > max_delay ) {
+	max_delay = delay;
+	slot = s;
+      }
+    }
+
+    if( slot->slave_id != 0xff && verbose_level >= 2 ) {
+      DEBUG_MSG("[MBNET] request slots full - dropped pending request to slave ID 0x%02x\n", slot->slave_id);
+    }
+
+    slot->slave_id = slave_id;
+  }
+
+  slot->got_ack = 0;
+
+  return slot;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function:
+// Takes over all received acknowledge messages into the request slots of
+// the sending slaves
+/////////////////////////////////////////////////////////////////////////////
+static void MBNET_AckDispatch(void)
+{
+  mbnet_packet_t p;
+
+  while( MBNET_HAL_ReceiveAck(&p) > 0 ) {
+    u8 slave_id = p.id.control & 0xff;
+    mbnet_req_slot_t *slot = MBNET_ReqSlotGet(slave_id);
+
+    // response from expected slave? if not - ignore it!
+    if( slot == NULL ) {
+      if( verbose_level >= 3 ) {
+	DEBUG_MSG("[MBNET] ERROR: ACK from unexpected slave ID 0x%02x (TOS=%d DLC=%d MSG=%02x %02x %02x...)\n",
+		  slave_id,
+		  p.id.tos,
+		  p.dlc,
+		  p.msg.bytes[0], p.msg.bytes[1], p.msg.bytes[2]);
+      }
+    } else {
+      if( verbose_level >= 3 ) {
+	DEBUG_MSG("[MBNET] got ACK from slave ID 0x%02x TOS=%d DLC=%d MSG=%02x %02x %02x %02x %02x %02x %02x %02x\n",
+		  slave_id,
+		  p.id.tos,
+		  p.dlc,
+		  p.msg.bytes[0], p.msg.bytes[1], p.msg.bytes[2], p.msg.bytes[3],
+		  p.msg.bytes[4], p.msg.bytes[5], p.msg.bytes[6], p.msg.bytes[7]);
+      }
+
+      slot->got_ack = 1;
+      slot->ack_tos = p.id.tos;
+      slot->ack_dlc = p.dlc;
+      slot->ack_msg = p.msg;
+    }
+  }
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Sends request to slave node
+// Requests to different slaves can be pipelined: the acknowledges are
+// collected with MBNET_WaitAck() afterwards (up to MBNET_REQ_SLOTS requests
+// can be pending)
 // IN: <slave_id>: slave node ID (0x00..0x7f)
 //     <tos_req>: request TOS
 //     <control>: 16bit control field of ID
@@ -319,11 +434,12 @@ s32 MBNET_SendReq(u8 slave_id, mbnet_tos_req_t tos_req, u16 control, mbnet_msg_t
   mbnet_id.ack     = 0;
   mbnet_id.node    = slave_id;
 
-  // remember settings for MBNET_SendReqAgain()
-  last_req_slave_id = slave_id;
-  last_req_mbnet_id = mbnet_id;
-  last_req_msg = msg;
-  last_req_dlc = dlc;
+  // remember settings for MBNET_WaitAck() and MBNET_SendReqAgain()
+  mbnet_req_slot_t *slot = MBNET_ReqSlotAlloc(slave_id);
+  slot->mbnet_id = mbnet_id;
+  slot->msg = msg;
+  slot->dlc = dlc;
+  slot->timestamp = MIOS32_TIMESTAMP_Get();
 
   return MBNET_SendMsg(mbnet_id, msg, dlc);
 }
@@ -349,10 +465,15 @@ s32 MBNET_SendReqAgain(u8 slave_id)
   if( my_node_id & 0x0f )
     return -2; // this node isn's configured as master
 
-  if( slave_id != last_req_slave_id )
+  mbnet_req_slot_t *slot = MBNET_ReqSlotGet(slave_id);
+  if( slot == NULL )
     return -7; // sequence error
 
-  return MBNET_SendMsg(last_req_mbnet_id, last_req_msg, last_req_dlc);
+  // restart timeout
+  slot->got_ack = 0;
+  slot->timestamp = MIOS32_TIMESTAMP_Get();
+
+  return MBNET_SendMsg(slot->mbnet_id, slot->msg, slot->dlc);
 }
 
 
@@ -389,6 +510,8 @@ s32 MBNET_SendAck(u8 master_id, mbnet_tos_ack_t tos_ack, mbnet_msg_t msg, u8 dlc
 
 /////////////////////////////////////////////////////////////////////////////
 // Checks for acknowledge from a specific slave
+// Acknowledges of other slaves with pending requests are stored in their
+// request slots, so that they can be requested later
 // IN: <slave_id>: slave node ID (0x00..0x7f)
 //     <*msg>: received MBNet message (see mbnet_msg_t structure)
 //     <*dlc>: received data field length (0..8)
@@ -397,7 +520,9 @@ s32 MBNET_SendAck(u8 master_id, mbnet_tos_ack_t tos_ack, mbnet_msg_t msg, u8 dlc
 //      returns -2 if this node isn't configured as master
 //      returns -3 on transmission error
 //      returns -4 if slave acknowledged with retry (send message again)
-//      returns -5 if no response from slave yet (check again or timeout!)
+//      returns -5 if no response from slave yet (check again)
+//      returns -6 on timeout (no response within MBNET_ACK_TIMEOUT mS)
+//      returns -7 if no request has been sent to this slave (sequence error)
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNET_WaitAck_NonBlocking(u8 slave_id, mbnet_msg_t *ack_msg, u8 *dlc)
 {
@@ -412,49 +537,38 @@ s32 MBNET_WaitAck_NonBlocking(u8 slave_id, mbnet_msg_t *ack_msg, u8 *dlc)
     return -3; // transmission error
 
   // check for incoming acknowledge messages
-  mbnet_packet_t p;
-  s32 got_msg;
-  do {
-    got_msg = MBNET_HAL_ReceiveAck(&p);
+  MBNET_AckDispatch();
 
-    if( got_msg > 0 ) {
-      // get EID, MSG and DLC
-      *dlc = p.dlc;
-      *ack_msg = p.msg;
+  mbnet_req_slot_t *slot = MBNET_ReqSlotGet(slave_id);
+  if( slot == NULL )
+    return -7; // sequence error
 
-      // response from expected slave? if not - ignore it!
-      if( (p.id.control & 0xff) == slave_id ) {
-	if( verbose_level >= 3 ) {
-	  DEBUG_MSG("[MBNET] got ACK from slave ID 0x%02x TOS=%d DLC=%d MSG=%02x %02x %02x %02x %02x %02x %02x %02x\n",
-		    p.id.control & 0xff,
-		    p.id.tos,
-		    *dlc,
-		    ack_msg->bytes[0], ack_msg->bytes[1], ack_msg->bytes[2], ack_msg->bytes[3],
-		    ack_msg->bytes[4], ack_msg->bytes[5], ack_msg->bytes[6], ack_msg->bytes[7]);
-	}
+  if( !slot->got_ack ) {
+    if( MIOS32_TIMESTAMP_GetDelay(slot->timestamp) > MBNET_ACK_TIMEOUT ) {
+      slot->slave_id = 0xff; // release slot
+      if( verbose_level >= 3 ) {
+	DEBUG_MSG("[MBNET] ACK polling for slave ID 0x%02x timed out!\n", slave_id);
+      }
+      return -6; // timeout
+    }
 
-	// retry requested?
-	if( p.id.tos == MBNET_ACK_RETRY ) {
-	  if( verbose_level >= 3 ) {
-	    DEBUG_MSG("[MBNET] Slave ID 0x%02x requested to retry the transfer!\n", slave_id);
-	  }
-	  return -4; // slave requested to retry
-	}
+    return -5; // no response from slave yet (check again)
+  }
 
-	return 0; // wait ack successful!
-      } else {
-	  if( verbose_level >= 3 ) {
-	    DEBUG_MSG("[MBNET] ERROR: ACK from unexpected slave ID 0x%02x (TOS=%d DLC=%d MSG=%02x %02x %02x...)\n",
-		      p.id.control & 0xff,
-		      p.id.tos,
-		      *dlc,
-		      ack_msg->bytes[0], ack_msg->bytes[1], ack_msg->bytes[2]);
-	  }
-      }
+  *dlc = slot->ack_dlc;
+  *ack_msg = slot->ack_msg;
+
+  // retry requested?
+  if( slot->ack_tos == MBNET_ACK_RETRY ) {
+    if( verbose_level >= 3 ) {
+      DEBUG_MSG("[MBNET] Slave ID 0x%02x requested to retry the transfer!\n", slave_id);
     }
-  } while( got_msg );
+    return -4; // slave requested to retry (slot is kept for MBNET_SendReqAgain())
+  }
 
-  return -5; // no response from slave yet (check again or timeout!)
+  slot->slave_id = 0xff; // release slot
+
+  return 0; // wait ack successful!
 }
 
 
@@ -468,28 +582,18 @@ s32 MBNET_WaitAck_NonBlocking(u8 slave_id, mbnet_msg_t *ack_msg, u8 *dlc)
 //      returns -1 if this node hasn't been configured yet
 //      returns -2 if this node isn't configured as master
 //      returns -3 on transmission error
-//      returns -6 on timeout (no response within 10 mS)
+//      returns -6 on timeout (no response within MBNET_ACK_TIMEOUT mS)
+//      returns -7 if no request has been sent to this slave (sequence error)
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNET_WaitAck(u8 slave_id, mbnet_msg_t *ack_msg, u8 *dlc)
 {
-  // TODO: timeout after 10 mS, use system timer!
-  u32 timeout_ctr = 0;
   s32 error;
 
   do {
     error = MBNET_WaitAck_NonBlocking(slave_id, ack_msg, dlc);
-    if( error == -4 ) {
-      MBNET_SendReqAgain(slave_id);
-      timeout_ctr = 0;
-    }
-  } while( (error == -4 || error == -5) && ++timeout_ctr < MBNET_TIMEOUT_CTR_MAX );
-
-  if( timeout_ctr == MBNET_TIMEOUT_CTR_MAX ) {
-    if( verbose_level >= 3 ) {
-      DEBUG_MSG("[MBNET] ACK polling for slave ID 0x%02x timed out!\n", slave_id);
-    }
-    return -6; // timeout
-  }
+    if( error == -4 )
+      MBNET_SendReqAgain(slave_id); // also restarts the timeout
+  } while( error == -4 || error == -5 );
 
   return error;
 }
@@ -516,69 +620,83 @@ s32 MBNET_Handler(void (*callback)(u8 master_id, mbnet_tos_req_t tos, u16 contro
   // scan for slave nodes if this node is a master
   if( !scan_finished && (my_node_id & 0x0f) == 0 ) {
     
-    // determine next slave node
-    u8 again = 0;
-    do {
+    // send pings to the next slaves which haven't been found yet, thereafter wait for the pongs
+    // the requests are pipelined, so that the timeouts of missing slaves elapse in parallel
+    u8 ping_slave_id[MBNET_NODE_SCAN_PIPELINE];
+    u8 num_pings = 0;
+    int n;
+
+    for(n=0; n<=(MBNET_SLAVE_NODES_END-MBNET_SLAVE_NODES_BEGIN) && num_pings<MBNET_NODE_SCAN_PIPELINE; ++n) {
+      // determine next slave node
+      u8 again = 0;
+      do {
 #if MBNET_SLAVE_NODES_BEGIN > 0
-      if( search_slave_id < MBNET_SLAVE_NODES_BEGIN || search_slave_id >= MBNET_SLAVE_NODES_END )
+	if( search_slave_id < MBNET_SLAVE_NODES_BEGIN || search_slave_id >= MBNET_SLAVE_NODES_END )
 #else
-      if( search_slave_id >= MBNET_SLAVE_NODES_END )
+	if( search_slave_id >= MBNET_SLAVE_NODES_END )
 #endif
-	search_slave_id = MBNET_SLAVE_NODES_BEGIN-1; // restart
-
-      // next slave
-      ++search_slave_id;
-
-      again = (search_slave_id == my_node_id) ? 1 : 0; // skip my own ID
-    } while( again );
-
-    // search slave if not found yet, and retry counter hasn't reached end yet
-    u8 ix_ix = search_slave_id-MBNET_SLAVE_NODES_BEGIN;
-    if( slave_nodes_ix[ix_ix] >= 128 && slave_nodes_ix[ix_ix] != 0xff ) {
-      // increment retry counter
-      ++slave_nodes_ix[ix_ix];
-
-      // send a ping, wait for a pong
-      mbnet_msg_t req_msg;
-      req_msg.data_l = 0;
-      req_msg.data_h = 0;
-      if( MBNET_SendReq(search_slave_id, MBNET_REQ_PING, 0x0000, req_msg, 0) == 1 ) {
-	mbnet_msg_t ack_msg;
-	u8 dlc;
-
-	if( MBNET_WaitAck(search_slave_id, &ack_msg, &dlc) == 0 ) {
-
-	  // got it! :-)
-	  slave_nodes_ix[ix_ix] = search_slave_id;
-
-	  // try to put it into info array
-	  int i;
-	  for(i=0; i<MBNET_SLAVE_NODES_MAX; ++i) {
-	    if( slave_nodes_info[i].protocol_version == 0 ) {
-	      slave_nodes_info[i].data_l = ack_msg.data_l;
-	      slave_nodes_info[i].data_h = ack_msg.data_h;
-	      slave_nodes_ix[ix_ix] = i;
-	      break;
-	    }
-	  }
+	  search_slave_id = MBNET_SLAVE_NODES_BEGIN-1; // restart
+
+	// next slave
+	++search_slave_id;
+
+	again = (search_slave_id == my_node_id) ? 1 : 0; // skip my own ID
+      } while( again );
+
+      // search slave if not found yet, and retry counter hasn't reached end yet
+      u8 ix_ix = search_slave_id-MBNET_SLAVE_NODES_BEGIN;
+      if( slave_nodes_ix[ix_ix] >= 128 && slave_nodes_ix[ix_ix] != 0xff ) {
+	// increment retry counter
+	++slave_nodes_ix[ix_ix];
+
+	// send a ping
+	mbnet_msg_t req_msg;
+	req_msg.data_l = 0;
+	req_msg.data_h = 0;
+	if( MBNET_SendReq(search_slave_id, MBNET_REQ_PING, 0x0000, req_msg, 0) == 1 )
+	  ping_slave_id[num_pings++] = search_slave_id;
+      }
+    }
 
-	  // still a free slot?
-	  if( i >= MBNET_SLAVE_NODES_MAX ) {
-	    slave_nodes_ix[ix_ix] = 0xff; // disable retry counter
-	  }
+    for(n=0; n<num_pings; ++n) {
+      u8 slave_id = ping_slave_id[n];
+      u8 ix_ix = slave_id-MBNET_SLAVE_NODES_BEGIN;
+      mbnet_msg_t ack_msg;
+      u8 dlc;
 
-	  if( verbose_level >= 2 ) {
-	    DEBUG_MSG("[MBNET] new slave found: ID 0x%02x (Ix=%d) P:%d T:%c%c%c%c V:%d.%d\n", 
-		      search_slave_id,
-		      slave_nodes_ix[ix_ix],
-		      ack_msg.protocol_version,
-		      ack_msg.node_type[0], ack_msg.node_type[1], ack_msg.node_type[2], ack_msg.node_type[3],
-		      ack_msg.node_version, ack_msg.node_subversion);
-
-	    if( slave_nodes_ix[ix_ix] == 0xff )
-	      DEBUG_MSG("[MBNET] unfortunately no free info slot anymore!\n");
+      // wait for a pong
+      if( MBNET_WaitAck(slave_id, &ack_msg, &dlc) == 0 ) {
+
+	// got it! :-)
+	slave_nodes_ix[ix_ix] = slave_id;
+
+	// try to put it into info array
+	int i;
+	for(i=0; i<MBNET_SLAVE_NODES_MAX; ++i) {
+	  if( slave_nodes_info[i].protocol_version == 0 ) {
+	    slave_nodes_info[i].data_l = ack_msg.data_l;
+	    slave_nodes_info[i].data_h = ack_msg.data_h;
+	    slave_nodes_ix[ix_ix] = i;
+	    break;
 	  }
 	}
+
+	// still a free slot?
+	if( i >= MBNET_SLAVE_NODES_MAX ) {
+	  slave_nodes_ix[ix_ix] = 0xff; // disable retry counter
+	}
+
+	if( verbose_level >= 2 ) {
+	  DEBUG_MSG("[MBNET] new slave found: ID 0x%02x (Ix=%d) P:%d T:%c%c%c%c V:%d.%d\n", 
+		    slave_id,
+		    slave_nodes_ix[ix_ix],
+		    ack_msg.protocol_version,
+		    ack_msg.node_type[0], ack_msg.node_type[1], ack_msg.node_type[2], ack_msg.node_type[3],
+		    ack_msg.node_version, ack_msg.node_subversion);
+
+	  if( slave_nodes_ix[ix_ix] == 0xff )
+	    DEBUG_MSG("[MBNET] unfortunately no free info slot anymore!\n");
+	}
       }
     }
 
@@ -788,7 +906,7 @@ static s32 MBNET_BusErrorCheck(void)
 /////////////////////////////////////////////////////////////////////////////
 // Installs an optional Tx Handler which is called via interrupt whenever
 // a new message can be sent
-// Currently only supported by LPC17xx HAL!
+// Currently only supported by LPC17xx and STM32F4xx HAL!
 // tx_handler_callback == NULL will disable the handler
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNET_InstallTxHandler(s32 (*tx_handler_callback)(mbnet_id_t *mbnet_id, mbnet_msg_t *msg, u8 *dlc))
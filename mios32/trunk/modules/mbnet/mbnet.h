@@ -42,6 +42,25 @@ extern "C" {
 #define MBNET_NODE_SCAN_RETRY 32
 #endif
 
+// how many nodes are pinged at once while scanning
+// (the pings are pipelined, so that the timeouts of missing nodes elapse in parallel)
+#ifndef MBNET_NODE_SCAN_PIPELINE
+#define MBNET_NODE_SCAN_PIPELINE 4
+#endif
+
+// relevant if configured as master: how many requests can wait for an acknowledge
+// at the same time (one slot per slave node)
+// Requests to different slaves can be sent with MBNET_SendReq() before
+// the acknowledges are collected with MBNET_WaitAck()
+#ifndef MBNET_REQ_SLOTS
+#define MBNET_REQ_SLOTS 8
+#endif
+
+// acknowledge timeout in mS
+#ifndef MBNET_ACK_TIMEOUT
+#define MBNET_ACK_TIMEOUT 10
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
 /////////////////////////////////////////////////////////////////////////////
@@ -35,6 +35,36 @@
 // SysEx buffer for each input (exclusive Default)
 #define NUM_SYSEX_BUFFERS     (MIDI_PORT_NUM_IN_PORTS-1)
 
+// number of source ports in the compiled routing table: USB0..7, UART0..7, IIC0..7, OSC0..7, SPIM0..7
+#define NUM_ROUTE_SRC_PORTS   (5*8)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// local types
+/////////////////////////////////////////////////////////////////////////////
+
+// one flag for each node
+#if MIDI_ROUTER_NUM_NODES <= 16
+typedef u16 node_mask_t;
+#elif MIDI_ROUTER_NUM_NODES <= 32
+typedef u32 node_mask_t;
+#else
+# error "MIDI_ROUTER_NUM_NODES > 32 not supported"
+#endif
+
+// the nodes which have to be considered for a given source port
+typedef struct {
+  node_mask_t chn[16]; // Note/CC/Program Change/Aftertouch/PitchBender events of a given channel
+  node_mask_t common;  // realtime and common events (only forwarded once per destination port)
+  node_mask_t sysex;   // SysEx streams (only forwarded once per destination port)
+} route_t;
+
+// the routing table of all source ports, and the nodes it has been compiled from
+typedef struct {
+  route_t route[NUM_ROUTE_SRC_PORTS];
+  midi_router_node_entry_t node[MIDI_ROUTER_NUM_NODES];
+} route_table_t;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // global variables
@@ -69,6 +99,12 @@ u32 midi_router_mclk_out;
 static u8 sysex_buffer[NUM_SYSEX_BUFFERS][MIDI_ROUTER_SYSEX_BUFFER_SIZE];
 static u32 sysex_buffer_len[NUM_SYSEX_BUFFERS];
 
+// the node configuration is compiled into a routing table, so that the router
+// only has to process the nodes which are really affected by an incoming event.
+// MIDI_ROUTER_NodesChanged() compiles the shadow table and swaps the pointer
+static route_table_t route_table[2];
+static route_table_t * volatile route_table_active = &route_table[0];
+
 
 /////////////////////////////////////////////////////////////////////////////
 // This function initializes the MIDI router
@@ -88,6 +124,9 @@ s32 MIDI_ROUTER_Init(u32 mode)
   for(i=0; i<NUM_SYSEX_BUFFERS; ++i)
     sysex_buffer_len[i] = 0;
 
+  // compile routing table for the initial nodes
+  MIDI_ROUTER_NodesChanged();
+
   return 0; // no error
 }
 
@@ -107,48 +146,156 @@ static inline u32 MIDI_ROUTER_PortMaskGet(mios32_midi_port_t port)
 
 
 /////////////////////////////////////////////////////////////////////////////
-// Receives a MIDI package from APP_NotifyReceivedEvent (-> app.c)
+// Returns the index of a source port in the routing table, -1 if not covered
 /////////////////////////////////////////////////////////////////////////////
-s32 MIDI_ROUTER_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_package)
+static inline s32 MIDI_ROUTER_RouteIxGet(mios32_midi_port_t port)
 {
-  // filter SysEx which is handled by separate parser
-  if( midi_package.evnt0 < 0xf8 &&
-      (midi_package.cin == 0xf ||
-      (midi_package.cin >= 0x4 && midi_package.cin <= 0x7)) )
-    return 0; // no error
+  u8 port_type = port >> 4;
+  u8 port_ix = port & 0xf;
+  if( port_type >= (USB0 >> 4) && port_type <= (SPIM0 >> 4) && port_ix <= 7 ) {
+    return ((port_type - (USB0 >> 4)) << 3) | port_ix;
+  }
 
+  return -1;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Determines the nodes which have to be considered for the given source port
+/////////////////////////////////////////////////////////////////////////////
+static void MIDI_ROUTER_RouteGet(const midi_router_node_entry_t *nodes, mios32_midi_port_t port, route_t *r)
+{
+  u32 common_dst_fwd_done = 0;
   u32 sysex_dst_fwd_done = 0;
+
+  memset(r, 0, sizeof(route_t));
+
   int node;
-  midi_router_node_entry_t *n = (midi_router_node_entry_t *)&midi_router_node[0];
+  const midi_router_node_entry_t *n = &nodes[0];
   for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
     if( n->src_chn && n->dst_chn && (n->src_port == port) ) {
+      node_mask_t node_mask = (node_mask_t)1 << node;
+
+      // SysEx and realtime events: ensure that they are only forwarded once
+      u32 mask = MIDI_ROUTER_PortMaskGet(n->dst_port);
+      if( !mask || !(sysex_dst_fwd_done & mask) ) {
+	sysex_dst_fwd_done |= mask;
+	r->sysex |= node_mask;
+      }
 
       // forwarding OSC to OSC will very likely result into a stack overflow (or feedback loop) -> avoid this!
       if( ((port & 0xf0) == OSC0) && ((n->dst_port & 0xf0) == OSC0) )
 	continue;
 
-      if( midi_package.event >= NoteOff && midi_package.event <= PitchBend ) {
-	if( n->src_chn == 17 || midi_package.chn == (n->src_chn-1) ) {
-	  mios32_midi_package_t fwd_package = midi_package;
-	  if( n->dst_chn <= 16 )
-	    fwd_package.chn = (n->dst_chn-1);
-	  mios32_midi_port_t port = n->dst_port;
-	  MUTEX_MIDIOUT_TAKE;
-	  MIOS32_MIDI_SendPackage(port, fwd_package);
-	  MUTEX_MIDIOUT_GIVE;
-	}
-      } else {
-	// Realtime events: ensure that they are only forwarded once
-	u32 mask = MIDI_ROUTER_PortMaskGet(n->dst_port);
-	if( !mask || !(sysex_dst_fwd_done & mask) ) {
-	  sysex_dst_fwd_done |= mask;
-	  MUTEX_MIDIOUT_TAKE;
-	  MIOS32_MIDI_SendPackage(n->dst_port, midi_package);
-	  MUTEX_MIDIOUT_GIVE;
-	}
+      if( !mask || !(common_dst_fwd_done & mask) ) {
+	common_dst_fwd_done |= mask;
+	r->common |= node_mask;
+      }
+
+      if( n->src_chn == 17 ) {
+	int chn;
+	for(chn=0; chn<16; ++chn)
+	  r->chn[chn] |= node_mask;
+      } else if( n->src_chn <= 16 ) {
+	r->chn[n->src_chn-1] |= node_mask;
       }
     }
   }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Has to be called whenever midi_router_node[] has been changed.
+// The routing table is compiled into the shadow table, which replaces the
+// active table with a single pointer write. This is done within the MIDIOUT
+// mutex, so that the table can't change while an event is forwarded.
+/////////////////////////////////////////////////////////////////////////////
+s32 MIDI_ROUTER_NodesChanged(void)
+{
+  MUTEX_MIDIOUT_TAKE;
+
+  route_table_t *shadow = (route_table_active == &route_table[0]) ? &route_table[1] : &route_table[0];
+  memcpy(shadow->node, midi_router_node, sizeof(shadow->node));
+
+  int ix;
+  for(ix=0; ix<NUM_ROUTE_SRC_PORTS; ++ix) {
+    mios32_midi_port_t src_port = (USB0 + ((ix & 0x38) << 1)) | (ix & 7);
+    MIDI_ROUTER_RouteGet(shadow->node, src_port, &shadow->route[ix]);
+  }
+
+  route_table_active = shadow;
+
+  MUTEX_MIDIOUT_GIVE;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the routing table entry of the given source port and the nodes
+// it has been compiled from. Has to be called within the MIDIOUT mutex.
+// If the port isn't covered by the table, the entry is determined from
+// midi_router_node[] in the given buffer
+/////////////////////////////////////////////////////////////////////////////
+static const route_t *MIDI_ROUTER_RouteLookup(mios32_midi_port_t port, route_t *buffer, const midi_router_node_entry_t **nodes)
+{
+  s32 ix = MIDI_ROUTER_RouteIxGet(port);
+  if( ix >= 0 ) {
+    route_table_t *table = route_table_active;
+    *nodes = table->node;
+    return &table->route[ix];
+  }
+
+  *nodes = midi_router_node;
+  MIDI_ROUTER_RouteGet(midi_router_node, port, buffer);
+  return buffer;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Receives a MIDI package from APP_NotifyReceivedEvent (-> app.c)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIDI_ROUTER_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_package)
+{
+  // filter SysEx which is handled by separate parser
+  if( midi_package.evnt0 < 0xf8 &&
+      (midi_package.cin == 0xf ||
+      (midi_package.cin >= 0x4 && midi_package.cin <= 0x7)) )
+    return 0; // no error
+
+  u8 is_chn_event = midi_package.event >= NoteOff && midi_package.event <= PitchBend;
+
+  // quick check without taking the mutex: exit if the port has no route
+  // (a table which is swapped meanwhile only delays the change by one event)
+  s32 ix = MIDI_ROUTER_RouteIxGet(port);
+  if( ix >= 0 ) {
+    route_t *r = &route_table_active->route[ix];
+    if( !(is_chn_event ? r->chn[midi_package.chn] : r->common) )
+      return 0; // no route
+  }
+
+  // forward to all destinations within one locked section
+  MUTEX_MIDIOUT_TAKE;
+  route_t route_buffer;
+  const midi_router_node_entry_t *nodes;
+  const route_t *r = MIDI_ROUTER_RouteLookup(port, &route_buffer, &nodes);
+
+  node_mask_t node_mask = is_chn_event ? r->chn[midi_package.chn] : r->common;
+  while( node_mask ) {
+    int node = __builtin_ctz(node_mask);
+    node_mask &= node_mask - 1;
+
+    const midi_router_node_entry_t *n = &nodes[node];
+    if( is_chn_event ) {
+      mios32_midi_package_t fwd_package = midi_package;
+      if( n->dst_chn <= 16 )
+	fwd_package.chn = (n->dst_chn-1);
+      MIOS32_MIDI_SendPackage(n->dst_port, fwd_package);
+    } else {
+      MIOS32_MIDI_SendPackage(n->dst_port, midi_package);
+    }
+  }
+  MUTEX_MIDIOUT_GIVE;
 
   return 0; // no error
 }
@@ -182,26 +329,22 @@ s32 MIDI_ROUTER_ReceiveSysEx(mios32_midi_port_t port, u8 midi_in)
     if( midi_in == 0xf7 && buffer_len < MIDI_ROUTER_SYSEX_BUFFER_SIZE ) // note: we always have a free byte for F7
       sysex_buffer[sysex_in][sysex_buffer_len[sysex_in]++] = midi_in;
 
-    u32 sysex_dst_fwd_done = 0;
-    int node;
-    midi_router_node_entry_t *n = (midi_router_node_entry_t *)&midi_router_node[0];
-    for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
-      if( n->src_chn && n->dst_chn && (n->src_port == port) ) {
-	// SysEx, only forwarded once per destination port
-	u32 mask = MIDI_ROUTER_PortMaskGet(n->dst_port);
-	if( !mask || !(sysex_dst_fwd_done & mask) ) {
-	  sysex_dst_fwd_done |= mask;
-
-	  mios32_midi_port_t port = n->dst_port;
-	  MUTEX_MIDIOUT_TAKE;
-	  if( (port & 0xf0) == OSC0 )
-	    OSC_CLIENT_SendSysEx(port & 0x0f, sysex_buffer[sysex_in], sysex_buffer_len[sysex_in]);
-	  else
-	    MIOS32_MIDI_SendSysEx(port, sysex_buffer[sysex_in], sysex_buffer_len[sysex_in]);
-	  MUTEX_MIDIOUT_GIVE;
-	}
-      }
+    // SysEx, only forwarded once per destination port
+    MUTEX_MIDIOUT_TAKE;
+    route_t route_buffer;
+    const midi_router_node_entry_t *nodes;
+    node_mask_t node_mask = MIDI_ROUTER_RouteLookup(port, &route_buffer, &nodes)->sysex;
+    while( node_mask ) {
+      int node = __builtin_ctz(node_mask);
+      node_mask &= node_mask - 1;
+
+      mios32_midi_port_t port = nodes[node].dst_port;
+      if( (port & 0xf0) == OSC0 )
+	OSC_CLIENT_SendSysEx(port & 0x0f, sysex_buffer[sysex_in], sysex_buffer_len[sysex_in]);
+      else
+	MIOS32_MIDI_SendSysEx(port, sysex_buffer[sysex_in], sysex_buffer_len[sysex_in]);
     }
+    MUTEX_MIDIOUT_GIVE;
 
     // empty buffer
     sysex_buffer_len[sysex_in] = 0;
@@ -545,6 +688,7 @@ s32 MIDI_ROUTER_TerminalParseLine(char *input, void *_output_function)
 	n->src_chn = src_chn;
 	n->dst_port = dst_port;
 	n->dst_chn = dst_chn;
+	MIDI_ROUTER_NodesChanged();
 
 	out("Changed Node %d to SRC:%s %s  DST:%s %s",
 	    node+1,
@@ -58,6 +58,8 @@ typedef struct {
 
 extern s32 MIDI_ROUTER_Init(u32 mode);
 
+extern s32 MIDI_ROUTER_NodesChanged(void);
+
 extern s32 MIDI_ROUTER_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_package);
 extern s32 MIDI_ROUTER_ReceiveSysEx(mios32_midi_port_t port, u8 midi_in);
 
@@ -77,6 +79,7 @@ extern s32 MIDI_ROUTER_TerminalPrintConfig(void *_output_function);
 // Exported variables
 /////////////////////////////////////////////////////////////////////////////
 
+// MIDI_ROUTER_NodesChanged() has to be called after the nodes have been changed
 extern midi_router_node_entry_t midi_router_node[MIDI_ROUTER_NUM_NODES];
 extern u32 midi_router_mclk_in;
 extern u32 midi_router_mclk_out;
@@ -32,6 +32,53 @@
 # define OPL3_PIN_RS_0  { MIOS32_SYS_STM_PINSET(OPL3_RS_PORT, OPL3_RS_PIN, 0); }
 # define OPL3_PIN_RS_1  { MIOS32_SYS_STM_PINSET(OPL3_RS_PORT, OPL3_RS_PIN, 1); }
 
+//32-bit access to BSRRL/BSRRH: lower half sets, upper half clears port pins
+#define OPL3_BSRR       (*(__IO u32 *)&GPIOE->BSRRL)
+//D7:0 (PE15:8), A1 (PE7), A0 (PE6)
+#define OPL3_BUS_MASK   0xFFC0
+
+/////////////////////////////////////////////////////////////////////////////
+// Write engine
+/////////////////////////////////////////////////////////////////////////////
+
+//Register writes are played back by DMA2 Stream1, which is triggered by the
+//update event of TIM8 (DMA Channel 7). Each transfer writes one word into
+//GPIOE->BSRR, so that the CPU doesn't need to wait, and other pins of port E
+//aren't touched. A register write takes 6 slots:
+//  idle, address + CS low, CS high, idle, data + CS low, CS high
+//so that with 1.25 uS per slot there are at least 2.5 uS (> 32 OPL3 clocks)
+//between a write and the next one.
+#define OPL3_DMA_SLOTS_PER_WRITE 6
+#define OPL3_DMA_SLOT_PERIOD     (MIOS32_SYS_CPU_FREQUENCY/800000) //1.25 uS @ TIM8 clock
+
+//Number of register writes which are transferred with one DMA block. When
+//the block is done, the DMA interrupt prepares the next one.
+#ifndef OPL3_DMA_WRITES
+#define OPL3_DMA_WRITES 32
+#endif
+
+#ifndef OPL3_DMA_IRQ_PRIORITY
+#define OPL3_DMA_IRQ_PRIORITY MIOS32_IRQ_PRIO_LOW
+#endif
+
+#define OPL3_DMA_PTR         DMA2_Stream1
+#define OPL3_DMA_CHN         DMA_Channel_7
+#define OPL3_DMA_IRQ         DMA2_Stream1_IRQn
+#define OPL3_DMA_FLAGS       (DMA_FLAG_TCIF1 | DMA_FLAG_TEIF1 | DMA_FLAG_HTIF1 | DMA_FLAG_FEIF1 | DMA_FLAG_DMEIF1)
+#define OPL3_DMA_IRQHANDLER_FUNC void DMA2_Stream1_IRQHandler(void)
+
+//Register images: operators (5 regs), channels (3 regs), chips (4 regs)
+#define OPL3_NUM_OP_REGS   (36*5*OPL3_COUNT)
+#define OPL3_NUM_CHAN_REGS (18*3*OPL3_COUNT)
+#define OPL3_NUM_CHIP_REGS (4*OPL3_COUNT)
+#define OPL3_NUM_REGS      (OPL3_NUM_OP_REGS + OPL3_NUM_CHAN_REGS + OPL3_NUM_CHIP_REGS)
+#define OPL3_FLAG_WORDS    ((OPL3_NUM_REGS+31)/32)
+#define OPL3_CHAN_REG_BASE OPL3_NUM_OP_REGS
+#define OPL3_CHIP_REG_BASE (OPL3_NUM_OP_REGS + OPL3_NUM_CHAN_REGS)
+
+//Size of the commit FIFO: a complete refresh and the changes of one frame
+#define OPL3_COMMIT_SIZE   (2*OPL3_NUM_REGS)
+
 /////////////////////////////////////////////////////////////////////////////
 // Global variables
 /////////////////////////////////////////////////////////////////////////////
@@ -44,13 +91,28 @@ opl3_chip_t opl3_chip[OPL3_COUNT];
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
 
-// Queues for what registers need to be updated
-static u16 opl3_op_queue[36*5*OPL3_COUNT];
-static u8 opl3_chan_queue[18*3*OPL3_COUNT];
-static u8 opl3_chip_queue[4*OPL3_COUNT];
-static u16 op_queue_idx;
-static u8 chan_queue_idx;
-static u8 chip_queue_idx;
+// Flags for what registers need to be updated (one bit per register image)
+// Multiple changes of the same register within a frame result into a single write
+static u32 opl3_pending[OPL3_FLAG_WORDS];
+
+// Commit FIFO: OPL3_OnFrame() copies the pending registers with their values
+// into it, the write engine only streams from here. So that changes of the next
+// frame can't be merged into a frame which is still being sent (e.g. key off
+// followed by key on)
+// Entry: chip (bit 31:17), addrhigh (bit 16), addr (bit 15:8), data (bit 7:0)
+static u32 opl3_commit[OPL3_COMMIT_SIZE];
+static volatile u16 commit_head; //written by OPL3_OnFrame()
+static volatile u16 commit_tail; //written by the write engine
+
+// DMA block
+static u32 opl3_dma_buffer[OPL3_DMA_WRITES*OPL3_DMA_SLOTS_PER_WRITE];
+static volatile u8 opl3_dma_busy;
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static void OPL3_DMA_Next(void);
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -109,92 +171,167 @@ static const u8 OPL3ChannelMap[18] = {
   OPL3 A1:0 -> PE7:6
 */
 
+//Puts the port E slots of a register write into dst, returns the pointer after it
+static u32 *OPL3_EncodeWrite(u32 *dst, u8 chip, u8 addrhigh, u8 addr, u8 data){
+  u32 cs = OPL3CSMasks[chip];
+  u32 a1 = addrhigh ? (1 << 7) : 0; //A1 is kept during the data write
+  u32 set = ((u32)addr << 8) | a1; //A0 == 0
+  *dst++ = 0; //Idle: wait after the previous data write
+  *dst++ = set | (((~set & OPL3_BUS_MASK) | cs) << 16); //Address, CS low
+  *dst++ = cs; //CS high
+  *dst++ = 0; //Idle: wait after the address write
+  set = ((u32)data << 8) | a1 | (1 << 6); //A0 == 1
+  *dst++ = set | (((~set & OPL3_BUS_MASK) | cs) << 16); //Data, CS low
+  *dst++ = cs; //CS high
+  return dst;
+}
+
+//Waits until the write engine has sent all committed registers
+//Also works when the DMA interrupt is masked (e.g. during initialisation)
+static void OPL3_WaitIdle(void){
+  while(opl3_dma_busy){
+    u8 done;
+    MIOS32_IRQ_Disable();
+    done = DMA_GetFlagStatus(OPL3_DMA_PTR, DMA_FLAG_TCIF1) == SET;
+    if(done) DMA_ClearFlag(OPL3_DMA_PTR, DMA_FLAG_TCIF1);
+    MIOS32_IRQ_Enable();
+    if(done) OPL3_DMA_Next();
+  }
+}
+
+//Writes a register directly, bypassing the register images.
+//Waits until the write engine is idle, interrupts stay enabled.
 s32 OPL3_SendAddrData(u8 chip, u8 addrhigh, u8 addr, u8 data){
-  //Turn off interrupts
-  MIOS32_IRQ_Disable();
-  //-------------------------------------------------------------
-  //Write address, high address bit, and appropriate #CS low
-  //-------------------------------------------------------------
-  u32 porte = GPIOE->ODR;
-  porte &= 0xFFFF003F; //Mask out the things we will set
-  u32 a = addr; //Put in address
-  a <<= 1; //Make room for high bit
-  a |= (addrhigh > 0) & 1; //Add high bit
-  a <<= 7; //Move over into place, A0 == 0
-  porte |= a; //Write to our temp copy
-  u32 mask = OPL3CSMasks[chip]; //Get value to mask to set CS low
-  a = ~mask; //Invert mask
-  porte &= a; //AND mask, bringing CS low
-  GPIOE->ODR = porte; //Write
-  porte |= mask; //OR mask, bringing CS high
-  a = ~a; //Waste a cycle
-  a = ~a; //Waste a cycle
-  GPIOE->ODR = porte; //Write
-  //-------------------------------------------------------------
-  //Wait 32 times clock rate (at 14 Mhz, this would be 2.3 us)
-  //-------------------------------------------------------------
-  MIOS32_DELAY_Wait_uS(1);
-  MIOS32_DELAY_Wait_uS(1);
-  MIOS32_DELAY_Wait_uS(1);
-  //-------------------------------------------------------------
-  //Write data
-  //-------------------------------------------------------------
-  porte = GPIOE->ODR;
-  porte &= 0xFFFF00BF; //Mask out the things we will set
-  a = data; //Put in data
-  a <<= 8; //Move into place
-  a |= (1 << 6); //Or in bit saying it's data, A0 == 1
-  porte |= a; //Write to our temp copy
-  a = ~mask; //Invert mask
-  porte &= a; //AND mask, bringing CS low
-  GPIOE->ODR = porte; //Write
-  porte |= mask; //OR mask, bringing CS high
-  a = ~a; //Waste a cycle
-  a = ~a; //Waste a cycle
-  GPIOE->ODR = porte; //Write
-  //-------------------------------------------------------------
-  //Wait enough time that this won't be called again before 32 times clock rate
-  //-------------------------------------------------------------
-  MIOS32_DELAY_Wait_uS(1);
-  //Turn on interrupts
-  MIOS32_IRQ_Enable();
-  return 0;
-}
-
-s32 OPL3_RefreshOperator(u8 op, u8 reg){
-  if(op >= 36*OPL3_COUNT) return -1;
-  if(reg >= 5) return -1;
-  u8 chip = op / 36;
-  u8 chipop = op % 36; //Op within the chip
-  u8 chan = OPL3ChannelMap[chipop >> 1]; //Channel mapped to OPL3 way
-  u8 addrhigh = chan >= 9; //Use second half of chip
-  u8 index = ((chan % 9) << 1) + (chipop & 1); //Which operator, with channels mapped OPL3 way but ops not yet mapped
-  u8 addr = OPL3OperRegBegin[reg] + OPL3RegOffset[index];
-  u8 data = opl3_operators[op].ALL[reg];
-  OPL3_SendAddrData(chip, addrhigh, addr, data);
-  return 0;
-}
-
-s32 OPL3_RefreshChannel(u8 chan, u8 reg){
-  if(chan >= 18*OPL3_COUNT) return -1;
-  if(reg >= 3) return -1;
-  u8 chip = chan / 18;
-  u8 chipchan = chan % 18;
-  u8 mappedchan = OPL3ChannelMap[chipchan];
-  u8 addrhigh = mappedchan >= 9;
-  u8 addr = OPL3ChanRegBegin[reg] + (mappedchan % 9);
-  u8 data = opl3_channels[chan].ALL[reg];
-  OPL3_SendAddrData(chip, addrhigh, addr, data);
+  u32 slots[OPL3_DMA_SLOTS_PER_WRITE];
+  u8 i;
+  if(chip >= OPL3_COUNT) return -1;
+  OPL3_WaitIdle();
+  OPL3_EncodeWrite(slots, chip, addrhigh, addr, data);
+  for(i=0; i<OPL3_DMA_SLOTS_PER_WRITE; i++){
+    if(slots[i]){
+      OPL3_BSRR = slots[i];
+    }else{
+      //Wait 32 times clock rate (at 14 Mhz, this would be 2.3 us)
+      MIOS32_DELAY_Wait_uS(3);
+    }
+  }
   return 0;
 }
 
-s32 OPL3_RefreshChip(u8 chip, u8 reg){
-  if(reg >= 4*OPL3_COUNT) return -1;
-  u8 addrhigh = OPL3ChipRegHigh[reg];
-  u8 addr = OPL3ChipReg[reg];
-  u8 data = opl3_chip[chip].ALL[reg];
-  OPL3_SendAddrData(chip, addrhigh, addr, data);
-  return 0;
+//Gets address and data of a register image (index into the flag arrays)
+static void OPL3_GetReg(u16 index, u8 *chip, u8 *addrhigh, u8 *addr, u8 *data){
+  if(index < OPL3_NUM_OP_REGS){
+    u8 op = index / 5;
+    u8 reg = index % 5;
+    u8 chipop = op % 36; //Op within the chip
+    u8 chan = OPL3ChannelMap[chipop >> 1]; //Channel mapped to OPL3 way
+    u8 opindex = ((chan % 9) << 1) + (chipop & 1); //Which operator, with channels mapped OPL3 way but ops not yet mapped
+    *chip = op / 36;
+    *addrhigh = chan >= 9; //Use second half of chip
+    *addr = OPL3OperRegBegin[reg] + OPL3RegOffset[opindex];
+    *data = opl3_operators[op].ALL[reg];
+    return;
+  }
+  index -= OPL3_NUM_OP_REGS;
+  if(index < OPL3_NUM_CHAN_REGS){
+    u8 chan = index / 3;
+    u8 reg = index % 3;
+    u8 mappedchan = OPL3ChannelMap[chan % 18];
+    *chip = chan / 18;
+    *addrhigh = mappedchan >= 9;
+    *addr = OPL3ChanRegBegin[reg] + (mappedchan % 9);
+    *data = opl3_channels[chan].ALL[reg];
+    return;
+  }
+  index -= OPL3_NUM_CHAN_REGS;
+  {
+    u8 reg = index % 4;
+    *chip = index / 4;
+    *addrhigh = OPL3ChipRegHigh[reg];
+    *addr = OPL3ChipReg[reg];
+    *data = opl3_chip[*chip].ALL[reg];
+  }
+}
+
+//Copies a pending register with its current value into the commit FIFO
+//(the caller ensures that there is enough space)
+static void OPL3_CommitReg(u16 index, u16 *head){
+  u8 chip, addrhigh, addr, data;
+  u32 mask = 1UL << (index & 31);
+  if(!(opl3_pending[index >> 5] & mask)) return;
+  opl3_pending[index >> 5] &= ~mask;
+  OPL3_GetReg(index, &chip, &addrhigh, &addr, &data);
+  opl3_commit[*head] = ((u32)chip << 17) | ((u32)addrhigh << 16) | ((u32)addr << 8) | data;
+  if(++*head >= OPL3_COMMIT_SIZE) *head = 0;
+}
+
+//Fills the DMA block from the commit FIFO and starts the transfer.
+//Called from the DMA interrupt, or from OPL3_OnFrame() when the engine is idle.
+static void OPL3_DMA_Next(void){
+  u32 *dst = opl3_dma_buffer;
+  u16 num = 0;
+  u16 tail = commit_tail;
+  while(tail != commit_head && num<OPL3_DMA_WRITES){
+    u32 entry = opl3_commit[tail];
+    if(++tail >= OPL3_COMMIT_SIZE) tail = 0;
+    dst = OPL3_EncodeWrite(dst, entry >> 17, (entry >> 16) & 1, (entry >> 8) & 0xFF, entry & 0xFF);
+    num++;
+  }
+  commit_tail = tail;
+  if(!num){
+    opl3_dma_busy = 0;
+    return;
+  }
+  opl3_dma_busy = 1;
+  DMA_Cmd(OPL3_DMA_PTR, DISABLE);
+  while(OPL3_DMA_PTR->CR & DMA_SxCR_EN);
+  DMA_ClearFlag(OPL3_DMA_PTR, OPL3_DMA_FLAGS);
+  DMA_SetCurrDataCounter(OPL3_DMA_PTR, num*OPL3_DMA_SLOTS_PER_WRITE);
+  DMA_Cmd(OPL3_DMA_PTR, ENABLE);
+}
+
+//DMA block has been sent
+OPL3_DMA_IRQHANDLER_FUNC{
+  if(DMA_GetITStatus(OPL3_DMA_PTR, DMA_IT_TCIF1)){
+    DMA_ClearITPendingBit(OPL3_DMA_PTR, DMA_IT_TCIF1);
+    OPL3_DMA_Next();
+  }
+}
+
+//Sets up TIM8 and DMA2 Stream1 for the write engine
+static void OPL3_DMA_Init(void){
+  opl3_dma_busy = 0;
+  commit_head = commit_tail = 0;
+  //Timer: one DMA request per slot
+  RCC_APB2PeriphClockCmd(RCC_APB2Periph_TIM8, ENABLE);
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructInit(&TIM_TimeBaseStructure);
+  TIM_TimeBaseStructure.TIM_Period = OPL3_DMA_SLOT_PERIOD - 1;
+  TIM_TimeBaseStructure.TIM_Prescaler = 0;
+  TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+  TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+  TIM_TimeBaseInit(TIM8, &TIM_TimeBaseStructure);
+  TIM_DMACmd(TIM8, TIM_DMA_Update, ENABLE);
+  TIM_Cmd(TIM8, ENABLE);
+  //DMA: memory -> GPIOE->BSRR
+  RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_DMA2, ENABLE);
+  DMA_Cmd(OPL3_DMA_PTR, DISABLE);
+  DMA_InitTypeDef DMA_InitStructure;
+  DMA_StructInit(&DMA_InitStructure);
+  DMA_InitStructure.DMA_Channel = OPL3_DMA_CHN;
+  DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+  DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+  DMA_InitStructure.DMA_Memory0BaseAddr = (u32)&opl3_dma_buffer[0];
+  DMA_InitStructure.DMA_BufferSize = OPL3_DMA_SLOTS_PER_WRITE;
+  DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)&OPL3_BSRR;
+  DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+  DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+  DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+  DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+  DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+  DMA_Init(OPL3_DMA_PTR, &DMA_InitStructure);
+  DMA_ITConfig(OPL3_DMA_PTR, DMA_IT_TC, ENABLE);
+  MIOS32_IRQ_Install(OPL3_DMA_IRQ, OPL3_DMA_IRQ_PRIORITY);
 }
 
 s32 OPL3_Reset(){
@@ -237,6 +374,8 @@ s32 OPL3_Init(){
     MIOS32_BOARD_J10_PinInit(OPL3CSPins[i], MIOS32_BOARD_PIN_MODE_OUTPUT_PP);
     MIOS32_BOARD_J10_PinSet(OPL3CSPins[i], 1);
   }
+  //Write engine
+  OPL3_DMA_Init();
   //Reset
   OPL3_Reset();
   return 0;
@@ -244,24 +383,18 @@ s32 OPL3_Init(){
 
 s32 OPL3_RefreshAll(){
   MIOS32_MIDI_SendDebugMessage("OPL3_RefreshAll");
-  u8 i, j;
-  for(i=0; i<OPL3_COUNT; i++){
-    for(j=0; j<4; j++){
-      OPL3_RefreshChip(i, j);
-    }
-  }
-  MIOS32_MIDI_SendDebugMessage("OPL3_RefreshAll: Refresh operators");
-  for(i=0; i<36*OPL3_COUNT; i++){
-    for(j=0; j<5; j++){
-      OPL3_RefreshOperator(i, j);
-    }
-  }
-  MIOS32_MIDI_SendDebugMessage("OPL3_RefreshAll: Refresh channels");
-  for(i=0; i<18*OPL3_COUNT; i++){
-    for(j=0; j<3; j++){
-      OPL3_RefreshChannel(i, j);
-    }
-  }
+  u16 i;
+  //Chip registers first (OPL3 mode), then operators and channels
+  OPL3_WaitIdle();
+  for(i=OPL3_CHIP_REG_BASE; i<OPL3_NUM_REGS; i++){
+    opl3_pending[i >> 5] |= (1UL << (i & 31));
+  }
+  OPL3_OnFrame();
+  OPL3_WaitIdle();
+  for(i=0; i<OPL3_NUM_REGS; i++){
+    opl3_pending[i >> 5] |= (1UL << (i & 31));
+  }
+  OPL3_OnFrame();
   MIOS32_MIDI_SendDebugMessage("OPL3_RefreshAll: Demo patch");
   OPL3_SendDemoPatch();
   return 0;
@@ -300,125 +433,89 @@ void OPL3_SendDemoPatch(){
 
 u8 toggle;
 s32 OPL3_OnFrame(){
-  u8 op, chan, chip, reg;
-  u16 val, q=0;
-  while(q < op_queue_idx){
-    if(q >= 36*5*OPL3_COUNT){
-      DEBUG_MSG("PANIC!! [opl3.c] Op queue overflow q==%d!", q);
-    }
-    val = opl3_op_queue[q];
-    op = val / 5;
-    reg = val % 5;
-    OPL3_RefreshOperator(op, reg);
-    q++;
-  }
-  op_queue_idx = 0;
-  q = 0;
-  if(chan_queue_idx > 20){
-    DEBUG_MSG("chan_queue_idx=%d", chan_queue_idx);
-  }
-  while(q < chan_queue_idx){
-    if(q >= 18*3*OPL3_COUNT){
-      DEBUG_MSG("PANIC!! [opl3.c] Chan queue overflow q==%d!", q);
-    }
-    val = opl3_chan_queue[q];
-    chan = val / 3;
-    reg = val % 3;
-    OPL3_RefreshChannel(chan, reg);
-    q++;
-  }
-  chan_queue_idx = 0;
-  q = 0;
-  while(q < chip_queue_idx){
-    if(q >= 4*OPL3_COUNT){
-      DEBUG_MSG("PANIC!! [opl3.c] Chip queue overflow q==%d!", q);
-    }
-    val = opl3_chip_queue[q];
-    chip = val / 4;
-    reg = val % 4;
-    OPL3_RefreshChip(chip, reg);
-    q++;
+  u8 w, start;
+  u16 i, num = 0, used, head;
+  //Hand over the changed registers to the write engine
+  for(w=0; w<OPL3_FLAG_WORDS; w++){
+    num += __builtin_popcount(opl3_pending[w]);
+  }
+  if(!num) return 0;
+  head = commit_head;
+  used = (head + OPL3_COMMIT_SIZE - commit_tail) % OPL3_COMMIT_SIZE;
+  if(num > (OPL3_COMMIT_SIZE - 1 - used)){
+    return 0; //Previous frames haven't been sent yet, try again with the next frame
+  }
+  //Operators, chip settings and channels (frequency, algorithm), then
+  //key on/off and percussion triggers, so that a note starts with its new sound
+  for(i=0; i<OPL3_NUM_OP_REGS; i++){
+    OPL3_CommitReg(i, &head);
+  }
+  for(i=OPL3_CHIP_REG_BASE; i<OPL3_NUM_REGS; i++){
+    if(((i - OPL3_CHIP_REG_BASE) & 3) != 2) OPL3_CommitReg(i, &head);
+  }
+  for(i=OPL3_CHAN_REG_BASE; i<OPL3_CHIP_REG_BASE; i+=3){
+    OPL3_CommitReg(i, &head);
+    OPL3_CommitReg(i+2, &head);
+  }
+  for(i=OPL3_CHAN_REG_BASE; i<OPL3_CHIP_REG_BASE; i+=3){
+    OPL3_CommitReg(i+1, &head);
+  }
+  for(i=OPL3_CHIP_REG_BASE+2; i<OPL3_NUM_REGS; i+=4){
+    OPL3_CommitReg(i, &head);
   }
-  chip_queue_idx = 0;
+  MIOS32_IRQ_Disable();
+  commit_head = head;
+  start = !opl3_dma_busy;
+  if(start) opl3_dma_busy = 1;
+  MIOS32_IRQ_Enable();
+  //If the engine is idle, start it; otherwise the DMA interrupt continues with the new registers
+  if(start) OPL3_DMA_Next();
   return 0;
 }
 
 
 s32 OPL3_AddOperQueue(u8 op, u8 reg){
   if(op >= 36*OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid op %d passed to OPL3_AddOperQueue! op_queue_idx=%d", op, op_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid op %d passed to OPL3_AddOperQueue!", op);
     return -9001;
   }
   if(reg >= 5){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddOperQueue! op_queue_idx=%d", reg, op_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddOperQueue!", reg);
     return -9001;
   }
   u16 val = (0x0005*((u16)op))+reg;
-  //See if it's on the queue
-  u16 q;
-  for(q=0; q<op_queue_idx; q++){
-    if(opl3_op_queue[q] == val){
-      return 0;
-    }
-  }
-  opl3_op_queue[op_queue_idx] = val;
-  op_queue_idx++;
-  if(op_queue_idx >= 36*5*OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Op queue overflow on write op_queue_idx==%d!", op_queue_idx);
-    op_queue_idx = (36*5*OPL3_COUNT)-1;
-  }
+  //Flag it, if it's already flagged the write is merged
+  opl3_pending[val >> 5] |= (1UL << (val & 31));
   return 0;
 }
 
 s32 OPL3_AddChanQueue(u8 chan, u8 reg){
   if(chan >= 18*OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid chan %d passed to OPL3_AddChanQueue! chan_queue_idx=%d", chan, chan_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid chan %d passed to OPL3_AddChanQueue!", chan);
     return -9001;
   }
   if(reg >= 3){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddChanQueue! chan_queue_idx=%d", reg, chan_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddChanQueue!", reg);
     return -9001;
   }
-  u8 val = (3*chan)+reg;
-  //See if it's on the queue
-  u8 q;
-  for(q=0; q<chan_queue_idx; q++){
-    if(opl3_chan_queue[q] == val){
-      return 0;
-    }
-  }
-  opl3_chan_queue[chan_queue_idx] = val;
-  chan_queue_idx++;
-  if(chan_queue_idx >= 18*3*OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Chan queue overflow on write chan_queue_idx==%d!", chan_queue_idx);
-    chan_queue_idx = (18*3*OPL3_COUNT)-1;
-  }
+  u16 val = OPL3_NUM_OP_REGS+(3*chan)+reg;
+  //Flag it, if it's already flagged the write is merged
+  opl3_pending[val >> 5] |= (1UL << (val & 31));
   return 0;
 }
 
 s32 OPL3_AddChipQueue(u8 chip, u8 reg){
   if(chip >= OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid chip %d passed to OPL3_AddChipQueue! chip_queue_idx=%d", chip, chip_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid chip %d passed to OPL3_AddChipQueue!", chip);
     return -9001;
   }
   if(reg >= 4){
-    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddChipQueue! chip_queue_idx=%d", reg, chip_queue_idx);
+    DEBUG_MSG("PANIC!! [opl3.c] Invalid reg %d passed to OPL3_AddChipQueue!", reg);
     return -9001;
   }
-  u8 val = (4*chip)+reg;
-  //See if it's on the queue
-  u8 q;
-  for(q=0; q<chip_queue_idx; q++){
-    if(opl3_chip_queue[q] == val){
-      return 0;
-    }
-  }
-  opl3_chip_queue[chip_queue_idx] = val;
-  chip_queue_idx++;
-  if(chip_queue_idx >= 4*OPL3_COUNT){
-    DEBUG_MSG("PANIC!! [opl3.c] Chip queue overflow on write chip_queue_idx==%d!", chip_queue_idx);
-    chip_queue_idx = 4*OPL3_COUNT;
-  }
+  u16 val = OPL3_NUM_OP_REGS+OPL3_NUM_CHAN_REGS+(4*chip)+reg;
+  //Flag it, if it's already flagged the write is merged
+  opl3_pending[val >> 5] |= (1UL << (val & 31));
   return 0;
 }
 
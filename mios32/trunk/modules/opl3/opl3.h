@@ -201,7 +201,7 @@ extern opl3_chip_t opl3_chip[OPL3_COUNT];
 /////////////////////////////////////////////////////////////////////////////
 
 // Call this when setting up the microcontroller. Sets up GPIO pins, internals,
-// calls OPL3_Reset().
+// the write engine (TIM8 + DMA2 Stream1, see Readme.txt), calls OPL3_Reset().
 extern s32 OPL3_Init(void);
 
 // Sends reset signal to OPL3 and then refreshes it with current data.
@@ -222,6 +222,11 @@ extern void OPL3_SendDemoPatch(void);
 
 // Call this after every control refresh. Refreshes any OPL3 registers that have
 // changed since last time.
+// The registers are written by DMA in the background, so this function returns
+// immediately and doesn't disable interrupts. The register values are taken
+// when this function is called: if a register is changed several times within
+// a frame, only the latest value is sent. Key On/Off is written after the
+// operator and channel registers of the frame.
 extern s32 OPL3_OnFrame(void);
 
 // Convenience functions for interacting with OPL3
@@ -28,26 +28,38 @@
 //! \note these flags <B>have to be</B> polled as well, otherwise clock requests
 //! will be held back
 //!
+//! The sequencer task doesn't need to wait for its next periodic execution
+//! to process a new request: a callback can be installed with 
+//! SEQ_BPM_TickCallback_Init(), which is called whenever a request has been
+//! flagged (e.g. to resume the sequencer task immediately)
+//!
 //!
 //! <B>SLAVE MODE</B>
 //!
 //! In order to reach a higher ppqn resolution (e.g. 384 ppqn) than provided 
 //! by MIDI (24 ppqn), the incoming clock has to be interpolated in ppqn/24 steps
 //!
-//! A timer interrupt with an interval of 250 uS is used to measure 
-//! the delay between two incoming MIDI clock events. The same interrupt
-//! will call the sequencer clock handler with an interval of:
-//!   interval = 250 uS * measured_delay / (ppqn/24)
+//! The incoming F8 events are timestamped with MIOS32_TIMESTAMP_Get_uS(),
+//! and passed to a tempo tracker (second order PLL) which filters phase and
+//! period of the clock. Clocks which are far off the expected time (e.g.
+//! bursts of USB hosts) are treated as outliers, after a few outliers in
+//! series the tracker assumes a tempo change and locks again.
+//!
+//! All (ppqn/24) internal ticks of a F8 period, including the first one,
+//! are placed relative to the filtered phase by a timer interrupt with an
+//! interval of 250 uS:
+//!   tick = 1 + (time - phase) / (period / (ppqn/24))
 //! (e.g. 384 ppqn: 16x interpolated clock)
+//! The measured F8 time only corrects the tracker, accordingly the jitter
+//! of the incoming clock doesn't pass through to the ticks.
+//! If F8 is received before the filtered phase has been reached, the
+//! first tick is delayed until then, if it's received later, the due
+//! ticks are sent immediately.
 //!
 //! There is a protection (-> sent_clk_ctr) which ensures, that never more
 //! that 16 internal ticks will be triggered between two F8 events to 
 //! improve the robustness on BPM sweeps or jittering incoming MIDI clock
 //!
-//! Note that instead of the timer interrupt, we could also use a HW timer
-//! to measure the delay. Problem: currently I don't know how to handle this
-//! in the MacOS based emulation...
-//!
 //! \{
 /* ==========================================================================
  *
@@ -80,6 +92,18 @@
 // the timer rate in slave mode
 #define TIMER_RATE_SLAVE_MODE_US 250
 
+// tempo tracker: phase and period correction (error divided by given value)
+// beta ~= alpha^2 / (2-alpha) results into a critically damped PLL
+#define CLK_TRACKER_ALPHA_DIV 4
+#define CLK_TRACKER_BETA_DIV  32
+
+// number of outliers in series until the tracker locks again
+#define CLK_TRACKER_MAX_OUTLIERS 3
+
+// range of the F8 period (24 ppqn)
+#define CLK_TRACKER_MIN_PERIOD_US 1000
+#define CLK_TRACKER_MAX_PERIOD_US (SLAVE_CLK_TIMEOUT_DELAY*TIMER_RATE_SLAVE_MODE_US)
+
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
 /////////////////////////////////////////////////////////////////////////////
@@ -88,6 +112,20 @@ static s32 SEQ_BPM_TimerInit(void);
 static void SEQ_BPM_Timer_Slave(void);
 static void SEQ_BPM_Timer_Master(void);
 static s32 SEQ_BPM_DigitUpdate(void);
+static void SEQ_BPM_ClkTrackerInit(void);
+static void SEQ_BPM_ClkTrackerUpdate(u32 timestamp_us);
+static u8 SEQ_BPM_SlaveTicksUpdate(u32 now_us);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+  CLK_TRACKER_IDLE,   // no clock received yet
+  CLK_TRACKER_SYNC,   // first clock received, waiting for the second one
+  CLK_TRACKER_LOCKED, // phase and period are known
+} clk_tracker_state_t;
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -114,16 +152,21 @@ static float bpm;
 static u16 ppqn;
 
 static u32 incoming_clk_ctr;
-static u32 incoming_clk_delay;
-static u32 incoming_clk_delay_beat;
-static u32 incoming_clk_delay_beat_latched;
-static u32 sent_clk_ctr;
-static u32 received_clk_beat_ctr;
-static u32 sent_clk_delay;
+static u32 sent_clk_ctr;      // ticks which have been sent in the current F8 period
+static u32 sent_clk_phase_us; // filtered timestamp of the F8 event which started this period
+static u8  sent_clk_next;     // the next F8 period starts at clk_phase_us
+
+static clk_tracker_state_t clk_tracker_state;
+static u32 clk_last_us;    // timestamp of the last F8 event
+static u32 clk_phase_us;   // filtered timestamp of the last F8 event
+static s32 clk_period_q8;  // filtered F8 period in uS (24.8 fixed point)
+static u8  clk_outlier_ctr;
 
 static u16 new_song_pos;
 static u8  receive_song_pos_state;
 
+static void (*tick_callback_func)(void);
+
 
 /////////////////////////////////////////////////////////////////////////////
 //! Initialisation of BPM generator
@@ -146,12 +189,10 @@ s32 SEQ_BPM_Init(u32 mode)
 
   slave_clk = 0;
   incoming_clk_ctr = 0;
-  incoming_clk_delay = 0;
-  incoming_clk_delay_beat = 0;
-  incoming_clk_delay_beat_latched = 0;
   sent_clk_ctr = 0;
-  received_clk_beat_ctr = 0;
-  sent_clk_delay = 0;
+  sent_clk_phase_us = 0;
+  sent_clk_next = 0;
+  SEQ_BPM_ClkTrackerInit();
 
   // start clock generator with 140 BPM/384 ppqn in Auto mode
   ppqn = 384;
@@ -206,10 +247,10 @@ float SEQ_BPM_Get(void)
 float SEQ_BPM_EffectiveGet(void)
 {
   if( slave_clk ) {
-    if( incoming_clk_ctr >= SLAVE_CLK_TIMEOUT_DELAY )
+    if( incoming_clk_ctr >= SLAVE_CLK_TIMEOUT_DELAY || clk_tracker_state != CLK_TRACKER_LOCKED )
       return 0.0;
 
-    return (60.0 * 1E6) / (float)(incoming_clk_delay_beat_latched * TIMER_RATE_SLAVE_MODE_US);
+    return (60.0 * 1E6 * 256) / ((float)clk_period_q8 * 24);
   }
 
   return bpm;
@@ -356,6 +397,7 @@ static s32 SEQ_BPM_TimerInit(void)
     // two clocks to generate 16 internal clocks (@384ppqn) on every F8 event.
     // using 250 uS as reference
     // using highest priority for best accuracy (routine is very short, so that this doesn't hurt)
+    SEQ_BPM_ClkTrackerInit();
     MIOS32_TIMER_Init(SEQ_BPM_MIOS32_TIMER_NUM, TIMER_RATE_SLAVE_MODE_US, SEQ_BPM_Timer_Slave, MIOS32_IRQ_PRIO_HIGHEST);
   } else {
     // initial timer configuration for master mode -- calls the core clk routine directly
@@ -373,32 +415,158 @@ static void SEQ_BPM_Timer_Master(void)
   if( run_mode == SEQ_BPM_RUN_MODE_Clocked ) {
     ++bpm_tick;
     ++bpm_req_clk_ctr;
+
+    if( tick_callback_func )
+      tick_callback_func();
   }
 }
 
 
 static void SEQ_BPM_Timer_Slave(void)
 {
+  u8 notify = 0;
+
   // disable interrupts to avoid conflicts with NotifyRx handler (which could be called from 
   // a high-prio interrupt)
   MIOS32_IRQ_Disable();
 
-  // increment clock counter, used to measure the delay between two F8 events
+  // increment clock counter, used to detect a missing clock
   ++incoming_clk_ctr;
 
-  // decrement sent clock delay, send interpolated clock events ((ppqn/24)-1) times
-  if( sent_clk_delay && --sent_clk_delay == 0 ) {
-    if( sent_clk_ctr < (ppqn/24) ) {
-      sent_clk_delay = incoming_clk_delay/(ppqn/24);
-      ++sent_clk_ctr;
+  // send the ticks which are due
+  notify = SEQ_BPM_SlaveTicksUpdate(MIOS32_TIMESTAMP_Get_uS());
+  MIOS32_IRQ_Enable();
+
+  if( notify && tick_callback_func )
+    tick_callback_func();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Tempo tracker for the incoming MIDI clock (slave mode)
+// A second order PLL (alpha-beta filter) follows phase and period of the
+// F8 events:
+//   error  = timestamp - (phase + period)
+//   phase  = phase + period + error / ALPHA_DIV
+//   period = period + error / BETA_DIV
+// Errors of more than 1/4 period are clamped, since they are typically
+// caused by bursts (e.g. USB) - after CLK_TRACKER_MAX_OUTLIERS in series
+// a tempo change is assumed, and the tracker locks to the measured delay.
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_BPM_ClkTrackerInit(void)
+{
+  clk_tracker_state = CLK_TRACKER_IDLE;
+  clk_last_us = 0;
+  clk_phase_us = 0;
+  clk_period_q8 = 0;
+  clk_outlier_ctr = 0;
+}
+
+static void SEQ_BPM_ClkTrackerUpdate(u32 timestamp_us)
+{
+  u32 delay_us = timestamp_us - clk_last_us;
+  clk_last_us = timestamp_us;
+
+  if( clk_tracker_state == CLK_TRACKER_IDLE || delay_us >= CLK_TRACKER_MAX_PERIOD_US ) {
+    // first clock, or clock has been stopped: wait for the next one
+    clk_tracker_state = CLK_TRACKER_SYNC;
+    clk_phase_us = timestamp_us;
+    return;
+  }
+
+  if( delay_us < CLK_TRACKER_MIN_PERIOD_US )
+    delay_us = CLK_TRACKER_MIN_PERIOD_US;
+
+  if( clk_tracker_state == CLK_TRACKER_SYNC ) {
+    // take over the measured delay
+    clk_tracker_state = CLK_TRACKER_LOCKED;
+    clk_period_q8 = delay_us << 8;
+    clk_phase_us = timestamp_us;
+    clk_outlier_ctr = 0;
+    return;
+  }
+
+  s32 period_us = clk_period_q8 >> 8;
+
+  // clock has been paused for some time (e.g. by a DAW): keep the period, take over the phase
+  if( delay_us > 2*period_us ) {
+    clk_phase_us = timestamp_us;
+    clk_outlier_ctr = 0;
+    return;
+  }
+
+  s32 error = (s32)(timestamp_us - (clk_phase_us + period_us));
+  s32 max_error = period_us / 4;
+  if( error > max_error || error < -max_error ) {
+    if( ++clk_outlier_ctr >= CLK_TRACKER_MAX_OUTLIERS ) {
+      // tempo change: lock to the measured delay
+      clk_period_q8 = delay_us << 8;
+      clk_phase_us = timestamp_us;
+      clk_outlier_ctr = 0;
+      return;
+    }
+    error = (error > 0) ? max_error : -max_error;
+  } else {
+    clk_outlier_ctr = 0;
+  }
+
+  clk_phase_us += period_us + error / CLK_TRACKER_ALPHA_DIV;
+  clk_period_q8 += (error << 8) / CLK_TRACKER_BETA_DIV;
+
+  if( clk_period_q8 < (CLK_TRACKER_MIN_PERIOD_US << 8) )
+    clk_period_q8 = CLK_TRACKER_MIN_PERIOD_US << 8;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sends the ticks of the current F8 period which are due at the given time
+// Once the filtered phase of the next F8 event has been reached, the
+// remaining ticks of the current period are flushed, so that never more
+// than (ppqn/24) ticks are sent per F8 event.
+// Has to be called with disabled interrupts.
+// Returns 1 if new ticks have been requested
+/////////////////////////////////////////////////////////////////////////////
+static u8 SEQ_BPM_SlaveTicksUpdate(u32 now_us)
+{
+  u32 num_ticks = ppqn/24;
+  u32 new_ticks = 0;
+
+  if( sent_clk_next && (s32)(now_us - clk_phase_us) >= 0 ) {
+    if( sent_clk_ctr < num_ticks )
+      new_ticks += num_ticks - sent_clk_ctr;
 
-      if( run_mode == SEQ_BPM_RUN_MODE_Clocked ) {
-	++bpm_tick;
-	++bpm_req_clk_ctr;
+    sent_clk_ctr = 0;
+    sent_clk_phase_us = clk_phase_us;
+    sent_clk_next = 0;
+  }
+
+  if( sent_clk_ctr < num_ticks ) {
+    s32 elapsed_us = (s32)(now_us - sent_clk_phase_us);
+
+    if( elapsed_us >= 0 ) {
+      // interpolated ticks only if the period is known
+      u32 due = 1;
+      u32 tick_period_q8 = (clk_tracker_state == CLK_TRACKER_LOCKED) ? (clk_period_q8 / num_ticks) : 0;
+      if( tick_period_q8 ) {
+	due += ((u32)elapsed_us << 8) / tick_period_q8;
+	if( due > num_ticks )
+	  due = num_ticks;
+      }
+
+      if( due > sent_clk_ctr ) {
+	new_ticks += due - sent_clk_ctr;
+	sent_clk_ctr = due;
       }
     }
   }
-  MIOS32_IRQ_Enable();
+
+  if( !new_ticks || run_mode != SEQ_BPM_RUN_MODE_Clocked )
+    return 0;
+
+  bpm_tick += new_ticks;
+  bpm_req_clk_ctr += new_ticks;
+
+  return 1;
 }
 
 
@@ -443,45 +611,41 @@ s32 SEQ_BPM_NotifyMIDIRx(u8 midi_byte)
 
     if( midi_byte == 0xf8 ) { // MIDI clock
 
-      // we've measured a new delay between two F8 events
-      incoming_clk_delay = incoming_clk_ctr;
-      ++received_clk_beat_ctr;
-      if( received_clk_beat_ctr < (4*6) )
-    	incoming_clk_delay_beat += incoming_clk_ctr;
-      else {
-	received_clk_beat_ctr = 0;
-    	incoming_clk_delay_beat_latched = incoming_clk_delay_beat;
-    	incoming_clk_delay_beat = incoming_clk_ctr;
-      }
-      incoming_clk_ctr = 0;
-
-      // get new SENT_CLK delay
-      sent_clk_delay = incoming_clk_delay / (ppqn/24);
+      u32 now_us = MIOS32_TIMESTAMP_Get_uS();
 
-      // how many clocks (still) need to be triggered?
-      if( run_mode == SEQ_BPM_RUN_MODE_Clocked ) {
-	int open_requests = (ppqn/24) - sent_clk_ctr;
-	if( open_requests > 0 ) {
-	  bpm_req_clk_ctr += open_requests;
-	  bpm_tick += open_requests;
+      // the previous F8 period hasn't been started yet (its phase is still in the future): do it now
+      if( sent_clk_next ) {
+	if( run_mode == SEQ_BPM_RUN_MODE_Clocked && sent_clk_ctr < (ppqn/24) ) {
+	  bpm_req_clk_ctr += (ppqn/24) - sent_clk_ctr;
+	  bpm_tick += (ppqn/24) - sent_clk_ctr;
 	}
+	sent_clk_ctr = 0;
+	sent_clk_phase_us = clk_phase_us;
+	sent_clk_next = 0;
       }
 
+      // update tempo tracker
+      SEQ_BPM_ClkTrackerUpdate(now_us);
+      incoming_clk_ctr = 0;
+
       if( run_mode != SEQ_BPM_RUN_MODE_Off ) {
-	// send clock immediately if sequencer running
-	sent_clk_ctr = 1;
-	++bpm_tick;
-	++bpm_req_clk_ctr;
+	// if first clock after start or continue event: set run state to 2
+	// (now we start to send BPM ticks)
+	if( run_mode == SEQ_BPM_RUN_MODE_Armed ) {
+	  run_mode = SEQ_BPM_RUN_MODE_Clocked;
+	  sent_clk_ctr = (ppqn/24); // nothing to flush from the previous period
+	}
+
+	// the new period starts at the filtered phase
+	// (as long as the tracker isn't locked, this is the time of the F8 event)
+	sent_clk_next = 1;
+	SEQ_BPM_SlaveTicksUpdate(now_us);
       } else {
 	// sequencer not running: don't request new clock(s)
-	sent_clk_ctr = 0;
+	sent_clk_ctr = (ppqn/24);
+	sent_clk_next = 0;
       }
 
-      // if first clock after start or continue event: set run state to 2
-      // (now we start to send BPM ticks)
-      if( run_mode == SEQ_BPM_RUN_MODE_Armed )
-	run_mode = SEQ_BPM_RUN_MODE_Clocked;
-
     } else if( midi_byte == 0xfa ) { // MIDI Start event
       // request sequencer start, disable stop request
       bpm_req_start = 1;
@@ -490,8 +654,7 @@ s32 SEQ_BPM_NotifyMIDIRx(u8 midi_byte)
       // cancel all requested clocks
       bpm_req_clk_ctr = 0;
       sent_clk_ctr = (ppqn/24);
-      received_clk_beat_ctr = 0;
-      incoming_clk_delay_beat = 0;
+      sent_clk_next = 0;
 
       // reset BPM tick value
       bpm_tick = 0;
@@ -515,6 +678,10 @@ s32 SEQ_BPM_NotifyMIDIRx(u8 midi_byte)
     // enable interrupts again
     MIOS32_IRQ_Enable();
 
+    // notify about the new request(s)
+    if( tick_callback_func )
+      tick_callback_func();
+
   } else if( receive_song_pos_state || midi_byte == 0xf2 ) {
 
     // new song position is received
@@ -552,6 +719,9 @@ s32 SEQ_BPM_NotifyMIDIRx(u8 midi_byte)
 
 	    // take over new bpm_tick value immediately (16th notes resolution)
 	    bpm_tick = new_song_pos * (ppqn/4);
+
+	    if( tick_callback_func )
+	      tick_callback_func();
 	  }
 	}
 	break;
@@ -581,6 +751,9 @@ s32 SEQ_BPM_Start(void)
 
   MIOS32_IRQ_Enable();
 
+  if( tick_callback_func )
+    tick_callback_func();
+
   return 0; // no error
 }
 
@@ -605,6 +778,9 @@ s32 SEQ_BPM_Cont(void)
 
   MIOS32_IRQ_Enable();
 
+  if( tick_callback_func )
+    tick_callback_func();
+
   return 0; // no error
 }
 
@@ -621,6 +797,9 @@ s32 SEQ_BPM_Stop(void)
   run_mode = SEQ_BPM_RUN_MODE_Off;
   MIOS32_IRQ_Enable();
 
+  if( tick_callback_func )
+    tick_callback_func();
+
   return 0; // no error
 }
 
@@ -731,7 +910,10 @@ s32 SEQ_BPM_ChkReqSongPos(u16 *song_pos)
 u32 SEQ_BPM_TicksFor_mS(u16 time_ms)
 {
   if( slave_clk ) {
-    float time_per_tick = (TIMER_RATE_SLAVE_MODE_US*0.001) * incoming_clk_delay_beat_latched / ppqn;
+    if( !clk_period_q8 )
+      return 0; // period not known yet
+
+    float time_per_tick = (clk_period_q8 / 256000.0) / (ppqn/24);
     return (u32)((float)time_ms / time_per_tick);
   }
 
@@ -739,4 +921,45 @@ u32 SEQ_BPM_TicksFor_mS(u16 time_ms)
   return (u32)((float)time_ms / period_m);
 }
 
+
+/////////////////////////////////////////////////////////////////////////////
+//! This help function returns the current duration of a BPM tick.<BR>
+//! It can be used to place timestamped events between two calls of the
+//! sequencer task (see also SEQ_CV)
+//! Regardless if BPM generator is clocked in master or slave mode
+//! \return the tick period in uS (0 if not known yet)
+/////////////////////////////////////////////////////////////////////////////
+u32 SEQ_BPM_TickPeriod_uS(void)
+{
+  if( slave_clk ) {
+    return (clk_period_q8 >> 8) / (ppqn/24);
+  }
+
+  u32 period_u = (u32)(1E6 * (60 / (bpm*24)) / (float)(ppqn/24));
+  // same limit as in SEQ_BPM_Set()
+  if( period_u < 250 )
+    period_u = 250;
+  return period_u;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Installs a callback function which is called whenever a new request
+//! (clock, start, stop, continue, song position) has been flagged.<BR>
+//! Could be used to resume the sequencer task immediately, so that a new
+//! tick is processed without waiting for the next periodic execution.
+//! \note the callback is mostly called from the timer interrupt with
+//! MIOS32_IRQ_PRIO_HIGHEST, it must not call any RTOS function!
+//! \param[in] callback the callback function (NULL to disable)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_BPM_TickCallback_Init(void (*callback)(void))
+{
+  MIOS32_IRQ_Disable();
+  tick_callback_func = callback;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
 //! \}
@@ -83,6 +83,9 @@ extern s32 SEQ_BPM_ChkReqClk(u32 *bpm_tick_ptr);
 extern s32 SEQ_BPM_ChkReqSongPos(u16 *song_pos);
 
 extern u32 SEQ_BPM_TicksFor_mS(u16 time_ms);
+extern u32 SEQ_BPM_TickPeriod_uS(void);
+
+extern s32 SEQ_BPM_TickCallback_Init(void (*callback)(void));
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -82,9 +82,14 @@ static s32 (*callback_midi_send_package)(mios32_midi_port_t port, mios32_midi_pa
 static s32 (*callback_bpm_is_running)(void);
 static u32 (*callback_bpm_tick_get)(void);
 static s32 (*callback_bpm_set)(float bpm);
+static s32 (*callback_repeat)(u16 repeat_id, u32 timestamp, u32 *next_timestamp);
 
 static seq_midi_out_queue_item_t *midi_queue;
 
+// timestamp of the item which is currently forwarded to callback_midi_send_package
+static u32 dispatch_timestamp;
+static u8  dispatch_active;
+
 
 #if SEQ_MIDI_OUT_MALLOC_METHOD >= 0 && SEQ_MIDI_OUT_MALLOC_METHOD <= 3
 
@@ -130,6 +135,7 @@ s32 SEQ_MIDI_OUT_Init(u32 mode)
   SEQ_MIDI_OUT_Callback_BPM_IsRunning_Set(NULL);
   SEQ_MIDI_OUT_Callback_BPM_TickGet_Set(NULL);
   SEQ_MIDI_OUT_Callback_BPM_Set_Set(NULL);
+  SEQ_MIDI_OUT_Callback_Repeat_Set(NULL);
 
   // don't re-initialize queue to ensure that memory can be delocated properly
   // when this function is called multiple times
@@ -276,6 +282,46 @@ s32 SEQ_MIDI_OUT_Callback_BPM_Set_Set(void *_callback_bpm_set)
   return 0; // no error
 }
 
+/////////////////////////////////////////////////////////////////////////////
+//! Installs the function which is called for SEQ_MIDI_OUT_RepeatEvent items.
+//!
+//! Repeated events (e.g. echo or ratchets) don't have to be scheduled
+//! up front: only a single repeat item is queued, the callback schedules
+//! the next event(s) and returns the timestamp at which it should be
+//! called again. Accordingly the queue occupancy doesn't depend on the
+//! number of repeats.
+//!
+//! The repeat item is queued with SEQ_MIDI_OUT_Send(), the repeat ID
+//! (which identifies the repeat descriptor of the application) is passed
+//! in the len parameter, port and MIDI package are ignored.
+//!
+//! \param[in] *_callback_repeat pointer to callback function:<BR>
+//! \code
+//!   s32 callback_repeat(u16 repeat_id, u32 timestamp, u32 *next_timestamp)
+//!   {
+//!     if( next_timestamp == NULL ) {
+//!       // item has been removed from queue (e.g. on Stop): release descriptor
+//!       return 0;
+//!     }
+//!
+//!     // ...
+//!     // schedule the next event(s) via SEQ_MIDI_OUT_Send()
+//!     // ...
+//!
+//!     *next_timestamp = timestamp + interval;
+//!     return 1; // 1: call me again at *next_timestamp, 0: finished
+//!   }
+//! \endcode
+//! If set to NULL, repeat items will be ignored.
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_MIDI_OUT_Callback_Repeat_Set(void *_callback_repeat)
+{
+  callback_repeat = _callback_repeat;
+
+  return 0; // no error
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //! This function schedules a MIDI event, which will be sent over a given
 //! port at a given bpm_tick
@@ -294,7 +340,7 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
   // failsave measure:
   // don't take On or OnOff item if heap is almost completely allocated
   if( seq_midi_out_allocated >= (SEQ_MIDI_OUT_MAX_EVENTS-2) && // should be enough for a On *and* Off event
-      (event_type == SEQ_MIDI_OUT_OnEvent || event_type == SEQ_MIDI_OUT_OnOffEvent) ) {
+      (event_type == SEQ_MIDI_OUT_OnEvent || event_type == SEQ_MIDI_OUT_OnOffEvent || event_type == SEQ_MIDI_OUT_RepeatEvent) ) {
 #if SEQ_MIDI_OUT_MALLOC_ANALYSIS
     ++seq_midi_out_dropouts;
 #endif
@@ -303,7 +349,8 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
 
 
 #if SEQ_MIDI_OUT_SUPPORT_DELAY
-  if( port < PPQN_DELAY_NUM ) {
+  // (repeat items are not delayed, the events which are scheduled by the callback will be delayed instead)
+  if( port < PPQN_DELAY_NUM && event_type != SEQ_MIDI_OUT_RepeatEvent ) {
     s8 delay = ppqn_delay[port];
     if( (delay < 0) && (timestamp < -delay) ) {
       timestamp = 0;
@@ -551,6 +598,8 @@ s32 SEQ_MIDI_OUT_FlushQueue(void)
     if( item->event_type == SEQ_MIDI_OUT_OffEvent || item->event_type == SEQ_MIDI_OUT_OnOffEvent ) {
       item->package.velocity = 0; // ensure that velocity is 0
       callback_midi_send_package(item->port, item->package);
+    } else if( item->event_type == SEQ_MIDI_OUT_RepeatEvent && callback_repeat ) {
+      callback_repeat(item->len, item->timestamp, NULL); // release descriptor
     }
 
     midi_queue = item->next;
@@ -570,6 +619,9 @@ s32 SEQ_MIDI_OUT_FreeHeap(void)
   // ensure that all items are delocated
   seq_midi_out_queue_item_t *item;
   while( (item=midi_queue) != NULL ) {
+    if( item->event_type == SEQ_MIDI_OUT_RepeatEvent && callback_repeat )
+      callback_repeat(item->len, item->timestamp, NULL); // release descriptor
+
     midi_queue = item->next;
     SEQ_MIDI_OUT_SlotFree(item);
   }
@@ -622,11 +674,31 @@ s32 SEQ_MIDI_OUT_Handler(void)
     DEBUG_MSG("[SEQ_MIDI_OUT_Handler:%u] (tag %d) %02x %02x %02x @%u\n", item->timestamp, item->package.cable, item->package.evnt0, item->package.evnt1, item->package.evnt2, SEQ_BPM_TickGet());
 #endif
 
+    // if repeat event: release the item before the callback schedules new events, re-schedule if requested
+    if( item->event_type == SEQ_MIDI_OUT_RepeatEvent ) {
+      u16 repeat_id = item->len;
+      u32 timestamp = item->timestamp;
+      mios32_midi_package_t package = item->package;
+
+      midi_queue = item->next;
+      SEQ_MIDI_OUT_SlotFree(item);
+
+      u32 next_timestamp;
+      if( callback_repeat && callback_repeat(repeat_id, timestamp, &next_timestamp) > 0 ) {
+	if( SEQ_MIDI_OUT_Send(0, package, SEQ_MIDI_OUT_RepeatEvent, next_timestamp, repeat_id) < 0 )
+	  callback_repeat(repeat_id, next_timestamp, NULL); // out of memory: release descriptor
+      }
+      continue;
+    }
+
     // if tempo event: change BPM stored in midi_package.ALL
     if( item->event_type == SEQ_MIDI_OUT_TempoEvent ) {
       callback_bpm_set(item->package.ALL);
     } else {
+      dispatch_timestamp = item->timestamp;
+      dispatch_active = 1;
       callback_midi_send_package(item->port, item->package);
+      dispatch_active = 0;
     }
 
     // schedule Off event if requested
@@ -675,6 +747,26 @@ s32 SEQ_MIDI_OUT_Handler(void)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! This function can be called from the MIDI send callback to get the
+//! timestamp of the event which is currently sent by SEQ_MIDI_OUT_Handler().<BR>
+//! It allows output drivers (e.g. CV/Gates) to place events between two
+//! handler calls with higher accuracy.
+//!
+//! \param[out] timestamp the bpm_tick of the event
+//! \return 0 if no timestamped event is sent (e.g. direct output), content of timestamp invalid
+//! \return 1 if the event has been sent by SEQ_MIDI_OUT_Handler()
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_MIDI_OUT_DispatchTimestampGet(u32 *timestamp)
+{
+  if( !dispatch_active )
+    return 0;
+
+  *timestamp = dispatch_timestamp;
+  return 1;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local function to allocate memory
 // returns NULL if no memory free
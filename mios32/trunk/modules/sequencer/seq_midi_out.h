@@ -62,7 +62,8 @@ typedef enum {
   SEQ_MIDI_OUT_CCEvent,    // sent before notes
   SEQ_MIDI_OUT_OnEvent,    // on event
   SEQ_MIDI_OUT_OffEvent,   // off event - sent by SEQ_MIDI_OUT_FlushQueue when queue is emptied (e.g. on Stop/Pause)
-  SEQ_MIDI_OUT_OnOffEvent  // Plays On and Off event after given length
+  SEQ_MIDI_OUT_OnOffEvent, // Plays On and Off event after given length
+  SEQ_MIDI_OUT_RepeatEvent // calls the repeat callback (repeat ID located in len), which can re-schedule the event
 } seq_midi_out_event_type_t;
 
 
@@ -76,12 +77,14 @@ extern s32 SEQ_MIDI_OUT_Callback_MIDI_SendPackage_Set(void *_callback_midi_send_
 extern s32 SEQ_MIDI_OUT_Callback_BPM_IsRunning_Set(void *_callback_bpm_is_running);
 extern s32 SEQ_MIDI_OUT_Callback_BPM_TickGet_Set(void *_callback_bpm_tick_get);
 extern s32 SEQ_MIDI_OUT_Callback_BPM_Set_Set(void *_callback_bpm_set);
+extern s32 SEQ_MIDI_OUT_Callback_Repeat_Set(void *_callback_repeat);
 
 extern s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_package, seq_midi_out_event_type_t event_type, u32 timestamp, u32 len);
 extern s32 SEQ_MIDI_OUT_ReSchedule(u8 tag, seq_midi_out_event_type_t event_type, u32 timestamp, u32 *reschedule_filter);
 extern s32 SEQ_MIDI_OUT_FlushQueue(void);
 extern s32 SEQ_MIDI_OUT_FreeHeap(void);
 extern s32 SEQ_MIDI_OUT_Handler(void);
+extern s32 SEQ_MIDI_OUT_DispatchTimestampGet(u32 *timestamp);
 
 #if SEQ_MIDI_OUT_SUPPORT_DELAY
 extern s32 SEQ_MIDI_OUT_DelaySet(mios32_midi_port_t port, s8 delay);
@@ -54,23 +54,29 @@
 #define MBNET_TX_STATE_SID7  7
 #define MBNET_TX_STATE_SID8  8
 #define MBNET_TX_STATE_DONE  9
+
+// number of SIDs which are serviced via MBNet
+#define MBNET_TX_NUM_SIDS    ((SID_NUM < 2) ? SID_NUM : 2)
 #endif
 
+// allows to compare 4 registers at once
+typedef u32 __attribute__((__may_alias__)) sid_regs_word_t;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global variables
 /////////////////////////////////////////////////////////////////////////////
 
-sid_regs_t sid_regs[SID_NUM];
+sid_regs_t sid_regs[SID_NUM] __attribute__((aligned(4)));
 
 
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
 
-static sid_regs_t sid_regs_shadow[SID_NUM]; // to determine register changes
+static sid_regs_t sid_regs_shadow[SID_NUM] __attribute__((aligned(4))); // to determine register changes
 #if SID_USE_MBNET
-static u32 sid_regs_shadow_updated[SID_NUM];
+static u32 sid_regs_shadow_updated[SID_NUM]; // one bit per register
 #endif
 
 static const u8 update_order[SID_REGS_NUM] = { 
@@ -82,11 +88,14 @@ static const u8 update_order[SID_REGS_NUM] = {
   25, 26, 27, 28, 29, 30, 31 // SwinSID registers
 };
 
+#if !SID_USE_MBNET
+static u8 update_pos[SID_REGS_NUM]; // register -> position in update_order
+#endif
+
 static u8 sid_available;
 
 #if SID_USE_MBNET
 static u8 mbnet_tx_state;
-static u8 mbnet_tx_reg_ctr;
 static u8 mbnet_my_node_id;
 static u32 mbnet_tx_msg_ctr;
 static u32 mbnet_tx_msg_ctr_min;
@@ -135,6 +144,7 @@ typedef struct {
 // Local Prototypes
 /////////////////////////////////////////////////////////////////////////////
 
+static u32 SID_ShadowUpdate(u8 sid);
 #if !SID_USE_MBNET
 static inline void SID_UpdateReg(sid_cs_pin_t *cs_pin0, sid_cs_pin_t *cs_pin1, u8 cs, u8 addr, u8 data, u8 reset);
 #else
@@ -162,13 +172,15 @@ s32 SID_Init(u32 mode)
 #if SID_USE_MBNET
   sid_available = 0x00; // set after node scan
   mbnet_tx_state = MBNET_TX_STATE_NOP;
-  mbnet_tx_reg_ctr = 0;
   mbnet_tx_msg_ctr = 0;
   mbnet_tx_msg_ctr_min = 0;
   mbnet_tx_msg_ctr_max = 0;
   mbnet_my_node_id = 0xff;
 #else
   sid_available = (u8)((1 << SID_NUM)-1);
+
+  for(reg=0; reg<SID_REGS_NUM; ++reg)
+    update_pos[update_order[reg]] = reg;
 #endif
 
 #ifdef SIDEMU_ENABLED
@@ -292,7 +304,6 @@ s32 SID_AvailableSet(u8 available)
   if( sid_available && mbnet_tx_state == MBNET_TX_STATE_NOP ) {
     // start MBNet transfers once SIDs have been found
     mbnet_tx_state = MBNET_TX_STATE_SID1;
-    mbnet_tx_reg_ctr = 0;
     mbnet_tx_msg_ctr = 0;
     mbnet_tx_msg_ctr_min = 0;
     mbnet_tx_msg_ctr_max = 0;
@@ -315,6 +326,36 @@ u8 SID_AvailableGet(void)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Takes over the SID registers into the shadow registers
+// Compares 4 registers at once, returns a mask with one bit per changed register
+/////////////////////////////////////////////////////////////////////////////
+static u32 SID_ShadowUpdate(u8 sid)
+{
+  sid_regs_word_t *regs = (sid_regs_word_t *)&sid_regs[sid].ALL[0];
+  sid_regs_word_t *regs_shadow = (sid_regs_word_t *)&sid_regs_shadow[sid].ALL[0];
+  u32 changed = 0;
+  int word;
+
+  for(word=0; word<(SID_REGS_NUM/4); ++word, ++regs, ++regs_shadow) {
+    u32 value = *regs;
+    u32 diff = value ^ *regs_shadow;
+
+    if( diff ) {
+      *regs_shadow = value;
+
+      // little endian: register 4*word+n is located at bit 8*n
+      if( diff & 0x000000ff ) changed |= ((u32)1 << (4*word+0));
+      if( diff & 0x0000ff00 ) changed |= ((u32)1 << (4*word+1));
+      if( diff & 0x00ff0000 ) changed |= ((u32)1 << (4*word+2));
+      if( diff & 0xff000000 ) changed |= ((u32)1 << (4*word+3));
+    }
+  }
+
+  return changed;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Updates all SID registers
 // IN: <mode>: if 0: only register changes will be transfered to SID(s)
@@ -325,26 +366,15 @@ u8 SID_AvailableGet(void)
 #if SID_USE_MBNET
 s32 SID_Update(u32 mode)
 {
-  int sid, reg;
-  // if register update should be forced, just inverse all shadow register values
-  if( mode >= 1 ) { // (also for reset mode)
-    MIOS32_IRQ_Disable();
-    for(sid=0; sid<SID_NUM; ++sid)
-      sid_regs_shadow_updated[sid] = 0xffffffff;
-    MIOS32_IRQ_Enable();
-  }
+  int sid;
 
   // transfer SID registers to shadow registers and check for updates
+  // if register update should be forced, all registers are marked (also for reset mode)
   MIOS32_IRQ_Disable();
   for(sid=0; sid<SID_NUM; ++sid) {
-    u8 *regs = (u8 *)&sid_regs[sid];
-    u8 *regs_shadow = (u8 *)&sid_regs_shadow[sid];
-
-    for(reg=0; reg<SID_REGS_NUM; ++reg) {
-      if( *regs_shadow != *regs )
-	sid_regs_shadow_updated[sid] |= (1 << reg);
-      *regs_shadow++ = *regs++;
-    }
+    sid_regs_shadow_updated[sid] |= SID_ShadowUpdate(sid);
+    if( mode >= 1 )
+      sid_regs_shadow_updated[sid] = 0xffffffff;
   }
   MIOS32_IRQ_Enable();
 
@@ -356,7 +386,6 @@ s32 SID_Update(u32 mode)
       mbnet_tx_msg_ctr_max = mbnet_tx_msg_ctr;
 
     mbnet_tx_msg_ctr = 0;
-    mbnet_tx_reg_ctr = 0;
 
     mbnet_tx_state = MBNET_TX_STATE_SID1;
     MBNET_TriggerTxHandler();
@@ -375,41 +404,35 @@ s32 SID_MBNET_TxHandler(mbnet_id_t *mbnet_id, mbnet_msg_t *msg, u8 *dlc)
   if( mbnet_tx_state == MBNET_TX_STATE_DONE )
     return 0; // nothing else to do...
 
-  // - search for next register set of 8 bytes which have been updated (-> tx_required)
-  // - check if there are remaining bytes which have to be updated - if not, set remote_reg_update
-  // - if all registers for all SIDs have been updated, change to MBNET_TX_STATE_DONE
-  u8 tx_sid = 0;
-  u8 tx_addr = 0;
-  u8 tx_required = 0;
-  u8 remote_reg_update = 0;
-  while( 1 ) {
-    u8 sid = (mbnet_tx_state-MBNET_TX_STATE_SID1);
-    u8 addr = mbnet_tx_reg_ctr;
-
-    if( sid_regs_shadow_updated[sid] & (0xff << addr) ) {
-      if( tx_required )
-	break; // ok, this isn't the last update for this SID
-      else {
-	tx_required = 1;
-	tx_sid = sid;
-	tx_addr = addr;
-      }
-    }
+  // - search for the next SID with changed registers
+  // - the message starts at the first changed register, so that up to 8 changes are sent at once
+  // - if there are no remaining changes, set remote_reg_update and change to MBNET_TX_STATE_DONE
+  u8 tx_sid = mbnet_tx_state - MBNET_TX_STATE_SID1;
+  while( tx_sid < MBNET_TX_NUM_SIDS && !sid_regs_shadow_updated[tx_sid] )
+    ++tx_sid;
 
-    mbnet_tx_reg_ctr += 8;
-    if( mbnet_tx_reg_ctr >= SID_REGS_NUM ) {
-      mbnet_tx_reg_ctr = 0;
-      if( ++mbnet_tx_state == MBNET_TX_STATE_SID3 ) {
-	mbnet_tx_state = MBNET_TX_STATE_DONE;
-
-	if( !tx_required )
-	  return 0; // abort loop, because register update has finished
-	else {
-	  remote_reg_update = 1; // update SID registers at remote side
-	  break;
-	}
-      }
-    }
+  if( tx_sid >= MBNET_TX_NUM_SIDS ) {
+    mbnet_tx_state = MBNET_TX_STATE_DONE;
+    return 0; // abort, because register update has finished
+  }
+
+  MIOS32_IRQ_Disable();
+  u8 tx_addr = __builtin_ctz(sid_regs_shadow_updated[tx_sid]);
+  if( tx_addr > (SID_REGS_NUM-8) )
+    tx_addr = SID_REGS_NUM-8;
+  sid_regs_shadow_updated[tx_sid] &= ~((u32)0xff << tx_addr);
+
+  u8 next_sid = tx_sid;
+  while( next_sid < MBNET_TX_NUM_SIDS && !sid_regs_shadow_updated[next_sid] )
+    ++next_sid;
+  MIOS32_IRQ_Enable();
+
+  u8 remote_reg_update = 0;
+  if( next_sid >= MBNET_TX_NUM_SIDS ) {
+    remote_reg_update = 1; // update SID registers at remote side
+    mbnet_tx_state = MBNET_TX_STATE_DONE;
+  } else {
+    mbnet_tx_state = MBNET_TX_STATE_SID1 + next_sid;
   }
 
   // create MBNet message
@@ -435,7 +458,6 @@ s32 SID_MBNET_TxHandler(mbnet_id_t *mbnet_id, mbnet_msg_t *msg, u8 *dlc)
   msg->data_h |= (u32)*regs_shadow++ << 8;
   msg->data_h |= (u32)*regs_shadow++ << 16;
   msg->data_h |= (u32)*regs_shadow++ << 24;
-  sid_regs_shadow_updated[tx_sid] &= ~(0xff << tx_addr);
   MIOS32_IRQ_Enable();
 
   ++mbnet_tx_msg_ctr;
@@ -445,7 +467,7 @@ s32 SID_MBNET_TxHandler(mbnet_id_t *mbnet_id, mbnet_msg_t *msg, u8 *dlc)
 #else
 s32 SID_Update(u32 mode)
 {
-  int sid, reg, i;
+  int sid;
 
   // trigger reset?
   if( mode == 2 ) {
@@ -460,59 +482,67 @@ s32 SID_Update(u32 mode)
     SID_UpdateReg(cs_pin0, cs_pin1, 0xff, 0x00, 0x00, 1); // CS lines, address, data, reset
   }
 
-  // if register update should be forced, just inverse all shadow register values
-  if( mode >= 1 ) { // (also for reset mode)
-    for(sid=0; sid<SID_NUM; ++sid)
-      for(reg=0; reg<SID_REGS_NUM; ++reg)
-	sid_regs_shadow[sid].ALL[reg] = ~sid_regs[sid].ALL[reg];
-  }
-
   // this loop should run so fast as possible, 
   // we consider to update two SIDs at once if values are identical
   for(sid=0; sid<SID_NUM; sid+=2) {
-    u8 *update_order_ptr = (u8 *)&update_order[0];
-    u8 *sidl = (u8 *)&sid_regs[sid+0].ALL[0];
+    u8 sidr_available = (sid+1) < SID_NUM;
     u8 *sidl_shadow = (u8 *)&sid_regs_shadow[sid+0].ALL[0];
-    u8 *sidr = (u8 *)&sid_regs[sid+1].ALL[0];
-    u8 *sidr_shadow = (u8 *)&sid_regs_shadow[sid+1].ALL[0];
-    u8 cs_both = (3 << (2*sid));
-    u8 cs_l_only = (1 << (2*sid));
-    u8 cs_r_only = (2 << (2*sid));
+    u8 *sidr_shadow = (u8 *)&sid_regs_shadow[sidr_available ? (sid+1) : sid].ALL[0];
+    u8 cs_both = (3 << sid);
+    u8 cs_l_only = (1 << sid);
+    u8 cs_r_only = (2 << sid);
 #if defined(MIOS32_FAMILY_STM32F10x)
-    sid_cs_pin_t *cs_pin0 = (sid_cs_pin_t *)&sid_cs_pin[2*sid+0];
-    sid_cs_pin_t *cs_pin1 = (sid_cs_pin_t *)&sid_cs_pin[2*sid+1];
+    sid_cs_pin_t *cs_pin0 = (sid_cs_pin_t *)&sid_cs_pin[sid+0];
+    sid_cs_pin_t *cs_pin1 = sidr_available ? (sid_cs_pin_t *)&sid_cs_pin[sid+1] : NULL;
 #else
     sid_cs_pin_t *cs_pin0 = NULL;
     sid_cs_pin_t *cs_pin1 = NULL;
 #endif
 
-    for(i=0; i<SID_REGS_NUM; ++i, update_order_ptr++) {
-      u8 data;
+    // take over changed registers into shadow registers (if register update should be forced, all registers are marked)
+    u32 changed_l = SID_ShadowUpdate(sid+0);
+    u32 changed_r = sidr_available ? SID_ShadowUpdate(sid+1) : 0;
+    if( mode >= 1 ) { // (also for reset mode)
+      changed_l = 0xffffffff;
+      changed_r = sidr_available ? 0xffffffff : 0;
+    }
+
+    // sort changes according to update_order: MSB is the first register
+    u32 pending = 0;
+    u32 changed = changed_l | changed_r;
+    while( changed ) {
+      int reg = __builtin_ctz(changed);
+      changed &= changed - 1;
+      pending |= 0x80000000 >> update_pos[reg];
+    }
 
-      reg = *update_order_ptr;
+    // only changed registers are visited
+    while( pending ) {
+      int pos = __builtin_clz(pending);
+      pending &= ~(0x80000000 >> pos);
+
+      int reg = update_order[pos];
+      u32 reg_mask = (u32)1 << reg;
+      u8 data;
 
       // check if update of left/right channel SID are required
       // partly duplicated code ensures best performance in all cases!
-      if( (data=sidl[reg]) != sidl_shadow[reg] ) {
+      if( changed_l & reg_mask ) {
+	data = sidl_shadow[reg];
 	// check if the value of the second SID is identical
-	if( data == sidr[reg] ) {
+	if( sidr_available && data == sidr_shadow[reg] ) {
 	  SID_UpdateReg(cs_pin0, cs_pin1, cs_both, reg, data, 0); // CS lines, address, data, reset
-	  sidl_shadow[reg] = data;
-	  sidr_shadow[reg] = data;
 	} else {
 	  SID_UpdateReg(cs_pin0, NULL, cs_l_only, reg, data, 0); // CS lines, address, data, reset
-	  sidl_shadow[reg] = data;
 
-	  if( (data=sidr[reg]) != sidr_shadow[reg] ) {
+	  if( changed_r & reg_mask ) {
 	    // individual update for second SID required
-	    SID_UpdateReg(cs_pin1, NULL, cs_r_only, reg, data, 0); // CS lines, address, data, reset
-	    sidr_shadow[reg] = data;
+	    SID_UpdateReg(cs_pin1, NULL, cs_r_only, reg, sidr_shadow[reg], 0); // CS lines, address, data, reset
 	  }
 	}
-      } else if( (data=sidr[reg]) != sidr_shadow[reg] ) {
+      } else {
 	// individual update for second SID required
-	SID_UpdateReg(cs_pin1, NULL, cs_r_only, reg, data, 0); // CS lines, address, data, reset
-	sidr_shadow[reg] = data;
+	SID_UpdateReg(cs_pin1, NULL, cs_r_only, reg, sidr_shadow[reg], 0); // CS lines, address, data, reset
       }
     }
   }
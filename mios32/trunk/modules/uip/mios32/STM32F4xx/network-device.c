@@ -68,6 +68,9 @@ int network_device_read(void)
   s32 status;
 
   if( (status=MIOS32_ENC28J60_PackageReceive((u8 *)uip_buf, UIP_BUFSIZE)) < 0 ) {
+    if( status == -17 )
+      return -1; // package has been discarded, the next one can be fetched
+
     netdev_available = 0;
 #if DEBUG_VERBOSE_LEVEL >= 1
     MIOS32_MIDI_SendDebugMessage("[network_device_read] ERROR %d\n", status);
@@ -44,6 +44,12 @@
 
 #define BUF ((struct uip_eth_hdr *)&uip_buf[0])
 
+/* Max. number of frames which are processed before the timers are
+   checked (same receive scheme as in modules/uip_task_standard/uip_task.c) */
+#ifndef RX_BURST_SIZE
+#define RX_BURST_SIZE 8
+#endif
+
 #ifndef NULL
 #define NULL (void *)0
 #endif /* NULL */
@@ -96,8 +102,13 @@ main(void)
 
   
   while(1) {
-    uip_len = tapdev_read();
-    if(uip_len > 0) {
+    int num_frames;
+    for(num_frames = 0; num_frames < RX_BURST_SIZE; num_frames++) {
+      uip_len = tapdev_read();
+      if(uip_len == 0) {
+	break;
+      }
+
       if(BUF->type == htons(UIP_ETHTYPE_IP)) {
 	uip_arp_ipin();
 	uip_input();
@@ -117,8 +128,9 @@ main(void)
 	  tapdev_send();
 	}
       }
+    }
 
-    } else if(timer_expired(&periodic_timer)) {
+    if(timer_expired(&periodic_timer)) {
       timer_reset(&periodic_timer);
       for(i = 0; i < UIP_CONNS; i++) {
 	uip_periodic(i);
@@ -46,6 +46,11 @@ static struct uip_udp_conn *osc_conn[OSC_SERVER_NUM_CONNECTIONS];
 const static mios32_osc_search_tree_t parse_root[];
 static u8 osc_parsed_from_con;
 
+#if OSC_SERVER_USE_ADDRESS_CACHE
+// recently received OSC addresses of each connection
+static mios32_osc_address_cache_t osc_address_cache[OSC_SERVER_NUM_CONNECTIONS];
+#endif
+
 static u8 *osc_send_packet;
 static u32 osc_send_len;
 
@@ -70,6 +75,12 @@ s32 OSC_SERVER_Init(u32 mode)
     if( osc_conn[con] != NULL )
       uip_udp_remove(osc_conn[con]);
 
+#if OSC_SERVER_USE_ADDRESS_CACHE
+  // invalidate address caches
+  for(con=0; con<OSC_SERVER_NUM_CONNECTIONS; ++con)
+    MIOS32_OSC_AddressCacheClear(&osc_address_cache[con]);
+#endif
+
   // create new connections
   // note: for faster execution we accept all UDP packets from the given IP which are sent to the given local port!
   // ports are checked inside OSC_SERVER_AppCall!
@@ -270,7 +281,11 @@ s32 OSC_SERVER_AppCall(void)
 #endif
 
       osc_parsed_from_con = con; // used by event propagation
+#if OSC_SERVER_USE_ADDRESS_CACHE
+      s32 status = MIOS32_OSC_ParsePacketCached((u8 *)uip_appdata, uip_len, parse_root, &osc_address_cache[con]);
+#else
       s32 status = MIOS32_OSC_ParsePacket((u8 *)uip_appdata, uip_len, parse_root);
+#endif
       if( status < 0 ) {
 #if DEBUG_VERBOSE_LEVEL >= 2
 	UIP_TASK_MUTEX_MIDIOUT_TAKE;
@@ -751,7 +766,7 @@ static s32 OSC_SERVER_Method_EventTOSC(mios32_osc_args_t *osc_args, u32 method_a
 
 
 /////////////////////////////////////////////////////////////////////////////
-// Search Tree for OSC Methods (used by MIOS32_OSC_ParsePacket())
+// Search Tree for OSC Methods (used by MIOS32_OSC_ParsePacketCached())
 /////////////////////////////////////////////////////////////////////////////
 
 
@@ -40,6 +40,12 @@ extern "C" {
 #define OSC_REMOTE_PORT 8001
 #endif
 
+// cache the resolved OSC addresses of each connection?
+// (speeds up parsing of fader streams, costs MIOS32_OSC_ADDRESS_CACHE_SIZE entries per connection)
+#ifndef OSC_SERVER_USE_ADDRESS_CACHE
+#define OSC_SERVER_USE_ADDRESS_CACHE 1
+#endif
+
 // should transfer mode be ignored on incoming OSC packets?
 #ifndef OSC_IGNORE_TRANSFER_MODE
 #define OSC_IGNORE_TRANSFER_MODE 0
@@ -85,6 +85,8 @@ static u32 my_ip_address = MY_IP_ADDRESS;
 static u32 my_netmask = MY_NETMASK;
 static u32 my_gateway = MY_GATEWAY;
 
+static uip_task_rx_stats_t rx_stats;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initialize the uIP task
@@ -192,9 +194,22 @@ static void UIP_TASK_Handler(void *pvParameters)
     }
 
     if( network_device_available() ) {
-      uip_len = network_device_read();
+      // fetch all frames which are waiting in the receive FIFO of the network device
+      // Each frame is read directly into uip_buf and parsed there (no additional copy),
+      // the number of frames per pass is limited to keep the task timing predictable.
+      // A discarded frame (CRC error) is notified with a negative value, it doesn't end the burst.
+      u8 num_frames;
+      u8 num_received = 0;
+      for(num_frames=0; num_frames<UIP_TASK_RX_BURST_SIZE; ++num_frames) {
+	int len = network_device_read();
+	if( len < 0 )
+	  continue;
+	if( len == 0 )
+	  break;
+
+	uip_len = len;
+	++num_received;
 
-      if( uip_len > 0 ) {
 	if(BUF->type == HTONS(UIP_ETHTYPE_IP) ) {
 	  uip_arp_ipin();
 	  uip_input();
@@ -215,8 +230,18 @@ static void UIP_TASK_Handler(void *pvParameters)
 	    network_device_send();
 	  }
 	}
+      }
+
+      if( num_frames ) {
+	rx_stats.frames += num_received;
+	if( num_frames > rx_stats.max_burst )
+	  rx_stats.max_burst = num_frames;
+	if( num_frames >= UIP_TASK_RX_BURST_SIZE )
+	  ++rx_stats.bursts_limited;
+      }
 
-      } else if(timer_expired(&periodic_timer)) {
+      // periodic timers are serviced even if frames are received continuously
+      if(timer_expired(&periodic_timer)) {
 	timer_reset(&periodic_timer);
 	for(i = 0; i < UIP_CONNS; i++) {
 	  uip_periodic(i);
@@ -524,6 +549,30 @@ s32 UIP_TASK_ServicesRunning(void)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Receive statistics
+/////////////////////////////////////////////////////////////////////////////
+s32 UIP_TASK_RxStatsGet(uip_task_rx_stats_t *stats)
+{
+  MUTEX_UIP_TAKE;
+  *stats = rx_stats;
+  MUTEX_UIP_GIVE;
+
+  return 0; // no error
+}
+
+s32 UIP_TASK_RxStatsClear(void)
+{
+  MUTEX_UIP_TAKE;
+  rx_stats.frames = 0;
+  rx_stats.bursts_limited = 0;
+  rx_stats.max_burst = 0;
+  MUTEX_UIP_GIVE;
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // network device connected to core?
 /////////////////////////////////////////////////////////////////////////////
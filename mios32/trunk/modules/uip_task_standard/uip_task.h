@@ -31,6 +31,12 @@ extern "C" {
 # define UIP_TASK_STACK_SIZE MIOS32_MINIMAL_STACK_SIZE
 #endif
 
+// max. number of frames which are processed in a single task pass
+// pending frames stay in the receive FIFO of the network device until the next pass
+#ifndef UIP_TASK_RX_BURST_SIZE
+# define UIP_TASK_RX_BURST_SIZE 8
+#endif
+
 // Ethernet configuration
 // can be overruled in mios32_config.h
 
@@ -97,6 +103,13 @@ extern "C" {
 // Global Types
 /////////////////////////////////////////////////////////////////////////////
 
+// receive statistics of the uIP task
+typedef struct {
+  u32 frames;            // number of processed frames
+  u32 bursts_limited;    // number of task passes which reached UIP_TASK_RX_BURST_SIZE
+  u8  max_burst;         // max. number of frames processed in a single pass
+} uip_task_rx_stats_t;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Prototypes
@@ -108,6 +121,9 @@ extern s32 UIP_TASK_InitFromPresets(u8 _dhcp_enabled, u32 _my_ip_address, u32 _m
 extern s32 UIP_TASK_NetworkDeviceAvailable(void);
 extern s32 UIP_TASK_ServicesRunning(void);
 
+extern s32 UIP_TASK_RxStatsGet(uip_task_rx_stats_t *stats);
+extern s32 UIP_TASK_RxStatsClear(void);
+
 extern s32 UIP_TASK_AppCall(void);
 
 extern s32 UIP_TASK_UDP_AppCall(void);
@@ -452,6 +452,22 @@ s32 UIP_TERMINAL_PrintNetwork(void *_output_function)
 
   out("UDP Monitor: verbose level #%d\n", UIP_TASK_UDP_MonitorLevelGet());
 
+  {
+    uip_task_rx_stats_t stats;
+    UIP_TASK_RxStatsGet(&stats);
+    out("Received frames: %u (max. %d per pass, %u passes reached the burst limit of %d)",
+	stats.frames, stats.max_burst, stats.bursts_limited, UIP_TASK_RX_BURST_SIZE);
+  }
+
+#if !defined(MIOS32_DONT_USE_ENC28J60) && !defined(MIOS32_FAMILY_LPC17xx)
+  {
+    mios32_enc28j60_rx_stats_t stats;
+    MIOS32_ENC28J60_RxStatsGet(&stats);
+    out("ENC28J60: %u packets, %u discarded, %u truncated, %u FIFO overflows, max. %d pending\n",
+	stats.packets, stats.discarded, stats.truncated, stats.overflows, stats.max_pending);
+  }
+#endif
+
   return 0; // no error
 }
 
@@ -19,14 +19,15 @@
 //!
 //! In order to avoid that the CPU is loaded with switching the duty cycle for each
 //! bit during the serial transfer, we just use the DMA controller to perform the
-//! register write operations in background. This results into a high memory consumption,
-//! because for each bit a 16bit number has to be stored in memory, resulting into 48 bytes
-//! per RGB LED.
+//! register write operations in background. For each bit a 16bit compare value is
+//! required, but only a small circular buffer of 2*WS2812_DMA_LEDS LEDs is stored
+//! in memory: whenever one half has been transfered (DMA half-transfer and
+//! transfer-complete interrupt), it's refilled from the RGB values of the next
+//! LEDs. Each LED consumes 3 bytes only.
 //!
-//! But the advantages are clearly that the CPU is not involved and can run other
-//! (more useful) tasks. Since the DMA is configured in circular mode, the LED strip
-//! will be periodically loaded with the current RGB values which are stored in the
-//! memory buffer.
+//! A frame is only sent if LEDs have been changed, and it ends at the last
+//! changed LED (the LEDs behind it keep their values). Changes which are done
+//! while a frame is sent will be transfered with the next frame.
 //!
 //!
 //! Currently this driver is only supported for the MBHP_CORE_STM32F4 module.
@@ -91,20 +92,41 @@
 // DMA channel (DMA1 Stream 0, Channel 2 - fortunately DMA1_Stream0 not used by any other MIOS32 driver yet...!)
 #define WS2812_DMA_PTR          DMA1_Stream0
 #define WS2812_DMA_CHN          DMA_Channel_2
+#define WS2812_DMA_FLAGS        (DMA_FLAG_TCIF0 | DMA_FLAG_TEIF0 | DMA_FLAG_HTIF0 | DMA_FLAG_FEIF0 | DMA_FLAG_DMEIF0)
+#define WS2812_DMA_IRQn         DMA1_Stream0_IRQn
+#define WS2812_DMA_IRQHANDLER_FUNC void DMA1_Stream0_IRQHandler(void)
+#define WS2812_DMA_IRQ_PRIORITY MIOS32_IRQ_PRIO_HIGH
 
+// the buffer half has to be refilled within WS2812_DMA_LEDS * 30 uS
+#define WS2812_BUFFER_SIZE (2*WS2812_DMA_LEDS*24)
 
-#define WS2812_BUFFER_SIZE ((WS2812_NUM_LEDS+2)*24) // +2*24 to insert the RESET frame
+// 2*24 reset slots at the end of a frame
+#define WS2812_RESET_LEDS 2
 
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
 
+static u8 led_grb[WS2812_NUM_LEDS][3]; // in the order of the WS2812 protocol
+
 static u16 send_buffer[WS2812_BUFFER_SIZE];
 
+static u8 dma_ready;
+static volatile u8 frame_active;
+static volatile u16 dirty_leds; // number of LEDs which have to be sent with the next frame
+static u16 frame_leds;
+static u16 frame_pos;
+static u16 frame_pos_end[2];
+
 /////////////////////////////////////////////////////////////////////////////
 // Local Prototypes
 /////////////////////////////////////////////////////////////////////////////
 
+#if WS2812_SUPPORTED
+static void WS2812_Touch(u16 num_leds);
+static void WS2812_FrameStart(void);
+static void WS2812_BufferRefill(u8 half);
+#endif
 
 /////////////////////////////////////////////////////////////////////////////
 //! Initializes WS2812 driver
@@ -120,16 +142,15 @@ s32 WS2812_Init(u32 mode)
 #else
   {
     int i;
-    for(i=0; i<(WS2812_NUM_LEDS*24); ++i) {
-      send_buffer[i] = WS2812_TIM_CC_LOW;
-    }
-
-    for(;i<WS2812_BUFFER_SIZE; ++i) {
-      send_buffer[i] = WS2812_TIM_CC_RESET;
+    u8 *led_ptr = &led_grb[0][0];
+    for(i=0; i<(WS2812_NUM_LEDS*3); ++i) {
+      *(led_ptr++) = 0;
     }
   }
 
   if( mode == 0 ) {
+    dma_ready = 0;
+
     // WS2812 coding: see following nice overview page: http://www.mikrocontroller.net/articles/WS2812_Ansteuerung
     // We take the timer based approach since TIM4 isn't used by MIOS32 (yet), and J4B.SC is normally not used by apps
     // Programming Example for STM32F4: 
@@ -190,10 +211,18 @@ s32 WS2812_Init(u32 mode)
       DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
       DMA_Init(WS2812_DMA_PTR, &DMA_InitStructure);
 
-      DMA_Cmd(WS2812_DMA_PTR, ENABLE);
+      // trigger interrupt when transfer half complete/complete
+      DMA_ITConfig(WS2812_DMA_PTR, DMA_IT_HT | DMA_IT_TC, ENABLE);
+      MIOS32_IRQ_Install(WS2812_DMA_IRQn, WS2812_DMA_IRQ_PRIORITY);
+
+      // DMA will be enabled with the first frame
+      dma_ready = 1;
     }
   }
 
+  // send cleared LEDs
+  WS2812_Touch(WS2812_NUM_LEDS);
+
   return 0; // no error
 #endif
 }
@@ -216,18 +245,18 @@ s32 WS2812_LED_SetRGB(u16 led, u8 colour, u8 value)
 
   u8 offset = 0;
   if( colour == 0 )
-    offset = 1*8;
+    offset = 1;
   else if( colour == 1 )
-    offset = 0*8;
+    offset = 0;
   else if( colour == 2 )
-    offset = 2*8;
+    offset = 2;
   else
     return -2; // unsupported colour
 
-  u8 i, mask;
-  u16 *dst_ptr = (u16 *)&send_buffer[24*led + offset];
-  for(i=0, mask=0x80; i<8; ++i, mask >>= 1)
-    *(dst_ptr++) = (value & mask) ? WS2812_TIM_CC_HIGH : WS2812_TIM_CC_LOW;
+  if( led_grb[led][offset] != value ) {
+    led_grb[led][offset] = value;
+    WS2812_Touch(led + 1);
+  }
 
   return value;
 #endif
@@ -250,23 +279,15 @@ s32 WS2812_LED_GetRGB(u16 led, u8 colour)
 
   u8 offset = 0;
   if( colour == 0 )
-    offset = 1*8;
+    offset = 1;
   else if( colour == 1 )
-    offset = 0*8;
+    offset = 0;
   else if( colour == 2 )
-    offset = 2*8;
+    offset = 2;
   else
     return -2; // unsupported colour
 
-  u8 i, mask;
-  u16 *src_ptr = (u16 *)&send_buffer[24*led + offset];
-  s32 value = 0;
-  for(i=0, mask=0x80; i<8; ++i, mask >>= 1) {
-    if( *(src_ptr++) == WS2812_TIM_CC_HIGH )
-      value |= mask;
-  }
-
-  return value;
+  return led_grb[led][offset];
 #endif
 }
 
@@ -399,4 +420,105 @@ s32 WS2812_LED_GetHSV(u16 led, float *h, float *s, float *v)
 }
 
 
+#if WS2812_SUPPORTED
+/////////////////////////////////////////////////////////////////////////////
+// Requests a frame which covers the given number of LEDs
+/////////////////////////////////////////////////////////////////////////////
+static void WS2812_Touch(u16 num_leds)
+{
+  MIOS32_IRQ_Disable();
+  if( num_leds > dirty_leds )
+    dirty_leds = num_leds;
+
+  if( dma_ready && !frame_active )
+    WS2812_FrameStart();
+  MIOS32_IRQ_Enable();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Starts a new frame with the dirty LEDs
+// Called with disabled interrupts, or from the DMA interrupt
+/////////////////////////////////////////////////////////////////////////////
+static void WS2812_FrameStart(void)
+{
+  frame_leds = dirty_leds;
+  dirty_leds = 0;
+  frame_pos = 0;
+  frame_active = 1;
+
+  WS2812_BufferRefill(0);
+  WS2812_BufferRefill(1);
+
+  DMA_ClearFlag(WS2812_DMA_PTR, WS2812_DMA_FLAGS);
+  WS2812_DMA_PTR->M0AR = (u32)&send_buffer[0];
+  WS2812_DMA_PTR->NDTR = WS2812_BUFFER_SIZE;
+  DMA_Cmd(WS2812_DMA_PTR, ENABLE);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Encodes the next LEDs into the lower (half == 0) or upper (half == 1)
+// range of the DMA buffer. The frame is terminated with reset slots.
+/////////////////////////////////////////////////////////////////////////////
+static void WS2812_BufferRefill(u8 half)
+{
+  u16 *dst_ptr = (u16 *)&send_buffer[half * (WS2812_DMA_LEDS*24)];
+  int led;
+
+  for(led=0; led<WS2812_DMA_LEDS; ++led, ++frame_pos) {
+    if( frame_pos < frame_leds ) {
+      u8 *src_ptr = &led_grb[frame_pos][0];
+      int c;
+      for(c=0; c<3; ++c) {
+        u8 value = *(src_ptr++);
+        u8 i, mask;
+        for(i=0, mask=0x80; i<8; ++i, mask >>= 1)
+          *(dst_ptr++) = (value & mask) ? WS2812_TIM_CC_HIGH : WS2812_TIM_CC_LOW;
+      }
+    } else {
+      int i;
+      for(i=0; i<24; ++i)
+        *(dst_ptr++) = WS2812_TIM_CC_RESET;
+    }
+  }
+
+  frame_pos_end[half] = frame_pos;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! DMA interrupt is triggered on HT and TC interrupts
+//! \note shouldn't be called directly from application
+/////////////////////////////////////////////////////////////////////////////
+WS2812_DMA_IRQHANDLER_FUNC
+{
+  u8 half;
+
+  if( DMA1->LISR & DMA_FLAG_HTIF0 ) {
+    DMA1->LIFCR = DMA_FLAG_HTIF0;
+    half = 0; // lower range has been transfered
+  } else if( DMA1->LISR & DMA_FLAG_TCIF0 ) {
+    DMA1->LIFCR = DMA_FLAG_TCIF0;
+    half = 1; // upper range has been transfered
+  } else {
+    DMA1->LIFCR = WS2812_DMA_FLAGS;
+    return;
+  }
+
+  if( frame_pos_end[half] >= (frame_leds + WS2812_RESET_LEDS) ) {
+    // the reset slots have been sent (the other half only contains reset slots as well)
+    DMA_Cmd(WS2812_DMA_PTR, DISABLE);
+    while( WS2812_DMA_PTR->CR & DMA_SxCR_EN );
+    frame_active = 0;
+
+    // LEDs changed meanwhile?
+    if( dirty_leds )
+      WS2812_FrameStart();
+  } else {
+    WS2812_BufferRefill(half);
+  }
+}
+#endif
+
 //! \}
@@ -23,11 +23,18 @@ extern "C" {
 /////////////////////////////////////////////////////////////////////////////
 
 // Maximum number of LEDs connected to the WS2812 chain
-// Each LED will consume 48 bytes!
+// Each LED will consume 3 bytes
 #ifndef WS2812_NUM_LEDS
 #define WS2812_NUM_LEDS 64
 #endif
 
+// Number of LEDs which are encoded into each half of the DMA buffer
+// Each LED will consume 2*48 bytes, the DMA interrupt is invoked each
+// WS2812_DMA_LEDS * 30 uS while a frame is sent
+#ifndef WS2812_DMA_LEDS
+#define WS2812_DMA_LEDS 4
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -19,6 +19,9 @@
 LogBox::LogBox(const String &componentName)
     : ListBox(componentName, 0)
     , maxRowWidth(0)
+    , contentRowWidth(0)
+    , maxNumEntries(0)
+    , entryFormatter(NULL)
 #if JUCE_MAJOR_VERSION==1 && JUCE_MINOR_VERSION<51
 #if defined(JUCE_WIN32)
     , logEntryFont(Typeface::defaultTypefaceNameMono, 10.0, 0)
@@ -61,19 +64,32 @@ void LogBox::paintListBoxItem(int rowNumber,
                               int width, int height,
                               bool rowIsSelected)
 {
-    std::pair<Colour, String> p = logEntries[rowNumber];
+    if( rowNumber < 0 || rowNumber >= logEntries.size() )
+        return;
 
     if( rowIsSelected )
         g.fillAll(Colours::lightblue);
 
     g.setFont(logEntryFont);
 
-    g.setColour(p.first);
-    g.drawText(p.second,
+    g.setColour(logEntries.getReference(rowNumber).colour);
+    g.drawText(getEntryText(rowNumber),
                5, 0, width, height,
                Justification::centredLeft, true);
 }
 
+//==============================================================================
+// Returns the text of an entry, raw entries are formatted here
+String LogBox::getEntryText(int row)
+{
+    const LogEntry &e = logEntries.getReference(row);
+
+    if( e.text.isEmpty() && entryFormatter != NULL && e.rawData.getSize() )
+        return entryFormatter->formatLogEntry(e.rawData);
+
+    return e.text;
+}
+
 //==============================================================================
 void LogBox::paintOverChildren(Graphics& g)
 {
@@ -133,8 +149,10 @@ void LogBox::paintOverChildren(Graphics& g)
 //==============================================================================
 void LogBox::clear(void)
 {
+    stopTimer();
+
     logEntries.clear();
-    setMinimumContentWidth(maxRowWidth = 1);
+    setMinimumContentWidth(maxRowWidth = contentRowWidth = 1);
 
     updateContent();
     repaint(); // note: sometimes not updated without repaint()
@@ -143,19 +161,66 @@ void LogBox::clear(void)
 
 void LogBox::addEntry(const Colour &colour, const String &textLine)
 {
-    std::pair<Colour, String> p;
-    p.first = colour;
-    p.second = textLine;
-    logEntries.add(p);
+    LogEntry e;
+    e.colour = colour;
+    e.text = textLine;
+    logEntries.add(e);
+
+    triggerContentUpdate(30 + logEntryFont.getStringWidth(textLine));
+} 
+
+// Adds an entry which will be formatted by the entry formatter once it gets visible.
+// numChars is used to determine the row width without formatting the entry
+// (the log font is monospaced)
+void LogBox::addRawEntry(const Colour &colour, const MemoryBlock &rawData, int numChars)
+{
+    LogEntry e;
+    e.colour = colour;
+    e.rawData = rawData;
+    logEntries.add(e);
+
+    triggerContentUpdate(30 + numChars * logEntryFont.getStringWidth(T("0")));
+}
+
+void LogBox::setEntryFormatter(LogBoxEntryFormatter *formatter)
+{
+    entryFormatter = formatter;
+}
+
+// Limits the history, 0: no limit
+void LogBox::setMaxNumEntries(int maxEntries)
+{
+    maxNumEntries = maxEntries;
+}
+
+// The list content is updated with a timer, so that a burst of entries only
+// results into a single update
+void LogBox::triggerContentUpdate(int rowWidth)
+{
+    if( rowWidth > contentRowWidth )
+        contentRowWidth = rowWidth;
+
+    if( !isTimerRunning() )
+        startTimer(20);
+}
+
+void LogBox::timerCallback()
+{
+    stopTimer();
+
+    // remove the oldest entries (10% at once, so that this doesn't happen too often)
+    if( maxNumEntries > 0 && logEntries.size() > maxNumEntries ) {
+        deselectAllRows();
+        logEntries.removeRange(0, logEntries.size() - maxNumEntries + maxNumEntries/10);
+    }
 
     updateContent();
 
-    int rowWidth = 30 + logEntryFont.getStringWidth(textLine);
-    if( rowWidth > maxRowWidth )
-        setMinimumContentWidth(maxRowWidth = rowWidth);
+    if( contentRowWidth > maxRowWidth )
+        setMinimumContentWidth(maxRowWidth = contentRowWidth);
 
     setVerticalPosition(2.0); // has to be done after updateContent()!
-} 
+}
 
 
 //==============================================================================
@@ -165,8 +230,6 @@ void LogBox::copy(void)
 
     for(int row=0; row<getNumRows(); ++row)
         if( isRowSelected(row) ) {
-            std::pair<Colour, String> p = logEntries[row];
-
 #if JUCE_WIN32
             if( selectedText != String::empty )
                 selectedText += T("\r\n");
@@ -174,7 +237,7 @@ void LogBox::copy(void)
             if( selectedText != String::empty )
                 selectedText += T("\n");
 #endif
-            selectedText += p.second;
+            selectedText += getEntryText(row);
         }
 
     if( selectedText != String::empty )
@@ -17,11 +17,21 @@
 
 #include "../includes.h"
 
-#include <utility>
+//==============================================================================
+// Formats entries which have been added with LogBox::addRawEntry()
+// Only called for visible (or copied) rows
+class LogBoxEntryFormatter
+{
+public:
+    virtual ~LogBoxEntryFormatter() {}
+    virtual String formatLogEntry(const MemoryBlock &rawData) = 0;
+};
+
 
 class LogBox
     : public ListBox
     , public ListBoxModel
+    , public Timer
 {
 public:
     //==============================================================================
@@ -39,6 +49,13 @@ public:
     //==============================================================================
     void clear(void);
     void addEntry(const Colour &colour, const String &textLine);
+    void addRawEntry(const Colour &colour, const MemoryBlock &rawData, int numChars);
+
+    void setEntryFormatter(LogBoxEntryFormatter *formatter);
+    void setMaxNumEntries(int maxEntries);
+
+    //==============================================================================
+    void timerCallback();
 
     //==============================================================================
     void copy(void);
@@ -54,9 +71,23 @@ public:
 protected:
     Font logEntryFont;
 
-    Array<std::pair<Colour, String> > logEntries;
+    struct LogEntry {
+        Colour colour;
+        String text;
+        MemoryBlock rawData; // formatted on demand if text is empty
+    };
+
+    Array<LogEntry> logEntries;
 
     int maxRowWidth;
+    int contentRowWidth;
+    int maxNumEntries;
+
+    LogBoxEntryFormatter *entryFormatter;
+
+    //==============================================================================
+    String getEntryText(int row);
+    void triggerContentUpdate(int rowWidth);
 
     //==============================================================================
     // (prevent copy constructor and operator= being generated..)
@@ -15,6 +15,12 @@
 #include "MidiMonitor.h"
 #include "MiosStudio.h"
 
+// size of the capture ring buffer (must be able to store a large SysEx dump)
+#define MIDI_MONITOR_CAPTURE_BUFFER_SIZE (1024*1024)
+
+// max. number of log entries, older entries will be removed
+#define MIDI_MONITOR_MAX_LOG_ENTRIES 100000
+
 
 //==============================================================================
 MidiMonitor::MidiMonitor(MiosStudio *_miosStudio, const bool _inPort)
@@ -24,6 +30,8 @@ MidiMonitor::MidiMonitor(MiosStudio *_miosStudio, const bool _inPort)
     , filterActiveSense(1)
     , filterMiosTerminalMessage(1)
     , cutLongMessages(1)
+    , captureFifo(MIDI_MONITOR_CAPTURE_BUFFER_SIZE)
+    , captureBuffer(MIDI_MONITOR_CAPTURE_BUFFER_SIZE)
 {
 	addAndMakeVisible(midiPortSelector = new ComboBox(String::empty));
 	midiPortSelector->addListener(this);
@@ -35,13 +43,18 @@ MidiMonitor::MidiMonitor(MiosStudio *_miosStudio, const bool _inPort)
 	midiPortLabel->attachToComponent(midiPortSelector, true);
 
     addAndMakeVisible(monitorLogBox = new LogBox(T("Midi Monitor")));
+    monitorLogBox->setEntryFormatter(this);
+    monitorLogBox->setMaxNumEntries(MIDI_MONITOR_MAX_LOG_ENTRIES);
     monitorLogBox->addEntry(Colours::red, T("Connecting to MIDI driver - be patient!"));
 
     setSize(400, 200);
+
+    startTimer(20);
 }
 
 MidiMonitor::~MidiMonitor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -193,7 +206,9 @@ String MidiMonitor::getNoteString(uint8 note)
 }
 
 //==============================================================================
-void MidiMonitor::handleIncomingMidiMessage(const MidiMessage& message, uint8 runningStatus)
+// Called from the MIDI thread: filters the message and copies it into the capture buffer.
+// The log entry will be formatted by formatLogEntry() once it gets visible.
+void MidiMonitor::captureMidiMessage(const MidiMessage& message)
 {
     uint32 size = message.getRawDataSize();
     uint8 *data = (uint8 *)message.getRawData();
@@ -207,65 +222,156 @@ void MidiMonitor::handleIncomingMidiMessage(const MidiMessage& message, uint8 ru
         !(isMiosTerminalMessage && filterMiosTerminalMessage) ) {
 
         double timeStamp = message.getTimeStamp() ? message.getTimeStamp() : ((double)Time::getMillisecondCounter() / 1000.0);
-        String timeStampStr = (timeStamp > 0)
-            ? String::formatted(T("%8.3f"), timeStamp)
-            : T("now");
 
-        String hexStr = String::toHexString(data, size);
+        int recordSize = sizeof(uint32) + sizeof(double) + size;
+        if( captureFifo.getFreeSpace() < recordSize ) {
+            ++numDroppedMessages; // will be reported by timerCallback()
+            return;
+        }
+
+        int start1, size1, start2, size2;
+        captureFifo.prepareToWrite(recordSize, start1, size1, start2, size2);
+
+        int pos = start1;
+        captureWrite(pos, &size, sizeof(uint32));
+        captureWrite(pos, &timeStamp, sizeof(double));
+        captureWrite(pos, data, size);
+
+        captureFifo.finishedWrite(recordSize);
+    }
+}
+
+//==============================================================================
+// Copies into/from the capture ring buffer, pos wraps at the end of the buffer
+void MidiMonitor::captureWrite(int &pos, const void *src, int len)
+{
+    const int bufferSize = captureFifo.getTotalSize();
+    const uint8 *s = (const uint8 *)src;
+    while( len > 0 ) {
+        int chunk = jmin(len, bufferSize - pos);
+        memcpy(captureBuffer + pos, s, chunk);
+        s += chunk;
+        len -= chunk;
+        pos = (pos + chunk) % bufferSize;
+    }
+}
+
+void MidiMonitor::captureRead(int &pos, void *dst, int len)
+{
+    const int bufferSize = captureFifo.getTotalSize();
+    uint8 *d = (uint8 *)dst;
+    while( len > 0 ) {
+        int chunk = jmin(len, bufferSize - pos);
+        memcpy(d, captureBuffer + pos, chunk);
+        d += chunk;
+        len -= chunk;
+        pos = (pos + chunk) % bufferSize;
+    }
+}
 
-        String descStr;
-        switch( data[0] & 0xf0 ) {
-            case 0x80:
+
+//==============================================================================
+// Transfers the captured messages into the log box (GUI thread)
+void MidiMonitor::timerCallback()
+{
+    while( captureFifo.getNumReady() >= (int)(sizeof(uint32) + sizeof(double)) ) {
+        int start1, size1, start2, size2;
+        captureFifo.prepareToRead(sizeof(uint32), start1, size1, start2, size2);
+
+        int pos = start1;
+        uint32 size;
+        captureRead(pos, &size, sizeof(uint32));
+
+        // raw entry: [double timestamp][size bytes]
+        int entrySize = sizeof(double) + size;
+        MemoryBlock rawData(entrySize);
+        captureRead(pos, rawData.getData(), entrySize);
+        captureFifo.finishedRead(sizeof(uint32) + entrySize);
+
+        // row width estimation: timestamp + hex string + max. length of description
+        monitorLogBox->addRawEntry(Colours::black, rawData, 11 + 3*size + 40);
+    }
+
+    int numDropped = numDroppedMessages.exchange(0);
+    if( numDropped > 0 )
+        monitorLogBox->addEntry(Colours::red, String(numDropped) + T(" messages dropped (capture buffer full)!"));
+}
+
+
+//==============================================================================
+// Formats a captured message
+String MidiMonitor::formatLogEntry(const MemoryBlock &rawData)
+{
+    if( rawData.getSize() <= sizeof(double) )
+        return String::empty;
+
+    double timeStamp;
+    memcpy(&timeStamp, rawData.getData(), sizeof(double));
+    uint32 size = rawData.getSize() - sizeof(double);
+    uint8 *data = (uint8 *)rawData.getData() + sizeof(double);
+
+    String timeStampStr = (timeStamp > 0)
+        ? String::formatted(T("%8.3f"), timeStamp)
+        : T("now");
+
+    String hexStr = String::toHexString(data, size);
+
+    // ensure that the description doesn't read behind the message
+    uint8 msg[3] = { data[0], (size >= 2) ? data[1] : (uint8)0, (size >= 3) ? data[2] : (uint8)0 };
+    data = msg;
+
+    String descStr;
+    switch( data[0] & 0xf0 ) {
+        case 0x80:
+            descStr = String::formatted(T("   Chn#%2d  Note Off "), (data[0] & 0x0f) + 1);
+            descStr += getNoteString(data[1]);
+            descStr += String::formatted(T("  Vel:%d"), data[2]);
+            break;
+
+        case 0x90:
+            if( data[2] == 0 ) {
                 descStr = String::formatted(T("   Chn#%2d  Note Off "), (data[0] & 0x0f) + 1);
+                descStr += getNoteString(data[1]) + " (optimized)";
+            } else {
+                descStr = String::formatted(T("   Chn#%2d  Note On  "), (data[0] & 0x0f) + 1);
                 descStr += getNoteString(data[1]);
                 descStr += String::formatted(T("  Vel:%d"), data[2]);
-                break;
-
-            case 0x90:
-                if( data[2] == 0 ) {
-                    descStr = String::formatted(T("   Chn#%2d  Note Off "), (data[0] & 0x0f) + 1);
-                    descStr += getNoteString(data[1]) + " (optimized)";
-                } else {
-                    descStr = String::formatted(T("   Chn#%2d  Note On  "), (data[0] & 0x0f) + 1);
-                    descStr += getNoteString(data[1]);
-                    descStr += String::formatted(T("  Vel:%d"), data[2]);
-                }
-                break;
-                
-            case 0xa0:
-                descStr = String::formatted(T("   Chn#%2d  Aftertouch "), (data[0] & 0x0f) + 1);
-                descStr += getNoteString(data[1]);
-                descStr += String::formatted(T(" %d"), data[2]);
-                break;
-                
-            case 0xb0:
-                descStr = String::formatted(T("   Chn#%2d  CC#%3d = %d"),
-                                            (data[0] & 0x0f) + 1,
-                                            data[1],
-                                            data[2]);
-                break;
-                
-            case 0xc0:
-                descStr = String::formatted(T("   Chn#%2d  Program Change %d"),
-                                            (data[0] & 0x0f) + 1,
-                                            data[1]);
-                break;
-                
-            case 0xd0:
-                descStr = String::formatted(T("   Chn#%2d  Aftertouch "), (data[0] & 0x0f) + 1);
-                descStr += getNoteString(data[1]);
-                break;
-                
-            case 0xe0:
-                descStr = String::formatted(T("   Chn#%2d  Pitchbend %d"),
-                                            (data[0] & 0x0f) + 1,
-                                            (int)((data[1] & 0x7f) | ((data[2] & 0x7f) << 7)) - 8192);
-                break;
-                
-            default:
-                descStr = String::formatted(T("")); // nothing to add here
-        }
-        
-        monitorLogBox->addEntry(Colours::black, "[" + timeStampStr + "] " + hexStr + descStr);
+            }
+            break;
+            
+        case 0xa0:
+            descStr = String::formatted(T("   Chn#%2d  Aftertouch "), (data[0] & 0x0f) + 1);
+            descStr += getNoteString(data[1]);
+            descStr += String::formatted(T(" %d"), data[2]);
+            break;
+            
+        case 0xb0:
+            descStr = String::formatted(T("   Chn#%2d  CC#%3d = %d"),
+                                        (data[0] & 0x0f) + 1,
+                                        data[1],
+                                        data[2]);
+            break;
+            
+        case 0xc0:
+            descStr = String::formatted(T("   Chn#%2d  Program Change %d"),
+                                        (data[0] & 0x0f) + 1,
+                                        data[1]);
+            break;
+            
+        case 0xd0:
+            descStr = String::formatted(T("   Chn#%2d  Aftertouch "), (data[0] & 0x0f) + 1);
+            descStr += getNoteString(data[1]);
+            break;
+            
+        case 0xe0:
+            descStr = String::formatted(T("   Chn#%2d  Pitchbend %d"),
+                                        (data[0] & 0x0f) + 1,
+                                        (int)((data[1] & 0x7f) | ((data[2] & 0x7f) << 7)) - 8192);
+            break;
+            
+        default:
+            descStr = String::formatted(T("")); // nothing to add here
     }
+    
+    return "[" + timeStampStr + "] " + hexStr + descStr;
 }
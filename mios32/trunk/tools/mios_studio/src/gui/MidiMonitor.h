@@ -24,6 +24,8 @@ class MiosStudio; // forward declaration
 class MidiMonitor
     : public Component
     , public ComboBoxListener
+    , public LogBoxEntryFormatter
+    , public Timer
 {
 public:
     //==============================================================================
@@ -39,7 +41,12 @@ public:
     void comboBoxChanged(ComboBox*);
 
     //==============================================================================
-    void handleIncomingMidiMessage(const MidiMessage& message, uint8 runningStatus);
+    // can be called from the MIDI thread, calls have to be serialized by the caller
+    void captureMidiMessage(const MidiMessage& message);
+
+    //==============================================================================
+    void timerCallback();
+    String formatLogEntry(const MemoryBlock &rawData);
 
 protected:
     //==============================================================================
@@ -60,6 +67,16 @@ protected:
     bool filterMiosTerminalMessage;
     bool cutLongMessages;
 
+    //==============================================================================
+    // captured messages are transfered from the MIDI thread to the GUI thread
+    // via this ring buffer: [uint32 size][double timestamp][size bytes]
+    AbstractFifo captureFifo;
+    HeapBlock<uint8> captureBuffer;
+    Atomic<int> numDroppedMessages;
+
+    void captureWrite(int &pos, const void *src, int len);
+    void captureRead(int &pos, void *dst, int len);
+
     //==============================================================================
     // (prevent copy constructor and operator= being generated..)
     MidiMonitor (const MidiMonitor&);
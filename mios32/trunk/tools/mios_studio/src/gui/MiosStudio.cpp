@@ -439,6 +439,7 @@ void MiosStudio::handleIncomingMidiMessage(MidiInput* source, const MidiMessage&
 
         const ScopedLock sl(midiInQueueLock); // lock will be released at end of function
         midiInQueue.push(combinedMessage);
+        midiInMonitor->captureMidiMessage(combinedMessage);
 
         // propagate to upload handler
         uploadHandler->handleIncomingMidiMessage(source, combinedMessage);
@@ -448,6 +449,7 @@ void MiosStudio::handleIncomingMidiMessage(MidiInput* source, const MidiMessage&
 
         const ScopedLock sl(midiInQueueLock); // lock will be released at end of function
         midiInQueue.push(message);
+        midiInMonitor->captureMidiMessage(message);
 
         // propagate to upload handler
         uploadHandler->handleIncomingMidiMessage(source, message);
@@ -467,8 +469,9 @@ void MiosStudio::sendMidiMessage(MidiMessage &message)
     if( out )
         out->sendMessageNow(message);
 
-    const ScopedLock sl(midiOutQueueLock); // lock will be released at end of function
-    midiOutQueue.push(message);
+    // the MIDI Out monitor captures the message directly, the lock serializes calls from different threads
+    const ScopedLock sl(midiOutMonitorLock); // lock will be released at end of function
+    midiOutMonitor->captureMidiMessage(message);
 }
 
 
@@ -556,7 +559,7 @@ void MiosStudio::timerCallback()
                     runningStatus = data[0];
 
                 // propagate incoming event to MIDI components
-                midiInMonitor->handleIncomingMidiMessage(message, runningStatus);
+                // (the MIDI In monitor already captured it in handleIncomingMidiMessage())
 
                 // filter runtime events for following components to improve performance
                 if( data[0] < 0xf8 ) {
@@ -579,16 +582,6 @@ void MiosStudio::timerCallback()
 
                 midiInQueue.pop();
             }
-
-            if( !midiOutQueue.empty() ) {
-                const ScopedLock sl(midiOutQueueLock); // lock will be released at end of this scope
-
-                MidiMessage &message = midiOutQueue.front();
-
-                midiOutMonitor->handleIncomingMidiMessage(message, message.getRawData()[0]);
-
-                midiOutQueue.pop();
-            }
         }
 
         if( batchJobs.size() ) {
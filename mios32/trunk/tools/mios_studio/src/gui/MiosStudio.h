@@ -161,8 +161,7 @@ protected:
     CriticalSection midiInQueueLock;
     uint8 runningStatus;
 
-    std::queue<MidiMessage> midiOutQueue;
-    CriticalSection midiOutQueueLock;
+    CriticalSection midiOutMonitorLock;
 
     Array<uint8> sysexReceiveBuffer;
 